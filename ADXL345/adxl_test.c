@@ -15,6 +15,7 @@ Midas
 #include "i2c_adxl345.h" //--- use  read() write() to operate I2C
 #include "mathwork.h"
 #include "filters.h"
+#include "filter_bank.h"
 #include "data_server.h"
 
 //#define TCP_TRANSFER
@@ -29,7 +30,7 @@ int main(void)
    double  faccXYZ[3]; //double //faccXYZ=fs*accXYZ
    double  fangleYZ; //atan(Y/Z)
    //----- filter data base -----
-   struct int16MAFilterDB fdb_accXYZ[3];
+   struct int16FilterBankDB fbank_accXYZ;
    //Note: Big limit value smooths data better,but you have to trade off with reactive speed.
    uint16_t  relative_uint16limit=128;//256 //1.0*1000/3.9=256; relative difference limit between two fdb_faccXYZ[] data
    //------ time value ----
@@ -48,8 +49,9 @@ int main(void)
    }
 
    //---- init filter data base
-   printf("Init int16MA filter data base ...\n");
-   if( Init_int16MAFilterDB_NG(3, fdb_accXYZ, 4, relative_uint16limit)<0) //2^4=16 points average filter
+   printf("Init int16 filter bank ...\n");
+   //2^4=16 points average filter, and 4 order Butterworth lowpass Fs=800Hz Fc=50Hz
+   if( Init_int16FilterBankDB(&fbank_accXYZ, 3, 4, relative_uint16limit, 2, 800, 50)<0)
    {
 	ret_val=-2;
         goto INIT_MAFILTER_FAIL;
@@ -88,14 +90,9 @@ while(1)
    while(i<100000)
    {
        i++;
-       adxl_read_int16AXYZ(accXYZ); // OFSX,OFSY,OFSZ preset in Init_ADXL345()
-
-       //-----applay int16 Moving Average Filter
+       //-----read and apply int16 Moving Average Filter and IIR LOWPASS FILTER
        //----- single and double spiking value will be trimmed.
-       int16_MAfilter_NG(3,fdb_accXYZ, accXYZ, accXYZ, 0); // three filter groups, only [0] data filterd for each filter
-
-       //----- apply IIR LOWPASS FILTER
-//       IIR_Lowpass_int16Filter(&accXYZ[2], &accXYZ[2], 0); // only ONE group to be filtered.
+       adxl_read_filtered_int16AXYZ(&fbank_accXYZ, accXYZ, 1); // OFSX,OFSY,OFSZ preset in Init_ADXL345()
 
        //------- use factor
        for(j=0;j<3;j++)
@@ -181,7 +178,7 @@ CALL_FAIL:
 
 INIT_MAFILTER_FAIL:
    //---- release filter data base
-   Release_int16MAFilterDB_NG(3,fdb_accXYZ);
+   Release_int16FilterBankDB(&fbank_accXYZ);
 
 INIT_ADXL345_FAIL:
    Close_ADXL345();
@@ -287,3 +287,102 @@ inline void adxl_get_int16BiasXYZ(int16_t* bias_xyz)
                 bias_xyz[i]=xyz_sums[i]/ADXL_BIAS_SAMPLE_NUM;
 
 }
+
+/*----------------------------------------------------
+Read a block of AX AY AZ and filter them.
+Offsets are adjusted by OFSX,OFSY,OFSZ in Init_ADXL345().
+
+*fbank:    filter bank for 3 axes, see filter_bank.h
+*accXYZ:   filtered data, int16_t [nsamples][3]
+nsamples:  number of XYZ samples to read
+----------------------------------------------------- */
+void adxl_read_filtered_int16AXYZ(struct int16FilterBankDB *fbank, int16_t *accXYZ, int nsamples)
+{
+	int i;
+
+	for(i=0; i<nsamples; i++)
+		adxl_read_int16AXYZ(accXYZ+3*i);
+
+	int16_FilterBank(fbank, accXYZ, accXYZ, nsamples);
+}
+
+
+static uint8_t g_fifo_wtm; //FIFO watermark level, set in adxl_fifo_start()
+
+/*----------------------------------------------------
+Enable FIFO in stream mode, so up to 32 XYZ samples
+are kept, and drain them by adxl_fifo_fetch().
+
+wtm:  watermark level, 1-31, adxl_fifo_fetch() reads
+      nothing until the FIFO level reaches it.
+Return:
+	0  OK
+	<0 Fail
+----------------------------------------------------- */
+int adxl_fifo_start(uint8_t wtm)
+{
+	if(wtm<1 || wtm>ADXL_FIFO_DEPTH-1)
+	{
+		fprintf(stderr,"adxl_fifo_start(): watermark level should be 1-%d!\n",ADXL_FIFO_DEPTH-1);
+		return -1;
+	}
+	g_fifo_wtm=wtm;
+
+	//----- bypass mode first to clear the FIFO
+	I2C_Single_Write(ADXL345REG_FIFO_CTL, ADXL_FIFO_BYPASS);
+	if( I2C_Single_Write(ADXL345REG_FIFO_CTL, ADXL_FIFO_STREAM|wtm) <0 )
+		return -2;
+
+	return 0;
+}
+
+/*----------------------------------------------------
+Disable FIFO, back to read sample by sample
+----------------------------------------------------- */
+void adxl_fifo_stop(void)
+{
+	I2C_Single_Write(ADXL345REG_FIFO_CTL, ADXL_FIFO_BYPASS);
+}
+
+/*----------------------------------------------------------------
+Drain the FIFO, if its level reaches the watermark.
+Each 6 bytes read of DATAX0-DATAZ1 pops one FIFO entry, and a longer
+read does NOT go on to the next entry, so it takes one I2C_Multi_Read()
+for each sample.
+
+ctx:      not used
+raw:      raw data of DATAX0 - DATAZ1, [max][6] bytes
+max:      max. samples to read
+t_us:     CLOCK_MONOTONIC time when the FIFO level was read, in us
+overrun:  true if the FIFO is full, and old samples may be lost
+
+Return:
+	>0  number of samples read
+	0   FIFO level is below the watermark, or fails to read it
+------------------------------------------------------------------*/
+int adxl_fifo_fetch(void *ctx, uint8_t *raw, int max, int64_t *t_us, bool *overrun)
+{
+	struct timespec tp;
+	uint8_t status;
+	int i,n;
+
+	if( I2C_Single_Read(ADXL345REG_FIFO_STATUS, &status) <0 )
+		return 0;
+	clock_gettime(CLOCK_MONOTONIC,&tp);
+
+	n=status&0x3f; //entries D5-D0
+	if(n<g_fifo_wtm)
+		return 0;
+	if(n>max)
+		n=max;
+
+	*t_us=(int64_t)tp.tv_sec*1000000+tp.tv_nsec/1000;
+	*overrun=(n>=ADXL_FIFO_DEPTH);
+	for(i=0; i<n; i++)
+	{
+		if( I2C_Multi_Read(6, ADXL345REG_DATAX0, raw+6*i) <0 )
+			return i; //samples read so far
+	}
+
+	return n;
+}
@@ -20,6 +20,7 @@ Midas
 #include <string.h>
 #include <time.h>
 #include <sys/time.h>
+#include "filter_bank.h"
 
 
 #define ADXL345REG_DEVID 0x00
@@ -39,6 +40,14 @@ Midas
 #define ADXL345REG_DATAY1 0x35
 #define ADXL345REG_DATAZ0 0x36
 #define ADXL345REG_DATAZ1 0x37
+#define ADXL345REG_FIFO_CTL 0x38
+#define ADXL345REG_FIFO_STATUS 0x39
+
+//----- FIFO_CTL: FIFO mode D7-D6, samples(watermark) D4-D0 -----
+#define ADXL_FIFO_BYPASS 0x00
+#define ADXL_FIFO_FIFO 0x40
+#define ADXL_FIFO_STREAM 0x80
+#define ADXL_FIFO_DEPTH 32
 
 #if 0
 #define ADXL_ODR_1600HZ  0xE
@@ -96,6 +105,10 @@ bool DataReady_ADXL345(void);
 int Init_ADXL345(enum ADXL_ODRBW_setval ODRBW_setval, uint8_t g_range);
 void adxl_read_int16AXYZ(int16_t  *accXYZ);
 inline void adxl_get_int16BiasXYZ(int16_t* bias_xyz);
+void adxl_read_filtered_int16AXYZ(struct int16FilterBankDB *fbank, int16_t *accXYZ, int nsamples);
+int adxl_fifo_start(uint8_t wtm);
+void adxl_fifo_stop(void);
+int adxl_fifo_fetch(void *ctx, uint8_t *raw, int max, int64_t *t_us, bool *overrun);
 
 
 #endif
@@ -0,0 +1,285 @@
+/*----------------------------------------------------------------------
+Filter bank for int16 XYZ streams, see filter_bank.h.
+
+Midas
+----------------------------  COPYLEFT  --------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "filter_bank.h"
+
+#define FBANK_STATE_MAX		( 32767*(1<<FBANK_STATE_QBITS))
+#define FBANK_STATE_MIN		(-32768*(1<<FBANK_STATE_QBITS))	/* NOT to left shift a negative value */
+
+
+/*----------------------------------------------------------------------------
+Init. a ring-indexed int16 MA filter
+
+*fdb   --- filter data base
+ng     --- filter grade number, 2^ng points average.
+limit  --- abs(limit) value for input data incremental value, above which the
+	   value will be trimmed.
+Return:
+	0    OK
+	<0   fails
+--------------------------------------------------------------------------*/
+int Init_int16MARingDB(struct int16MARingDB *fdb, uint16_t ng, int16_t limit)
+{
+	int np;
+
+	memset(fdb,0,sizeof(struct int16MARingDB));
+
+	if(ng>FBANK_MA_MAX_GRADE)
+	{
+		printf("Max. Filter grade is %d!\n",FBANK_MA_MAX_GRADE);
+		ng=FBANK_MA_MAX_GRADE;
+	}
+	fdb->f_ng=ng;
+	np=1<<ng;
+
+	fdb->f_limit=abs(limit);
+	fdb->f_ring=calloc(np,sizeof(int16_t));
+	if(fdb->f_ring == NULL)
+	{
+		fprintf(stderr,"Init_int16MARingDB(): malloc f_ring failed!\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*----------------------------------------------------------------------
+Release a ring-indexed int16 MA filter
+----------------------------------------------------------------------*/
+void Release_int16MARingDB(struct int16MARingDB *fdb)
+{
+	if(fdb->f_ring != NULL)
+		free(fdb->f_ring);
+	fdb->f_ring=NULL;
+}
+
+/*--------------------------------------------------------------------------
+Push a new data into a ring-indexed int16 MA filter, and return the average.
+
+Same as int16_MAfilter(): the data to be averaged is the one 2 points before
+the new data, if it jumps over limit from the previous one, it's trimmed
+to the previous one, unless the 2 data after it also jump over the limit.
+So the output is 2^ng+2 points later than the input.
+--------------------------------------------------------------------------*/
+int16_t int16_MARingFilter(struct int16MARingDB *fdb, int16_t data)
+{
+	int mask=(1<<fdb->f_ng)-1;
+	int16_t prev=fdb->f_ring[(fdb->f_pos-1)&mask];	//the newest one in ring
+	int16_t cand=fdb->f_next[0];			//the one to be averaged
+	int limit=fdb->f_limit;
+
+	//----- move next data
+	fdb->f_next[0]=fdb->f_next[1];
+	fdb->f_next[1]=data;
+
+	//----- Limit Pick Method : ---  Relative Limit ---
+	if( cand > prev+limit )
+	{
+		//------- if 1+2 CONTINOUS up_limit detected, then do NOT trim ----
+		if( !(fdb->f_next[0] > prev+limit && fdb->f_next[1] > prev+limit) )
+			cand=prev;
+	}
+	else if( cand < prev-limit )
+	{
+		//------- if 1+2 CONTINOUS low_limit detected, then do NOT trim ----
+		if( !(fdb->f_next[0] < prev-limit && fdb->f_next[1] < prev-limit) )
+			cand=prev;
+	}
+
+	//----- replace the oldest one
+	fdb->f_sum += cand-fdb->f_ring[fdb->f_pos];
+	fdb->f_ring[fdb->f_pos]=cand;
+	fdb->f_pos=(fdb->f_pos+1)&mask;
+
+	return fdb->f_sum>>fdb->f_ng;
+}
+
+
+/*-------------------------------------------------------------------------
+Design a Butterworth lowpass filter as cascaded biquad sections.
+
+*bq    --- [nsect] biquad coefficients
+nsect  --- number of sections, order of the filter is 2*nsect
+fs     --- sample rate, in Hz
+fc     --- cutoff frequency(-3dB), in Hz
+
+Return:
+	0    OK
+	<0   fails
+--------------------------------------------------------------------------*/
+int Design_Butterworth_Lowpass(struct biquadQ28 *bq, int nsect, float fs, float fc)
+{
+	double w0,cw,alpha,q,a0;
+	double one=(double)(1<<FBANK_COEF_QBITS);
+	int k;
+
+	if(nsect<1 || nsect>FBANK_MAX_BIQUADS || fc<=0 || fc>=fs/2)
+	{
+		fprintf(stderr,"Design_Butterworth_Lowpass(): invalid nsect, fs or fc!\n");
+		return -1;
+	}
+
+	w0=2*M_PI*fc/fs;
+	cw=cos(w0);
+	for(k=0; k<nsect; k++)
+	{
+		//----- Q of each section, by poles of Butterworth
+		q=1.0/(2*cos(M_PI*(2*k+1)/(4*nsect)));
+		alpha=sin(w0)/(2*q);
+		a0=1+alpha;
+
+		bq[k].b0=lround((1-cw)/2/a0*one);
+		bq[k].b1=lround((1-cw)/a0*one);
+		bq[k].b2=bq[k].b0;
+		bq[k].a1=lround(-2*cw/a0*one);
+		bq[k].a2=lround((1-alpha)/a0*one);
+	}
+
+	return 0;
+}
+
+/*-------------------------------------------------------
+Biquad in Direct Form I
+x:	input in Q8
+Return:
+	output in Q8, limited to int16 range.
+--------------------------------------------------------*/
+int32_t biquad_Filter(const struct biquadQ28 *bq, struct biquadState *st, int32_t x)
+{
+	int64_t acc;
+	int32_t y;
+
+	acc =(int64_t)bq->b0*x + (int64_t)bq->b1*st->x1 + (int64_t)bq->b2*st->x2
+	    -(int64_t)bq->a1*st->y1 - (int64_t)bq->a2*st->y2;
+	y=(int32_t)( (acc+((int64_t)1<<(FBANK_COEF_QBITS-1))) >> FBANK_COEF_QBITS );
+
+	if(y>FBANK_STATE_MAX)
+		y=FBANK_STATE_MAX;
+	else if(y<FBANK_STATE_MIN)
+		y=FBANK_STATE_MIN;
+
+	st->x2=st->x1;
+	st->x1=x;
+	st->y2=st->y1;
+	st->y1=y;
+
+	return y;
+}
+
+
+/*----------------------------------------------------------------------------
+Init. a filter bank
+
+*fbank --- filter bank data base
+naxes  --- number of axes, 1-3
+ng     --- MA grade number, 2^ng points average, <0 no MA.
+limit  --- MA incremental limit, see Init_int16MARingDB()
+nbq    --- number of Butterworth lowpass biquad sections, 0 no IIR.
+fs, fc --- sample rate and cutoff frequency for IIR, in Hz.
+
+Return:
+	0    OK
+	<0   fails
+--------------------------------------------------------------------------*/
+int Init_int16FilterBankDB(struct int16FilterBankDB *fbank, int naxes, int ng, int16_t limit,
+			   int nbq, float fs, float fc)
+{
+	int i;
+
+	memset(fbank,0,sizeof(struct int16FilterBankDB));
+
+	if(naxes<1 || naxes>FBANK_MAX_AXES || nbq<0 || nbq>FBANK_MAX_BIQUADS)
+	{
+		fprintf(stderr,"Init_int16FilterBankDB(): invalid naxes or nbq!\n");
+		return -1;
+	}
+	fbank->naxes=naxes;
+
+	if(ng>=0)
+	{
+		fprintf(stdout,"	%d points ring-indexed MA filter for %d axes initilizing...\n",1<<ng,naxes);
+		for(i=0; i<naxes; i++)
+		{
+			if( Init_int16MARingDB(&fbank->ma[i], ng, limit)<0 )
+			{
+				Release_int16FilterBankDB(fbank);
+				return -2;
+			}
+		}
+		fbank->ma_enable=1;
+	}
+
+	if(nbq>0)
+	{
+		fprintf(stdout,"	%d order Butterworth IIR filter, Fs=%.1fHz Fc=%.1fHz initilizing...\n",
+										2*nbq,fs,fc);
+		if( Design_Butterworth_Lowpass(fbank->bq, nbq, fs, fc)<0 )
+		{
+			Release_int16FilterBankDB(fbank);
+			return -3;
+		}
+		fbank->nbq=nbq;
+	}
+
+	return 0;
+}
+
+/*----------------------------------------------------------------------
+Release a filter bank
+----------------------------------------------------------------------*/
+void Release_int16FilterBankDB(struct int16FilterBankDB *fbank)
+{
+	int i;
+
+	for(i=0; i<FBANK_MAX_AXES; i++)
+		Release_int16MARingDB(&fbank->ma[i]);
+	fbank->ma_enable=0;
+}
+
+/*---------------------------------------------------------------------
+Filter a block of interleaved samples
+
+*source:   raw data input, [nsamples][naxes]
+*dest:     where you put your filtered data, [nsamples][naxes]
+	   (source and dest may be the same)
+nsamples:  number of samples in the block
+----------------------------------------------------------------------*/
+void int16_FilterBank(struct int16FilterBankDB *fbank, const int16_t *source, int16_t *dest, int nsamples)
+{
+	int naxes=fbank->naxes;
+	int i,j,k;
+	int16_t v;
+	int32_t y;
+
+	for(i=0; i<nsamples; i++)
+	{
+		for(j=0; j<naxes; j++)
+		{
+			v=source[j];
+
+			if(fbank->ma_enable)
+				v=int16_MARingFilter(&fbank->ma[j], v);
+
+			if(fbank->nbq>0)
+			{
+				y=(int32_t)v*(1<<FBANK_STATE_QBITS);
+				for(k=0; k<fbank->nbq; k++)
+					y=biquad_Filter(&fbank->bq[k], &fbank->bqs[j][k], y);
+
+				//----- round to int16, states are limited to int16 range already
+				y=(y+(1<<(FBANK_STATE_QBITS-1)))>>FBANK_STATE_QBITS;
+				v=y>32767 ? 32767 : y;
+			}
+
+			dest[j]=v;
+		}
+		source += naxes;
+		dest += naxes;
+	}
+}
@@ -0,0 +1,79 @@
+/*----------------------------------------------------------------------
+Filter bank for int16 XYZ streams of gyro/accelerometer.
+
+1. Samples are processed in blocks of interleaved XYZ, as
+   [nsamples][naxes], source and dest may be the same.
+2. Moving average: The window is a ring, so each sample costs O(1)
+   instead of shifting 2^ng+2 elements as int16_MAfilter() does.
+   The spike-limit logic and output are exactly the same as of
+   int16_MAfilter().
+3. IIR: Cascaded biquad sections in fixed point, coefficients in Q28,
+   states in Q8, and products summed in int64_t(MIPS madd).
+   Butterworth lowpass coefficients are computed at init.
+4. Moving average is applied first, then the IIR sections.
+
+Midas
+----------------------------  COPYLEFT  --------------------------------*/
+#ifndef __FILTER_BANK_H__
+#define __FILTER_BANK_H__
+
+#include <stdint.h>
+
+#define FBANK_MAX_AXES		3
+#define FBANK_MAX_BIQUADS	4	//max. biquad sections, 2*4=8 order IIR
+#define FBANK_MA_MAX_GRADE	10	//max. grade for MA, 2^10 points moving average.
+#define FBANK_COEF_QBITS	28	//fraction bits of biquad coefficients
+#define FBANK_STATE_QBITS	8	//fraction bits of biquad states
+
+//----- Ring-indexed int16 moving average filter with spike limit -----
+struct int16MARingDB {
+	uint16_t f_ng;		//grade number, point number = 2^ng
+	uint16_t f_pos;		//ring index of the oldest data
+	int16_t *f_ring;	//[2^ng] data being averaged
+	int16_t f_next[2];	//2 raw data after the newest one, for limit check
+	int32_t f_sum;		//sum of ring data
+	int16_t f_limit;	//limit of incremental value
+};
+
+//----- Biquad coefficients, a0=1, in Q28 -----
+struct biquadQ28 {
+	int32_t b0,b1,b2;
+	int32_t a1,a2;
+};
+
+//----- Biquad states, Direct Form I, in Q8 -----
+struct biquadState {
+	int32_t x1,x2;
+	int32_t y1,y2;
+};
+
+//----- Filter bank Data Base -----
+struct int16FilterBankDB {
+	int naxes;					//number of axes, 1-3
+	int ma_enable;					//moving average is applied
+	struct int16MARingDB ma[FBANK_MAX_AXES];
+	int nbq;					//number of biquad sections, 0 for none
+	struct biquadQ28 bq[FBANK_MAX_BIQUADS];		//same coefficients for all axes
+	struct biquadState bqs[FBANK_MAX_AXES][FBANK_MAX_BIQUADS];
+};
+
+
+//------------------------     FUNCTION DECLARATION     ---------------------------
+
+//------ Ring-indexed MA for one axis ------
+int Init_int16MARingDB(struct int16MARingDB *fdb, uint16_t ng, int16_t limit);
+void Release_int16MARingDB(struct int16MARingDB *fdb);
+int16_t int16_MARingFilter(struct int16MARingDB *fdb, int16_t data);
+
+//------ Biquad ------
+int Design_Butterworth_Lowpass(struct biquadQ28 *bq, int nsect, float fs, float fc);
+int32_t biquad_Filter(const struct biquadQ28 *bq, struct biquadState *st, int32_t x);
+
+//------ Filter bank for XYZ blocks ------
+int Init_int16FilterBankDB(struct int16FilterBankDB *fbank, int naxes, int ng, int16_t limit,
+			   int nbq, float fs, float fc);
+void Release_int16FilterBankDB(struct int16FilterBankDB *fbank);
+void int16_FilterBank(struct int16FilterBankDB *fbank, const int16_t *source, int16_t *dest, int nsamples);
+
+
+#endif
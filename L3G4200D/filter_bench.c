@@ -0,0 +1,237 @@
+/*-------------------------------------------------------------------------
+Benchmark of the filter bank (filter_bank.c) against int16_MAfilter_NG()
+and IIR_Lowpass_dblFilter() in filters.c.
+
+1. MA: 3 axes, ng=4,6,8,10, check that output of int16_FilterBank() is
+   exactly the same as int16_MAfilter_NG(), and print samples/sec of both.
+2. IIR: 4 order Butterworth lowpass Fs=300Hz Fc=50Hz, same as
+   IIR_Lowpass_dblFilter(), on X axis only since the latter keeps its
+   states in static vars. Print samples/sec of both and max. error of
+   the fixed point biquads.
+
+Data are XYZ int16 readings from a text file, 3 values a line separated
+by ',' or spaces, as recorded by gyro_test or adxl_test. If no file is
+given, a stream of 800Hz noise with spikes is generated.
+
+Usage:	filter_bench [xyz.dat|-] [loops]
+
+Midas
+---------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+#include "filters.h"
+#include "filter_bank.h"
+
+#define BENCH_MAXN	(800*60)	/* Max. XYZ samples, 1 minute at 800Hz */
+#define BENCH_BLOCK	32		/* Samples per int16_FilterBank() call */
+
+static int16_t datXYZ[BENCH_MAXN*3];	/* raw readings */
+static int16_t refXYZ[BENCH_MAXN*3];	/* by int16_MAfilter_NG() */
+static int16_t newXYZ[BENCH_MAXN*3];	/* by int16_FilterBank() */
+static double  dblX[BENCH_MAXN];
+static double  refX[BENCH_MAXN];	/* by IIR_Lowpass_dblFilter() */
+static int     ndat;
+
+
+static double tm_diffs(struct timeval t_start, struct timeval t_end)
+{
+	return (t_end.tv_sec-t_start.tv_sec)+(t_end.tv_usec-t_start.tv_usec)/1000000.0;
+}
+
+/*-------------------------------------------
+Load XYZ readings from a text file.
+Return:
+	>0	Number of XYZ samples
+	<0	Fails
+--------------------------------------------*/
+static int load_xyzdat(const char *fpath)
+{
+	FILE *fil;
+	char line[128];
+	int x,y,z;
+	int n=0;
+
+	fil=fopen(fpath,"r");
+	if(fil==NULL)
+	{
+		fprintf(stderr,"Fail to open %s!\n",fpath);
+		return -1;
+	}
+
+	while( n<BENCH_MAXN && fgets(line,sizeof(line),fil)!=NULL )
+	{
+		if( sscanf(line,"%d%*[ ,\t]%d%*[ ,\t]%d",&x,&y,&z)!=3 )
+			continue;
+		datXYZ[3*n]=x;
+		datXYZ[3*n+1]=y;
+		datXYZ[3*n+2]=z;
+		n++;
+	}
+	fclose(fil);
+
+	return n>0 ? n : -2;
+}
+
+/*-------------------------------------------
+Generate 800Hz XYZ samples: slow sine wave
++ white noise + single/double spikes.
+--------------------------------------------*/
+static int gen_xyzdat(void)
+{
+	int i,j;
+	double v;
+
+	srand(1);
+	for(i=0; i<BENCH_MAXN; i++)
+	{
+		for(j=0; j<3; j++)
+		{
+			v=2000*sin(2*M_PI*(1+j)*i/800.0)+(rand()%401-200);
+			if(rand()%200==0)
+				v += (rand()&1) ? 8000 : -8000;
+			datXYZ[3*i+j]=v;
+		}
+		//----- a double spike on Z
+		if(i%1000==500)
+		{
+			datXYZ[3*i+2] += 6000;
+			datXYZ[3*i-1] += 6000;
+		}
+	}
+
+	return BENCH_MAXN;
+}
+
+/* MA: int16_MAfilter_NG() vs int16_FilterBank() */
+static int bench_ma(int ng, int16_t limit, int loops)
+{
+	struct int16MAFilterDB fdb[3];
+	struct int16FilterBankDB fbank;
+	struct timeval tm_start,tm_end;
+	double t_ref, t_new;
+	int i,k,n,errs;
+
+	//----- int16_MAfilter_NG(), sample by sample. Init only once, so its message is printed
+	//      once, and states go on through loops, as the filter bank's.
+	if( Init_int16MAFilterDB_NG(3, fdb, ng, limit)<0 )
+		return -1;
+	gettimeofday(&tm_start,NULL);
+	for(k=0; k<loops; k++)
+	{
+		for(i=0; i<ndat; i++)
+			int16_MAfilter_NG(3, fdb, datXYZ+3*i, refXYZ+3*i, 0);
+	}
+	gettimeofday(&tm_end,NULL);
+	t_ref=tm_diffs(tm_start,tm_end);
+	Release_int16MAFilterDB_NG(3, fdb);
+
+	//----- int16_FilterBank(), by blocks
+	if( Init_int16FilterBankDB(&fbank, 3, ng, limit, 0, 0, 0)<0 )
+		return -1;
+	gettimeofday(&tm_start,NULL);
+	for(k=0; k<loops; k++)
+	{
+		for(i=0; i<ndat; i+=n)
+		{
+			n= ndat-i < BENCH_BLOCK ? ndat-i : BENCH_BLOCK;
+			int16_FilterBank(&fbank, datXYZ+3*i, newXYZ+3*i, n);
+		}
+	}
+	gettimeofday(&tm_end,NULL);
+	t_new=tm_diffs(tm_start,tm_end);
+	Release_int16FilterBankDB(&fbank);
+
+	errs=0;
+	for(i=0; i<3*ndat; i++)
+	{
+		if(refXYZ[i]!=newXYZ[i])
+			errs++;
+	}
+
+	printf("MA %4d points:  int16_MAfilter_NG %10.0f samples/s,  int16_FilterBank %10.0f samples/s,  %s\n",
+		1<<ng, (double)ndat*loops/t_ref, (double)ndat*loops/t_new,
+		errs==0 ? "EXACT" : "MISMATCH!");
+
+	return errs;
+}
+
+/* IIR: IIR_Lowpass_dblFilter() vs fixed point biquads, X axis */
+static void bench_iir(int loops)
+{
+	struct int16FilterBankDB fbank;
+	struct timeval tm_start,tm_end;
+	double t_ref, t_new;
+	double err, max_err=0;
+	int i,k,n;
+
+	//----- IIR_Lowpass_dblFilter(), its states start from 0 at the first loop only,
+	//      keep output of the first loop as reference.
+	gettimeofday(&tm_start,NULL);
+	for(k=0; k<loops; k++)
+	{
+		for(i=0; i<ndat; i++)
+			dblX[i]=datXYZ[3*i];
+		for(i=0; i<ndat; i++)
+			IIR_Lowpass_dblFilter(dblX, k==0 ? refX : dblX, i);
+	}
+	gettimeofday(&tm_end,NULL);
+	t_ref=tm_diffs(tm_start,tm_end);
+
+	//----- int16_FilterBank(), 2 biquad sections for 1 axis. Init only once, keep output
+	//      of the first loop to compare, later loops write to the rest of newXYZ[].
+	for(i=0; i<ndat; i++)
+		refXYZ[i]=datXYZ[3*i];
+	if( Init_int16FilterBankDB(&fbank, 1, -1, 0, 2, 300, 50)<0 )
+		return;
+	gettimeofday(&tm_start,NULL);
+	for(k=0; k<loops; k++)
+	{
+		for(i=0; i<ndat; i+=n)
+		{
+			n= ndat-i < BENCH_BLOCK ? ndat-i : BENCH_BLOCK;
+			int16_FilterBank(&fbank, refXYZ+i, k==0 ? newXYZ+i : newXYZ+ndat+i, n);
+		}
+	}
+	gettimeofday(&tm_end,NULL);
+	t_new=tm_diffs(tm_start,tm_end);
+	Release_int16FilterBankDB(&fbank);
+
+	for(i=0; i<ndat; i++)
+	{
+		err=fabs(newXYZ[i]-refX[i]);
+		if(err>max_err)
+			max_err=err;
+	}
+
+	printf("IIR 4 order:    IIR_Lowpass_dblFilter %10.0f samples/s,  int16_FilterBank %10.0f samples/s,  max. error %.2f LSB\n",
+		(double)ndat*loops/t_ref, (double)ndat*loops/t_new, max_err);
+}
+
+int main(int argc, char **argv)
+{
+	int loops=10;
+	int ng, errs=0;
+
+	if(argc>1 && strcmp(argv[1],"-")!=0)
+		ndat=load_xyzdat(argv[1]);
+	else
+		ndat=gen_xyzdat();
+	if(ndat<0)
+		exit(1);
+	if(argc>2)
+		loops=atoi(argv[2]);
+	if(loops<1)
+		loops=1;
+
+	printf("%d XYZ samples, %d loops\n", ndat, loops);
+
+	for(ng=4; ng<=10; ng+=2)
+		errs += bench_ma(ng, 1024, loops);
+
+	bench_iir(loops);
+
+	return errs==0 ? 0 : 1;
+}
@@ -179,6 +179,113 @@ inline  void gyro_get_int16BiasXYZ(int16_t* bias_xyz)
 
 }
 
+/*----------------------------------------------------
+Read a block of RX RY RZ, deduce bias and filter them.
+
+*fbank:    filter bank for 3 axes, see filter_bank.h
+*angRXYZ:  filtered data, int16_t [nsamples][3]
+nsamples:  number of XYZ samples to read
+----------------------------------------------------- */
+void gyro_read_filtered_int16RXYZ(struct int16FilterBankDB *fbank, int16_t *angRXYZ, int nsamples)
+{
+	int i,j;
+
+	for(i=0; i<nsamples; i++)
+	{
+		gyro_read_int16RXYZ(angRXYZ+3*i);
+		for(j=0; j<3; j++)
+			angRXYZ[3*i+j] -= g_bias_int16RXYZ[j];
+	}
+
+	int16_FilterBank(fbank, angRXYZ, angRXYZ, nsamples);
+}
+
+
+static uint8_t g_fifo_wtm; //FIFO watermark level, set in gyro_fifo_start()
+
+/*----------------------------------------------------
+Enable FIFO in stream mode, so up to 32 XYZ samples
+are kept, and drain them by gyro_fifo_fetch().
+
+wtm:  watermark level, 1-31, gyro_fifo_fetch() reads
+      nothing until the FIFO level reaches it.
+Return:
+	0  OK
+	<0 Fail
+----------------------------------------------------- */
+int gyro_fifo_start(uint8_t wtm)
+{
+	if(wtm<1 || wtm>L3G_FIFO_DEPTH-1)
+	{
+		fprintf(stderr,"gyro_fifo_start(): watermark level should be 1-%d!\n",L3G_FIFO_DEPTH-1);
+		return -1;
+	}
+	g_fifo_wtm=wtm;
+
+	//----- bypass mode first to clear the FIFO
+	halSpiWriteReg(L3G_FIFO_CTRL_REG, L3G_FIFO_MODE_BYPASS);
+	halSpiWriteReg(L3G_CTRL_REG5, 0x40);//FIFO_EN[6]
+	halSpiWriteReg(L3G_FIFO_CTRL_REG, L3G_FIFO_MODE_STREAM|wtm);
+
+	return 0;
+}
+
+/*----------------------------------------------------
+Disable FIFO, back to read sample by sample
+----------------------------------------------------- */
+void gyro_fifo_stop(void)
+{
+	halSpiWriteReg(L3G_FIFO_CTRL_REG, L3G_FIFO_MODE_BYPASS);
+	halSpiWriteReg(L3G_CTRL_REG5, 0x00);
+}
+
+/*----------------------------------------------------------------
+Drain the FIFO in SPI bursts, if its level reaches the watermark.
+With FIFO enabled, the read address rolls back from OUT_Z_H to
+OUT_X_L, so each burst reads L3G_FIFO_BURST samples at most, as
+a burst is limited to 31 bytes.
+
+ctx:      not used
+raw:      raw data of OUT_X_L - OUT_Z_H, [max][6] bytes
+max:      max. samples to read
+t_us:     CLOCK_MONOTONIC time when the FIFO level was read, in us
+overrun:  true if the FIFO is full and old samples are lost
+
+Return:
+	>0  number of samples read
+	0   FIFO level is below the watermark
+------------------------------------------------------------------*/
+int gyro_fifo_fetch(void *ctx, uint8_t *raw, int max, int64_t *t_us, bool *overrun)
+{
+	struct timespec tp;
+	uint8_t src;
+	int n,i,k;
+
+	src=halSpiReadStatus(L3G_FIFO_SRC_REG);
+	clock_gettime(CLOCK_MONOTONIC,&tp);
+
+	if(src&L3G_FIFO_SRC_EMPTY)
+		n=0;
+	else if(src&L3G_FIFO_SRC_OVRN)
+		n=L3G_FIFO_DEPTH;
+	else
+		n=src&L3G_FIFO_SRC_FSS;
+
+	if(n<g_fifo_wtm)
+		return 0;
+	if(n>max)
+		n=max;
+
+	*t_us=(int64_t)tp.tv_sec*1000000+tp.tv_nsec/1000;
+	*overrun=(src&L3G_FIFO_SRC_OVRN) ? true : false;
+	for(i=0; i<n; i+=k) {
+		k= n-i < L3G_FIFO_BURST ? n-i : L3G_FIFO_BURST;
+		halSpiReadBurstReg(L3G_OUT_X_L, raw+6*i, 6*k);
+	}
+
+	return n;
+}
+
 
 /*----------------------------------------------------
  thread function:
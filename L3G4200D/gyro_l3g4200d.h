@@ -8,8 +8,10 @@ TODOs and BUGs:
 #include <string.h>
 #include <stdbool.h>
 #include <sys/time.h>
+#include <time.h>
 #include "i2c_oled_128x64.h"
 #include "gyro_spi.h"
+#include "filter_bank.h"
 
 //---- SPI Read and Write BITs set -----
 #define WRITE_SINGLE 0x00
@@ -46,6 +48,18 @@ TODOs and BUGs:
 #define L3G_INT1_TSH_ZL 0x37
 #define L3G_INT1_DURATION 0x38
 
+//----- FIFO_CTRL_REG: FIFO mode[7:5], watermark level[4:0] -----
+#define L3G_FIFO_MODE_BYPASS 0x00
+#define L3G_FIFO_MODE_FIFO 0x20
+#define L3G_FIFO_MODE_STREAM 0x40
+//----- FIFO_SRC_REG: watermark[7], overrun[6], empty[5], stored data level[4:0] -----
+#define L3G_FIFO_SRC_WTM 0x80
+#define L3G_FIFO_SRC_OVRN 0x40
+#define L3G_FIFO_SRC_EMPTY 0x20
+#define L3G_FIFO_SRC_FSS 0x1f
+#define L3G_FIFO_DEPTH 32
+#define L3G_FIFO_BURST 5 /* max. samples in one SPI burst, 5*6=30 bytes, see halSpiReadBurstReg() */
+
 enum L3G_ODRBW_setval
 {
  L3G_DR100_BW12_5=0x00,
@@ -83,6 +97,10 @@ int Init_L3G4200D(enum L3G_ODRBW_setval ODRBW_setval);
 bool status_XYZ_available(void);
 inline void gyro_read_int16RXYZ(int16_t *angRXYZ);
 inline void gyro_get_int16BiasXYZ(int16_t* bias_xyz);
+void gyro_read_filtered_int16RXYZ(struct int16FilterBankDB *fbank, int16_t *angRXYZ, int nsamples);
+int gyro_fifo_start(uint8_t wtm);
+void gyro_fifo_stop(void);
+int gyro_fifo_fetch(void *ctx, uint8_t *raw, int max, int64_t *t_us, bool *overrun);
 void  thread_gyroWriteOled(void);
 
 
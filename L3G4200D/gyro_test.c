@@ -32,7 +32,7 @@ int main(void)
    //in head file: double g_fangXYZ[3]={0};// angle value of X Y Z  ---- g_fangXYZ[]= integ{ dt_us*fangRXYZ[] }
 
    //----- filter db -----
-   struct int16MAFilterDB fdb_RXYZ[3];
+   struct int16FilterBankDB fbank_RXYZ;
 
    //----- timer -----
    struct timeval tm_start,tm_end;
@@ -63,8 +63,8 @@ int main(void)
 		goto INIT_PTHREAD_FAIL;
    }
    //---- init filter data base
-   printf("Init int16MA filter data base ...\n");
-   if( Init_int16MAFilterDB_NG(3, fdb_RXYZ, 6, 0x7fff)<0) //2^6=64 points average filter
+   printf("Init int16 filter bank ...\n");
+   if( Init_int16FilterBankDB(&fbank_RXYZ, 3, 6, 0x7fff, 0, 0, 0)<0) //2^6=64 points average filter, no IIR
    {
 	ret_val=-2;
 	goto INIT_MAFILTER_FAIL;
@@ -101,18 +101,10 @@ int main(void)
 	   k++;
 //   for(k=0;k<100000;k++) {
 
-	   //------- read angular rate of XYZ
-	   gyro_read_int16RXYZ(angRXYZ);
-//	   printf("Raw data: angRX=%d angRY=%d angRZ=%d \n",angRXYZ[0],angRXYZ[1],angRXYZ[2]);
-
-	   //------  deduce bias to adjust zero level
-	   for(i=0; i<3; i++)
-		   angRXYZ[i]=angRXYZ[i]-g_bias_int16RXYZ[i];
-//	   printf("Zero_leveled data: angRX=%d angRY=%d angRZ=%d \n",angRXYZ[0],angRXYZ[1],angRXYZ[2]);
-
-	   //---- Activate filter for  RX RY RZ
-	   // first reset each filter context struct, then you must use the same data stream until end.
-	   int16_MAfilter_NG(3,fdb_RXYZ, angRXYZ, angRXYZ, 0); // three group fitler 
+	   //------- read angular rate of XYZ, deduce bias to adjust zero level, and filter
+	   // first reset the filter bank, then you must use the same data stream until end.
+	   gyro_read_filtered_int16RXYZ(&fbank_RXYZ, angRXYZ, 1);
+//	   printf("Filtered data: angRX=%d angRY=%d angRZ=%d \n",angRXYZ[0],angRXYZ[1],angRXYZ[2]);
 
 	   //----- convert to real value
 	   for(i=0; i<3; i++)
@@ -156,7 +148,7 @@ CALL_FAIL:
 
 INIT_MAFILTER_FAIL:
    //---- release filter data base
-   Release_int16MAFilterDB_NG(3,fdb_RXYZ);
+   Release_int16FilterBankDB(&fbank_RXYZ);
 
 INIT_PTHREAD_FAIL:
    //----- close I2C and Oled
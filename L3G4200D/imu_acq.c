@@ -0,0 +1,388 @@
+/*----------------------------------------------------------------------
+Burst acquisition of gyro/accelerometer samples, see imu_acq.h.
+
+Midas
+----------------------------  COPYLEFT  --------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "imu_acq.h"
+
+#define IMU_ACQ_PHASE_GAIN	4	//phase error/4 is corrected for each burst
+#define IMU_ACQ_FREQ_GAIN	64	//phase error/64 goes to the period estimate
+#define IMU_ACQ_WAITMS		100	//max. wait for ring space, to check the quit token
+
+
+/*------------------------------------
+Return CLOCK_MONOTONIC time in us
+-------------------------------------*/
+int64_t imu_acq_clock_us(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC,&tp);
+	return (int64_t)tp.tv_sec*1000000+tp.tv_nsec/1000;
+}
+
+/*----------------------------------------------------------------------------
+Init. an acquisition data base
+
+*acq   --- acquisition data base
+sensor --- enum imu_sensor
+odr    --- nominal output data rate set to the chip, in Hz
+wtm    --- FIFO watermark level set to the chip
+fetch  --- fetch function of the FIFO
+ctx    --- context of fetch
+
+Set acq->lossless or call imu_acq_record() before imu_acq_start() if necessary.
+Return:
+	0    OK
+	<0   fails
+--------------------------------------------------------------------------*/
+int Init_imu_acq(struct imu_acq *acq, int sensor, float odr, int wtm, imu_fetch_t fetch, void *ctx)
+{
+	memset(acq,0,sizeof(struct imu_acq));
+
+	if(odr<=0 || wtm<1 || wtm>IMU_ACQ_FIFO_DEPTH || fetch==NULL)
+	{
+		fprintf(stderr,"Init_imu_acq(): invalid odr, wtm or fetch!\n");
+		return -1;
+	}
+
+	acq->sensor=sensor;
+	acq->odr=odr;
+	acq->wtm=wtm;
+	acq->fetch=fetch;
+	acq->ctx=ctx;
+	acq->period_us=1000000.0/odr;
+
+	return 0;
+}
+
+/*--------------------------------------------------------------------------
+Timestamp a burst of n samples fetched at t_fetch.
+
+The newest sample of the burst was taken within one period before t_fetch,
+so it's expected at t_fetch-period/2. Compared with last_ts+n*period, the
+error is partly corrected at once(phase), and partly goes to the period
+estimate(frequency), as a PLL does. The first burst and the one after an
+overrun are stamped from t_fetch directly, as samples may be lost, but
+never before the last timestamp, so timestamps are always monotonic.
+
+ts:	timestamps of the samples, [n], in us.
+Return:
+	0    OK
+	<0   fails
+--------------------------------------------------------------------------*/
+int imu_acq_stamp(struct imu_acq *acq, int n, int64_t t_fetch, bool overrun, int64_t *ts)
+{
+	double nominal=1000000.0/acq->odr;
+	double period=acq->period_us;
+	double pred,err,corr;
+	double end;
+	int i;
+
+	if(n<1)
+		return -1;
+
+	pred=acq->last_ts+n*period;
+	err=(t_fetch-period/2)-pred;
+
+	//----- resync if samples are lost, or the error is too big to track
+	if( !acq->synced || overrun || fabs(err) > IMU_ACQ_FIFO_DEPTH*period )
+	{
+		end=t_fetch-period/2;
+
+		//----- clamp, the first sample is at least half a period after the last one
+		if( acq->synced && end-(n-1)*period < acq->last_ts+period/2 )
+			end=acq->last_ts+period/2+(n-1)*period;
+
+		acq->synced=true;
+	}
+	else
+	{
+		//----- phase, no more than half a period, so timestamps are monotonic
+		corr=err/IMU_ACQ_PHASE_GAIN;
+		if(corr>period/2)
+			corr=period/2;
+		else if(corr<-period/2)
+			corr=-period/2;
+		end=pred+corr;
+
+		//----- frequency, within 1/2-2 times of the nominal period
+		acq->period_us += err/n/IMU_ACQ_FREQ_GAIN;
+		if(acq->period_us<nominal/2)
+			acq->period_us=nominal/2;
+		else if(acq->period_us>nominal*2)
+			acq->period_us=nominal*2;
+	}
+
+	for(i=0; i<n; i++)
+		ts[i]=llround(end-(n-1-i)*period);
+	acq->last_ts=end;
+
+	return 0;
+}
+
+/*-----------------------------------------
+Write a raw burst to the dump file
+------------------------------------------*/
+static void imu_acq_dump(FILE *fil, const uint8_t *raw, int n, int64_t t_fetch, bool overrun)
+{
+	int i;
+
+	fprintf(fil,"%lld %d %d ",(long long)t_fetch,n,overrun?1:0);
+	for(i=0; i<n*IMU_ACQ_SAMPLE_BYTES; i++)
+		fprintf(fil,"%02x",raw[i]);
+	fprintf(fil,"\n");
+}
+
+/*---------------------------------------------------
+Acquisition thread: fetch bursts, stamp them and push
+them to the ring, until quit or end of data.
+----------------------------------------------------*/
+static void *imu_acq_thread(void *arg)
+{
+	struct imu_acq *acq=(struct imu_acq *)arg;
+	uint8_t raw[IMU_ACQ_FIFO_DEPTH*IMU_ACQ_SAMPLE_BYTES];
+	struct imu_sample samples[IMU_ACQ_FIFO_DEPTH];
+	int64_t ts[IMU_ACQ_FIFO_DEPTH];
+	int64_t t_fetch;
+	bool overrun;
+	const uint8_t *p;
+	int poll_us;
+	int i,j,n;
+	unsigned int cnt;
+
+	//----- poll 4 times while the FIFO fills up to the watermark
+	poll_us=1000000/acq->odr*acq->wtm/4;
+	if(poll_us<IMU_ACQ_MIN_POLLUS)
+		poll_us=IMU_ACQ_MIN_POLLUS;
+
+	while( !__atomic_load_n(&acq->quit,__ATOMIC_RELAXED) )
+	{
+		overrun=false;
+		n=acq->fetch(acq->ctx, raw, IMU_ACQ_FIFO_DEPTH, &t_fetch, &overrun);
+		if(n<0)
+			break;
+		if(n==0)
+		{
+			usleep(poll_us);
+			continue;
+		}
+
+		if(acq->fdump)
+			imu_acq_dump(acq->fdump, raw, n, t_fetch, overrun);
+
+		acq->nbursts++;
+		if(overrun)
+			acq->noverruns++;
+
+		imu_acq_stamp(acq, n, t_fetch, overrun, ts);
+		for(i=0; i<n; i++)
+		{
+			p=raw+i*IMU_ACQ_SAMPLE_BYTES;
+			for(j=0; j<3; j++)
+				samples[i].xyz[j]=(int16_t)(p[2*j]|(p[2*j+1]<<8));
+			samples[i].ts_us=ts[i];
+			samples[i].sensor=acq->sensor;
+		}
+
+		if(acq->lossless)
+		{
+			while( egi_ring_wait_space(acq->ring, n, IMU_ACQ_WAITMS)==1
+				&& !__atomic_load_n(&acq->quit,__ATOMIC_RELAXED) );
+		}
+		cnt=egi_ring_push(acq->ring, samples, n);
+		acq->nsamples += cnt;
+		acq->ndropped += n-cnt;
+	}
+
+	__atomic_store_n(&acq->eof, 1, __ATOMIC_RELEASE);
+	return (void *)0;
+}
+
+/*----------------------------------------------------------
+Start the acquisition thread.
+
+ring:	ring of struct imu_sample, the thread is its producer.
+Return:
+	0    OK
+	<0   fails
+----------------------------------------------------------*/
+int imu_acq_start(struct imu_acq *acq, EGI_RING *ring)
+{
+	if(ring==NULL || ring->item_size!=sizeof(struct imu_sample))
+	{
+		fprintf(stderr,"imu_acq_start(): ring is NULL or its item_size is not of struct imu_sample!\n");
+		return -1;
+	}
+	acq->ring=ring;
+
+	if( pthread_create(&acq->thread, NULL, imu_acq_thread, acq) !=0 )
+	{
+		fprintf(stderr,"imu_acq_start(): fail to create acquisition thread!\n");
+		return -2;
+	}
+
+	return 0;
+}
+
+/*----------------------------------------------------------
+Stop the acquisition thread, and close the dump file.
+----------------------------------------------------------*/
+void imu_acq_stop(struct imu_acq *acq)
+{
+	__atomic_store_n(&acq->quit, 1, __ATOMIC_RELAXED);
+	pthread_join(acq->thread, NULL);
+
+	if(acq->fdump)
+	{
+		fclose(acq->fdump);
+		acq->fdump=NULL;
+	}
+
+	printf("	sensor %d: %lu samples in %lu bursts, %lu dropped, %lu FIFO overruns, period %.2fus\n",
+		acq->sensor, acq->nsamples, acq->nbursts, acq->ndropped, acq->noverruns, acq->period_us);
+}
+
+/*----------------------------------------------------------
+Consumer: Return true if the acquisition thread has quit
+and all its samples have been pulled from the ring.
+----------------------------------------------------------*/
+bool imu_acq_finished(struct imu_acq *acq)
+{
+	return __atomic_load_n(&acq->eof,__ATOMIC_ACQUIRE) && egi_ring_count(acq->ring)==0;
+}
+
+
+/*----------------------------------------------------------
+Record raw bursts to a dump file, call it before
+imu_acq_start().
+Return:
+	0    OK
+	<0   fails
+----------------------------------------------------------*/
+int imu_acq_record(struct imu_acq *acq, const char *path)
+{
+	acq->fdump=fopen(path,"w");
+	if(acq->fdump==NULL)
+	{
+		fprintf(stderr,"imu_acq_record(): fail to open %s!\n",path);
+		return -1;
+	}
+	fprintf(acq->fdump,"# sensor=%d odr=%.1f wtm=%d\n",acq->sensor,acq->odr,acq->wtm);
+
+	return 0;
+}
+
+/*-------------------------------------------------------------------
+Open a dump file to replay, sensor, odr and wtm are taken from
+its header, if any.
+
+realtime:  true to feed bursts at their recorded pace, or false
+	   to feed them as fast as the ring is consumed, with
+	   acq->lossless set.
+Return:
+	0    OK
+	<0   fails
+--------------------------------------------------------------------*/
+int imu_replay_open(struct imu_replay *rp, const char *path, bool realtime)
+{
+	char line[256];
+	long pos;
+
+	memset(rp,0,sizeof(struct imu_replay));
+	rp->sensor=-1;
+	rp->realtime=realtime;
+	rp->t0_clock=-1;
+
+	rp->fil=fopen(path,"r");
+	if(rp->fil==NULL)
+	{
+		fprintf(stderr,"imu_replay_open(): fail to open %s!\n",path);
+		return -1;
+	}
+
+	//----- parse header in comments before the first burst
+	for(;;)
+	{
+		pos=ftell(rp->fil);
+		if( fgets(line,sizeof(line),rp->fil)==NULL || line[0]!='#' )
+			break;
+		sscanf(line,"# sensor=%d odr=%f wtm=%d",&rp->sensor,&rp->odr,&rp->wtm);
+	}
+	fseek(rp->fil,pos,SEEK_SET);
+
+	return 0;
+}
+
+/*---------------------------------
+Close a replay dump file
+----------------------------------*/
+void imu_replay_close(struct imu_replay *rp)
+{
+	if(rp->fil)
+		fclose(rp->fil);
+	rp->fil=NULL;
+}
+
+/*-------------------------------------------------------------------
+Fetch function of a replay, ctx is struct imu_replay *.
+A burst line is parsed back to raw bytes exactly as read from the
+chip, with its recorded fetch time and overrun flag.
+Return:
+	>=0  number of samples
+	<0   end of the dump, or a bad line
+--------------------------------------------------------------------*/
+int imu_replay_fetch(void *ctx, uint8_t *raw, int max, int64_t *t_us, bool *overrun)
+{
+	struct imu_replay *rp=(struct imu_replay *)ctx;
+	char line[IMU_ACQ_FIFO_DEPTH*IMU_ACQ_SAMPLE_BYTES*2+64];
+	long long t;
+	int n,ovr,pos;
+	unsigned int byte;
+	int64_t wait;
+	int i;
+
+	do {
+		if( fgets(line,sizeof(line),rp->fil)==NULL )
+			return -1;
+	} while( line[0]=='#' || line[0]=='\n' );
+
+	if( sscanf(line,"%lld %d %d %n",&t,&n,&ovr,&pos)!=3 || n<0 || n>max )
+	{
+		fprintf(stderr,"imu_replay_fetch(): bad burst line: %s",line);
+		return -1;
+	}
+	for(i=0; i<n*IMU_ACQ_SAMPLE_BYTES; i++)
+	{
+		if( sscanf(line+pos+2*i,"%2x",&byte)!=1 )
+		{
+			fprintf(stderr,"imu_replay_fetch(): burst line is too short: %s",line);
+			return -1;
+		}
+		raw[i]=byte;
+	}
+
+	//----- pace as recorded
+	if(rp->realtime)
+	{
+		if(rp->t0_clock<0)
+		{
+			rp->t0_clock=imu_acq_clock_us();
+			rp->t0_dump=t;
+		}
+		wait=rp->t0_clock+(t-rp->t0_dump)-imu_acq_clock_us();
+		if(wait>0)
+			usleep(wait);
+	}
+
+	*t_us=t;
+	*overrun=ovr?true:false;
+
+	return n;
+}
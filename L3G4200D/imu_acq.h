@@ -0,0 +1,117 @@
+/*----------------------------------------------------------------------
+Burst acquisition of gyro/accelerometer samples from hardware FIFOs.
+
+1. An acquisition thread for each sensor polls its FIFO level, and
+   drains a burst once the watermark is reached, by a fetch function
+   such as gyro_fifo_fetch() or adxl_fifo_fetch().
+2. Samples in a burst are timestamped by interpolating backward from
+   the fetch time with the estimated sampling period, which tracks the
+   actual ODR of the chip, so timestamps are evenly spaced and monotonic
+   instead of carrying the jitter of the polling loop.
+3. Samples are pushed to an EGI_RING(wegi/utils/egi_ring.h) of struct
+   imu_sample, ONE ring for each sensor, and the Kalman filter thread
+   is the only consumer.
+4. Raw bursts may be recorded to a text dump, and imu_replay_fetch()
+   feeds a dump back as the fetch function, to test everything after
+   the bus off-board.
+
+Dump format, one burst a line, '#' for comments:
+	# sensor=0 odr=800 wtm=16
+	t_us nsamples overrun hex_bytes_of_OUT_X_L...OUT_Z_H
+
+Midas
+----------------------------  COPYLEFT  --------------------------------*/
+#ifndef __IMU_ACQ_H__
+#define __IMU_ACQ_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "egi_ring.h"
+
+#define IMU_ACQ_FIFO_DEPTH	32	//max. samples of a burst, FIFO depth of L3G4200D and ADXL345
+#define IMU_ACQ_SAMPLE_BYTES	6	//XL XH YL YH ZL ZH, little endian
+#define IMU_ACQ_MIN_POLLUS	200	//min. poll interval of the FIFO level, in us
+
+enum imu_sensor {
+	IMU_SENSOR_GYRO=0,
+	IMU_SENSOR_ACCEL=1,
+};
+
+//----- A timestamped XYZ sample in the ring -----
+struct imu_sample {
+	int64_t  ts_us;		//interpolated sampling time, in us
+	int16_t  xyz[3];	//raw XYZ
+	uint16_t sensor;	//enum imu_sensor
+};
+
+/*----------------------------------------------------------------
+Fetch function of a FIFO: read a burst of up to max samples to raw,
+and set t_us to the time when the FIFO level was read, overrun if
+samples were lost.
+Return:
+	>0  number of samples
+	0   no burst ready
+	<0  end of data(replay), the acquisition thread quits.
+------------------------------------------------------------------*/
+typedef int (*imu_fetch_t)(void *ctx, uint8_t *raw, int max, int64_t *t_us, bool *overrun);
+
+//----- Acquisition Data Base -----
+struct imu_acq {
+	int		sensor;		//enum imu_sensor
+	float		odr;		//nominal output data rate, in Hz
+	int		wtm;		//FIFO watermark level
+	imu_fetch_t	fetch;
+	void		*ctx;		//context of fetch
+	bool		lossless;	//wait for ring space instead of dropping samples, for replay
+	FILE		*fdump;		//record raw bursts to it, or NULL
+
+	EGI_RING	*ring;		//[] struct imu_sample, producer side
+
+	//----- timestamp interpolation
+	bool		synced;		//last_ts is valid
+	double		period_us;	//estimated sampling period
+	double		last_ts;	//timestamp of the last sample
+
+	//----- statistics
+	unsigned long	nsamples;	//samples pushed to the ring
+	unsigned long	nbursts;
+	unsigned long	ndropped;	//samples dropped as the ring is full
+	unsigned long	noverruns;	//FIFO overruns
+
+	pthread_t	thread;
+	int		quit;		//token to stop the thread
+	int		eof;		//fetch() returned <0, no more data
+};
+
+//----- Replay backend -----
+struct imu_replay {
+	FILE		*fil;
+	int		sensor;		//from dump header, or -1
+	float		odr;		//from dump header, or 0
+	int		wtm;		//from dump header, or 0
+	bool		realtime;	//pace bursts by their recorded time
+	int64_t		t0_dump;	//recorded time of the first burst
+	int64_t		t0_clock;	//clock time when the first burst is fed
+};
+
+
+//------------------------     FUNCTION DECLARATION     ---------------------------
+int64_t imu_acq_clock_us(void);
+
+//------ Acquisition -------
+int Init_imu_acq(struct imu_acq *acq, int sensor, float odr, int wtm, imu_fetch_t fetch, void *ctx);
+int imu_acq_stamp(struct imu_acq *acq, int n, int64_t t_fetch, bool overrun, int64_t *ts);
+int imu_acq_start(struct imu_acq *acq, EGI_RING *ring);
+void imu_acq_stop(struct imu_acq *acq);
+bool imu_acq_finished(struct imu_acq *acq);
+
+//------ Record and replay ------
+int imu_acq_record(struct imu_acq *acq, const char *path);
+int imu_replay_open(struct imu_replay *rp, const char *path, bool realtime);
+void imu_replay_close(struct imu_replay *rp);
+int imu_replay_fetch(void *ctx, uint8_t *raw, int max, int64_t *t_us, bool *overrun);
+
+
+#endif
@@ -0,0 +1,276 @@
+/*-------------------------------------------------------------------------
+Test of burst acquisition(imu_acq.c), with the Kalman filter as consumer.
+
+Samples from each source go through its own EGI_RING, and the main thread
+pulls them from all rings, feeds each axis to a kalmanN3M1 filter,
+integrates gyro rates by sample timestamps, and checks that timestamps
+are monotonic and evenly spaced.
+
+Sources:
+  -g		hardware FIFO, L3G4200D at 800Hz, or ADXL345 at 800Hz when
+		built with -DIMU_ACQ_ADXL345.
+  -r dump	replay a dump, as fast as possible, or at recorded pace with -t.
+		Up to 2 dumps, e.g. one for gyro and one for accel.
+Options:
+  -w wtm	FIFO watermark level for -g, default 16.
+  -d dump	record bursts of -g to a dump file.
+  -s secs	seconds to run for -g, default 10.
+
+Usage:	imu_acq_test -g [-w wtm] [-d dump] [-s secs]
+	imu_acq_test -r dump [-r dump] [-t]
+
+Midas
+---------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <getopt.h>
+#include "imu_acq.h"
+#include "kalman_fixdim.h"
+#ifdef IMU_ACQ_ADXL345
+#include "i2c_adxl345.h"
+#else
+#include "gyro_l3g4200d.h"
+#endif
+
+#define TEST_MAX_SOURCES	2
+#define TEST_RING_CAPACITY	1024	/* samples, 1.28s at 800Hz */
+#define TEST_ODR		800
+#define GYRO_DPS_LSB		0.070	/* for +-2000dps full scale */
+
+struct test_source {
+	struct imu_acq		acq;
+	struct imu_replay	replay;
+	EGI_RING		*ring;
+	struct kalmanN3M1DB	kdb[3];
+
+	/* timestamp check */
+	unsigned long		nsamples;
+	unsigned long		nbackward;	/* ts not increasing */
+	int64_t			last_ts;
+	double			sum_dt, sum_dt2;
+	double			fangXYZ[3];	/* integral of gyro rates, degree */
+};
+
+static struct test_source sources[TEST_MAX_SOURCES];
+static int nsources;
+
+
+/*----------------------------------------------------------
+Kalman filter of each axis: state (value, 1st and 2nd order
+differences per sample), observe the value, in LSB.
+----------------------------------------------------------*/
+static void init_kalman(struct kalmanN3M1DB *kdb)
+{
+	const float Y[3]={ 0, 0, 0 };
+	const float F[3*3]={ 1, 1, 0.5,
+			     0, 1, 1,
+			     0, 0, 1 };
+	const float P[3*3]={ 100, 0, 0,
+			     0, 100, 0,
+			     0, 0, 100 };
+	const float H[3]={ 1, 0, 0 };
+	const float Q[3*3]={ 1, 0, 0,
+			     0, 0.1, 0,
+			     0, 0, 0.01 };
+
+	Init_kalmanN3M1_FilterDB(kdb, Y, F, P, H, Q, 100);
+}
+
+/* Consume a sample */
+static void consume_sample(struct test_source *src, const struct imu_sample *s)
+{
+	double dt;
+	int i;
+
+	for(i=0; i<3; i++)
+		kalmanN3M1_Filter(&src->kdb[i], KF_FROM_FLOAT(s->xyz[i]));
+
+	if(src->nsamples>0)
+	{
+		if(s->ts_us <= src->last_ts)
+			src->nbackward++;
+		dt=s->ts_us-src->last_ts;
+		src->sum_dt += dt;
+		src->sum_dt2 += dt*dt;
+
+		if(s->sensor==IMU_SENSOR_GYRO)
+		{
+			for(i=0; i<3; i++)
+				src->fangXYZ[i] += GYRO_DPS_LSB*KF_TO_FLOAT(src->kdb[i].Y[0])*dt/1000000.0;
+		}
+	}
+	src->last_ts=s->ts_us;
+	src->nsamples++;
+}
+
+/* Print timestamp statistics of a source */
+static void print_source(struct test_source *src)
+{
+	unsigned long n=src->nsamples>1 ? src->nsamples-1 : 1;
+	double mean=src->sum_dt/n;
+	double jitter=sqrt(fabs(src->sum_dt2/n-mean*mean));
+
+	printf("sensor %d: %lu samples, dt mean %.2fus, jitter %.2fus, %lu not increasing, ",
+		src->acq.sensor, src->nsamples, mean, jitter, src->nbackward);
+	if(src->acq.sensor==IMU_SENSOR_GYRO)
+		printf("angle X %.2f Y %.2f Z %.2f\n", src->fangXYZ[0], src->fangXYZ[1], src->fangXYZ[2]);
+	else
+		printf("filtered X %.1f Y %.1f Z %.1f\n", KF_TO_FLOAT(src->kdb[0].Y[0]),
+			KF_TO_FLOAT(src->kdb[1].Y[0]), KF_TO_FLOAT(src->kdb[2].Y[0]));
+}
+
+/*---------------------------------------------
+Open a replay source
+----------------------------------------------*/
+static int open_replay(struct test_source *src, const char *path, bool realtime)
+{
+	struct imu_replay *rp=&src->replay;
+
+	if( imu_replay_open(rp, path, realtime)<0 )
+		return -1;
+	if( Init_imu_acq(&src->acq, rp->sensor<0 ? IMU_SENSOR_GYRO : rp->sensor,
+			 rp->odr>0 ? rp->odr : TEST_ODR, rp->wtm>0 ? rp->wtm : 16,
+			 imu_replay_fetch, rp)<0 )
+		return -2;
+	src->acq.lossless=true;
+
+	return 0;
+}
+
+/*---------------------------------------------
+Open the hardware FIFO
+----------------------------------------------*/
+static int open_hardware(struct test_source *src, int wtm, const char *dump)
+{
+#ifdef IMU_ACQ_ADXL345
+	if( Init_ADXL345(ADXL_DR800_BW400,ADXL_RANGE_4G) !=0 || adxl_fifo_start(wtm)<0 )
+		return -1;
+	if( Init_imu_acq(&src->acq, IMU_SENSOR_ACCEL, TEST_ODR, wtm, adxl_fifo_fetch, NULL)<0 )
+		return -2;
+#else
+	if( Init_L3G4200D(L3G_DR800_BW35) !=0 || gyro_fifo_start(wtm)<0 )
+		return -1;
+	if( Init_imu_acq(&src->acq, IMU_SENSOR_GYRO, TEST_ODR, wtm, gyro_fifo_fetch, NULL)<0 )
+		return -2;
+#endif
+	if(dump!=NULL && imu_acq_record(&src->acq, dump)<0 )
+		return -3;
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	const char *dump=NULL;
+	bool hardware=false;
+	bool realtime=false;
+	int wtm=16;
+	int secs=10;
+	int64_t t_end;
+	const struct imu_sample *s;
+	unsigned int cnt;
+	int i,k,opt;
+	int nfinished;
+
+	while( (opt=getopt(argc,argv,"gr:tw:d:s:")) !=-1 )
+	{
+		switch(opt)
+		{
+			case 'g':
+				hardware=true;
+				break;
+			case 'r':
+				if(nsources==TEST_MAX_SOURCES)
+					break;
+				if( open_replay(&sources[nsources], optarg, realtime)<0 )
+					exit(1);
+				nsources++;
+				break;
+			case 't':
+				realtime=true;
+				for(i=0; i<nsources; i++)
+					sources[i].replay.realtime=true;
+				break;
+			case 'w':
+				wtm=atoi(optarg);
+				break;
+			case 'd':
+				dump=optarg;
+				break;
+			case 's':
+				secs=atoi(optarg);
+				break;
+			default:
+				printf("Usage: %s -g [-w wtm] [-d dump] [-s secs]\n", argv[0]);
+				printf("       %s -r dump [-r dump] [-t]\n", argv[0]);
+				exit(1);
+		}
+	}
+
+	if(hardware && nsources<TEST_MAX_SOURCES)
+	{
+		if( open_hardware(&sources[nsources], wtm, dump)<0 )
+			exit(2);
+		nsources++;
+	}
+	if(nsources==0)
+	{
+		printf("No source, use -g or -r dump!\n");
+		exit(1);
+	}
+
+	//----- start acquisition
+	for(i=0; i<nsources; i++)
+	{
+		sources[i].ring=egi_ring_create(TEST_RING_CAPACITY, sizeof(struct imu_sample));
+		for(k=0; k<3; k++)
+			init_kalman(&sources[i].kdb[k]);
+		if( sources[i].ring==NULL || imu_acq_start(&sources[i].acq, sources[i].ring)<0 )
+			exit(3);
+	}
+
+	//----- Kalman filter: consume all rings, until time out or all replays end
+	t_end=imu_acq_clock_us()+(int64_t)secs*1000000;
+	do {
+		nfinished=0;
+		for(i=0; i<nsources; i++)
+		{
+			if( imu_acq_finished(&sources[i].acq) )
+			{
+				nfinished++;
+				continue;
+			}
+			if( egi_ring_wait_data(sources[i].ring, 1, 10) !=0 )
+				continue;
+
+			cnt=TEST_RING_CAPACITY;
+			s=egi_ring_peek(sources[i].ring, &cnt);
+			for(k=0; k<cnt; k++)
+				consume_sample(&sources[i], s+k);
+			egi_ring_release(sources[i].ring, cnt);
+		}
+	} while( nfinished<nsources && (!hardware || imu_acq_clock_us()<t_end) );
+
+	//----- stop and print results
+	for(i=0; i<nsources; i++)
+	{
+		imu_acq_stop(&sources[i].acq);
+		print_source(&sources[i]);
+		if(sources[i].acq.fetch==imu_replay_fetch)
+			imu_replay_close(&sources[i].replay);
+		egi_ring_free(&sources[i].ring);
+	}
+
+#ifdef IMU_ACQ_ADXL345
+	if(hardware)
+		adxl_fifo_stop();
+#else
+	if(hardware)
+		gyro_fifo_stop();
+#endif
+
+	return 0;
+}
@@ -0,0 +1,396 @@
+/*-------------------------------------------------------------------------
+Benchmark of fixed dimension Kalman filters (kalman_fixdim.c) against
+float_KalmanFilter() with float_Matrix.
+
+1. N3M1: distance readings in s.dat, same model as kalman_N3M1_test.c
+2. N3M3: (s,v,a) readings in matrixS.h, same model as kalman_N3M3_test.c
+3. N2M2: (s,v) readings in matrixS.h
+
+For each filter, print updates/sec of both paths, and max. error of the
+state var. against float_KalmanFilter().
+Build with -DKALMAN_FIXED(and -DKALMAN_QBITS=15) to test fixed point kernels,
+in which distance s is divided by BENCH_SCALE to fit the range of Q16/Q15,
+and the model is scaled accordingly. v and a are not scaled, so as to keep
+resolution of their covariances.
+
+Usage:	kalman_bench [s.dat] [loops]
+
+Midas
+---------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/time.h>
+#include "mathwork.h"
+#include "filters.h"
+#include "kalman_fixdim.h"
+#include "matrixS.h"	/* float MatS[3*100], (s,v,a) readings */
+
+#define BENCH_MAXN	1024	/* Max. readings from s.dat */
+
+#ifdef KALMAN_FIXED
+#define BENCH_SCALE	8.0	/* Distance s is divided by it */
+#else
+#define BENCH_SCALE	1.0
+#endif
+
+static const float scale3[3]={ BENCH_SCALE, 1.0, 1.0 };	/* for (s,v,a) */
+static const float scale1[1]={ 1.0 };				/* for column of a vector */
+
+static float dats[BENCH_MAXN];	/* readings from s.dat */
+static int   nsdat;
+
+static float refY[BENCH_MAXN*3];	/* state var. by float_KalmanFilter() */
+static float newY[BENCH_MAXN*3];	/* state var. by kalman_fixdim */
+
+
+static double tm_diffs(struct timeval t_start, struct timeval t_end)
+{
+	return (t_end.tv_sec-t_start.tv_sec)+(t_end.tv_usec-t_start.tv_usec)/1000000.0;
+}
+
+/*-------------------------------------------
+Load readings from a text file, separated by
+',' or spaces.
+Return:
+	>0	Number of readings
+	<0	Fails
+--------------------------------------------*/
+static int load_sdat(const char *fpath)
+{
+	FILE *fp;
+	int n=0;
+	int c;
+
+	fp=fopen(fpath,"r");
+	if(fp==NULL) {
+		fprintf(stderr,"Fail to open %s!\n", fpath);
+		return -1;
+	}
+
+	while( n<BENCH_MAXN ) {
+		if( fscanf(fp,"%f",&dats[n])==1 ) {
+			n++;
+			continue;
+		}
+		/* skip a separator */
+		c=fgetc(fp);
+		if(c==EOF)
+			break;
+	}
+	fclose(fp);
+
+	return n;
+}
+
+/*-----------------------------------------------------------------
+Scale a [nr x nc] matrix as var. of rows are divided by rsc[], and
+var. of columns are divided by csc[].
+
+tp:	0  for a covariance:	dest[i][j]=src[i][j]/(rsc[i]*csc[j])
+	1  for a transformation: dest[i][j]=src[i][j]*csc[j]/rsc[i]
+------------------------------------------------------------------*/
+static void scale_matrix(float *dest, const float *src, int nr, int nc,
+				const float *rsc, const float *csc, int tp)
+{
+	int i,j;
+
+	for(i=0; i<nr; i++) {
+		for(j=0; j<nc; j++) {
+			if(tp)
+				dest[i*nc+j]=src[i*nc+j]*csc[j]/rsc[i];
+			else
+				dest[i*nc+j]=src[i*nc+j]/(rsc[i]*csc[j]);
+		}
+	}
+}
+
+/*-------------------------------------------
+Print result of a filter test.
+ndat:	number of readings.
+n:	state dimension.
+-------------------------------------------*/
+static void print_result(const char *name, int ndat, int n, int loops, double tref, double tnew)
+{
+	int i,k;
+	float err[3]={0};
+	float range[3]={0};
+
+	for(k=0; k<ndat; k++) {
+		for(i=0; i<n; i++) {
+			if( fabs(newY[k*n+i]-refY[k*n+i]) > err[i] )
+				err[i]=fabs(newY[k*n+i]-refY[k*n+i]);
+			if( fabs(refY[k*n+i]) > range[i] )
+				range[i]=fabs(refY[k*n+i]);
+		}
+	}
+
+	printf("%s: %d updates\n", name, ndat*loops);
+	printf("	float_KalmanFilter:	%.0f updates/s\n", ndat*loops/tref);
+	printf("	kalman_fixdim:		%.0f updates/s, x%.1f\n", ndat*loops/tnew, tref/tnew);
+	for(i=0; i<n; i++)
+		printf("	Y[%d] max. error: %g (%.2e of max. |Y[%d]| %g)\n",
+				i, err[i], range[i]>0 ? err[i]/range[i] : 0.0, i, range[i]);
+}
+
+
+/*-----------------------------------------------------
+N3M1, same model as kalman_N3M1_test.c
+------------------------------------------------------*/
+static void bench_N3M1(int loops)
+{
+	float MatY[3]={900,0,0};
+	float MatF[3*3]={ 1,1,0, 0,1,1, 0,0,1 };
+	float MatH[1*3]={ 1,0,0 };
+	float MatQ[3*3]={ 0,0,0, 0,0,0, 0,0,20 };
+	float MatR[1*1]={ 16.0 };
+	float MatP[3*3]={ 30,0,0, 0,10,0, 0,0,10 };
+	float sY[3], sF[9], sH[3], sQ[9], sR[1], sP[9];
+	struct float_Matrix *pMat_Y, *pMat_F, *pMat_H, *pMat_Q, *pMat_R, *pMat_P, *pMat_S;
+	struct floatKalmanDB *fdb;
+	struct kalmanN3M1DB kdb;
+	struct timeval tm_start, tm_end;
+	double tref, tnew;
+	int i,k,j;
+
+	/* 1. float_KalmanFilter() */
+	pMat_Y=init_float_Matrix(3,1);
+	pMat_F=init_float_Matrix(3,3);	Matrix_FillArray(pMat_F,MatF);
+	pMat_H=init_float_Matrix(1,3);	Matrix_FillArray(pMat_H,MatH);
+	pMat_Q=init_float_Matrix(3,3);	Matrix_FillArray(pMat_Q,MatQ);
+	pMat_R=init_float_Matrix(1,1);	Matrix_FillArray(pMat_R,MatR);
+	pMat_P=init_float_Matrix(3,3);
+	pMat_S=init_float_Matrix(1,1);
+	fdb=Init_floatKalman_FilterDB(3, 1, pMat_Y, pMat_F, pMat_P, pMat_H, pMat_Q, pMat_R);
+	if(fdb==NULL)
+		exit(-1);
+
+	gettimeofday(&tm_start,NULL);
+	for(i=0; i<loops; i++) {
+		Matrix_FillArray(pMat_Y,MatY);
+		Matrix_FillArray(pMat_P,MatP);
+		for(k=0; k<nsdat; k++) {
+			pMat_S->pmat[0]=dats[k];
+			float_KalmanFilter(fdb, pMat_S);
+			if(i==loops-1)
+				memcpy(refY+k*3, pMat_Y->pmat, 3*sizeof(float));
+		}
+	}
+	gettimeofday(&tm_end,NULL);
+	tref=tm_diffs(tm_start,tm_end);
+
+	/* 2. kalmanN3M1_Filter() */
+	scale_matrix(sY,MatY,3,1,scale3,scale1,0);
+	scale_matrix(sF,MatF,3,3,scale3,scale3,1);
+	scale_matrix(sH,MatH,1,3,scale3,scale3,1);  /* observation s */
+	scale_matrix(sQ,MatQ,3,3,scale3,scale3,0);
+	scale_matrix(sR,MatR,1,1,scale3,scale3,0);
+	scale_matrix(sP,MatP,3,3,scale3,scale3,0);
+	gettimeofday(&tm_start,NULL);
+	for(i=0; i<loops; i++) {
+		Init_kalmanN3M1_FilterDB(&kdb, sY, sF, sP, sH, sQ, sR[0]);
+		for(k=0; k<nsdat; k++) {
+			kalmanN3M1_Filter(&kdb, KF_FROM_FLOAT(dats[k]/scale3[0]));
+			if(i==loops-1) {
+				for(j=0; j<3; j++)
+					newY[k*3+j]=KF_TO_FLOAT(kdb.Y[j])*scale3[j];
+			}
+		}
+	}
+	gettimeofday(&tm_end,NULL);
+	tnew=tm_diffs(tm_start,tm_end);
+
+	print_result("N3M1 (s.dat)", nsdat, 3, loops, tref, tnew);
+
+	Release_floatKalman_FilterDB(fdb);
+	release_float_Matrix(pMat_Y); release_float_Matrix(pMat_F); release_float_Matrix(pMat_H);
+	release_float_Matrix(pMat_Q); release_float_Matrix(pMat_R); release_float_Matrix(pMat_P);
+	release_float_Matrix(pMat_S);
+}
+
+
+/*-----------------------------------------------------
+N3M3, same model as kalman_N3M3_test.c
+------------------------------------------------------*/
+static void bench_N3M3(int loops)
+{
+	float MatY[3]={900,0,0};
+	float MatF[3*3]={ 1,1,0, 0,1,1, 0,0,1 };
+	float MatH[3*3]={ 1,0,0, 0,1,0, 0,0,1 };
+	float MatQ[3*3]={ 1,0,0, 0,0,0, 0,0,0 };
+	float MatR[3*3]={ 5,0,0, 0,2,0, 0,0,1 };
+	float MatP[3*3]={ 30,0,0, 0,20,0, 0,0,10 };
+	float sY[3], sF[9], sH[9], sQ[9], sR[9], sP[9];
+	kf_t S[3];
+	struct float_Matrix *pMat_Y, *pMat_F, *pMat_H, *pMat_Q, *pMat_R, *pMat_P, *pMat_S;
+	struct floatKalmanDB *fdb;
+	struct kalmanN3M3DB kdb;
+	struct timeval tm_start, tm_end;
+	double tref, tnew;
+	int i,k,j;
+
+	/* 1. float_KalmanFilter() */
+	pMat_Y=init_float_Matrix(3,1);
+	pMat_F=init_float_Matrix(3,3);	Matrix_FillArray(pMat_F,MatF);
+	pMat_H=init_float_Matrix(3,3);	Matrix_FillArray(pMat_H,MatH);
+	pMat_Q=init_float_Matrix(3,3);	Matrix_FillArray(pMat_Q,MatQ);
+	pMat_R=init_float_Matrix(3,3);	Matrix_FillArray(pMat_R,MatR);
+	pMat_P=init_float_Matrix(3,3);
+	pMat_S=init_float_Matrix(3,1);
+	fdb=Init_floatKalman_FilterDB(3, 3, pMat_Y, pMat_F, pMat_P, pMat_H, pMat_Q, pMat_R);
+	if(fdb==NULL)
+		exit(-1);
+
+	gettimeofday(&tm_start,NULL);
+	for(i=0; i<loops; i++) {
+		Matrix_FillArray(pMat_Y,MatY);
+		Matrix_FillArray(pMat_P,MatP);
+		for(k=0; k<100; k++) {
+			Matrix_FillArray(pMat_S,MatS+k*3);
+			float_KalmanFilter(fdb, pMat_S);
+			if(i==loops-1)
+				memcpy(refY+k*3, pMat_Y->pmat, 3*sizeof(float));
+		}
+	}
+	gettimeofday(&tm_end,NULL);
+	tref=tm_diffs(tm_start,tm_end);
+
+	/* 2. kalmanN3M3_Filter() */
+	scale_matrix(sY,MatY,3,1,scale3,scale1,0);
+	scale_matrix(sF,MatF,3,3,scale3,scale3,1);
+	scale_matrix(sH,MatH,3,3,scale3,scale3,1);
+	scale_matrix(sQ,MatQ,3,3,scale3,scale3,0);
+	scale_matrix(sR,MatR,3,3,scale3,scale3,0);
+	scale_matrix(sP,MatP,3,3,scale3,scale3,0);
+	gettimeofday(&tm_start,NULL);
+	for(i=0; i<loops; i++) {
+		Init_kalmanN3M3_FilterDB(&kdb, sY, sF, sP, sH, sQ, sR);
+		for(k=0; k<100; k++) {
+			for(j=0; j<3; j++)
+				S[j]=KF_FROM_FLOAT(MatS[k*3+j]/scale3[j]);
+			kalmanN3M3_Filter(&kdb, S);
+			if(i==loops-1) {
+				for(j=0; j<3; j++)
+					newY[k*3+j]=KF_TO_FLOAT(kdb.Y[j])*scale3[j];
+			}
+		}
+	}
+	gettimeofday(&tm_end,NULL);
+	tnew=tm_diffs(tm_start,tm_end);
+
+	print_result("N3M3 (matrixS.h)", 100, 3, loops, tref, tnew);
+
+	Release_floatKalman_FilterDB(fdb);
+	release_float_Matrix(pMat_Y); release_float_Matrix(pMat_F); release_float_Matrix(pMat_H);
+	release_float_Matrix(pMat_Q); release_float_Matrix(pMat_R); release_float_Matrix(pMat_P);
+	release_float_Matrix(pMat_S);
+}
+
+
+/*-----------------------------------------------------
+N2M2, (s,v) in matrixS.h
+------------------------------------------------------*/
+static void bench_N2M2(int loops)
+{
+	float MatY[2]={900,0};
+	float MatF[2*2]={ 1,1, 0,1 };
+	float MatH[2*2]={ 1,0, 0,1 };
+	float MatQ[2*2]={ 1,0, 0,20 };
+	float MatR[2*2]={ 16,0, 0,10000 };
+	float MatP[2*2]={ 30,0, 0,20 };
+	float sY[2], sF[4], sH[4], sQ[4], sR[4], sP[4];
+	kf_t S[2];
+	struct float_Matrix *pMat_Y, *pMat_F, *pMat_H, *pMat_Q, *pMat_R, *pMat_P, *pMat_S;
+	struct floatKalmanDB *fdb;
+	struct kalmanN2M2DB kdb;
+	struct timeval tm_start, tm_end;
+	double tref, tnew;
+	int i,k;
+
+	/* 1. float_KalmanFilter() */
+	pMat_Y=init_float_Matrix(2,1);
+	pMat_F=init_float_Matrix(2,2);	Matrix_FillArray(pMat_F,MatF);
+	pMat_H=init_float_Matrix(2,2);	Matrix_FillArray(pMat_H,MatH);
+	pMat_Q=init_float_Matrix(2,2);	Matrix_FillArray(pMat_Q,MatQ);
+	pMat_R=init_float_Matrix(2,2);	Matrix_FillArray(pMat_R,MatR);
+	pMat_P=init_float_Matrix(2,2);
+	pMat_S=init_float_Matrix(2,1);
+	fdb=Init_floatKalman_FilterDB(2, 2, pMat_Y, pMat_F, pMat_P, pMat_H, pMat_Q, pMat_R);
+	if(fdb==NULL)
+		exit(-1);
+
+	gettimeofday(&tm_start,NULL);
+	for(i=0; i<loops; i++) {
+		Matrix_FillArray(pMat_Y,MatY);
+		Matrix_FillArray(pMat_P,MatP);
+		for(k=0; k<100; k++) {
+			pMat_S->pmat[0]=MatS[k*3];
+			pMat_S->pmat[1]=MatS[k*3+1];
+			float_KalmanFilter(fdb, pMat_S);
+			if(i==loops-1)
+				memcpy(refY+k*2, pMat_Y->pmat, 2*sizeof(float));
+		}
+	}
+	gettimeofday(&tm_end,NULL);
+	tref=tm_diffs(tm_start,tm_end);
+
+	/* 2. kalmanN2M2_Filter() */
+	scale_matrix(sY,MatY,2,1,scale3,scale1,0);
+	scale_matrix(sF,MatF,2,2,scale3,scale3,1);
+	scale_matrix(sH,MatH,2,2,scale3,scale3,1);
+	scale_matrix(sQ,MatQ,2,2,scale3,scale3,0);
+	scale_matrix(sR,MatR,2,2,scale3,scale3,0);
+	scale_matrix(sP,MatP,2,2,scale3,scale3,0);
+	gettimeofday(&tm_start,NULL);
+	for(i=0; i<loops; i++) {
+		Init_kalmanN2M2_FilterDB(&kdb, sY, sF, sP, sH, sQ, sR);
+		for(k=0; k<100; k++) {
+			S[0]=KF_FROM_FLOAT(MatS[k*3]/scale3[0]);
+			S[1]=KF_FROM_FLOAT(MatS[k*3+1]/scale3[1]);
+			kalmanN2M2_Filter(&kdb, S);
+			if(i==loops-1) {
+				newY[k*2]=KF_TO_FLOAT(kdb.Y[0])*scale3[0];
+				newY[k*2+1]=KF_TO_FLOAT(kdb.Y[1])*scale3[1];
+			}
+		}
+	}
+	gettimeofday(&tm_end,NULL);
+	tnew=tm_diffs(tm_start,tm_end);
+
+	print_result("N2M2 (matrixS.h)", 100, 2, loops, tref, tnew);
+
+	Release_floatKalman_FilterDB(fdb);
+	release_float_Matrix(pMat_Y); release_float_Matrix(pMat_F); release_float_Matrix(pMat_H);
+	release_float_Matrix(pMat_Q); release_float_Matrix(pMat_R); release_float_Matrix(pMat_P);
+	release_float_Matrix(pMat_S);
+}
+
+
+int main(int argc, char **argv)
+{
+	const char *fpath="s.dat";
+	int loops=1000;
+
+	if(argc>1)
+		fpath=argv[1];
+	if(argc>2)
+		loops=atoi(argv[2]);
+	if(loops<1)
+		loops=1;
+
+	nsdat=load_sdat(fpath);
+	if(nsdat<1)
+		return -1;
+
+#ifdef KALMAN_FIXED
+	printf("kalman_fixdim: fixed point Q%d, distance scaled by 1/%g\n", KALMAN_QBITS, BENCH_SCALE);
+#else
+	printf("kalman_fixdim: float\n");
+#endif
+
+	bench_N3M1(loops);
+	bench_N3M3(loops);
+	bench_N2M2(loops);
+
+	return 0;
+}
@@ -0,0 +1,487 @@
+/*----------------------------------------------------------------------
+Kalman filters with fixed small dimensions, see kalman_fixdim.h.
+
+Midas
+----------------------------  COPYLEFT  --------------------------------*/
+#include <stdio.h>
+#include "kalman_fixdim.h"
+
+
+#ifdef KALMAN_FIXED
+/* Sum of products, with 2*QBITS fraction bits */
+typedef int64_t kf_acc_t;
+#define KF_MUL(a,b)	((kf_acc_t)(a)*(b))
+#define KF_OUT(acc)	((kf_t)( ((acc)+((kf_acc_t)1<<(KALMAN_QBITS-1))) >> KALMAN_QBITS ))
+
+/* Number of significant bits of an uint64_t */
+#define KF_BITLEN(x)	( (x)==0 ? 0 : 64-__builtin_clzll(x) )
+
+/*-----------------------------------------------------------
+n*2^sh/d, rounded, and limited to range of kf_t.
+Both n and d are normalized before dividing, so precision is
+kept for a wide range of n, d and sh, without int64 overflow.
+-----------------------------------------------------------*/
+static kf_t kf_divshift(int64_t n, int64_t d, int sh)
+{
+	uint64_t un= n<0 ? -(uint64_t)n : n;
+	uint64_t ud= d<0 ? -(uint64_t)d : d;
+	uint64_t q;
+	int k;
+
+	if(un==0)
+		return 0;
+
+	/* Shift n left, or d right for sh>0, and d left, or n right for sh<0 */
+	if(sh>0) {
+		k=62-KF_BITLEN(un);
+		if(k>sh) k=sh;
+		un <<= k;
+		sh -= k;
+		ud >>= sh;
+	}
+	else if(sh<0) {
+		k=62-KF_BITLEN(ud);
+		if(k>-sh) k=-sh;
+		ud <<= k;
+		sh += k;
+		un >>= -sh;
+	}
+
+	if( ud==0 || (q=(un+ud/2)/ud) > INT32_MAX )
+		q=INT32_MAX;
+
+	return ( (n<0) != (d<0) ) ? -(kf_t)q : (kf_t)q;
+}
+
+/* a/d, where a is kf_t and d is a sum of products(kf_acc_t) */
+#define kf_div(a,d)	kf_divshift((a), (d), 2*KALMAN_QBITS)
+
+/*-----------------------------------------------------------
+Normalize elements of a matrix for inverse, so the max. one
+is of bits significant bits.
+Return:
+	sh:	An=A*2^(-sh)
+-----------------------------------------------------------*/
+static int kf_normalize(const kf_t *A, int64_t *An, int n, int bits)
+{
+	uint32_t m=0;
+	uint32_t u;
+	int i, sh;
+
+	for(i=0; i<n; i++) {
+		u= A[i]<0 ? -(uint32_t)A[i] : A[i];
+		if(u>m) m=u;
+	}
+
+	sh=KF_BITLEN((uint64_t)m)-bits;
+	for(i=0; i<n; i++)
+		An[i]= sh>=0 ? (int64_t)A[i]>>sh : (int64_t)A[i]*((int64_t)1<<(-sh));
+
+	return sh;
+}
+
+#else
+typedef float kf_acc_t;
+#define KF_MUL(a,b)	((a)*(b))
+#define KF_OUT(acc)	(acc)
+#define kf_div(a,d)	((a)/(d))
+#endif
+
+
+/*------------------------------------------------------------
+	<<<<<<<<<<<    2X2  Matrix Kernels    >>>>>>>>>>>
+All matrix data is stored from row to column, C may NOT be the
+same as A or B.
+------------------------------------------------------------*/
+//----- C=A*B -----
+void kf_Mat2X2_Multiply(const kf_t *A, const kf_t *B, kf_t *C)
+{
+	C[0]=KF_OUT( KF_MUL(A[0],B[0]) + KF_MUL(A[1],B[2]) );
+	C[1]=KF_OUT( KF_MUL(A[0],B[1]) + KF_MUL(A[1],B[3]) );
+	C[2]=KF_OUT( KF_MUL(A[2],B[0]) + KF_MUL(A[3],B[2]) );
+	C[3]=KF_OUT( KF_MUL(A[2],B[1]) + KF_MUL(A[3],B[3]) );
+}
+
+//----- C=A*B' -----
+void kf_Mat2X2_MultiplyTp(const kf_t *A, const kf_t *B, kf_t *C)
+{
+	C[0]=KF_OUT( KF_MUL(A[0],B[0]) + KF_MUL(A[1],B[1]) );
+	C[1]=KF_OUT( KF_MUL(A[0],B[2]) + KF_MUL(A[1],B[3]) );
+	C[2]=KF_OUT( KF_MUL(A[2],B[0]) + KF_MUL(A[3],B[1]) );
+	C[3]=KF_OUT( KF_MUL(A[2],B[2]) + KF_MUL(A[3],B[3]) );
+}
+
+//----- y=A*x, x,y: [2x1] -----
+void kf_Mat2X2_MultVector(const kf_t *A, const kf_t *x, kf_t *y)
+{
+	y[0]=KF_OUT( KF_MUL(A[0],x[0]) + KF_MUL(A[1],x[1]) );
+	y[1]=KF_OUT( KF_MUL(A[2],x[0]) + KF_MUL(A[3],x[1]) );
+}
+
+/*-----------------------------------------
+C=inv(A)
+Return:
+	0	OK
+	<0	A is singular, C is not changed.
+-----------------------------------------*/
+int kf_Mat2X2_Inverse(const kf_t *A, kf_t *C)
+{
+#ifdef KALMAN_FIXED
+	/* Normalized to 30bits, so det is exact in int64_t, and inv(A)=adj(An)/det(An)*2^(2*QBITS-sh) */
+	int64_t An[4];
+	int64_t det;
+	int sh;
+
+	sh=kf_normalize(A, An, 4, 30);
+	det=An[0]*An[3] - An[1]*An[2];
+	if(det==0)
+		return -1;
+
+	sh=2*KALMAN_QBITS-sh;
+	C[0]=kf_divshift(An[3],det,sh);
+	C[1]=kf_divshift(-An[1],det,sh);
+	C[2]=kf_divshift(-An[2],det,sh);
+	C[3]=kf_divshift(An[0],det,sh);
+
+#else
+	float det;
+
+	det=A[0]*A[3] - A[1]*A[2];
+	if(det==0)
+		return -1;
+
+	C[0]=A[3]/det;
+	C[1]=-A[1]/det;
+	C[2]=-A[2]/det;
+	C[3]=A[0]/det;
+#endif
+
+	return 0;
+}
+
+
+/*------------------------------------------------------------
+	<<<<<<<<<<<    3X3  Matrix Kernels    >>>>>>>>>>>
+------------------------------------------------------------*/
+//----- C=A*B -----
+void kf_Mat3X3_Multiply(const kf_t *A, const kf_t *B, kf_t *C)
+{
+	C[0]=KF_OUT( KF_MUL(A[0],B[0]) + KF_MUL(A[1],B[3]) + KF_MUL(A[2],B[6]) );
+	C[1]=KF_OUT( KF_MUL(A[0],B[1]) + KF_MUL(A[1],B[4]) + KF_MUL(A[2],B[7]) );
+	C[2]=KF_OUT( KF_MUL(A[0],B[2]) + KF_MUL(A[1],B[5]) + KF_MUL(A[2],B[8]) );
+	C[3]=KF_OUT( KF_MUL(A[3],B[0]) + KF_MUL(A[4],B[3]) + KF_MUL(A[5],B[6]) );
+	C[4]=KF_OUT( KF_MUL(A[3],B[1]) + KF_MUL(A[4],B[4]) + KF_MUL(A[5],B[7]) );
+	C[5]=KF_OUT( KF_MUL(A[3],B[2]) + KF_MUL(A[4],B[5]) + KF_MUL(A[5],B[8]) );
+	C[6]=KF_OUT( KF_MUL(A[6],B[0]) + KF_MUL(A[7],B[3]) + KF_MUL(A[8],B[6]) );
+	C[7]=KF_OUT( KF_MUL(A[6],B[1]) + KF_MUL(A[7],B[4]) + KF_MUL(A[8],B[7]) );
+	C[8]=KF_OUT( KF_MUL(A[6],B[2]) + KF_MUL(A[7],B[5]) + KF_MUL(A[8],B[8]) );
+}
+
+//----- C=A*B' -----
+void kf_Mat3X3_MultiplyTp(const kf_t *A, const kf_t *B, kf_t *C)
+{
+	C[0]=KF_OUT( KF_MUL(A[0],B[0]) + KF_MUL(A[1],B[1]) + KF_MUL(A[2],B[2]) );
+	C[1]=KF_OUT( KF_MUL(A[0],B[3]) + KF_MUL(A[1],B[4]) + KF_MUL(A[2],B[5]) );
+	C[2]=KF_OUT( KF_MUL(A[0],B[6]) + KF_MUL(A[1],B[7]) + KF_MUL(A[2],B[8]) );
+	C[3]=KF_OUT( KF_MUL(A[3],B[0]) + KF_MUL(A[4],B[1]) + KF_MUL(A[5],B[2]) );
+	C[4]=KF_OUT( KF_MUL(A[3],B[3]) + KF_MUL(A[4],B[4]) + KF_MUL(A[5],B[5]) );
+	C[5]=KF_OUT( KF_MUL(A[3],B[6]) + KF_MUL(A[4],B[7]) + KF_MUL(A[5],B[8]) );
+	C[6]=KF_OUT( KF_MUL(A[6],B[0]) + KF_MUL(A[7],B[1]) + KF_MUL(A[8],B[2]) );
+	C[7]=KF_OUT( KF_MUL(A[6],B[3]) + KF_MUL(A[7],B[4]) + KF_MUL(A[8],B[5]) );
+	C[8]=KF_OUT( KF_MUL(A[6],B[6]) + KF_MUL(A[7],B[7]) + KF_MUL(A[8],B[8]) );
+}
+
+//----- C=A' -----
+void kf_Mat3X3_Transpose(const kf_t *A, kf_t *C)
+{
+	C[0]=A[0]; C[1]=A[3]; C[2]=A[6];
+	C[3]=A[1]; C[4]=A[4]; C[5]=A[7];
+	C[6]=A[2]; C[7]=A[5]; C[8]=A[8];
+}
+
+//----- y=A*x, x,y: [3x1] -----
+void kf_Mat3X3_MultVector(const kf_t *A, const kf_t *x, kf_t *y)
+{
+	y[0]=KF_OUT( KF_MUL(A[0],x[0]) + KF_MUL(A[1],x[1]) + KF_MUL(A[2],x[2]) );
+	y[1]=KF_OUT( KF_MUL(A[3],x[0]) + KF_MUL(A[4],x[1]) + KF_MUL(A[5],x[2]) );
+	y[2]=KF_OUT( KF_MUL(A[6],x[0]) + KF_MUL(A[7],x[1]) + KF_MUL(A[8],x[2]) );
+}
+
+/*-----------------------------------------
+C=inv(A), by adjugate matrix.
+Return:
+	0	OK
+	<0	A is singular, C is not changed.
+-----------------------------------------*/
+int kf_Mat3X3_Inverse(const kf_t *A, kf_t *C)
+{
+#ifdef KALMAN_FIXED
+	/* Normalized to 20bits, so cofactors(<2^41) and det(<2^63) are exact in int64_t,
+	 * and inv(A)=adj(An)/det(An)*2^(2*QBITS-sh)
+	 */
+	int64_t a[9];
+	int64_t cof[9];
+	int64_t det;
+	int sh;
+
+	sh=kf_normalize(A, a, 9, 20);
+	sh=2*KALMAN_QBITS-sh;
+#define KF_DIV(c,d)	kf_divshift((c),(d),sh)
+#else
+	const kf_t *a=A;
+	float cof[9];	/* cofactors */
+	float det;
+#define KF_DIV(c,d)	((c)/(d))
+#endif
+
+	cof[0]=a[4]*a[8] - a[5]*a[7];
+	cof[1]=a[5]*a[6] - a[3]*a[8];
+	cof[2]=a[3]*a[7] - a[4]*a[6];
+	cof[3]=a[2]*a[7] - a[1]*a[8];
+	cof[4]=a[0]*a[8] - a[2]*a[6];
+	cof[5]=a[1]*a[6] - a[0]*a[7];
+	cof[6]=a[1]*a[5] - a[2]*a[4];
+	cof[7]=a[2]*a[3] - a[0]*a[5];
+	cof[8]=a[0]*a[4] - a[1]*a[3];
+
+	det=a[0]*cof[0] + a[1]*cof[1] + a[2]*cof[2];
+	if(det==0)
+		return -1;
+
+	/* inv(A)=adj(A)/det, adj(A)=cof' */
+	C[0]=KF_DIV(cof[0],det); C[1]=KF_DIV(cof[3],det); C[2]=KF_DIV(cof[6],det);
+	C[3]=KF_DIV(cof[1],det); C[4]=KF_DIV(cof[4],det); C[5]=KF_DIV(cof[7],det);
+	C[6]=KF_DIV(cof[2],det); C[7]=KF_DIV(cof[5],det); C[8]=KF_DIV(cof[8],det);
+#undef KF_DIV
+
+	return 0;
+}
+
+
+/*----------------------------------------------------------------
+Convert float data to kf_t.
+----------------------------------------------------------------*/
+static void kf_FillArray(kf_t *dest, const float *src, int n)
+{
+	int i;
+
+	for(i=0; i<n; i++)
+		dest[i]=KF_FROM_FLOAT(src[i]);
+}
+
+/*-----------------------------------------------------------------------
+Initiliaze fixed dimension kalman filter data base with float data, all
+matrices are stored from row to column, as float_Matrix.
+
+kdb:	pointer of filter data base
+Y:	[nx1] state var. init. value
+F:	[nxn] transition
+P:	[nxn] state covariance init. value
+H:	[mxn] observation transformation
+Q:	[nxn] system noise covariance
+R:	[mxm] observation noise covariance
+-----------------------------------------------------------------------*/
+void Init_kalmanN2M2_FilterDB( struct kalmanN2M2DB *kdb, const float *Y, const float *F,
+			       const float *P, const float *H, const float *Q, const float *R )
+{
+	kf_FillArray(kdb->Y, Y, 2);
+	kf_FillArray(kdb->F, F, 2*2);
+	kf_FillArray(kdb->P, P, 2*2);
+	kf_FillArray(kdb->H, H, 2*2);
+	kf_FillArray(kdb->Q, Q, 2*2);
+	kf_FillArray(kdb->R, R, 2*2);
+}
+
+void Init_kalmanN3M1_FilterDB( struct kalmanN3M1DB *kdb, const float *Y, const float *F,
+			       const float *P, const float *H, const float *Q, float R )
+{
+	kf_FillArray(kdb->Y, Y, 3);
+	kf_FillArray(kdb->F, F, 3*3);
+	kf_FillArray(kdb->P, P, 3*3);
+	kf_FillArray(kdb->H, H, 3);
+	kf_FillArray(kdb->Q, Q, 3*3);
+	kdb->R=KF_FROM_FLOAT(R);
+}
+
+void Init_kalmanN3M3_FilterDB( struct kalmanN3M3DB *kdb, const float *Y, const float *F,
+			       const float *P, const float *H, const float *Q, const float *R )
+{
+	kf_FillArray(kdb->Y, Y, 3);
+	kf_FillArray(kdb->F, F, 3*3);
+	kf_FillArray(kdb->P, P, 3*3);
+	kf_FillArray(kdb->H, H, 3*3);
+	kf_FillArray(kdb->Q, Q, 3*3);
+	kf_FillArray(kdb->R, R, 3*3);
+}
+
+
+/*---------------------------------------------------------------------------------
+		N2M2 KALMAN FILTER REALTIME CALCUALATOR
+Same steps as float_KalmanFilter(), but P is updated as Pp-K*(H*Pp), which
+equals (I-K*H)*Pp.
+
+kdb:	filter data base
+S:	[2x1] input observation
+Return:
+	0	OK
+	<0	H*Pp*H'+R is singular, only prediction is carried out.
+---------------------------------------------------------------------------------*/
+int kalmanN2M2_Filter(struct kalmanN2M2DB *kdb, const kf_t *S)
+{
+	kf_t Yp[2], Pp[4], HPp[4], Sm[4], Si[4], PpHt[4], K[4];
+	kf_t T[4], E[2];
+	int i;
+
+	//----- 1.Predict(priori) state:  Yp = F*Y -----
+	kf_Mat2X2_MultVector(kdb->F, kdb->Y, Yp);
+
+	//----- 2. Predict(priori) state covariance:  Pp = F*P*F'+Q -----
+	kf_Mat2X2_Multiply(kdb->F, kdb->P, T);
+	kf_Mat2X2_MultiplyTp(T, kdb->F, Pp);
+	for(i=0; i<4; i++)
+		Pp[i] += kdb->Q[i];
+
+	//----- 3. Update Kalman Gain:  K = Pp*H'*inv(H*Pp*H'+R)  -----
+	kf_Mat2X2_Multiply(kdb->H, Pp, HPp);
+	kf_Mat2X2_MultiplyTp(HPp, kdb->H, Sm);
+	for(i=0; i<4; i++)
+		Sm[i] += kdb->R[i];
+	if( kf_Mat2X2_Inverse(Sm, Si) !=0 ) {
+		kdb->Y[0]=Yp[0]; kdb->Y[1]=Yp[1];
+		for(i=0; i<4; i++)
+			kdb->P[i]=Pp[i];
+		return -1;
+	}
+	kf_Mat2X2_MultiplyTp(Pp, kdb->H, PpHt);
+	kf_Mat2X2_Multiply(PpHt, Si, K);
+
+	//----- 4. Update(posteriori) state:  Y = Yp + K*(S-H*Yp)  -----
+	kf_Mat2X2_MultVector(kdb->H, Yp, E);
+	E[0]=S[0]-E[0];
+	E[1]=S[1]-E[1];
+	kf_Mat2X2_MultVector(K, E, kdb->Y);
+	kdb->Y[0] += Yp[0];
+	kdb->Y[1] += Yp[1];
+
+	//----- 5. Update(posteriori) state covariance:  P = (I-K*H)*Pp = Pp-K*(H*Pp) -----
+	kf_Mat2X2_Multiply(K, HPp, T);
+	for(i=0; i<4; i++)
+		kdb->P[i]=Pp[i]-T[i];
+
+	return 0;
+}
+
+
+/*---------------------------------------------------------------------------------
+		N3M1 KALMAN FILTER REALTIME CALCUALATOR
+H*Pp*H'+R is a scalar, so no matrix inverse.
+
+kdb:	filter data base
+S:	[1x1] input observation
+Return:
+	0	OK
+	<0	H*Pp*H'+R is zero, only prediction is carried out.
+---------------------------------------------------------------------------------*/
+int kalmanN3M1_Filter(struct kalmanN3M1DB *kdb, kf_t S)
+{
+	const kf_t *H=kdb->H;
+	kf_t Yp[3], Pp[9], T[9];
+	kf_t HPp[3];	/* [1x3] H*Pp */
+	kf_t PpHt[3];	/* [3x1] Pp*H' */
+	kf_t K[3];	/* [3x1] */
+	kf_acc_t s;	/* H*Pp*H'+R */
+	kf_t e;		/* S-H*Yp */
+	int i;
+
+	//----- 1.Predict(priori) state:  Yp = F*Y -----
+	kf_Mat3X3_MultVector(kdb->F, kdb->Y, Yp);
+
+	//----- 2. Predict(priori) state covariance:  Pp = F*P*F'+Q -----
+	kf_Mat3X3_Multiply(kdb->F, kdb->P, T);
+	kf_Mat3X3_MultiplyTp(T, kdb->F, Pp);
+	for(i=0; i<9; i++)
+		Pp[i] += kdb->Q[i];
+
+	//----- 3. Update Kalman Gain:  K = Pp*H'/(H*Pp*H'+R)  -----
+	for(i=0; i<3; i++) {
+		HPp[i]=KF_OUT( KF_MUL(H[0],Pp[i]) + KF_MUL(H[1],Pp[3+i]) + KF_MUL(H[2],Pp[6+i]) );
+		PpHt[i]=KF_OUT( KF_MUL(Pp[3*i],H[0]) + KF_MUL(Pp[3*i+1],H[1]) + KF_MUL(Pp[3*i+2],H[2]) );
+	}
+	s=KF_MUL(HPp[0],H[0]) + KF_MUL(HPp[1],H[1]) + KF_MUL(HPp[2],H[2]) + KF_MUL(kdb->R,KF_ONE);
+	if(s==0) {
+		for(i=0; i<3; i++)
+			kdb->Y[i]=Yp[i];
+		for(i=0; i<9; i++)
+			kdb->P[i]=Pp[i];
+		return -1;
+	}
+	for(i=0; i<3; i++)
+		K[i]=kf_div(PpHt[i], s);
+
+	//----- 4. Update(posteriori) state:  Y = Yp + K*(S-H*Yp)  -----
+	e=S-KF_OUT( KF_MUL(H[0],Yp[0]) + KF_MUL(H[1],Yp[1]) + KF_MUL(H[2],Yp[2]) );
+	for(i=0; i<3; i++)
+		kdb->Y[i]=Yp[i]+KF_OUT( KF_MUL(K[i],e) );
+
+	//----- 5. Update(posteriori) state covariance:  P = Pp-K*(H*Pp) -----
+	for(i=0; i<9; i++)
+		kdb->P[i]=Pp[i]-KF_OUT( KF_MUL(K[i/3],HPp[i%3]) );
+
+	return 0;
+}
+
+
+/*---------------------------------------------------------------------------------
+		N3M3 KALMAN FILTER REALTIME CALCUALATOR
+
+kdb:	filter data base
+S:	[3x1] input observation
+Return:
+	0	OK
+	<0	H*Pp*H'+R is singular, only prediction is carried out.
+---------------------------------------------------------------------------------*/
+int kalmanN3M3_Filter(struct kalmanN3M3DB *kdb, const kf_t *S)
+{
+	kf_t Yp[3], Pp[9], HPp[9], Sm[9], Si[9], PpHt[9], K[9];
+	kf_t T[9], E[3];
+	int i;
+
+	//----- 1.Predict(priori) state:  Yp = F*Y -----
+	kf_Mat3X3_MultVector(kdb->F, kdb->Y, Yp);
+
+	//----- 2. Predict(priori) state covariance:  Pp = F*P*F'+Q -----
+	kf_Mat3X3_Multiply(kdb->F, kdb->P, T);
+	kf_Mat3X3_MultiplyTp(T, kdb->F, Pp);
+	for(i=0; i<9; i++)
+		Pp[i] += kdb->Q[i];
+
+	//----- 3. Update Kalman Gain:  K = Pp*H'*inv(H*Pp*H'+R)  -----
+	kf_Mat3X3_Multiply(kdb->H, Pp, HPp);
+	kf_Mat3X3_MultiplyTp(HPp, kdb->H, Sm);
+	for(i=0; i<9; i++)
+		Sm[i] += kdb->R[i];
+	if( kf_Mat3X3_Inverse(Sm, Si) !=0 ) {
+		for(i=0; i<3; i++)
+			kdb->Y[i]=Yp[i];
+		for(i=0; i<9; i++)
+			kdb->P[i]=Pp[i];
+		return -1;
+	}
+	kf_Mat3X3_MultiplyTp(Pp, kdb->H, PpHt);
+	kf_Mat3X3_Multiply(PpHt, Si, K);
+
+	//----- 4. Update(posteriori) state:  Y = Yp + K*(S-H*Yp)  -----
+	kf_Mat3X3_MultVector(kdb->H, Yp, E);
+	for(i=0; i<3; i++)
+		E[i]=S[i]-E[i];
+	kf_Mat3X3_MultVector(K, E, kdb->Y);
+	for(i=0; i<3; i++)
+		kdb->Y[i] += Yp[i];
+
+	//----- 5. Update(posteriori) state covariance:  P = Pp-K*(H*Pp) -----
+	kf_Mat3X3_Multiply(K, HPp, T);
+	for(i=0; i<9; i++)
+		kdb->P[i]=Pp[i]-T[i];
+
+	return 0;
+}
@@ -0,0 +1,109 @@
+/*----------------------------------------------------------------------
+Kalman filters with fixed small dimensions: N2M2, N3M1 and N3M3.
+
+1. All matrices are fixed size arrays in the filter data base, and
+   temporary matrices are on stack, no malloc/free for each update.
+2. Matrix multiply/transpose/inverse for 2x2, 3x3 and 3x1 are unrolled.
+3. Fixed point build with -DKALMAN_FIXED for FPU-less targets, such as
+   MIPS 24kec. Values are int32_t with KALMAN_QBITS fraction bits,
+   Q16 by default, and -DKALMAN_QBITS=15 for Q15.
+   Products are summed in int64_t, and rounded only once for each element.
+
+NOTE:
+   1. In fixed point build, the range is +-2^(31-QBITS), and resolution
+      is 2^(-QBITS). So scale units of state var. and observation to fit
+      both the range and the noise covariance, e.g. N2M2 in wbiroll takes
+      covariance as small as 1e-19, it works only in float build.
+   2. Same as float_KalmanFilter(), H*Pp*H'+R MUST be invertible, and
+      if not, only prediction is carried out for that update.
+
+Midas
+----------------------------  COPYLEFT  --------------------------------*/
+#ifndef __KALMAN_FIXDIM_H__
+#define __KALMAN_FIXDIM_H__
+
+#include <stdint.h>
+
+
+#ifdef KALMAN_FIXED  /* ------ Fixed point ------ */
+
+#ifndef KALMAN_QBITS
+#define KALMAN_QBITS	16
+#endif
+
+typedef int32_t kf_t;
+
+#define KF_ONE			(1<<KALMAN_QBITS)
+#define KF_FROM_FLOAT(x)	((kf_t)( (x)*KF_ONE + ((x)>=0 ? 0.5 : -0.5) ))
+#define KF_TO_FLOAT(x)		((float)(x)/KF_ONE)
+
+#else  /* ------ Float ------ */
+
+typedef float kf_t;
+
+#define KF_ONE			1.0f
+#define KF_FROM_FLOAT(x)	((kf_t)(x))
+#define KF_TO_FLOAT(x)		((float)(x))
+
+#endif
+
+
+//----- N2M2 Kalman filter Data Base, all matrices are stored from row to column -----
+struct kalmanN2M2DB {
+	kf_t Y[2];	//[2x1] state var.
+	kf_t F[2*2];	//[2x2] transition
+	kf_t P[2*2];	//[2x2] state covariance
+	kf_t H[2*2];	//[2x2] observation transformation
+	kf_t Q[2*2];	//[2x2] system noise covariance
+	kf_t R[2*2];	//[2x2] observation noise covariance
+};
+
+//----- N3M1 Kalman filter Data Base -----
+struct kalmanN3M1DB {
+	kf_t Y[3];	//[3x1] state var.
+	kf_t F[3*3];	//[3x3] transition
+	kf_t P[3*3];	//[3x3] state covariance
+	kf_t H[3];	//[1x3] observation transformation
+	kf_t Q[3*3];	//[3x3] system noise covariance
+	kf_t R;		//[1x1] observation noise covariance
+};
+
+//----- N3M3 Kalman filter Data Base -----
+struct kalmanN3M3DB {
+	kf_t Y[3];	//[3x1] state var.
+	kf_t F[3*3];	//[3x3] transition
+	kf_t P[3*3];	//[3x3] state covariance
+	kf_t H[3*3];	//[3x3] observation transformation
+	kf_t Q[3*3];	//[3x3] system noise covariance
+	kf_t R[3*3];	//[3x3] observation noise covariance
+};
+
+
+//------------------------     FUNCTION DECLARATION     ---------------------------
+
+//------ Unrolled matrix kernels, C may NOT be the same as A or B -------
+void kf_Mat2X2_Multiply(const kf_t *A, const kf_t *B, kf_t *C);
+void kf_Mat2X2_MultiplyTp(const kf_t *A, const kf_t *B, kf_t *C);  // C=A*B'
+int  kf_Mat2X2_Inverse(const kf_t *A, kf_t *C);
+void kf_Mat2X2_MultVector(const kf_t *A, const kf_t *x, kf_t *y);  // [2x2]*[2x1]
+void kf_Mat3X3_Multiply(const kf_t *A, const kf_t *B, kf_t *C);
+void kf_Mat3X3_MultiplyTp(const kf_t *A, const kf_t *B, kf_t *C);  // C=A*B'
+void kf_Mat3X3_Transpose(const kf_t *A, kf_t *C);
+int  kf_Mat3X3_Inverse(const kf_t *A, kf_t *C);
+void kf_Mat3X3_MultVector(const kf_t *A, const kf_t *x, kf_t *y);  // [3x3]*[3x1]
+
+//------ Init. with float data, as for float_Matrix, R of N3M1 is a scalar ------
+void Init_kalmanN2M2_FilterDB( struct kalmanN2M2DB *kdb, const float *Y, const float *F,
+			       const float *P, const float *H, const float *Q, const float *R );
+void Init_kalmanN3M1_FilterDB( struct kalmanN3M1DB *kdb, const float *Y, const float *F,
+			       const float *P, const float *H, const float *Q, float R );
+void Init_kalmanN3M3_FilterDB( struct kalmanN3M3DB *kdb, const float *Y, const float *F,
+			       const float *P, const float *H, const float *Q, const float *R );
+
+//------ Update with observation S, return 0 OK, <0 H*Pp*H'+R is singular, predicted only -----
+int  kalmanN2M2_Filter(struct kalmanN2M2DB *kdb, const kf_t *S);  // S[2x1]
+int  kalmanN3M1_Filter(struct kalmanN3M1DB *kdb, kf_t S);	  // S[1x1]
+int  kalmanN3M3_Filter(struct kalmanN3M3DB *kdb, const kf_t *S);  // S[3x1]
+
+
+#endif
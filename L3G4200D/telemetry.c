@@ -0,0 +1,655 @@
+/*----------------------------------------------------------------------
+Telemetry publisher, see telemetry.h.
+
+Midas
+----------------------------  COPYLEFT  --------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include "telemetry.h"
+
+#define TELEM_LISTEN_ID		TELEM_MAX_CLIENTS	//epoll data of the listening socket
+#define TELEM_EVENT_ID		(TELEM_MAX_CLIENTS+1)	//epoll data of the eventfd
+
+
+/*------------------------------------
+Return CLOCK_MONOTONIC time in us
+-------------------------------------*/
+int64_t telem_clock_us(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC,&tp);
+	return (int64_t)tp.tv_sec*1000000+tp.tv_nsec/1000;
+}
+
+//----- little endian encoding
+static void put_u16(uint8_t *p, uint16_t v)
+{
+	p[0]=v; p[1]=v>>8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+	p[0]=v; p[1]=v>>8; p[2]=v>>16; p[3]=v>>24;
+}
+
+static void put_u64(uint8_t *p, uint64_t v)
+{
+	put_u32(p, (uint32_t)v);
+	put_u32(p+4, (uint32_t)(v>>32));
+}
+
+
+/*---------------------------------------
+Release a reference of a frame
+----------------------------------------*/
+static void frame_unref(struct telem_frame *f)
+{
+	if(--f->refs<=0)
+		free(f);
+}
+
+/*---------------------------------------
+Close a client, release its queued frames
+----------------------------------------*/
+static void client_close(struct telem_server *svr, struct telem_client *c)
+{
+	printf("telemetry: client fd=%d closed, %lu frames sent, %lu dropped.\n",
+		c->fd, c->nframes, c->ndropped);
+
+	epoll_ctl(svr->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+	close(c->fd);
+	c->fd=-1;
+
+	while(c->qcount>0)
+	{
+		frame_unref(c->queue[c->qhead]);
+		c->qhead=(c->qhead+1)%TELEM_CLIENT_QFRAMES;
+		c->qcount--;
+	}
+}
+
+/*---------------------------------------
+Turn EPOLLOUT on/off for a client
+----------------------------------------*/
+static void client_set_wout(struct telem_server *svr, struct telem_client *c, bool wout)
+{
+	struct epoll_event ev;
+
+	if(c->wout==wout)
+		return;
+
+	ev.events=EPOLLIN|(wout?EPOLLOUT:0);
+	ev.data.u32=c-svr->clients;
+	if( epoll_ctl(svr->epfd, EPOLL_CTL_MOD, c->fd, &ev)==0 )
+		c->wout=wout;
+}
+
+/*-----------------------------------------------------------
+Send queued frames until all sent or the socket is full.
+-----------------------------------------------------------*/
+static void client_send(struct telem_server *svr, struct telem_client *c)
+{
+	struct telem_frame *f;
+	int ret;
+
+	while(c->qcount>0)
+	{
+		f=c->queue[c->qhead];
+		ret=send(c->fd, f->data+c->sent, f->len-c->sent, MSG_NOSIGNAL|MSG_DONTWAIT);
+		if(ret<0)
+		{
+			if(errno==EAGAIN || errno==EWOULDBLOCK)
+				break;
+			if(errno==EINTR)
+				continue;
+			client_close(svr, c);
+			return;
+		}
+
+		c->sent += ret;
+		if(c->sent==f->len)
+		{
+			frame_unref(f);
+			c->qhead=(c->qhead+1)%TELEM_CLIENT_QFRAMES;
+			c->qcount--;
+			c->sent=0;
+			c->nframes++;
+		}
+	}
+
+	//----- wait for EPOLLOUT if frames remain
+	client_set_wout(svr, c, c->qcount>0);
+}
+
+/*-----------------------------------------------------------
+Queue a frame for a client, apply its policy if the queue is
+full. Return 0 if queued, <0 dropped or client closed.
+-----------------------------------------------------------*/
+static int client_queue(struct telem_server *svr, struct telem_client *c, struct telem_frame *f)
+{
+	int keep;
+
+	if(c->qcount==TELEM_CLIENT_QFRAMES)
+	{
+		switch(c->policy)
+		{
+			case TELEM_DROP_OLD:
+				//----- keep the head frame if it's partly sent
+				keep= c->sent>0 ? 1 : 0;
+				while(c->qcount>keep)
+				{
+					frame_unref(c->queue[(c->qhead+c->qcount-1)%TELEM_CLIENT_QFRAMES]);
+					c->qcount--;
+					c->ndropped++;
+				}
+				break;
+			case TELEM_CLOSE:
+				client_close(svr, c);
+				return -2;
+			default:	//TELEM_DROP_NEW
+				c->ndropped++;
+				return -1;
+		}
+	}
+
+	c->queue[(c->qhead+c->qcount)%TELEM_CLIENT_QFRAMES]=f;
+	c->qcount++;
+	f->refs++;
+
+	return 0;
+}
+
+/*-----------------------------------------------------------
+Parse a command line from a client
+-----------------------------------------------------------*/
+static void client_command(struct telem_client *c, const char *cmd)
+{
+	if(strcmp(cmd,"SUB raw")==0)
+		c->sub=TELEM_SUB_RAW;
+	else if(strcmp(cmd,"SUB filtered")==0)
+		c->sub=TELEM_SUB_FILTERED;
+	else if(strcmp(cmd,"SUB both")==0)
+		c->sub=TELEM_SUB_BOTH;
+	else if(strcmp(cmd,"POLICY drop_new")==0)
+		c->policy=TELEM_DROP_NEW;
+	else if(strcmp(cmd,"POLICY drop_old")==0)
+		c->policy=TELEM_DROP_OLD;
+	else if(strcmp(cmd,"POLICY close")==0)
+		c->policy=TELEM_CLOSE;
+	else
+		printf("telemetry: unknown command from client fd=%d: %s\n", c->fd, cmd);
+}
+
+/*-----------------------------------------------------------
+Read command lines from a client, close it if disconnected.
+-----------------------------------------------------------*/
+static void client_read(struct telem_server *svr, struct telem_client *c)
+{
+	char buf[128];
+	int i,ret;
+
+	ret=recv(c->fd, buf, sizeof(buf), MSG_DONTWAIT);
+	if(ret==0 || (ret<0 && errno!=EAGAIN && errno!=EWOULDBLOCK && errno!=EINTR))
+	{
+		client_close(svr, c);
+		return;
+	}
+
+	for(i=0; i<ret; i++)
+	{
+		if(buf[i]=='\n' || buf[i]=='\r')
+		{
+			c->cmd[c->cmdlen]='\0';
+			if(c->cmdlen>0)
+				client_command(c, c->cmd);
+			c->cmdlen=0;
+		}
+		else if(c->cmdlen < (int)sizeof(c->cmd)-1)
+			c->cmd[c->cmdlen++]=buf[i];
+	}
+}
+
+/*---------------------------------------
+Accept a new client
+----------------------------------------*/
+static void server_accept(struct telem_server *svr)
+{
+	struct telem_client *c=NULL;
+	struct epoll_event ev;
+	int fd,i;
+
+	fd=accept(svr->lsfd, NULL, NULL);
+	if(fd<0)
+		return;
+
+	for(i=0; i<TELEM_MAX_CLIENTS; i++)
+	{
+		if(svr->clients[i].fd<0)
+		{
+			c=&svr->clients[i];
+			break;
+		}
+	}
+	if(c==NULL)
+	{
+		printf("telemetry: max. %d clients, reject a new one.\n", TELEM_MAX_CLIENTS);
+		close(fd);
+		return;
+	}
+
+	fcntl(fd, F_SETFL, fcntl(fd,F_GETFL)|O_NONBLOCK);
+	memset(c, 0, sizeof(struct telem_client));
+	c->fd=fd;
+	c->sub=TELEM_SUB_BOTH;
+	c->policy=TELEM_DROP_NEW;
+
+	ev.events=EPOLLIN;
+	ev.data.u32=i;
+	if( epoll_ctl(svr->epfd, EPOLL_CTL_ADD, fd, &ev)<0 )
+	{
+		close(fd);
+		c->fd=-1;
+		return;
+	}
+
+	printf("telemetry: client fd=%d connected.\n", fd);
+}
+
+/*-----------------------------------------------------------
+Finish the frame of a stream, and queue it to subscribers.
+-----------------------------------------------------------*/
+static void server_flush(struct telem_server *svr, int stream)
+{
+	struct telem_frame *f=svr->frame[stream];
+	struct telem_client *c;
+	int i;
+
+	if(f==NULL)
+		return;
+	svr->frame[stream]=NULL;
+
+	put_u16(f->data+6, f->nsamples);
+	f->refs=1;	//held by the server until queued to all
+
+	for(i=0; i<TELEM_MAX_CLIENTS; i++)
+	{
+		c=&svr->clients[i];
+		if( c->fd<0 || !(c->sub&(1<<stream)) )
+			continue;
+		if( client_queue(svr, c, f)==0 )
+			client_send(svr, c);
+	}
+
+	frame_unref(f);
+}
+
+/*-----------------------------------------------------------
+Add a sample to the frame of its stream, start a new frame
+if necessary, and flush it when batch_n samples are in.
+-----------------------------------------------------------*/
+static void server_batch(struct telem_server *svr, const struct telem_sample *s)
+{
+	int stream=s->stream;
+	struct telem_frame *f=svr->frame[stream];
+	int64_t dt;
+	uint8_t *p;
+	uint32_t u;
+	int i;
+
+	//----- nchan changes, finish the old frame
+	if(f!=NULL && f->nchan!=s->nchan)
+	{
+		server_flush(svr, stream);
+		f=NULL;
+	}
+
+	if(f==NULL)
+	{
+		f=malloc(sizeof(struct telem_frame)+TELEM_HEADER_SIZE+svr->batch_n*(4+4*s->nchan));
+		if(f==NULL)
+			return;
+		f->refs=0;
+		f->nchan=s->nchan;
+		f->nsamples=0;
+		f->len=TELEM_HEADER_SIZE;
+
+		p=f->data;
+		put_u16(p, TELEM_MAGIC);
+		p[2]=TELEM_VERSION;
+		p[3]=stream;
+		p[4]=s->nchan;
+		p[5]=0;
+		put_u16(p+6, 0);
+		put_u32(p+8, svr->seq[stream]++);
+		put_u64(p+12, (uint64_t)s->ts_us);
+
+		svr->frame[stream]=f;
+		svr->frame_ts[stream]=s->ts_us;
+		svr->frame_tm[stream]=telem_clock_us();
+	}
+
+	dt=s->ts_us-svr->frame_ts[stream];
+	p=f->data+f->len;
+	put_u32(p, dt>0 ? (uint32_t)dt : 0);
+	for(i=0; i<s->nchan; i++)
+	{
+		memcpy(&u, &s->val[i], 4);
+		put_u32(p+4+4*i, u);
+	}
+	f->len += 4+4*s->nchan;
+	f->nsamples++;
+
+	if(f->nsamples>=svr->batch_n)
+		server_flush(svr, stream);
+}
+
+/*-----------------------------------------------------------
+Wake the server thread if it sleeps, or is going to sleep,
+in epoll_wait().
+-----------------------------------------------------------*/
+static void server_wake(struct telem_server *svr)
+{
+	uint64_t one=1;
+
+	if( __atomic_exchange_n(&svr->waiting, 0, __ATOMIC_SEQ_CST) )
+	{
+		if( write(svr->evfd, &one, sizeof(one))<0 && errno!=EAGAIN )
+			perror("telemetry: write eventfd");
+	}
+}
+
+/*-----------------------------------------------------------
+Return epoll_wait() timeout in ms, till the first frame is
+over batch_ms, or -1 if no frame is being filled.
+Also set wake_at[] for telem_publish(): the first sample of
+a stream without a frame, or the one filling up its frame.
+-----------------------------------------------------------*/
+static int server_timeout(struct telem_server *svr)
+{
+	int64_t now=telem_clock_us();
+	int64_t left, tmo=-1;
+	int i;
+
+	for(i=0; i<TELEM_NSTREAMS; i++)
+	{
+		if(svr->frame[i]==NULL)
+		{
+			__atomic_store_n(&svr->wake_at[i], svr->npulled[i]+1, __ATOMIC_RELAXED);
+			continue;
+		}
+		__atomic_store_n(&svr->wake_at[i], svr->npulled[i]+svr->batch_n-svr->frame[i]->nsamples,
+				 __ATOMIC_RELAXED);
+		left=svr->frame_tm[i]+svr->batch_ms*1000LL-now;
+		if(left<0)
+			left=0;
+		if(tmo<0 || left<tmo)
+			tmo=left;
+	}
+
+	return tmo<0 ? -1 : (int)((tmo+999)/1000);
+}
+
+/*---------------------------------------------------
+Server thread: serve clients, pull samples from the
+ring and batch them. It sleeps in epoll_wait() till
+a client event, a frame to start or fill up(eventfd),
+or the batch_ms of a frame is over.
+----------------------------------------------------*/
+static void *telem_server_thread(void *arg)
+{
+	struct telem_server *svr=(struct telem_server *)arg;
+	struct epoll_event evs[TELEM_MAX_CLIENTS+2];
+	struct telem_sample samples[64];
+	struct telem_client *c;
+	uint64_t cnt;
+	int64_t now;
+	int i,n,tmo;
+
+	while( !__atomic_load_n(&svr->quit,__ATOMIC_RELAXED) )
+	{
+		//----- announce to sleep, then recheck the ring, so no sample is left behind
+		tmo=server_timeout(svr);
+		__atomic_store_n(&svr->waiting, 1, __ATOMIC_SEQ_CST);
+		if( egi_ring_count(svr->ring)>0 || __atomic_load_n(&svr->quit,__ATOMIC_RELAXED) )
+			tmo=0;
+
+		n=epoll_wait(svr->epfd, evs, TELEM_MAX_CLIENTS+2, tmo);
+		__atomic_store_n(&svr->waiting, 0, __ATOMIC_RELAXED);
+		for(i=0; i<n; i++)
+		{
+			if(evs[i].data.u32==TELEM_LISTEN_ID)
+			{
+				server_accept(svr);
+				continue;
+			}
+			if(evs[i].data.u32==TELEM_EVENT_ID)
+			{
+				if( read(svr->evfd, &cnt, sizeof(cnt))<0 && errno!=EAGAIN )
+					perror("telemetry: read eventfd");
+				continue;
+			}
+
+			c=&svr->clients[evs[i].data.u32];
+			if(c->fd>=0 && (evs[i].events&(EPOLLERR|EPOLLHUP)))
+				client_close(svr, c);
+			if(c->fd>=0 && (evs[i].events&EPOLLIN))
+				client_read(svr, c);
+			if(c->fd>=0 && (evs[i].events&EPOLLOUT))
+				client_send(svr, c);
+		}
+
+		//----- batch new samples
+		while( (n=egi_ring_pull(svr->ring, samples, 64)) >0 )
+		{
+			for(i=0; i<n; i++)
+			{
+				svr->npulled[samples[i].stream]++;
+				server_batch(svr, samples+i);
+			}
+		}
+
+		//----- flush frames over batch_ms
+		now=telem_clock_us();
+		for(i=0; i<TELEM_NSTREAMS; i++)
+		{
+			if( svr->frame[i]!=NULL && now-svr->frame_tm[i] >= svr->batch_ms*1000LL )
+				server_flush(svr, i);
+		}
+	}
+
+	return (void *)0;
+}
+
+
+/*-----------------------------------------------------------------------
+Start a telemetry server.
+
+port:      TCP port to listen, TELEM_PORT by default.
+batch_n:   max. samples of a frame, 1-TELEM_MAX_BATCH.
+batch_ms:  max. time a sample waits in a frame before being sent.
+
+Return:
+	!NULL	OK
+	NULL	Fails
+-----------------------------------------------------------------------*/
+struct telem_server *telem_server_start(uint16_t port, int batch_n, int batch_ms)
+{
+	struct telem_server *svr;
+	struct sockaddr_in addr;
+	struct epoll_event ev;
+	int flag=1;
+	int i;
+
+	if(batch_n<1 || batch_n>TELEM_MAX_BATCH || batch_ms<1)
+	{
+		fprintf(stderr,"telem_server_start(): batch_n should be 1-%d, and batch_ms >0!\n",TELEM_MAX_BATCH);
+		return NULL;
+	}
+
+	svr=calloc(1, sizeof(struct telem_server));
+	if(svr==NULL)
+		return NULL;
+	svr->batch_n=batch_n;
+	svr->batch_ms=batch_ms;
+	svr->lsfd=-1;
+	svr->epfd=-1;
+	svr->evfd=-1;
+	for(i=0; i<TELEM_MAX_CLIENTS; i++)
+		svr->clients[i].fd=-1;
+
+	svr->ring=egi_ring_create(TELEM_RING_SAMPLES, sizeof(struct telem_sample));
+	if(svr->ring==NULL)
+		goto START_FAIL;
+
+	//----- listening socket
+	svr->lsfd=socket(AF_INET, SOCK_STREAM, 0);
+	if(svr->lsfd<0)
+	{
+		perror("telem_server_start(): socket");
+		goto START_FAIL;
+	}
+	setsockopt(svr->lsfd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family=AF_INET;
+	addr.sin_addr.s_addr=htonl(INADDR_ANY);
+	addr.sin_port=htons(port);
+	if( bind(svr->lsfd, (struct sockaddr *)&addr, sizeof(addr))<0 || listen(svr->lsfd, TELEM_MAX_CLIENTS)<0 )
+	{
+		fprintf(stderr,"telem_server_start(): fail to bind/listen port %d: %s\n",port,strerror(errno));
+		goto START_FAIL;
+	}
+	fcntl(svr->lsfd, F_SETFL, fcntl(svr->lsfd,F_GETFL)|O_NONBLOCK);
+
+	//----- eventfd to wake the server thread
+	svr->evfd=eventfd(0, EFD_NONBLOCK);
+	if(svr->evfd<0)
+	{
+		perror("telem_server_start(): eventfd");
+		goto START_FAIL;
+	}
+
+	//----- epoll
+	svr->epfd=epoll_create(TELEM_MAX_CLIENTS+2);
+	if(svr->epfd<0)
+	{
+		perror("telem_server_start(): epoll_create");
+		goto START_FAIL;
+	}
+	ev.events=EPOLLIN;
+	ev.data.u32=TELEM_LISTEN_ID;
+	if( epoll_ctl(svr->epfd, EPOLL_CTL_ADD, svr->lsfd, &ev)<0 )
+		goto START_FAIL;
+	ev.events=EPOLLIN;
+	ev.data.u32=TELEM_EVENT_ID;
+	if( epoll_ctl(svr->epfd, EPOLL_CTL_ADD, svr->evfd, &ev)<0 )
+		goto START_FAIL;
+
+	if( pthread_create(&svr->thread, NULL, telem_server_thread, svr) !=0 )
+	{
+		fprintf(stderr,"telem_server_start(): fail to create server thread!\n");
+		goto START_FAIL;
+	}
+
+	printf("telemetry: listening on port %d, %d samples or %dms a frame.\n", port, batch_n, batch_ms);
+	return svr;
+
+START_FAIL:
+	if(svr->epfd>=0)
+		close(svr->epfd);
+	if(svr->evfd>=0)
+		close(svr->evfd);
+	if(svr->lsfd>=0)
+		close(svr->lsfd);
+	egi_ring_free(&svr->ring);
+	free(svr);
+	return NULL;
+}
+
+/*---------------------------------------------------------
+Stop the server thread, close all clients and free it.
+Frames not sent yet are discarded.
+---------------------------------------------------------*/
+void telem_server_stop(struct telem_server **svr)
+{
+	struct telem_server *s;
+	int i;
+
+	if(svr==NULL || *svr==NULL)
+		return;
+	s=*svr;
+
+	__atomic_store_n(&s->quit, 1, __ATOMIC_SEQ_CST);
+	server_wake(s);
+	pthread_join(s->thread, NULL);
+
+	for(i=0; i<TELEM_MAX_CLIENTS; i++)
+	{
+		if(s->clients[i].fd>=0)
+			client_close(s, &s->clients[i]);
+	}
+	for(i=0; i<TELEM_NSTREAMS; i++)
+		free(s->frame[i]);
+
+	printf("telemetry: %lu samples published, %lu lost.\n", s->npublished, s->nlost);
+
+	close(s->epfd);
+	close(s->evfd);
+	close(s->lsfd);
+	egi_ring_free(&s->ring);
+	free(s);
+	*svr=NULL;
+}
+
+/*-----------------------------------------------------------------------
+Publish a sample, from ONE thread only, e.g. the control loop.
+It never blocks, the sample is lost if the server thread falls behind.
+The server thread is woken by the eventfd only if it sleeps and the
+sample starts a frame or fills it up, so it's one syscall a frame at
+most, and other samples cost no syscall.
+
+stream:  enum telem_stream
+ts_us:   timestamp of the sample, in us, <=0 to use CLOCK_MONOTONIC now.
+val:     [nchan] values
+Return:
+	0   OK
+	<0  invalid args, or the sample is lost
+-----------------------------------------------------------------------*/
+int telem_publish(struct telem_server *svr, int stream, int64_t ts_us, const float *val, int nchan)
+{
+	struct telem_sample s;
+
+	if(svr==NULL || stream<0 || stream>=TELEM_NSTREAMS || nchan<1 || nchan>TELEM_MAX_CHAN)
+		return -1;
+
+	s.ts_us= ts_us>0 ? ts_us : telem_clock_us();
+	s.stream=stream;
+	s.nchan=nchan;
+	memcpy(s.val, val, nchan*sizeof(float));
+
+	if( egi_ring_push(svr->ring, &s, 1)==0 )
+	{
+		svr->nlost++;
+		return -2;
+	}
+	svr->npublished++;
+	svr->npushed[stream]++;
+
+	//----- pairs with the server: set wake_at[], waiting, then recheck the ring
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if( __atomic_load_n(&svr->waiting, __ATOMIC_ACQUIRE)
+	    && (int32_t)(svr->npushed[stream]-__atomic_load_n(&svr->wake_at[stream], __ATOMIC_RELAXED)) >=0 )
+		server_wake(svr);
+
+	return 0;
+}
@@ -0,0 +1,137 @@
+/*----------------------------------------------------------------------
+Telemetry publisher: batched binary frames to multiple TCP clients.
+
+1. The control loop calls telem_publish() for each sample, which only
+   pushes it to an EGI_RING(wegi/utils/egi_ring.h), no lock, no syscall.
+2. A server thread pulls samples from the ring, batches them into frames
+   of up to batch_n samples or batch_ms milliseconds, one frame for each
+   stream(raw or filtered), and serves all clients by epoll with
+   non-blocking sockets.
+3. Each client has its own frame queue, when it's full because the client
+   is slow, the client's policy decides: drop the new frame, drop the old
+   queued frames, or close the client. A dropped frame shows up as a gap
+   of seq at the client.
+4. A client subscribes by sending text lines, default is "SUB both":
+	SUB raw | SUB filtered | SUB both
+	POLICY drop_new | POLICY drop_old | POLICY close
+
+Frame format, little endian:
+	uint16_t magic		TELEM_MAGIC
+	uint8_t  version	TELEM_VERSION
+	uint8_t  stream		enum telem_stream
+	uint8_t  nchan		values for each sample
+	uint8_t  reserved
+	uint16_t nsamples
+	uint32_t seq		frame sequence number of the stream
+	int64_t  ts_us		timestamp of the first sample, in us
+	nsamples x {
+		uint32_t dt_us		timestamp offset from ts_us
+		float    val[nchan]
+	}
+
+Midas
+----------------------------  COPYLEFT  --------------------------------*/
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "egi_ring.h"
+
+#define TELEM_PORT		5556
+#define TELEM_MAGIC		0x4754	//"TG" in little endian
+#define TELEM_VERSION		1
+#define TELEM_HEADER_SIZE	20
+#define TELEM_MAX_CHAN		8	//max. values of a sample
+#define TELEM_MAX_BATCH		256	//max. samples of a frame
+#define TELEM_MAX_CLIENTS	8
+#define TELEM_CLIENT_QFRAMES	64	//frame queue size of a client
+#define TELEM_RING_SAMPLES	1024	//ring between telem_publish() and the server thread
+
+enum telem_stream {
+	TELEM_RAW=0,
+	TELEM_FILTERED=1,
+	TELEM_NSTREAMS=2,
+};
+
+//----- subscription mask of a client
+#define TELEM_SUB_RAW		(1<<TELEM_RAW)
+#define TELEM_SUB_FILTERED	(1<<TELEM_FILTERED)
+#define TELEM_SUB_BOTH		(TELEM_SUB_RAW|TELEM_SUB_FILTERED)
+
+//----- what to do when a client's queue is full
+enum telem_policy {
+	TELEM_DROP_NEW=0,	//drop the new frame
+	TELEM_DROP_OLD=1,	//drop queued frames not being sent yet
+	TELEM_CLOSE=2,		//close the client
+};
+
+//----- A sample passed from telem_publish() to the server thread
+struct telem_sample {
+	int64_t  ts_us;
+	uint8_t  stream;
+	uint8_t  nchan;
+	float    val[TELEM_MAX_CHAN];
+};
+
+//----- An encoded frame, shared by all clients
+struct telem_frame {
+	int		refs;		//clients holding it
+	int		nchan;
+	int		nsamples;
+	int		len;		//bytes of data
+	uint8_t		data[];
+};
+
+//----- A client and its frame queue
+struct telem_client {
+	int		fd;
+	int		sub;		//TELEM_SUB_xxx
+	int		policy;		//enum telem_policy
+	struct telem_frame *queue[TELEM_CLIENT_QFRAMES];
+	int		qhead;		//index of the frame being sent
+	int		qcount;
+	int		sent;		//bytes of the head frame sent
+	bool		wout;		//EPOLLOUT is on
+	char		cmd[64];	//partial command line
+	int		cmdlen;
+	unsigned long	nframes;	//frames sent
+	unsigned long	ndropped;	//frames dropped
+};
+
+//----- Telemetry Server
+struct telem_server {
+	int		lsfd;		//listening socket
+	int		epfd;
+	int		batch_n;	//max. samples of a frame
+	int		batch_ms;	//max. time span of a frame
+	EGI_RING	*ring;		//[] struct telem_sample
+	int		evfd;		//eventfd in epoll, to wake the server thread
+	int		waiting;	//the server thread is going to sleep in epoll_wait()
+	uint32_t	npushed[TELEM_NSTREAMS];	//samples pushed to the ring, publisher side
+	uint32_t	npulled[TELEM_NSTREAMS];	//samples pulled from the ring, server side
+	uint32_t	wake_at[TELEM_NSTREAMS];	//wake the server when npushed reaches it
+
+	//----- batching for each stream
+	struct telem_frame *frame[TELEM_NSTREAMS];	//frame being filled, or NULL
+	int64_t		frame_ts[TELEM_NSTREAMS];	//ts_us of its first sample
+	int64_t		frame_tm[TELEM_NSTREAMS];	//clock time of its first sample
+	uint32_t	seq[TELEM_NSTREAMS];
+
+	struct telem_client clients[TELEM_MAX_CLIENTS];	//fd<0 if not used
+	unsigned long	npublished;
+	unsigned long	nlost;		//samples lost as the ring is full
+
+	pthread_t	thread;
+	int		quit;
+};
+
+
+//------------------------     FUNCTION DECLARATION     ---------------------------
+struct telem_server *telem_server_start(uint16_t port, int batch_n, int batch_ms);
+void telem_server_stop(struct telem_server **svr);
+int64_t telem_clock_us(void);
+int telem_publish(struct telem_server *svr, int stream, int64_t ts_us, const float *val, int nchan);
+
+#endif
@@ -0,0 +1,128 @@
+/*-------------------------------------------------------------------
+ Frames-per-second benchmark for RM68140 SPI LCD, 320x480 18bits
+
+ 1. WriteNData() for each SPIBUFF bytes, as in RMshow18bit*.
+ 2. GRAM_Write() with chained SPI transfers.
+ 3. GRAM_Write565() from an RGB565 frame buffer, with conversion.
+
+ Usage:  RMfps_bench [frames]
+	 frames: number of frames for each test, default 30
+
+by midaszhou
+-------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <sys/time.h>
+#include "./RM68140.h"
+#include "./spi_gram.h"
+
+#define SPIBUFF 32   //-- spi write buff-size for SPI_Write()
+#define LCD_WIDTH 320
+#define LCD_HEIGHT 480
+
+static uint16_t fb565[LCD_WIDTH*LCD_HEIGHT];	//--RGB565 frame
+static uint8_t  fb666[LCD_WIDTH*LCD_HEIGHT*3];	//--RGB666 frame
+
+static void ExitClean();
+
+/*------- color bars, shifted by k lines for each frame -------*/
+static void draw_frame(int k)
+{
+ int x,y;
+ static const uint16_t bars[8]={0xffff,0xffe0,0x07ff,0x07e0,0xf81f,0xf800,0x001f,0x0000};
+
+ for(y=0;y<LCD_HEIGHT;y++)
+    for(x=0;x<LCD_WIDTH;x++)
+       fb565[y*LCD_WIDTH+x]=bars[ (((y+k)%LCD_HEIGHT)*8/LCD_HEIGHT + x*8/LCD_WIDTH)&7 ];
+}
+
+static double tm_diffs(struct timeval t_start, struct timeval t_end)
+{
+ return (t_end.tv_sec-t_start.tv_sec)+(t_end.tv_usec-t_start.tv_usec)/1000000.0;
+}
+
+//================================  <<   MAIN  >>  ====================================
+int main(int argc, char* argv[])
+{
+ int i,k;
+ int nframes=30;
+ int total=LCD_WIDTH*LCD_HEIGHT*3;
+ struct timeval t_start,t_end;
+ double fps[3];
+
+ if(argc>1)
+    nframes=atoi(argv[1]);
+ if(nframes<1)
+    nframes=1;
+
+ signal(SIGINT,ExitClean);
+
+ /* -------------------    SPI  and PIN control initiation ------------------*/
+ SPI_Open();
+ setPinMmap();
+
+ /* --------------------   Init LCD, 18bits pixel   ---------------------------- */
+ LCD_HD_reset();
+ LCD_INIT_RM68140();
+ WriteComm(0x3a); WriteData(0x66);  //set pixel format 18bits pixel
+ WriteComm(0x36); WriteData(0x00);
+
+ /*-------- 1. WriteNData() for each SPIBUFF bytes ---------*/
+ draw_frame(0);
+ GRAM_rgb565_to_666(fb565,fb666,LCD_WIDTH*LCD_HEIGHT);
+ gettimeofday(&t_start,NULL);
+ for(k=0;k<nframes;k++)
+ {
+    GRAM_Block_Set(0,LCD_WIDTH-1,0,LCD_HEIGHT-1);
+    WriteComm(0x2c);
+    for(i=0;i+SPIBUFF<=total;i+=SPIBUFF)
+        WriteNData(fb666+i,SPIBUFF);
+    if(i<total)
+        WriteNData(fb666+i,total-i);
+ }
+ gettimeofday(&t_end,NULL);
+ fps[0]=nframes/tm_diffs(t_start,t_end);
+
+ /*-------- 2. GRAM_Write(), chained SPI transfers ---------*/
+ gettimeofday(&t_start,NULL);
+ for(k=0;k<nframes;k++)
+ {
+    GRAM_Block_Set(0,LCD_WIDTH-1,0,LCD_HEIGHT-1);
+    WriteComm(0x2c);
+    GRAM_Write(fb666,total);
+ }
+ gettimeofday(&t_end,NULL);
+ fps[1]=nframes/tm_diffs(t_start,t_end);
+
+ /*-------- 3. GRAM_Write565(), moving color bars ---------*/
+ gettimeofday(&t_start,NULL);
+ for(k=0;k<nframes;k++)
+ {
+    draw_frame(k*8);
+    GRAM_Block_Set(0,LCD_WIDTH-1,0,LCD_HEIGHT-1);
+    WriteComm(0x2c);
+    GRAM_Write565(fb565,LCD_WIDTH,LCD_HEIGHT,LCD_WIDTH);
+ }
+ gettimeofday(&t_end,NULL);
+ fps[2]=nframes/tm_diffs(t_start,t_end);
+
+ printf("%dx%d 18bits, %d frames for each test, SPI %dMHz\n",LCD_WIDTH,LCD_HEIGHT,nframes,speed/1000000);
+ printf("WriteNData() per %d bytes:   %.2f fps\n",SPIBUFF,fps[0]);
+ printf("GRAM_Write(), %d segs/ioctl: %.2f fps %s\n",GRAM_MAXSEGS,fps[1],
+						gram_nobatch ? "(chained message refused!)":"");
+ printf("GRAM_Write565() with drawing: %.2f fps\n",fps[2]);
+
+ SPI_Close();
+ resPinMmap();
+ return 0;
+}
+
+/*--------------- clean work when forced to exit -----------*/
+static void ExitClean()
+{
+ SPI_Close();
+ resPinMmap();
+ exit(0);
+}
@@ -8,6 +8,7 @@ by midaszhou
 #include <stdint.h> // data type
 #include <signal.h>
 #include "./RM68140.h"
+#include "./spi_gram.h"
 #include <sys/time.h>
 #include <dirent.h>
 #include <sched.h> // scheduler set
@@ -219,19 +220,14 @@ while(1)
 
      //-------------------- read RGB data from the file  and write to GRAM ----------------
          total=picWidth*picHeight*3; //--total bytes for BGR data
-         nbuff=total/SPIBUFF;
-         residual=total%SPIBUFF;
 
          offp=54; //--- start point where BGR data begins
          oftemp=offp+pmap;
 
-         for(i=0;i<nbuff;i++)
-         {
-                 //-----------write BGR interface to LCD, first 6bits of each 8bits for very color is valid ------------
-                 WriteNData(oftemp+i*SPIBUFF,SPIBUFF);
-         }
-         if(residual!=0)
-                 WriteNData(offp+pmap+i*SPIBUFF,residual);
+         //-----------write BGR interface to LCD, first 6bits of each 8bits for very color is valid ------------
+         //--- SPIBUFF segments are chained in each ioctl, instead of one WriteNData() for each of them.
+         if(GRAM_Write(oftemp,total)!=total)
+                 printf("Fail to write all data to GRAM!\n");
 
     printf("---------------------   Finish drawing the picture -------------\n");
 
@@ -0,0 +1,302 @@
+#ifndef _ADS_ACFT_H
+#define _ADS_ACFT_H
+
+/*-------------------------------------------------------------------
+ Aircraft state table for ADS-B decoding
+
+ 1. Open-addressing hash table keyed on full ICAO24, with linear
+    probing, all slots in one flat array, no malloc per aircraft.
+ 2. Each slot holds CALL-SIGN, last EVEN/ODD CPR frames with time
+    stamps, and decoded position/velocity of an aircraft, so position
+    halves of different aircrafts never mix up.
+ 3. An aircraft not heard for ACFT_TTL seconds is evicted, slots are
+    deleted by backward shifting, no tombstones.
+ 4. Snapshot: a compact binary file of ICAO24, CALL-SIGN and last
+    position of each aircraft, replacing the old hash data file.
+
+midaszhou@qq.com
+-------------------------------------------------------------------*/
+#include <stdlib.h>  //malloc()
+#include <string.h>  //memset()
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h> //uint32_t
+#include <time.h> //clock_gettime()
+
+#define ACFT_TABLE_SIZE 1024  //--power of 2, Max. 3/4 of it to be used.
+#define ACFT_TTL 300	      //--seconds, an aircraft not heard for ACFT_TTL will be evicted.
+#define ACFT_SNAPSHOT_MAGIC 0x31534441  //--"ADS1"
+
+#define ACFT_FLAG_CALLSIGN  (1<<0)
+#define ACFT_FLAG_POSITION  (1<<1)
+#define ACFT_FLAG_VELOCITY  (1<<2)
+
+/*=====================================================================
+                     AIRCRAFT  DATA  STRUCT  DEFINITION
+=====================================================================*/
+typedef struct _ACFT_DATA
+{
+  uint32_t int_ICAO24;     //--key, 0 as an empty slot
+  uint32_t flags;	   //--ACFT_FLAG_xxx
+  uint32_t tm_seen;	   //--seconds, monotonic time of last heard
+  char str_CALL_SIGN[9];
+
+  uint32_t lat_cpr[2];     //--17bits CPR latitude of [EVEN_FRAME] and [ODD_FRAME]
+  uint32_t lon_cpr[2];     //--17bits CPR longitude
+  long long tm_cpr[2];     //--ms, monotonic time stamp of the CPR frame, 0 as none
+
+  double dbl_lat;	   //--decoded position
+  double dbl_lon;
+  float  flt_speed;        //--knots, ground speed
+  float  flt_heading;      //--degree, [0 360)
+  int    int_vrate;        //--ft/min, vertical rate
+}ACFT_DATA;
+
+typedef struct _ACFT_TABLE
+{
+  int count;			   //--slots in use
+  ACFT_DATA slot[ACFT_TABLE_SIZE];
+}ACFT_TABLE;
+
+/* compact record in snapshot file, after a header of magic and count */
+typedef struct _ACFT_RECORD
+{
+  uint32_t icao_flags;     //--ICAO24 in low 24bits, flags in high 8bits
+  char     str_CALL_SIGN[8];
+  float    flt_lat;
+  float    flt_lon;
+}ACFT_RECORD;
+
+
+/*=====================================================================
+                     AIRCRAFT TABLE  FUNCTIONS   DEFINITION
+=====================================================================*/
+
+//---------- monotonic time in seconds and ms ------------
+uint32_t acft_time_sec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec;
+}
+
+long long acft_time_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (long long)ts.tv_sec*1000+ts.tv_nsec/1000000;
+}
+
+//---------create and initilize an aircraft table  ---------------
+ACFT_TABLE* create_acft_table(void)
+{
+  ACFT_TABLE* pTbl=(ACFT_TABLE*)malloc(sizeof(ACFT_TABLE));
+  if(pTbl!=NULL)
+     memset(pTbl,0,sizeof(ACFT_TABLE));
+  return pTbl;
+}
+
+void release_acft_table(ACFT_TABLE* pTbl)
+{
+  free(pTbl);
+}
+
+//------ home slot of an ICAO24, Fibonacci hashing --------
+static inline int acft_slot_num(uint32_t int_ICAO24)
+{
+  return ((int_ICAO24*2654435761u)>>16)&(ACFT_TABLE_SIZE-1);
+}
+
+//---------------- find an aircraft, NULL if not in table --------------
+ACFT_DATA* find_acft(ACFT_TABLE* pTbl,uint32_t int_ICAO24)
+{
+  int k;
+
+  if(pTbl==NULL || int_ICAO24==0)
+     return NULL;
+
+  for(k=acft_slot_num(int_ICAO24); pTbl->slot[k].int_ICAO24!=0; k=(k+1)&(ACFT_TABLE_SIZE-1))
+  {
+     if(pTbl->slot[k].int_ICAO24==int_ICAO24)
+        return &pTbl->slot[k];
+  }
+  return NULL;
+}
+
+//------------- delete slot k and shift following slots back ------------
+static void acft_delete_slot(ACFT_TABLE* pTbl,int k)
+{
+  int j,h;
+
+  j=k;
+  while(1)
+  {
+     j=(j+1)&(ACFT_TABLE_SIZE-1);
+     if(pTbl->slot[j].int_ICAO24==0)
+        break;
+     h=acft_slot_num(pTbl->slot[j].int_ICAO24);
+     //--move slot j to the hole k, only if its home slot h is NOT in (k,j]
+     if( (j>k && (h<=k || h>j)) || (j<k && (h<=k && h>j)) )
+     {
+        pTbl->slot[k]=pTbl->slot[j];
+        k=j;
+     }
+  }
+  memset(&pTbl->slot[k],0,sizeof(ACFT_DATA));
+  pTbl->count--;
+}
+
+//------------- delete an aircraft from table ------------
+bool delete_acft(ACFT_TABLE* pTbl,uint32_t int_ICAO24)
+{
+  ACFT_DATA* pAcft=find_acft(pTbl,int_ICAO24);
+
+  if(pAcft==NULL)
+     return false;
+  acft_delete_slot(pTbl,pAcft-pTbl->slot);
+  return true;
+}
+
+/*-------------------------------------------------------------------
+ Evict aircrafts not heard for ACFT_TTL seconds.
+ Return: number of aircrafts evicted.
+-------------------------------------------------------------------*/
+int expire_acft_table(ACFT_TABLE* pTbl,uint32_t tm_now)
+{
+  int k;
+  int cnt=0;
+
+  for(k=0;k<ACFT_TABLE_SIZE;k++)
+  {
+     //--slot k may be refilled by backward shifting, so check it again
+     while(pTbl->slot[k].int_ICAO24!=0 && tm_now-pTbl->slot[k].tm_seen>=ACFT_TTL)
+     {
+        acft_delete_slot(pTbl,k);
+        cnt++;
+     }
+  }
+  return cnt;
+}
+
+/*-------------------------------------------------------------------
+ Get an aircraft from table, insert a new one if not found.
+ tm_seen of the aircraft is updated with tm_now.
+ Return: NULL if table is full even after eviction.
+-------------------------------------------------------------------*/
+ACFT_DATA* get_acft(ACFT_TABLE* pTbl,uint32_t int_ICAO24,uint32_t tm_now)
+{
+  int k;
+
+  if(pTbl==NULL || int_ICAO24==0)
+     return NULL;
+
+  for(k=acft_slot_num(int_ICAO24); pTbl->slot[k].int_ICAO24!=0; k=(k+1)&(ACFT_TABLE_SIZE-1))
+  {
+     if(pTbl->slot[k].int_ICAO24==int_ICAO24) {
+        pTbl->slot[k].tm_seen=tm_now;
+        return &pTbl->slot[k];
+     }
+  }
+
+  //--keep load factor under 3/4
+  if(pTbl->count >= ACFT_TABLE_SIZE*3/4) {
+     if(expire_acft_table(pTbl,tm_now)==0)
+        return NULL;
+     return get_acft(pTbl,int_ICAO24,tm_now);
+  }
+
+  memset(&pTbl->slot[k],0,sizeof(ACFT_DATA));
+  pTbl->slot[k].int_ICAO24=int_ICAO24;
+  pTbl->slot[k].tm_seen=tm_now;
+  pTbl->count++;
+
+  return &pTbl->slot[k];
+}
+
+//=========================  save snapshot to file ==================
+int save_acft_snapshot(const char* str_FILE,ACFT_TABLE* pTbl)
+{
+ FILE *fp;
+ char str_TMP[256];
+ uint32_t head[2];
+ ACFT_RECORD rec;
+ int k;
+
+ //--write to a temp. file and then rename it, so a broken snapshot never replaces the old one
+ snprintf(str_TMP,sizeof(str_TMP),"%s.tmp",str_FILE);
+ if((fp=fopen(str_TMP,"w"))==NULL)
+ {
+    printf("fail to open %s\n",str_TMP);
+    return -1;
+ }
+
+ head[0]=ACFT_SNAPSHOT_MAGIC;
+ head[1]=pTbl->count;
+ fwrite(head,sizeof(head),1,fp);
+
+ for(k=0;k<ACFT_TABLE_SIZE;k++)
+ {
+    if(pTbl->slot[k].int_ICAO24==0)
+        continue;
+    rec.icao_flags=(pTbl->slot[k].int_ICAO24&0xffffff) | ((pTbl->slot[k].flags&0xff)<<24);
+    memcpy(rec.str_CALL_SIGN,pTbl->slot[k].str_CALL_SIGN,8);
+    rec.flt_lat=pTbl->slot[k].dbl_lat;
+    rec.flt_lon=pTbl->slot[k].dbl_lon;
+    fwrite(&rec,sizeof(rec),1,fp);
+ }
+
+ if(fclose(fp)!=0 || rename(str_TMP,str_FILE)!=0)
+ {
+    printf("fail to save %s\n",str_FILE);
+    return -2;
+ }
+ return 0;
+}
+
+/*----------------- restore snapshot ----------------------
+ Aircrafts restored are deemed as just heard at tm_now,
+ CPR frames and velocity are NOT saved.
+ Return: number of aircrafts restored, <0 fails.
+----------------------------------------------------------*/
+int restore_acft_snapshot(const char* str_FILE,ACFT_TABLE* pTbl,uint32_t tm_now)
+{
+ FILE *fp;
+ uint32_t head[2];
+ ACFT_RECORD rec;
+ ACFT_DATA *pAcft;
+ int i;
+ int cnt=0;
+
+ if((fp=fopen(str_FILE,"r"))==NULL)
+ {
+    printf("fail to open %s\n",str_FILE);
+    return -1;
+ }
+ if(fread(head,sizeof(head),1,fp)!=1 || head[0]!=ACFT_SNAPSHOT_MAGIC)
+ {
+    printf("%s is not an aircraft snapshot\n",str_FILE);
+    fclose(fp);
+    return -2;
+ }
+ for(i=0;i<head[1];i++)
+ {
+    if(fread(&rec,sizeof(rec),1,fp)!=1)
+        break;
+    pAcft=get_acft(pTbl,rec.icao_flags&0xffffff,tm_now);
+    if(pAcft==NULL)
+        break;
+    pAcft->flags=(rec.icao_flags>>24)&(ACFT_FLAG_CALLSIGN|ACFT_FLAG_POSITION);
+    memcpy(pAcft->str_CALL_SIGN,rec.str_CALL_SIGN,8);
+    pAcft->str_CALL_SIGN[8]='\0';
+    pAcft->dbl_lat=rec.flt_lat;
+    pAcft->dbl_lon=rec.flt_lon;
+    cnt++;
+ }
+
+ fclose(fp);
+ return cnt;
+}
+
+//======================================  AIRCRAFT TABLE DEFINITION FINISH  ========================
+
+#endif
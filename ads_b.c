@@ -21,16 +21,18 @@ midaszhou@qq.com
 #include <signal.h> //signal()
 #include "cstring.h" //strmid(),trim_strfb(),str_findb()
 #include "adsb_crc.h" //adsb_crc24( )
-#include "ads_hash.h" // hash table and data save
+#include "ads_acft.h" // aircraft state table and snapshot
 
 static int PRINT_ON=0;
-HASH_TABLE* pHashTbl_CODE; //---hash for ICAO and CALLSIGN data save
+static int FIX_BITS=1; //--Max. number of error bits to fix in a code, 2 for aggressive mode.
+ACFT_TABLE* pAcftTbl; //---aircraft state table, keyed on ICAO24
+static volatile sig_atomic_t flag_save_data=0; //--set by timer handler to save snapshot
 static char  str_FILE[]="/tmp/ads.data"; //--file to save data
 
 #define BUFSIZE 40
 #define CODE_BIN_LENGTH 112
 #define CODE_HEX_LENGTH 28
-#define CODE_LIVE_TIME 40 //seconds, data's live time great than the value will be deemed as obsolete.
+#define CODE_LIVE_TIME 10 //seconds, EVEN and ODD CPR frames with a greater time gap will NOT be paired.
 static char LOOKUP_TABLE[]="#ABCDEFGHIJKLMNOPQRSTUVWXYZ#####_###############0123456789######";
 #define EVEN_FRAME 0
 #define ODD_FRAME 1
@@ -75,12 +77,129 @@ static double mod(double x,double y)
 }
 
 
+/*-----------------------------------------------------------------
+ get 'len' bits from a 112bits code, starting from bit 'start'(from 0)
+-----------------------------------------------------------------*/
+static uint32_t get_bits(const uint32_t *bin32_code, int start, int len)
+{
+  uint64_t val;
+  int k=start/32;
+
+  val=((uint64_t)bin32_code[k]<<32) | (k<3 ? bin32_code[k+1] : 0);
+  return (val>>(64-(start%32)-len)) & ((1ULL<<len)-1);
+}
+
+
+/*------------------------------------------------------------------------
+ Decode global position from EVEN and ODD CPR frames of an aircraft.
+ The more recent frame decides the final Lat. and Long.
+ Return: 0 OK, position updated in pAcft;  <0 frames can't be paired.
+------------------------------------------------------------------------*/
+static int decode_cpr_position(ACFT_DATA *pAcft)
+{
+ double  dbl_lat_cpr_even,dbl_lon_cpr_even;  //--even frame latitude and longitude factor value
+ double  dbl_lat_cpr_odd,dbl_lon_cpr_odd; //--odd frame latitude and longitude factor value
+ int int_lat_index; // latitude index
+ double dbl_lat_even,dbl_lat_odd; //--relative latitude values
+ double dbl_lat_val,dbl_lon_val; //--final latitude and longitude valudes
+ double dbl_DLon;// =360/int_NI
+ int  int_EVEN_NL,int_ODD_NL;
+ int  int_NI; // =MAX(NL(Late),1)
+ int  int_M;
+
+ //--- both frames available and fresh
+ if(pAcft->tm_cpr[EVEN_FRAME]==0 || pAcft->tm_cpr[ODD_FRAME]==0)
+     return -1;
+ if(llabs(pAcft->tm_cpr[EVEN_FRAME]-pAcft->tm_cpr[ODD_FRAME]) >= CODE_LIVE_TIME*1000)
+     return -2;
+
+ dbl_lat_cpr_even=pAcft->lat_cpr[EVEN_FRAME]/131072.0; //--2^17=131072
+ dbl_lon_cpr_even=pAcft->lon_cpr[EVEN_FRAME]/131072.0;
+ dbl_lat_cpr_odd=pAcft->lat_cpr[ODD_FRAME]/131072.0;
+ dbl_lon_cpr_odd=pAcft->lon_cpr[ODD_FRAME]/131072.0;
+
+ //-------------------------   calculate Latitude Index  ----------------------------
+ int_lat_index=floor(59.0*dbl_lat_cpr_even-60.0*dbl_lat_cpr_odd+1/2.0);
+
+ //-------------------------   calculate Latitude Value  ----------------------------
+ dbl_lat_even=360.0/60.0*(mod(int_lat_index,60)+dbl_lat_cpr_even);
+ dbl_lat_odd=360.0/59.0*(mod(int_lat_index,59)+dbl_lat_cpr_odd);
+ //--convert value to within [-90,+90]
+ if(dbl_lat_even >=270.0)dbl_lat_even-=360.0;
+ if(dbl_lat_odd >=270.0)dbl_lat_odd-=360.0;
+ int_EVEN_NL=get_NL(dbl_lat_even);
+ int_ODD_NL=get_NL(dbl_lat_odd);
+ if(int_EVEN_NL!=int_ODD_NL) //--ensure they are in the same lat zone.
+     return -3;
+
+ //------- compare time value of even and odd frame, get final Latitude and Longitutde -----
+ if(pAcft->tm_cpr[EVEN_FRAME] >= pAcft->tm_cpr[ODD_FRAME])
+ {
+     dbl_lat_val=dbl_lat_even;  //---final Lat. value
+     int_NI=max(int_EVEN_NL,1);
+     dbl_DLon=360.0/int_NI;
+     int_M=floor(dbl_lon_cpr_even*(int_EVEN_NL-1)-dbl_lon_cpr_odd*int_EVEN_NL+0.5);
+     dbl_lon_val=dbl_DLon*(mod(int_M,int_NI)+dbl_lon_cpr_even);
+ }
+ else  //----tv_odd > tv_even
+ {
+     dbl_lat_val=dbl_lat_odd;  //----final Lat. value
+     int_NI=max((int_ODD_NL-1),1);
+     dbl_DLon=360.0/int_NI;
+     int_M=floor(dbl_lon_cpr_even*(int_ODD_NL-1)-dbl_lon_cpr_odd*int_ODD_NL+0.5);
+     dbl_lon_val=dbl_DLon*(mod(int_M,int_NI)+dbl_lon_cpr_odd);
+ }
+ if(dbl_lon_val>=180)dbl_lon_val-=360.0;//--convert to [-180 180]
+
+ pAcft->dbl_lat=dbl_lat_val;
+ pAcft->dbl_lon=dbl_lon_val;
+ pAcft->flags |= ACFT_FLAG_POSITION;
+
+ return 0;
+}
+
+
+/*------------------------------------------------------------------------
+ Decode airborne velocity, TC=19 subtype 1 and 2(supersonic) only.
+ Return: 0 OK, velocity updated in pAcft;  <0 not available.
+------------------------------------------------------------------------*/
+static int decode_velocity(ACFT_DATA *pAcft, const uint32_t *bin32_code)
+{
+ int subtype;
+ int vew,vns,vr;
+ double pi=3.1415926535897932;
+
+ subtype=get_bits(bin32_code,37,3); //--ME bits 6-8
+ if(subtype!=1 && subtype!=2)
+     return -1;
+
+ vew=get_bits(bin32_code,46,10);  //--ME bits 15-24
+ vns=get_bits(bin32_code,57,10);  //--ME bits 26-35
+ vr=get_bits(bin32_code,69,9);    //--ME bits 38-46
+ if(vew==0 || vns==0)
+     return -2;  //--no velocity information
+
+ vew=(vew-1)*(subtype==2 ? 4:1);
+ vns=(vns-1)*(subtype==2 ? 4:1);
+ if(get_bits(bin32_code,45,1)) vew=-vew;  //--flying West
+ if(get_bits(bin32_code,56,1)) vns=-vns;  //--flying South
+
+ pAcft->flt_speed=sqrt(vew*vew+vns*vns);
+ pAcft->flt_heading=mod(atan2(vew,vns)*180.0/pi,360.0);
+ if(vr!=0)
+     pAcft->int_vrate=(get_bits(bin32_code,68,1) ? -1:1)*(vr-1)*64;
+ pAcft->flags |= ACFT_FLAG_VELOCITY;
+
+ return 0;
+}
+
+
 //------------- INTERRUPT TO EXIT SIGNAL HANDLER ---------------
 static void sighandler(int sig)
 {
   printf("Signal to exit......\n");
-  save_hash_data(str_FILE,pHashTbl_CODE);
-  release_hash_table(pHashTbl_CODE);
+  save_acft_snapshot(str_FILE,pAcftTbl);
+  release_acft_table(pAcftTbl);
   exit(0); 
 }
 
@@ -95,11 +214,10 @@ void set_timer(void)
  setitimer(ITIMER_REAL,&itv,NULL);
 }
 
-//------------  timer handler: save hash data ------------
+//------------  timer handler: let main loop save snapshot ------------
 void timer_save_data(int sig)
 {
-  printf("\n   +++++++++++ timer handler: save hash data ++++++++++\n\n"); 
-  save_hash_data(str_FILE,pHashTbl_CODE);
+  flag_save_data=1;
 }
 
 
@@ -121,7 +239,6 @@ int int_ret; //-read STDIN_FILENO  return;
 
 char str_ICAO24[6+1]=""; //--4*6=24bits
 uint32_t  int_ICAO24;
-uint32_t  int_EVEN_ICAO24,int_ODD_ICAO24;// ICAO for even and odd frames
 int  int_FRAME; // 1 or 0
 char str_BIN_CODE[CODE_BIN_LENGTH-1];
 char str_Temp[8];
@@ -130,36 +247,27 @@ int n_div=CODE_HEX_LENGTH/8+1; // =4
 int nj,i,j,k,tmp;
 int  int_CODE_DF; 
 int  int_CODE_TC;
-int  int_NL; //number of latitude zones
-int  int_EVEN_NL,int_ODD_NL;
-int  int_NI; // =MAX(NL(Late),1)
-int  int_M;
 uint32_t bin32_code[4]; //store binary ADS-B CODE in 4 groups of 32bit array, meaningful data 112bits
 uint32_t bin32_message[3]; //88bits meaningful,message data in the 112-bits CODE after ripping 24bits CRC, used as dividend in CRC calculation.
 uint32_t bin32_checksum; // checksum in ADS-B  message, last 24bits in bin32_code.
 uint32_t bin32_CRC24; //CRC calculated from bin32_message
 
-int int_ret_errorfix; // return value from adsb_fixerror_slow()
+int int_ret_errorfix; // return value from adsb_fixerror()
 int int_ret_opt;// retrun value from getopt()
 
-double  dbl_lat_cpr_even=0,dbl_lon_cpr_even=0;  //--even frame latitude and longitude factor value
-double  dbl_lat_cpr_odd=0,dbl_lon_cpr_odd=0; //--odd frame latitude and longitude factor value
-int int_lat_index; // latitude index
-double dbl_lat_even,dbl_lat_odd; //--relative latitude values
-double dbl_lat_val,dbl_lon_val; //--final latitude and longitude valudes
-double dbl_DLon;// =360/int_NI
-struct timeval tv_even,tv_odd;//---time stamp
 time_t tm_record; //--record time 
+uint32_t tm_now; //--monotonic seconds
+uint32_t tm_expire=0; //--last time of evicting obsolete aircrafts
 
 int stdflag; //STD_FILENO flag
-STRUCT_DATA ads_data;
+ACFT_DATA *pAcft; //--aircraft of current code
 
 //------------- intterupt to exit signal handle --------
 signal(SIGINT,sighandler);
 
 
 //-------------- get option -----------------
-while( (int_ret_opt=getopt(argc,argv,"hd"))!=-1)
+while( (int_ret_opt=getopt(argc,argv,"hda"))!=-1)
 {
     switch(int_ret_opt)
     {
@@ -167,25 +275,39 @@ while( (int_ret_opt=getopt(argc,argv,"hd"))!=-1)
            printf("usage:  rtl_adsb | ads_b \n");   
            printf("         -h   help \n");   
            printf("         -d   printf debug information \n");   
-           printf("ICAO and corresponding CALL-SIGN will be saved every 30 minutes.");
+           printf("         -a   aggressive mode, try to fix 2bits error \n");   
+           printf("Snapshot of aircrafts(ICAO, CALL-SIGN and position) will be saved every 30 minutes.\n");
            printf("Please check /tmp/ads.data for saved data\n");
-           printf("Saved data is reloaded to hash table at start.")
+           printf("Saved data is reloaded to aircraft table at start.\n");
            return;
        case 'd':
            printf("----- Debug information available now! \n");
            PRINT_ON=1;
            break;
+       case 'a':
+           printf("----- Aggressive mode, fix 2bits error! \n");
+           FIX_BITS=2;
+           break;
        default:
            break;
     }//--end switch
 }//--end while()
 
 
-//---------------------  hash table prepararton  --------------------
-pHashTbl_CODE=create_hash_table(); //---init hash table
+//---------------------  CRC and syndrome tables  --------------------
+adsb_crc_init();
 
-//--------------------- restore hash data from file -------------
-restore_hash_data(str_FILE,pHashTbl_CODE);
+//---------------------  aircraft table prepararton  --------------------
+pAcftTbl=create_acft_table(); //---init aircraft table
+if(pAcftTbl==NULL) {
+   printf("Fail to create aircraft table!\n");
+   return;
+}
+
+//--------------------- restore snapshot from file -------------
+int_ret=restore_acft_snapshot(str_FILE,pAcftTbl,acft_time_sec());
+if(int_ret>0)
+   printf("%d aircrafts restored from %s\n",int_ret,str_FILE);
 
 //---------------------  set timer alarm signal ----------------
 signal(SIGALRM,timer_save_data);
@@ -228,8 +350,8 @@ for(i=0;i<4;i++) //---convert CODE to bin type
    // printf("%x",bin32_code[i]); 
  }
 
-//------- try to fix 1bit error in original code ---------
-int_ret_errorfix=adsb_fixerror_slow(bin32_code);
+//------- try to fix 1bit(or 2bits) error in original code, by syndrome lookup ---------
+int_ret_errorfix=adsb_fixerror(bin32_code,FIX_BITS);
 if(int_ret_errorfix<0)continue;  // !!!!!!!! WARNING !!!!!!!! temporarily suspending until CALLSIGN printed --if can't fix the error then drop it.
 
 //------- get checksum at last 24bits of codes -----------
@@ -260,6 +382,27 @@ int_ICAO24=(bin32_code[0]&0xffffff);
 //-------------------------  get int_FRAME  ----------------------------
 int_FRAME=(bin32_code[1]>>(32-(54-32)))&(0b1);
 
+//--------------- evict obsolete aircrafts and save snapshot -----------
+tm_now=acft_time_sec();
+if(tm_now-tm_expire>=10) {
+   expire_acft_table(pAcftTbl,tm_now);
+   tm_expire=tm_now;
+}
+if(flag_save_data) {
+   flag_save_data=0;
+   printf("\n   +++++++++++ save aircraft snapshot, %d aircrafts ++++++++++\n\n",pAcftTbl->count);
+   save_acft_snapshot(str_FILE,pAcftTbl);
+}
+
+//----- only DF17 codes are decoded, and CRC must be OK or fixed -----
+if(int_CODE_DF!=17 || int_ret_errorfix<0)
+   continue;
+pAcft=get_acft(pAcftTbl,int_ICAO24,tm_now);
+if(pAcft==NULL) {
+   if(PRINT_ON)printf("Aircraft table is full, drop ICAO %06X\n",int_ICAO24);
+   continue;
+}
+
 //=======================   AIRCRAFT  IDENTIFICATION  CALCUALTION  ========================
 if(int_CODE_DF==17 && (int_CODE_TC>0 && int_CODE_TC<5))  //-------DF=17, TC=1to4  Aircraft identification
 {
@@ -279,19 +422,18 @@ if(int_CODE_DF==17 && (int_CODE_TC>0 && int_CODE_TC<5))  //-------DF=17, TC=1to4
   if(!str_findb(str_CALL_SIGN,'#')) //--It's valid only there is no '#' in the CALLSIGN
      {
 	 //printf("str_hexcode :%s   len=%d\n",str_hexcode,strlen(str_hexcode));
-         bin32_CRC24=adsb_crc(bin32_code,88); //calculate CRC 24
+         bin32_CRC24=adsb_crc_fast(bin32_code,88); //calculate CRC 24
 	 printf("\nReceived ADS-B CODES: %x%x%x%04x \n",bin32_code[0],bin32_code[1],bin32_code[2],bin32_code[3]>>16);
 	 printf("TC=%d    CRC24 =%06x    CHECKSUM =%06x\n",int_CODE_TC,bin32_CRC24,bin32_checksum);
 	 time(&tm_record); 
 	 printf("-----------------------------------------       CALL SIGN: %s       %s \n",str_CALL_SIGN,ctime(&tm_record));//ctime() will cause a line return 
 
-         //-----------------    hash ICAO code and corresponding CALL-SIGN    ------------------
-         ads_data.int_ICAO24=int_ICAO24;
-         strcpy(ads_data.str_CALL_SIGN,str_CALL_SIGN);
-         if(insert_data_into_hash(pHashTbl_CODE,&ads_data))
-              printf("#########   ICAO CODE and CALL-SIGN push into hash table successfully.  ##########\n");
-         else
-              printf("#########   ICAO CODE and CALL-SIGN already exist in hash table.  ##########\n");
+         //-----------------    save CALL-SIGN to the aircraft    ------------------
+         if(!(pAcft->flags&ACFT_FLAG_CALLSIGN) || strcmp(pAcft->str_CALL_SIGN,str_CALL_SIGN))
+              printf("#########   ICAO %06X  CALL-SIGN: %s  updated, %d aircrafts in table.  ##########\n",
+								int_ICAO24,str_CALL_SIGN,pAcftTbl->count);
+         strcpy(pAcft->str_CALL_SIGN,str_CALL_SIGN);
+         pAcft->flags |= ACFT_FLAG_CALLSIGN;
      }
 } ///----- Aircraft identification decode end
 
@@ -308,105 +450,31 @@ if(int_CODE_DF==17 && ((int_CODE_TC>8 && int_CODE_TC<19) || (int_CODE_TC>19 && i
 //int_NL=get_NL(lat);
 // printf("int_NL=%d \n",int_NL);
 
-//-----------------   calculate Latitude and Longitude factors ------------------
-if(int_FRAME==EVEN_FRAME)
-{
- int_EVEN_ICAO24=int_ICAO24;
- gettimeofday(&tv_even,0);
- //printf("Time stamp EVEN : %lds %ldus \n",tv_even.tv_sec,tv_even.tv_usec);
- dbl_lat_cpr_even= (((bin32_code[1] & 0x3ff)<<7) + (bin32_code[2]>>(32-7)))/131072.0; // 55-41 bit  2^17=131072 
- dbl_lon_cpr_even= ((bin32_code[2]>>8) & 0x1ffff)/131072.0; //72-88 bit
- if(PRINT_ON)printf("LAT_CPR_EVEN=%.16f \n  LON_CPR_EVEN=%.16f \n",dbl_lat_cpr_even,dbl_lon_cpr_even); 
-
- //-----check data live time----------
-  if(abs(tv_even.tv_sec-tv_odd.tv_sec)>=CODE_LIVE_TIME) //--obsolete ODD data 
-  {
-     int_ODD_ICAO24=0; // reset ODD ICAO, mark it as obsolete
-     continue;
-  }
-}
-else if(int_FRAME==ODD_FRAME)
-{
- int_ODD_ICAO24=int_ICAO24;
- gettimeofday(&tv_odd,0);
- //printf("Time stamp ODD : %lds %ldus \n",tv_odd.tv_sec,tv_odd.tv_usec);
- dbl_lat_cpr_odd= (((bin32_code[1] & 0x3ff)<<7) + (bin32_code[2]>>(32-7)))/131072.0; // 55-41 bit
- dbl_lon_cpr_odd= ((bin32_code[2]>>8) & 0x1ffff)/131072.0; //72-88 bit
- if(PRINT_ON)printf("LAT_CPR_ODD=%.16f \n  LON_CPR_ODD=%.16f \n",dbl_lat_cpr_odd,dbl_lon_cpr_odd);
-
- //-----check data live time----------
- if(abs(tv_odd.tv_sec-tv_even.tv_sec)>=CODE_LIVE_TIME) //--obsolete EVEN data 
+//-----------------   save CPR frame to the aircraft ------------------
+ pAcft->lat_cpr[int_FRAME]=((bin32_code[1] & 0x3ff)<<7) + (bin32_code[2]>>(32-7)); // 55-41 bit
+ pAcft->lon_cpr[int_FRAME]=(bin32_code[2]>>8) & 0x1ffff; //72-88 bit
+ pAcft->tm_cpr[int_FRAME]=acft_time_ms();
+ if(PRINT_ON)printf("ICAO %06X  %s  LAT_CPR=%.16f  LON_CPR=%.16f \n",int_ICAO24,(int_FRAME==ODD_FRAME)?"ODD":"EVEN",
+				pAcft->lat_cpr[int_FRAME]/131072.0, pAcft->lon_cpr[int_FRAME]/131072.0);
+
+//-----------------   decode position with EVEN and ODD frames of the same aircraft ------------------
+ if(decode_cpr_position(pAcft)==0)
  {
-    int_EVEN_ICAO24=0; // reset EVEN ICAO,mark it as obsolete 
-    continue;
+       printf("TC=%d     Received ADS-B CODES: %x%x%x%04x \n",int_CODE_TC,bin32_code[0],bin32_code[1],bin32_code[2],bin32_code[3]>>16);
+       printf("--- ICAO: %6X %s Fix_Error:%d  Lat: %.14fN Long: %.14fE ---\n",int_ICAO24,pAcft->str_CALL_SIGN,
+								int_ret_errorfix,pAcft->dbl_lat,pAcft->dbl_lon);
  }
-}
-
-if(int_ODD_ICAO24==int_EVEN_ICAO24) //--ensure thery are from same flight
-  {
-	//-------------------------   calculate Latitude Index  ----------------------------
-	//-- !!!!!!!!!!!! to ensure that lat_cpr_even and odd are both valid !!!!!!!!!!!
-	int_lat_index=floor(59.0*dbl_lat_cpr_even-60.0*dbl_lat_cpr_odd+1/2.0);
-	//printf("Latitude Index = %d \n",int_lat_index);
-
-	//-------------------------   calculate Latitude Value  ----------------------------
-	dbl_lat_even=360.0/60.0*(mod(int_lat_index,60)+dbl_lat_cpr_even);
-	dbl_lat_odd=360.0/59.0*(mod(int_lat_index,59)+dbl_lat_cpr_odd);
-	//--convert value to within [-90,+90]
-	if(dbl_lat_even >=270.0)dbl_lat_even-=360.0;
-	if(dbl_lat_odd >=270.0)dbl_lat_odd-=360.0;
-	//printf("Latitude-Even = %.14f \n",dbl_lat_even);
-	//printf("Latitude-Odd = %.14f \n",dbl_lat_odd);
-        int_EVEN_NL=get_NL(dbl_lat_even);
-        int_ODD_NL=get_NL(dbl_lat_odd);
-
-	//------- compare time value of even and odd frame, get final Latitude and Longitutde -----
-	if((tv_even.tv_sec > tv_odd.tv_sec) || ((tv_even.tv_sec==tv_odd.tv_sec) && (tv_even.tv_usec >= tv_odd.tv_usec)))
-	//--- if tv_even > tv_odd
-	{
- 	  dbl_lat_val=dbl_lat_even;  //---final Lat. value 
-  
-	  //-----------------   calculate Longitude Teven >Todd --------------------------
-	  if(int_EVEN_NL==int_ODD_NL) //--ensure they are in the same lat zone.
-	  {
-	     int_NI=max(int_EVEN_NL,1);
-	     dbl_DLon=360.0/int_NI;
-	     int_M=floor(dbl_lon_cpr_even*(int_EVEN_NL-1)-dbl_lon_cpr_odd*int_EVEN_NL+0.5);
-	     dbl_lon_val=dbl_DLon*(mod(int_M,int_NI)+dbl_lon_cpr_even);
-	//      printf(" tv_even>tv_odd final Longitude =%.14f \n",dbl_lon_val);
-	  }
-          else continue;
-	}
-	else  //----tv_odd > tv_even
-	{
-	  dbl_lat_val=dbl_lat_odd;  //----final Lat. value
-	  //-----------------   calculate Longitude Teven < Todd -------------------------
-	  if(int_EVEN_NL==int_ODD_NL) //--ensure they are in the same lat zone.
-	   {
-	      int_NI=max((int_ODD_NL-1),1);
-	//      printf("NL_odd=%d\n",(get_NL(dbl_lat_odd)));
-	 //     printf("int_NI=%d\n",int_NI);
-	      	dbl_DLon=360.0/int_NI;
-	 //     printf("DLon=%.14f\n",dbl_DLon);
-	 //     printf("LoncprE=%.14f  LoncprO=%.14f \n",dbl_lon_cpr_even,dbl_lon_cpr_odd);
-	      int_M=floor(dbl_lon_cpr_even*(int_ODD_NL-1)-dbl_lon_cpr_odd*int_ODD_NL+0.5);
-	 //     printf("int_M=%d\n",int_M);
-	      dbl_lon_val=dbl_DLon*(mod(int_M,int_NI)+dbl_lon_cpr_odd);
-	   }
-          else continue; 
-	}
-
-       if(dbl_lon_val>=180)dbl_lon_val-=360.0;//--convert to [-180 180]
-       //printf("Teven %lds ---  Todd %lds ---  Tgap %d \n",tv_even.tv_sec,tv_odd.tv_sec,abs(tv_even.tv_sec-tv_odd.tv_sec));
-      // printf("Teven %lds:%ldus          Todd %lds:%ldus \n",tv_even.tv_sec,tv_even.tv_usec,tv_odd.tv_sec,tv_odd.tv_usec);
-       printf("TC=%d     NL=%d     Received ADS-B CODES: %x%x%x%04x \n",int_CODE_TC,int_EVEN_NL,bin32_code[0],bin32_code[1],bin32_code[2],bin32_code[3]>>16);
-       printf("--- ICAO: %6X  Fix_Error:%d  Lat: %.14fN Long: %.14fE ---\n",int_ICAO24,int_ret_errorfix,dbl_lat_val,dbl_lon_val);
-
- }//-----end of  if(int_ODD_ICAO24==int_EVEN_ICAO24)
-	
 
 }//$$$$$$----- Airebore Position decode end ------$$$$$
 
+//===========================     AIRBOREN VELOCITY  CALCUALTION    =======================
+if(int_CODE_DF==17 && int_CODE_TC==19)
+{
+ if(decode_velocity(pAcft,bin32_code)==0 && PRINT_ON)
+       printf("--- ICAO: %6X %s  Speed: %.0fkt  Heading: %.1f  VRate: %dft/min ---\n",int_ICAO24,pAcft->str_CALL_SIGN,
+								pAcft->flt_speed,pAcft->flt_heading,pAcft->int_vrate);
+}
+
 /*
 printf("int_FRAME=%d \n",int_FRAME);
 printf("DF=%d \n",int_CODE_DF);
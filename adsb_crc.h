@@ -188,4 +188,152 @@ int adsb_fixerror_slow(uint32_t *bin32_code)
 }
 
 
+/*==========================================================================
+                  TABLE-DRIVEN CRC24 AND ERROR CORRECTION
+ Byte-wise CRC with a 256-entry table, and a syndrome table for 112bits
+ code, which maps CRC syndrome of any 1bit or 2bits error to its bit
+ position(s), so an error is fixed by one lookup instead of flipping each
+ bit and recalculating CRC.
+ Tables are built by adsb_crc_init(), it's also called at first use.
+===========================================================================*/
+#define ADSB_CRC24_GP		0xFFF409 /* CRC24 Generator Polynomial, without the highest bit */
+#define ADSB_SYND_TBLSIZE	16384	 /* syndrome hash table size, power of 2, > 2*(112+112*111/2) */
+
+typedef struct
+{
+   uint32_t syndrome;  /* CRC24 of the error pattern, 0 as empty slot */
+   int8_t   nbits;     /* 1 or 2 error bits, -1 as ambiguous syndrome, NOT fixable */
+   uint8_t  pos1;      /* position of error bits, starting from 0 */
+   uint8_t  pos2;
+} ADSB_SYND;
+
+static uint32_t adsb_crc_table[256];
+static ADSB_SYND adsb_synd_table[ADSB_SYND_TBLSIZE];
+static int adsb_crc_inited=0;
+
+void adsb_crc_init(void);
+
+/*-------------------------------------------------------------
+ Calculate CRC24 for the first 'nbits' of a code, byte by byte
+ *bin32_code:  full message, in 32bits groups, MSB first.
+ nbits:  width of message for CRC check, multiple of 8, Max.112
+ Return: 24bits CRC, same as adsb_crc()
+ Note: original data uncontaminated.
+--------------------------------------------------------------*/
+uint32_t adsb_crc_fast(const uint32_t *bin32_code, int nbits)
+{
+   uint32_t crc=0;
+   int i;
+
+   if(!adsb_crc_inited)
+      adsb_crc_init();
+
+   if(nbits>112)
+      nbits=112;
+
+   for(i=0;i<nbits/8;i++)
+      crc=(crc<<8)^adsb_crc_table[ ((crc>>16)^(bin32_code[i>>2]>>(24-8*(i&3))))&0xff ];
+
+   return crc&0xffffff;
+}
+
+
+/*------------------------------------------------------
+ Insert syndrome of an error pattern into the table.
+ A syndrome shared by two patterns is marked ambiguous.
+------------------------------------------------------*/
+static void adsb_synd_insert(uint32_t syndrome, int nbits, int pos1, int pos2)
+{
+   uint32_t k=(syndrome*2654435761u)>>18; /* Fibonacci hashing to 14bits */
+
+   while(adsb_synd_table[k].syndrome != 0)
+   {
+      if(adsb_synd_table[k].syndrome==syndrome) {
+         adsb_synd_table[k].nbits=-1;
+         return;
+      }
+      k=(k+1)&(ADSB_SYND_TBLSIZE-1);
+   }
+   adsb_synd_table[k].syndrome=syndrome;
+   adsb_synd_table[k].nbits=nbits;
+   adsb_synd_table[k].pos1=pos1;
+   adsb_synd_table[k].pos2=pos2;
+}
+
+
+/*--------------------------------------------------------
+ Build CRC table and 112bits syndrome table, call it once
+ before using adsb_crc_fast() and adsb_fixerror().
+--------------------------------------------------------*/
+void adsb_crc_init(void)
+{
+   uint32_t crc;
+   uint32_t synd[112]; /* syndrome of 1bit error at each position */
+   uint32_t code[4];
+   int i,j;
+
+   /* 1. byte CRC table */
+   for(i=0;i<256;i++)
+   {
+      crc=(uint32_t)i<<16;
+      for(j=0;j<8;j++)
+          crc = (crc&0x800000) ? ((crc<<1)^ADSB_CRC24_GP) : (crc<<1);
+      adsb_crc_table[i]=crc&0xffffff;
+   }
+   adsb_crc_inited=1;
+
+   /* 2. 1bit error syndromes, as CRC is linear, syndrome of 2bits error is XOR of the two */
+   for(i=0;i<112;i++)
+   {
+      memset(code,0,sizeof(code));
+      code[i/32]=0x80000000>>(i%32);
+      synd[i]=adsb_crc_fast(code,112);
+   }
+
+   memset(adsb_synd_table,0,sizeof(adsb_synd_table));
+   for(i=0;i<112;i++)
+      adsb_synd_insert(synd[i],1,i,0);
+   for(i=0;i<112;i++)
+      for(j=i+1;j<112;j++)
+         adsb_synd_insert(synd[i]^synd[j],2,i,j);
+}
+
+
+/*==========================================================================
+    -------  FIX 1BIT OR 2BITS ERROR IN MESSAGE, BY SYNDROME LOOKUP ---------
+     *bin32_code : full message, 112bits
+     maxbits:  Max. number of error bits to fix, 1 or 2.
+     Return:   -1:error unfixable;     0: no error;     >0: number of bits fixed;
+     Note: original data will be modified! !!! ensure pointer safe !!!!
+===========================================================================*/
+int adsb_fixerror(uint32_t *bin32_code, int maxbits)
+{
+   uint32_t syndrome;
+   uint32_t k;
+
+   syndrome=adsb_crc_fast(bin32_code,112);
+   if(!syndrome)
+      return 0;
+
+   k=(syndrome*2654435761u)>>18;
+   while(adsb_synd_table[k].syndrome != 0)
+   {
+      if(adsb_synd_table[k].syndrome==syndrome)
+      {
+          if(adsb_synd_table[k].nbits<0 || adsb_synd_table[k].nbits>maxbits)
+             return -1;
+
+          bin32_code[adsb_synd_table[k].pos1/32] ^= 0x80000000>>(adsb_synd_table[k].pos1%32);
+          if(adsb_synd_table[k].nbits==2)
+             bin32_code[adsb_synd_table[k].pos2/32] ^= 0x80000000>>(adsb_synd_table[k].pos2%32);
+
+          return adsb_synd_table[k].nbits;
+      }
+      k=(k+1)&(ADSB_SYND_TBLSIZE-1);
+   }
+
+   return -1;
+}
+
+
 #endif
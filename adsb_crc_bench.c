@@ -0,0 +1,175 @@
+/*-------------------------------------------------------------------
+Benchmark for ADSB_CRC.H
+Replay a capture file of hex frames from rtl_adsb, such as:
+	*8D40621D58C382D690C8AC2863A7;
+and compare adsb_fixerror_slow() with table-driven adsb_fixerror().
+
+Usage:	adsb_crc_bench [-n rounds] [-e] capture_file
+	-n	replay the file for n rounds, default 100
+	-e	inject a random 1bit error into each frame
+
+midaszhou@qq.com
+-------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> //-strlen()
+#include <ctype.h> //isxdigit()
+#include <stdint.h> //uint32_t
+#include <unistd.h> //getopt()
+#include <sys/time.h> //gettimeofday()
+#include "adsb_crc.h"
+
+#define MAX_FRAMES 100000
+
+
+/*---------------------------------------------------
+Convert a 28 chars hex string to 112bits code.
+Return: 0 OK, <0 not a valid 112bits frame.
+---------------------------------------------------*/
+static int hex2code(const char *str, uint32_t *bin32_code)
+{
+ char str_Temp[9];
+ int i;
+
+ while(*str=='*' || *str==' ') str++;
+ for(i=0;i<28;i++)
+    if(!isxdigit((unsigned char)str[i])) return -1;
+
+ for(i=0;i<4;i++)
+ {
+    strncpy(str_Temp,str+i*8, i==3 ? 4:8);
+    str_Temp[i==3 ? 4:8]='\0';
+    bin32_code[i]=strtoul(str_Temp,NULL,16);
+    if(i==3)
+       bin32_code[i]<<=16; //--shift/adjust the last 16bits to left significent order
+ }
+ return 0;
+}
+
+
+static long tm_diffus(struct timeval t_start, struct timeval t_end)
+{
+ return (t_end.tv_sec-t_start.tv_sec)*1000000+(t_end.tv_usec-t_start.tv_usec);
+}
+
+
+/*=====================================================================
+                              MAIN
+=====================================================================*/
+int main(int argc, char* argv[])
+{
+ FILE *fil;
+ char strline[64];
+ uint32_t (*frames)[4];
+ uint32_t code[4];
+ int nframes=0;
+ int rounds=100;
+ int inject=0;
+ int opt;
+ int i,k,bit;
+ int nok_slow=0, nok_fast=0; //--frames passed CRC or fixed
+ int ndiff=0; //--frames fixed differently
+ struct timeval tm_start,tm_end;
+ long us_slow,us_fast;
+
+ while( (opt=getopt(argc,argv,"n:e"))!=-1)
+ {
+    switch(opt)
+    {
+       case 'n':
+          rounds=atoi(optarg);
+          if(rounds<1) rounds=1;
+          break;
+       case 'e':
+          inject=1;
+          break;
+       default:
+          printf("usage:  %s [-n rounds] [-e] capture_file\n",argv[0]);
+          return -1;
+    }
+ }
+ if(optind>=argc) {
+    printf("usage:  %s [-n rounds] [-e] capture_file\n",argv[0]);
+    return -1;
+ }
+
+ frames=malloc(MAX_FRAMES*sizeof(*frames));
+ if(frames==NULL) return -2;
+
+ //-------------- load 112bits frames ---------------
+ fil=fopen(argv[optind],"r");
+ if(fil==NULL) {
+    printf("Fail to open %s\n",argv[optind]);
+    free(frames);
+    return -3;
+ }
+ while( nframes<MAX_FRAMES && fgets(strline,sizeof(strline),fil)!=NULL )
+ {
+    if(hex2code(strline,frames[nframes])==0)
+       nframes++;
+ }
+ fclose(fil);
+ printf("%d frames of 112bits loaded from %s.\n",nframes,argv[optind]);
+ if(nframes==0) {
+    free(frames);
+    return -4;
+ }
+
+ //-------------- inject 1bit error -------------------
+ if(inject) {
+    srand(1);
+    for(i=0;i<nframes;i++)
+    {
+       bit=rand()%112;
+       frames[i][bit/32]^=0x80000000>>(bit%32);
+    }
+ }
+
+ adsb_crc_init();
+
+ //-------------- slow bitwise CRC and brute-force fixing -------------
+ gettimeofday(&tm_start,NULL);
+ for(k=0;k<rounds;k++)
+    for(i=0;i<nframes;i++)
+    {
+       memcpy(code,frames[i],sizeof(code));
+       if(adsb_fixerror_slow(code)>=0 && k==0) nok_slow++;
+    }
+ gettimeofday(&tm_end,NULL);
+ us_slow=tm_diffus(tm_start,tm_end);
+
+ //-------------- table CRC and syndrome lookup fixing ----------------
+ gettimeofday(&tm_start,NULL);
+ for(k=0;k<rounds;k++)
+    for(i=0;i<nframes;i++)
+    {
+       memcpy(code,frames[i],sizeof(code));
+       if(adsb_fixerror(code,1)>=0 && k==0) nok_fast++;
+    }
+ gettimeofday(&tm_end,NULL);
+ us_fast=tm_diffus(tm_start,tm_end);
+
+ //-------------- check result, both shall fix the same frames -------
+ for(i=0;i<nframes;i++)
+ {
+    uint32_t code2[4];
+    int ret1,ret2;
+    memcpy(code,frames[i],sizeof(code));
+    memcpy(code2,frames[i],sizeof(code2));
+    ret1=adsb_fixerror_slow(code);
+    ret2=adsb_fixerror(code2,1);
+    if( (ret1<0) != (ret2<0) || (ret1>=0 && memcmp(code,code2,sizeof(code))) )
+       ndiff++;
+ }
+
+ if(us_slow<1) us_slow=1;
+ if(us_fast<1) us_fast=1;
+ printf("adsb_fixerror_slow():  %d/%d frames OK,  %.0f frames/sec\n",
+			nok_slow, nframes, (double)nframes*rounds*1000000/us_slow);
+ printf("adsb_fixerror(1bit):   %d/%d frames OK,  %.0f frames/sec\n",
+			nok_fast, nframes, (double)nframes*rounds*1000000/us_fast);
+ printf("Speedup x%.1f,  %d frames with different result.\n",(double)us_slow/us_fast, ndiff);
+
+ free(frames);
+ return ndiff ? 1 : 0;
+}
@@ -9,10 +9,7 @@ Based on: blog.csdn.net/dlutbrucezhang/article/details/8880131
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-#define FILE_SERVER_PORT 5555
-#define BUFFER_SIZE 4096//2048//1024
-#define FILE_NAME_MAX_SIZE 512
+#include "file_trans.h"
 
 
 int main(int argc, char **argv)
@@ -20,11 +17,8 @@ int main(int argc, char **argv)
 int socket_desc;
 struct sockaddr_in client_addr;
 struct sockaddr_in server_addr;
-FILE *fp;
-int rec_len;
-int wrt_len;
+long long file_size;
 char file_name[FILE_NAME_MAX_SIZE+1];
-char buffer[BUFFER_SIZE];
 
 bzero(&client_addr,sizeof(client_addr));
 /*
@@ -78,50 +72,26 @@ if( connect(socket_desc,(struct sockaddr*)&server_addr, server_addr_length) < 0)
 }
 
 
-//----- receive file_name from the server ----
-bzero(file_name,FILE_NAME_MAX_SIZE+1);
-rec_len = recv(socket_desc,file_name,BUFFER_SIZE,0);//blocking method
-if(rec_len <0 )
+//----- request the default file of the server, usually 1.bmp ----
+if( ftrans_request_file(socket_desc,NULL) <0 )
 {
-        printf("Fail to receive file_name from the server!\n");
-        exit(-1);
+	printf("Fail to send request to the server!\n");
+	exit(-3);
 }
-printf("receive file_name: %s\n",file_name);
 
-//------ open file_name for write -----
-fp = fopen(file_name,"w");
-if(fp==NULL)
+//------ receive file_name and data from server and write to the file ----------
+file_size=ftrans_recv_file(socket_desc,file_name);
+if(file_size<0)
 {
-	printf("Cann't open file %s to write!\n",file_name);
-	exit(-3);
+	printf("Fail to receive file from the server!\n");
+	close(socket_desc);
+	exit(-4);
 }
 
-//------ receive data from server and write to the file ----------
-bzero(buffer,BUFFER_SIZE);
-rec_len=0;
-while( rec_len = recv(socket_desc,buffer,BUFFER_SIZE,0))
-{
-	if(rec_len <0 )
-	{
-		printf("Fail to receive file data from the server!\n");
-		break;
-	}
-	//------ write data to file -----
-	wrt_len = fwrite(buffer,sizeof(char),rec_len,fp);
-	if(wrt_len < rec_len)
-	{
-		printf("Fail to write data to %s!",file_name);
-		break;
-	}
-	bzero(buffer,BUFFER_SIZE);
-}// end of while()
-
-printf("Finish receiving file %s from the server!\n",file_name);
-
-close(fp);
+printf("Finish receiving file %s, %lld bytes, from the server!\n",file_name,file_size);
+
 close(socket_desc);
 
 return 0;
 
 }
-
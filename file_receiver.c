@@ -9,10 +9,7 @@ Based on: blog.csdn.net/dlutbrucezhang/article/details/8880131
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-#define FILE_SERVER_PORT 5555
-#define BUFFER_SIZE 1024
-#define FILE_NAME_MAX_SIZE 512
+#include "file_trans.h"
 
 
 int main(int argc, char **argv)
@@ -20,11 +17,8 @@ int main(int argc, char **argv)
 int socket_desc;
 struct sockaddr_in client_addr;
 struct sockaddr_in server_addr;
-FILE *fp;
-int rec_len;
-int wrt_len;
+long long file_size;
 char file_name[FILE_NAME_MAX_SIZE+1];
-char buffer[BUFFER_SIZE];
 
 bzero(&client_addr,sizeof(client_addr));
 /*
@@ -79,47 +73,28 @@ if( connect(socket_desc,(struct sockaddr*)&server_addr, server_addr_length) < 0)
 
 bzero(file_name,FILE_NAME_MAX_SIZE+1);
 printf("please input file name:\t");
-scanf("%s",file_name);
-
-bzero(buffer,BUFFER_SIZE);
-strncpy(buffer,file_name,strlen(file_name) > BUFFER_SIZE?BUFFER_SIZE:strlen(file_name));
-//---send buffer data to server ----
-send(socket_desc,buffer,BUFFER_SIZE,0);
+scanf("%512s",file_name);
 
-fp = fopen(file_name,"w");
-if(fp==NULL)
+//---send request to server ----
+if( ftrans_request_file(socket_desc,file_name) <0 )
 {
-	printf("Cann't open file %s to write!\n",file_name);
+	printf("Fail to send request to the server!\n");
 	exit(-3);
 }
 
-//----- receive data from server -------
-bzero(buffer,BUFFER_SIZE);
-rec_len=0;
-//------ receive data from server and write to the file ----------
-while( rec_len = recv(socket_desc,buffer,BUFFER_SIZE,0))
+//------ receive the file from server and write it to a local file ----------
+file_size=ftrans_recv_file(socket_desc,file_name);
+if(file_size<0)
 {
-	if(rec_len <0 )
-	{
-		printf("Fail to receive file data from the server!\n");
-		break;
-	}
-	//------ write data to file -----
-	wrt_len = fwrite(buffer,sizeof(char),rec_len,fp);
-	if(wrt_len < rec_len)
-	{
-		printf("Fail to write data to %s!",file_name);
-		break;
-	}
-	bzero(buffer,BUFFER_SIZE);
-}// end of while()
-
-printf("Finish receiving file %s from the server!\n",file_name);
-
-close(fp);
+	printf("Fail to receive file %s from the server!\n",file_name);
+	close(socket_desc);
+	exit(-4);
+}
+
+printf("Finish receiving file %s, %lld bytes, from the server!\n",file_name,file_size);
+
 close(socket_desc);
 
 return 0;
 
 }
-
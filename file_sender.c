@@ -1,33 +1,283 @@
 /*---------------------------------------------------------------------
 Based on: blog.csdn.net/dlutbrucezhang/article/details/8880131
 
+A file server for file_receiver and bmp_client, see file_trans.h for
+the protocol.
+
+1. Clients are served concurrently in an epoll loop, all sockets are
+   non-blocking.
+2. File data is sent by sendfile(), from page cache to socket, without
+   copying to user space.
+3. Adler-32 checksum of a file is cached with its inode, size and mtime,
+   so a file is read only once to get its checksum until it changes.
+
+Usage:	file_sender [default_file]
+	default_file is sent when the client asks for no name,
+	default as "1.bmp"(that bmp_client asks for).
+
 ---------------------------------------------------------------------*/
 
 #include <netinet/in.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <signal.h>
+#include "file_trans.h"
+
+#define SERVER_LISTEN_BACKLOG 16
+#define MAX_CLIENTS 64
+#define MAX_EVENTS 16
+#define SENDFILE_CHUNK (1024*1024) //--Max. bytes for one sendfile() call
+#define CHECKSUM_CACHE_SIZE 16
+
+//------ state of a client connection ------
+enum client_state
+{
+	st_free=0,
+	st_request,	//--receiving request
+	st_head,	//--sending head and file name
+	st_data,	//--sending file data
+};
+
+typedef struct
+{
+	enum client_state state;
+	int sock;
+	int fd;			//--file to send
+	char buf[sizeof(FTRANS_REQ)+FILE_NAME_MAX_SIZE+sizeof(FTRANS_HEAD)+FILE_NAME_MAX_SIZE];
+	int len;		//--bytes in buf[]
+	int pos;		//--bytes sent in buf[]
+	off_t offset;		//--file offset of sendfile()
+	off_t size;		//--file size
+}CLIENT;
+
+//------ cached checksum of a file ------
+typedef struct
+{
+	dev_t	 dev;
+	ino_t	 ino;
+	off_t	 size;
+	time_t	 mtime;
+	uint32_t checksum;
+}CHECKSUM_CACHE;
+
+static CLIENT clients[MAX_CLIENTS];
+static CHECKSUM_CACHE cksum_cache[CHECKSUM_CACHE_SIZE];
+static int cksum_next; //--next cache slot to replace
+static char *default_file="1.bmp";
 
-#define FILE_SERVER_PORT 5555
-#define SERVER_LISTEN_BACKLOG 5
-#define BUFFER_SIZE 1024
-#define FILE_NAME_MAX_SIZE 512
+
+/*-----------------------------------------------------
+Get Adler-32 checksum of an opened file, from cache
+if the file is not changed.
+Return: 0 OK, <0 fails
+-----------------------------------------------------*/
+static int get_file_checksum(int fd, const struct stat *st, uint32_t *checksum)
+{
+	unsigned char *buffer;
+	ssize_t len;
+	uint32_t adler=1;
+	int i;
+
+	for(i=0;i<CHECKSUM_CACHE_SIZE;i++)
+	{
+		if( cksum_cache[i].ino==st->st_ino && cksum_cache[i].dev==st->st_dev
+		    && cksum_cache[i].size==st->st_size && cksum_cache[i].mtime==st->st_mtime ) {
+			*checksum=cksum_cache[i].checksum;
+			return 0;
+		}
+	}
+
+	buffer=malloc(FTRANS_BUFSIZE);
+	if(buffer==NULL)
+		return -1;
+	while( (len=read(fd,buffer,FTRANS_BUFSIZE)) >0 )
+		adler=ftrans_adler32(adler,buffer,len);
+	free(buffer);
+	lseek(fd,0,SEEK_SET);
+	if(len<0)
+		return -2;
+
+	cksum_cache[cksum_next].dev=st->st_dev;
+	cksum_cache[cksum_next].ino=st->st_ino;
+	cksum_cache[cksum_next].size=st->st_size;
+	cksum_cache[cksum_next].mtime=st->st_mtime;
+	cksum_cache[cksum_next].checksum=adler;
+	cksum_next=(cksum_next+1)%CHECKSUM_CACHE_SIZE;
+
+	*checksum=adler;
+	return 0;
+}
+
+/*------------------------------------------
+Close a client and free its slot
+------------------------------------------*/
+static void close_client(int epfd, CLIENT *pcl)
+{
+	epoll_ctl(epfd,EPOLL_CTL_DEL,pcl->sock,NULL);
+	close(pcl->sock);
+	if(pcl->fd>=0)
+		close(pcl->fd);
+	memset(pcl,0,sizeof(CLIENT));
+	pcl->fd=-1;
+	pcl->state=st_free;
+}
+
+/*-----------------------------------------------------------
+Request is complete, open the file and prepare head in buf[]
+-----------------------------------------------------------*/
+static void prepare_head(CLIENT *pcl)
+{
+	char file_name[FILE_NAME_MAX_SIZE+1];
+	FTRANS_HEAD head;
+	struct stat st;
+	uint32_t checksum=0;
+	int name_len;
+
+	name_len=ntohl(((FTRANS_REQ *)pcl->buf)->name_len);
+	if(name_len==0)
+		strcpy(file_name,default_file);
+	else {
+		memcpy(file_name,pcl->buf+sizeof(FTRANS_REQ),name_len);
+		file_name[name_len]='\0';
+	}
+	name_len=strlen(file_name);
+
+	memset(&head,0,sizeof(head));
+	head.magic=htonl(FTRANS_MAGIC);
+
+	pcl->fd=open(file_name,O_RDONLY);
+	if( pcl->fd<0 || fstat(pcl->fd,&st)!=0 || !S_ISREG(st.st_mode)
+	    || get_file_checksum(pcl->fd,&st,&checksum)!=0 )
+	{
+		printf("fail to open file %s!\n", file_name);
+		head.status=htonl(-1);
+		if(pcl->fd>=0) {
+			close(pcl->fd);
+			pcl->fd=-1;
+		}
+		pcl->size=0;
+		name_len=0;
+	}
+	else {
+		pcl->size=st.st_size;
+		head.size_hi=htonl((uint64_t)st.st_size>>32);
+		head.size_lo=htonl(st.st_size&0xffffffff);
+		head.checksum=htonl(checksum);
+		printf("Start sending file: %s, %lld bytes\n",file_name,(long long)st.st_size);
+	}
+	head.name_len=htonl(name_len);
+
+	memcpy(pcl->buf,&head,sizeof(head));
+	memcpy(pcl->buf+sizeof(head),file_name,name_len);
+	pcl->len=sizeof(head)+name_len;
+	pcl->pos=0;
+	pcl->offset=0;
+	pcl->state=st_head;
+}
+
+/*-----------------------------------------------------------
+Handle IO of a client.
+Return: 0 to keep it, <0 to close it.
+-----------------------------------------------------------*/
+static int handle_client(int epfd, CLIENT *pcl)
+{
+	struct epoll_event ev;
+	ssize_t ret;
+	int need;
+
+	//-----  receive request  ---------
+	if(pcl->state==st_request)
+	{
+		need = pcl->len<sizeof(FTRANS_REQ) ? sizeof(FTRANS_REQ)
+			: sizeof(FTRANS_REQ)+ntohl(((FTRANS_REQ *)pcl->buf)->name_len);
+		ret=recv(pcl->sock,pcl->buf+pcl->len,need-pcl->len,0);
+		if(ret<0 && (errno==EAGAIN || errno==EINTR))
+			return 0;
+		if(ret<=0)
+			return -1;
+		pcl->len+=ret;
+		if(pcl->len==sizeof(FTRANS_REQ)) {
+			if( ntohl(((FTRANS_REQ *)pcl->buf)->magic)!=FTRANS_MAGIC
+			    || ntohl(((FTRANS_REQ *)pcl->buf)->name_len)>FILE_NAME_MAX_SIZE ) {
+				printf("Invalid request!\n");
+				return -1;
+			}
+		}
+		if( pcl->len<sizeof(FTRANS_REQ)
+		    || pcl->len<sizeof(FTRANS_REQ)+ntohl(((FTRANS_REQ *)pcl->buf)->name_len) )
+			return 0;
+
+		prepare_head(pcl);
+		ev.events=EPOLLOUT;
+		ev.data.ptr=pcl;
+		epoll_ctl(epfd,EPOLL_CTL_MOD,pcl->sock,&ev);
+		return 0;
+	}
+
+	//-----  send head and file name  ---------
+	if(pcl->state==st_head)
+	{
+		ret=send(pcl->sock,pcl->buf+pcl->pos,pcl->len-pcl->pos,MSG_NOSIGNAL);
+		if(ret<0 && (errno==EAGAIN || errno==EINTR))
+			return 0;
+		if(ret<0)
+			return -1;
+		pcl->pos+=ret;
+		if(pcl->pos<pcl->len)
+			return 0;
+		if(pcl->fd<0)
+			return -1; //--failed, head sent
+		pcl->state=st_data;
+	}
+
+	//-----  send file data, zero copy  ---------
+	if(pcl->state==st_data)
+	{
+		while(pcl->offset<pcl->size)
+		{
+			ret=sendfile(pcl->sock,pcl->fd,&pcl->offset,
+				pcl->size-pcl->offset > SENDFILE_CHUNK ? SENDFILE_CHUNK : pcl->size-pcl->offset);
+			if(ret<0 && (errno==EAGAIN || errno==EINTR))
+				return 0;
+			if(ret<=0) {
+				printf("send file failed!\n");
+				return -1;
+			}
+		}
+		printf("Finish sending file, %lld bytes!\n",(long long)pcl->size);
+		return -1; //--finish
+	}
+
+	return 0;
+}
 
 
 int main(int argc, char **argv)
 {
 int socket_desc;
+int epfd;
 struct sockaddr_in server_addr;
-int rec_len;
-FILE * fp;
-char file_name[FILE_NAME_MAX_SIZE+1];
-char buffer[BUFFER_SIZE];
+struct epoll_event ev, events[MAX_EVENTS];
+int nfds;
+int i,k;
+int on=1;
+
+if(argc>1)
+	default_file=argv[1];
+
+signal(SIGPIPE,SIG_IGN);
+for(i=0;i<MAX_CLIENTS;i++)
+	clients[i].fd=-1;
 
 bzero(&server_addr,sizeof(server_addr));
 server_addr.sin_family = AF_INET; //Address Family IP version 4
-server_addr.sin_addr.s_addr = htons(INADDR_ANY); //host to net short
+server_addr.sin_addr.s_addr = htonl(INADDR_ANY); //host to net long
 server_addr.sin_port = htons(FILE_SERVER_PORT);
 
 socket_desc = socket(AF_INET,SOCK_STREAM,0); //SOCK_STREAM -- connection oriented TCP protocol,  0--or IPPROTO_IP is IP protocol
@@ -36,6 +286,7 @@ if(socket_desc < 0)
 	printf("create server socket failed!\n");
 	exit(-1);
 }
+setsockopt(socket_desc,SOL_SOCKET,SO_REUSEADDR,&on,sizeof(on));
 
 //-----  int bind(int sock, struct sockaddr *addr, int addrLen) -----
 if( bind(socket_desc, (struct sockaddr*)&server_addr, sizeof(server_addr)) != 0 )
@@ -50,59 +301,71 @@ if( listen(socket_desc,SERVER_LISTEN_BACKLOG) != 0)
 	printf("listen to prot %d failed!\n",FILE_SERVER_PORT);
 	exit(-1);
 }
+fcntl(socket_desc,F_SETFL,fcntl(socket_desc,F_GETFL)|O_NONBLOCK);
+
+//----- epoll for listen socket and clients -----
+epfd=epoll_create(MAX_CLIENTS+1);
+if(epfd<0)
+{
+	printf("epoll_create failed!\n");
+	exit(-1);
+}
+ev.events=EPOLLIN;
+ev.data.ptr=NULL; //--NULL for listen socket
+epoll_ctl(epfd,EPOLL_CTL_ADD,socket_desc,&ev);
 
 //-----loop server-------
 while(1){
-	struct sockaddr_in client_addr;
-	socklen_t client_addr_len = sizeof(client_addr);
-
-	//---- int accept( int sock, struct sockaddr *addr, int *addrLen ) ------
-	int new_socket_desc = accept(socket_desc, (struct sockaddr*)&client_addr, &client_addr_len);
-	if (new_socket_desc < 0 )
+	nfds=epoll_wait(epfd,events,MAX_EVENTS,-1);
+	if(nfds<0)
 	{
-		printf("accept new socket failed");
+		if(errno==EINTR)
+			continue;
+		printf("epoll_wait failed!\n");
 		break;
 	}
 
-	//-----  receive file name  ---------
-	bzero(buffer,BUFFER_SIZE);
-	rec_len = recv(new_socket_desc, buffer, BUFFER_SIZE,0);
-	if(rec_len < 0)
+	for(k=0;k<nfds;k++)
 	{
-		printf(" receive data failed!\n");
-		break;
-	}
-	bzero(file_name,FILE_NAME_MAX_SIZE+1);
-	strncpy(file_name,buffer, strlen(buffer)>FILE_NAME_MAX_SIZE ? FILE_NAME_MAX_SIZE:strlen(buffer));
-
-	//-------  send file data  -------
-	fp = fopen(file_name, "r");
-	if(fp == NULL)
-	{
-		printf("fail to open file %s!\n", file_name);
-	}
-	else
-	{
-		bzero(buffer, BUFFER_SIZE);
-		int file_block_length=0;
-		//----- read file and send()  ------
-		while( (file_block_length = fread(buffer,sizeof(char),BUFFER_SIZE,fp)) >0 )
+		//---- accept new clients ------
+		if(events[k].data.ptr==NULL)
 		{
-			printf("file_block_length = %d \n",file_block_length);
-			//----- int send( int sock, const void *msg, int len, unsigned int flag ) --------
-			if(send(new_socket_desc, buffer, file_block_length,0)<0)
+			while(1)
 			{
-				printf("send file: %s failed!\n",file_name);
+				struct sockaddr_in client_addr;
+				socklen_t client_addr_len = sizeof(client_addr);
+				int new_socket_desc = accept(socket_desc, (struct sockaddr*)&client_addr, &client_addr_len);
+				if(new_socket_desc < 0)
+					break;
+
+				for(i=0;i<MAX_CLIENTS;i++)
+					if(clients[i].state==st_free) break;
+				if(i==MAX_CLIENTS) {
+					printf("Too many clients!\n");
+					close(new_socket_desc);
+					continue;
+				}
+
+				fcntl(new_socket_desc,F_SETFL,fcntl(new_socket_desc,F_GETFL)|O_NONBLOCK);
+				clients[i].sock=new_socket_desc;
+				clients[i].fd=-1;
+				clients[i].len=0;
+				clients[i].state=st_request;
+				ev.events=EPOLLIN;
+				ev.data.ptr=&clients[i];
+				epoll_ctl(epfd,EPOLL_CTL_ADD,new_socket_desc,&ev);
 			}
-			bzero(buffer, BUFFER_SIZE);
-		}//end while()
-		fclose(fp);
-		printf("Finish sending file: %s!\n",file_name);
-	}//end else{}
+			continue;
+		}
 
-	close(new_socket_desc);
+		//---- serve clients ------
+		if( (events[k].events&(EPOLLERR|EPOLLHUP)) || handle_client(epfd,events[k].data.ptr)<0 )
+			close_client(epfd,events[k].data.ptr);
+	}
 
 }//end while()
 
+close(epfd);
+close(socket_desc);
 return 0;
 }
@@ -0,0 +1,222 @@
+/*---------------------------------------------------------------------
+File transfer protocol for file_sender and file_receiver/bmp_client.
+
+Request (client -> server):
+	FTRANS_REQ + file name(name_len bytes, without '\0')
+	name_len==0 to ask for the server's default file, e.g. 1.bmp
+
+Reply (server -> client):
+	FTRANS_HEAD + file name(name_len bytes) + file data(size bytes)
+	status<0 if the server fails to open the file, and no data follows.
+
+All fields are in network byte order, checksum is Adler-32 of the
+file data.
+
+midaszhou@qq.com
+---------------------------------------------------------------------*/
+#ifndef _FILE_TRANS_H
+#define _FILE_TRANS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <arpa/inet.h> //htonl()
+
+#define FILE_SERVER_PORT 5555
+#define FILE_NAME_MAX_SIZE 512
+#define FTRANS_MAGIC 0x46545231  //--"FTR1"
+#define FTRANS_BUFSIZE (64*1024) //--receiving buffer size
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t name_len;
+}FTRANS_REQ;
+
+typedef struct
+{
+	uint32_t magic;
+	int32_t  status;	//--0 OK, <0 fails
+	uint32_t size_hi;	//--file size, high and low 32bits
+	uint32_t size_lo;
+	uint32_t checksum;	//--Adler-32 of file data
+	uint32_t name_len;
+}FTRANS_HEAD;
+
+
+/*------------------------------------------------------
+Update Adler-32 checksum with buf[len].
+adler:	init. value 1
+------------------------------------------------------*/
+static inline uint32_t ftrans_adler32(uint32_t adler, const unsigned char *buf, size_t len)
+{
+	uint32_t a=adler&0xffff;
+	uint32_t b=adler>>16;
+	size_t n;
+
+	while(len>0)
+	{
+		n = len<5552 ? len:5552; //--Max. n before b overflows
+		len-=n;
+		while(n--) {
+			a+=*buf++;
+			b+=a;
+		}
+		a%=65521;
+		b%=65521;
+	}
+
+	return (b<<16)|a;
+}
+
+/*--------------------------------------------
+Read/write exactly len bytes, retry on EINTR.
+Return: len OK, <len EOF or fails
+--------------------------------------------*/
+static inline ssize_t ftrans_readn(int fd, void *buf, size_t len)
+{
+	size_t n=0;
+	ssize_t ret;
+
+	while(n<len)
+	{
+		ret=read(fd,(char *)buf+n,len-n);
+		if(ret<0 && errno==EINTR)
+			continue;
+		if(ret<=0)
+			break;
+		n+=ret;
+	}
+	return n;
+}
+
+static inline ssize_t ftrans_writen(int fd, const void *buf, size_t len)
+{
+	size_t n=0;
+	ssize_t ret;
+
+	while(n<len)
+	{
+		ret=write(fd,(const char *)buf+n,len-n);
+		if(ret<0 && errno==EINTR)
+			continue;
+		if(ret<=0)
+			break;
+		n+=ret;
+	}
+	return n;
+}
+
+/*-------------------------------------------------------
+Send request for a file to the server.
+name:	file name, NULL or "" for the default file.
+Return: 0 OK, <0 fails
+-------------------------------------------------------*/
+static inline int ftrans_request_file(int sock, const char *name)
+{
+	char buf[sizeof(FTRANS_REQ)+FILE_NAME_MAX_SIZE];
+	FTRANS_REQ *req=(FTRANS_REQ *)buf;
+	int len = name==NULL ? 0 : strlen(name);
+
+	if(len>FILE_NAME_MAX_SIZE)
+		return -1;
+
+	req->magic=htonl(FTRANS_MAGIC);
+	req->name_len=htonl(len);
+	if(len>0)
+		memcpy(buf+sizeof(FTRANS_REQ),name,len);
+	if(ftrans_writen(sock,buf,sizeof(FTRANS_REQ)+len) != sizeof(FTRANS_REQ)+len)
+		return -2;
+
+	return 0;
+}
+
+/*---------------------------------------------------------------------
+Receive a file from the server and write it straight to a local file,
+which has the same name(base name) as on the server.
+
+file_name:	to pass out name of the saved file, FILE_NAME_MAX_SIZE+1 bytes.
+Return:
+	>=0	OK, size of the file
+	<0	fails, or checksum error
+----------------------------------------------------------------------*/
+static inline long long ftrans_recv_file(int sock, char *file_name)
+{
+	FTRANS_HEAD head;
+	unsigned char *buffer;
+	const char *pname;
+	long long size, nrecv=0;
+	uint32_t checksum=1;
+	ssize_t len;
+	int fd;
+
+	if( ftrans_readn(sock,&head,sizeof(head)) != sizeof(head) || ntohl(head.magic)!=FTRANS_MAGIC ) {
+		printf("Fail to receive file head from the server!\n");
+		return -1;
+	}
+	if( (int32_t)ntohl(head.status)<0 ) {
+		printf("Server fails to open the file!\n");
+		return -2;
+	}
+	len=ntohl(head.name_len);
+	if( len<=0 || len>FILE_NAME_MAX_SIZE || ftrans_readn(sock,file_name,len)!=len ) {
+		printf("Fail to receive file_name from the server!\n");
+		return -3;
+	}
+	file_name[len]='\0';
+	size=((long long)ntohl(head.size_hi)<<32) | ntohl(head.size_lo);
+
+	//------ save to current dir., with the base name -----
+	pname=strrchr(file_name,'/');
+	pname = pname ? pname+1 : file_name;
+	printf("receive file_name: %s, %lld bytes\n",file_name,size);
+
+	fd=open(pname,O_WRONLY|O_CREAT|O_TRUNC,0644);
+	if(fd<0) {
+		printf("Cann't open file %s to write!\n",pname);
+		return -4;
+	}
+
+	buffer=malloc(FTRANS_BUFSIZE);
+	if(buffer==NULL) {
+		close(fd);
+		return -5;
+	}
+
+	//------ receive data from server and write to the file ----------
+	while(nrecv<size)
+	{
+		len=recv(sock,buffer, size-nrecv > FTRANS_BUFSIZE ? FTRANS_BUFSIZE : size-nrecv, 0);
+		if(len<0 && errno==EINTR)
+			continue;
+		if(len<=0) {
+			printf("Fail to receive file data from the server!\n");
+			break;
+		}
+		checksum=ftrans_adler32(checksum,buffer,len);
+		if(ftrans_writen(fd,buffer,len)!=len) {
+			printf("Fail to write data to %s!\n",pname);
+			break;
+		}
+		nrecv+=len;
+	}
+
+	free(buffer);
+	close(fd);
+
+	if(nrecv<size)
+		return -6;
+	if(checksum!=ntohl(head.checksum)) {
+		printf("Checksum error: %08X, expect %08X!\n",checksum,ntohl(head.checksum));
+		return -7;
+	}
+
+	return size;
+}
+
+#endif
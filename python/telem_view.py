@@ -0,0 +1,107 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#---------------------------------------------------------------
+# Viewer of the gyro telemetry stream, see L3G4200D/telemetry.h
+#
+# Connect to the telemetry server, subscribe to raw, filtered or
+# both streams, decode binary frames, and print samples, or plot
+# them with matplotlib if -p is given.
+# A gap of frame seq means frames were dropped by the server.
+#
+# Usage: telem_view.py [-s raw|filtered|both] [-P drop_new|drop_old|close]
+#                      [-p] [host [port]]
+#
+#                                              Midas Zhou
+#---------------------------------------------------------------
+from __future__ import print_function
+import socket
+import struct
+import sys
+import getopt
+
+TELEM_MAGIC=0x4754
+TELEM_VERSION=1
+HEADER=struct.Struct('<HBBBBHIq')     #--- magic,version,stream,nchan,reserved,nsamples,seq,ts_us
+STREAM_NAMES=('raw','filtered')
+
+def recv_exact(sock, n):
+    buf=b''
+    while len(buf)<n:
+        data=sock.recv(n-len(buf))
+        if not data:
+            raise EOFError('server closed')
+        buf+=data
+    return buf
+
+#----- read a frame, return (stream, seq, [(ts_us, [val...]), ...])
+def read_frame(sock):
+    magic,version,stream,nchan,rsv,nsamples,seq,ts_us=HEADER.unpack(recv_exact(sock,HEADER.size))
+    if magic!=TELEM_MAGIC:
+        raise ValueError('bad magic 0x%04x, stream out of sync' % magic)
+    if version!=TELEM_VERSION:
+        raise ValueError('unsupported frame version %d' % version)
+    sample=struct.Struct('<I%df' % nchan)
+    body=recv_exact(sock, nsamples*sample.size)
+    samples=[]
+    for i in range(nsamples):
+        rec=sample.unpack_from(body, i*sample.size)
+        samples.append((ts_us+rec[0], rec[1:]))
+    return stream,seq,samples
+
+def main():
+    sub='both'
+    policy=None
+    plot=False
+    opts,args=getopt.getopt(sys.argv[1:],'s:P:p')
+    for o,a in opts:
+        if o=='-s': sub=a
+        elif o=='-P': policy=a
+        elif o=='-p': plot=True
+    host=args[0] if len(args)>0 else '127.0.0.1'
+    port=int(args[1]) if len(args)>1 else 5556
+
+    sock=socket.create_connection((host,port))
+    sock.sendall(('SUB %s\n' % sub).encode())
+    if policy:
+        sock.sendall(('POLICY %s\n' % policy).encode())
+    print('Connected to %s:%d, subscribe %s' % (host,port,sub))
+
+    if plot:
+        import matplotlib.pyplot as plt
+        plt.ion()
+        fig,ax=plt.subplots()
+        lines={}
+        hist={0:[],1:[]}
+
+    last_seq={}
+    lost=0
+    try:
+        while True:
+            stream,seq,samples=read_frame(sock)
+            if stream in last_seq and seq!=last_seq[stream]+1:
+                lost+=seq-last_seq[stream]-1
+                print('--- %s: %d frames dropped' % (STREAM_NAMES[stream],seq-last_seq[stream]-1))
+            last_seq[stream]=seq
+
+            if not plot:
+                for ts,val in samples:
+                    print('%-8s seq=%-6d ts=%.6fs  %s' % (STREAM_NAMES[stream],seq,ts/1e6,
+                                                     '  '.join('%+.6e' % v for v in val)))
+                continue
+
+            #----- plot the first value of each stream, last 1000 samples
+            hist[stream]+= [(ts/1e6,val[0]) for ts,val in samples]
+            hist[stream]=hist[stream][-1000:]
+            if stream not in lines:
+                lines[stream],=ax.plot([],[],label=STREAM_NAMES[stream])
+                ax.legend()
+            lines[stream].set_data([t for t,v in hist[stream]],[v for t,v in hist[stream]])
+            ax.relim(); ax.autoscale_view()
+            plt.pause(0.001)
+
+    except (EOFError,KeyboardInterrupt) as e:
+        print('Quit: %s, %d frames dropped in all.' % (e,lost))
+    sock.close()
+
+if __name__=='__main__':
+    main()
@@ -1,4 +1,4 @@
-#include "ads_hash.h"
+#include "ads_acft.h"
 #include <stdio.h>
 
 
@@ -6,31 +6,39 @@ void main(int argc, char* argv[])
 {
  FILE *fp;
  int i;
- int ncount=0;
- STRUCT_DATA  sdata;
+ uint32_t head[2];
+ ACFT_RECORD rec;
  char str_FILE[30]="/tmp/ads.data";
  char* pstrf; //="/tmp/ads.data";
 
  if(argc>1)
     pstrf=argv[1];
- else 
+ else
     pstrf=str_FILE;
- 
- if((fp=fopen(pstrf,"r"))==NULL) 
+
+ if((fp=fopen(pstrf,"r"))==NULL)
  {
     printf("fail to open %s\n",pstrf);
     return;
  }
 
- fread(&ncount,sizeof(int), 1,fp);
- printf("restore ncount=%d\n",ncount);
- for(i=0;i<ncount;i++)
+ if(fread(head,sizeof(head),1,fp)!=1 || head[0]!=ACFT_SNAPSHOT_MAGIC)
+ {
+    printf("%s is not an aircraft snapshot\n",pstrf);
+    fclose(fp);
+    return;
+ }
+ printf("restore ncount=%d\n",head[1]);
+ for(i=0;i<head[1];i++)
  {
-    fread((char*)&sdata,sizeof(STRUCT_DATA),1,fp);
-    printf("restore DATA[%03d]:   %06X  %s  \n",i,sdata.int_ICAO24,sdata.str_CALL_SIGN);
+    if(fread(&rec,sizeof(rec),1,fp)!=1)
+        break;
+    printf("restore DATA[%03d]:   %06X  %-8.8s",i,rec.icao_flags&0xffffff,
+			(rec.icao_flags>>24)&ACFT_FLAG_CALLSIGN ? rec.str_CALL_SIGN : "");
+    if((rec.icao_flags>>24)&ACFT_FLAG_POSITION)
+        printf("  Lat: %.5fN Long: %.5fE",rec.flt_lat,rec.flt_lon);
+    printf("\n");
  }
 
  fclose(fp);
 }
-
-
@@ -0,0 +1,161 @@
+/*-----------------------------------------------------------------------
+  Streaming GRAM writer for RM68140/ILI9488 SPI LCD
+
+1. GRAM_Write():  Data is still cut into GRAM_SEGSIZE bytes segments, as
+   each SPI transfer of the controller is limited, but up to GRAM_MAXSEGS
+   segments are chained in one SPI_IOC_MESSAGE ioctl, instead of one
+   SPI_Write() syscall for each 32 bytes.
+   If the spidev driver refuses chained messages, it falls back to one
+   SPI_Write() for each segment.
+2. GRAM_Write565(): Convert RGB565 pixels to 18bits RGB666 and stream them
+   to GRAM batch by batch, it reads straight from any RGB565 buffer, such
+   as FBDEV back buffer fb_dev->map_bk of EGI.
+3. Before calling them, set GRAM area by GRAM_Block_Set() and WriteComm(0x2c),
+   and pixel format 0x3a as 0x66 (18bits).
+
+midaszhou
+-----------------------------------------------------------------------*/
+#ifndef _SPI_GRAM_H
+#define _SPI_GRAM_H
+
+#include <stdint.h>
+#include <string.h>
+#include "./RM68140.h"
+
+#define GRAM_SEGSIZE	32	/* Max. bytes for each spi_ioc_transfer, same as SPIBUFF */
+#define GRAM_MAXSEGS	128	/* Max. segments chained in one SPI_IOC_MESSAGE */
+#define GRAM_BATCH	(GRAM_SEGSIZE*GRAM_MAXSEGS)	/* bytes for each ioctl */
+
+static struct spi_ioc_transfer gram_xfer[GRAM_MAXSEGS];
+static uint8_t gram_buff[GRAM_BATCH]; /* RGB666 data converted from RGB565 */
+static int gram_nobatch=0; /* 1 if chained messages are refused by spidev */
+
+
+/*------------------------------------------------------------
+ Write N bytes of data to LCD GRAM, with chained SPI transfers.
+ Return:
+	>=0	bytes written
+	<0	fails
+-------------------------------------------------------------*/
+int GRAM_Write(const uint8_t *data, int len)
+{
+ int nseg;
+ int n,k;
+ int total=0;
+
+ DCXdata;
+
+ while(len>0)
+ {
+   /*--- chain up to GRAM_MAXSEGS segments ---*/
+   for(nseg=0; nseg<GRAM_MAXSEGS && len>0; nseg++)
+   {
+      n = len>GRAM_SEGSIZE ? GRAM_SEGSIZE : len;
+      memset(&gram_xfer[nseg],0,sizeof(struct spi_ioc_transfer));
+      gram_xfer[nseg].tx_buf=(unsigned long)data;
+      gram_xfer[nseg].len=n;
+      gram_xfer[nseg].speed_hz=speed;
+      gram_xfer[nseg].bits_per_word=bits;
+      gram_xfer[nseg].delay_usecs=delay;
+      data+=n;
+      len-=n;
+   }
+
+   if(!gram_nobatch)
+   {
+      if(ioctl(g_SPI_Fd, SPI_IOC_MESSAGE(nseg), gram_xfer) >= 0) {
+          for(k=0;k<nseg;k++)
+             total+=gram_xfer[k].len;
+          continue;
+      }
+      pr_err("GRAM_Write: chained SPI message fails, fall back to SPI_Write()!\n");
+      gram_nobatch=1;
+   }
+
+   /*--- fall back to one write for each segment ---*/
+   for(k=0;k<nseg;k++)
+   {
+      if(SPI_Write((uint8_t *)(unsigned long)gram_xfer[k].tx_buf, gram_xfer[k].len) < 0)
+          return -1;
+      total+=gram_xfer[k].len;
+   }
+ }
+
+ return total;
+}
+
+
+/*-----------------------------------------------------------------
+ Convert npix RGB565 pixels to RGB666, 3 bytes for each pixel, only
+ high 6bits of each byte are valid for the LCD.
+ Byte order is B,G,R, same as BMP data shown by RMshow18bit*.
+-----------------------------------------------------------------*/
+static inline void GRAM_rgb565_to_666(const uint16_t *src, uint8_t *dst, int npix)
+{
+ int i;
+ uint16_t c;
+
+ for(i=0;i<npix;i++)
+ {
+    c=src[i];
+    dst[0]=(c<<3)&0xf8;		/* B */
+    dst[1]=(c>>3)&0xfc;		/* G */
+    dst[2]=(c>>8)&0xf8;		/* R */
+    dst+=3;
+ }
+}
+
+
+/*------------------------------------------------------------------
+ Stream an RGB565 image to GRAM as RGB666, converted batch by batch.
+
+ src:		RGB565 pixel data, such as fb_dev->map_bk.
+ width,height:	image size in pixels.
+ stride:	pixels of each line in src, >=width.
+
+ Return:
+	>=0	bytes written to GRAM
+	<0	fails
+------------------------------------------------------------------*/
+int GRAM_Write565(const uint16_t *src, int width, int height, int stride)
+{
+ int x,y,n;
+ int pos=0; /* bytes in gram_buff[] */
+ int total=0;
+ int ret;
+
+ if(src==NULL || width<=0 || height<=0 || stride<width)
+    return -1;
+
+ for(y=0;y<height;y++)
+ {
+    for(x=0;x<width;x+=n)
+    {
+       /* pixels to fit in gram_buff[] */
+       n=(GRAM_BATCH-pos)/3;
+       if(n>width-x)
+          n=width-x;
+       GRAM_rgb565_to_666(src+y*stride+x, gram_buff+pos, n);
+       pos+=n*3;
+
+       if(GRAM_BATCH-pos<3) {
+          ret=GRAM_Write(gram_buff,pos);
+          if(ret<0)
+             return ret;
+          total+=ret;
+          pos=0;
+       }
+    }
+ }
+
+ if(pos>0) {
+    ret=GRAM_Write(gram_buff,pos);
+    if(ret<0)
+       return ret;
+    total+=ret;
+ }
+
+ return total;
+}
+
+#endif
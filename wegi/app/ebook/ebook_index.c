@@ -0,0 +1,516 @@
+/*----------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+Page-offset index for an UTF-8 ebook, see ebook_index.h.
+
+Note:
+1. Pages are laid out by FTsymbol_uft8strings_writeFB() with a NULL
+   FBDEV, so line breaking is the same as displaying, and the glyph
+   cache/FT_Face is shared with the UI thread under its lock.
+2. Line gap does NOT affect pagination, and it's not in the key.
+
+Midas Zhou
+-----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "egi_FTsymbol.h"
+#include "ebook_index.h"
+
+static void *ebook_index_thread(void *arg);
+
+
+/*-----------------------------------------------------
+FNV-1a hash of the layout: font face and size, pixels
+per line and lines per page.
+------------------------------------------------------*/
+static unsigned int ebook_index_key(FT_Face face, int fw, int fh, int pixpl, int lines)
+{
+	unsigned int h=2166136261U;
+	int params[4]={fw, fh, pixpl, lines};
+	const char *s;
+	int i;
+
+	for( s=face->family_name; s && *s; s++ )
+		h=(h^(unsigned char)*s)*16777619U;
+	for( s=face->style_name; s && *s; s++ )
+		h=(h^(unsigned char)*s)*16777619U;
+	for( i=0; i<(int)sizeof(params); i++ )
+		h=(h^((unsigned char *)params)[i])*16777619U;
+
+	return h;
+}
+
+
+/*-----------------------------------------------------
+Make sure offs[] can hold n offsets. Call with mutex
+locked, or before the thread starts.
+------------------------------------------------------*/
+static int ebook_index_reserve(EBOOK_INDEX *idx, int n)
+{
+	int *offs;
+	int capacity;
+
+	if( n <= idx->capacity )
+		return 0;
+
+	capacity = idx->capacity>0 ? idx->capacity : 1024;
+	while( capacity < n )
+		capacity *= 2;
+
+	offs=realloc(idx->offs, capacity*sizeof(int));
+	if(offs==NULL) {
+		printf("%s: Fail to realloc offs!\n",__func__);
+		return -1;
+	}
+	idx->offs=offs;
+	idx->capacity=capacity;
+
+	return 0;
+}
+
+
+/*-----------------------------------------------------
+Load a saved index file, if it matches the book and the
+layout, a partial index will be resumed.
+
+Return:
+	0	OK, index loaded.
+	<0	No valid index, start from page 0.
+------------------------------------------------------*/
+static int ebook_index_load(EBOOK_INDEX *idx)
+{
+	EBOOK_INDEX_HEAD head;
+
+	if( pread(idx->fd, &head, sizeof(head), 0) != sizeof(head) )
+		return -1;
+
+	if( head.magic!=EBOOK_INDEX_MAGIC || head.key!=idx->head.key
+	    || head.fsize!=idx->head.fsize || head.mtime!=idx->head.mtime
+	    || head.fw!=idx->head.fw || head.fh!=idx->head.fh
+	    || head.pixpl!=idx->head.pixpl || head.lines!=idx->head.lines
+	    || head.npages<1 )
+	{
+		return -2;
+	}
+
+	if( ebook_index_reserve(idx, head.npages) !=0 )
+		return -3;
+
+	if( pread(idx->fd, idx->offs, head.npages*sizeof(int), sizeof(head)) != head.npages*sizeof(int)
+	    || idx->offs[0]!=0 || idx->offs[head.npages-1] >= idx->fsize )
+	{
+		printf("%s: Index file '%s' is broken!\n",__func__, idx->path);
+		return -4;
+	}
+
+	idx->head.npages=head.npages;
+	idx->head.complete=head.complete;
+	idx->nsaved=head.npages;
+
+	return 0;
+}
+
+
+/*-----------------------------------------------------
+Append offsets indexed since last time to the index
+file, then renew its head.
+------------------------------------------------------*/
+static void ebook_index_save(EBOOK_INDEX *idx)
+{
+	EBOOK_INDEX_HEAD head;
+	int nsaved;
+
+	if(idx->fd<0)
+		return;
+
+	pthread_mutex_lock(&idx->mutex);
+	head=idx->head;
+	nsaved=idx->nsaved;
+	if( head.npages > nsaved ) {
+		if( pwrite(idx->fd, idx->offs+nsaved, (head.npages-nsaved)*sizeof(int),
+				sizeof(head)+nsaved*sizeof(int)) != (head.npages-nsaved)*sizeof(int) )
+		{
+			pthread_mutex_unlock(&idx->mutex);
+			printf("%s: Fail to write index file '%s'!\n",__func__, idx->path);
+			return;
+		}
+	}
+	pthread_mutex_unlock(&idx->mutex);
+
+	/* Head at last, so offsets it claims are always in the file */
+	if( pwrite(idx->fd, &head, sizeof(head), 0) != sizeof(head) ) {
+		printf("%s: Fail to write head of index file '%s'!\n",__func__, idx->path);
+		return;
+	}
+	idx->nsaved=head.npages;
+}
+
+
+/*-------------------------------------------------------------------
+Open the page-offset index of a book, with a layout.
+The saved index file is loaded if it matches, call ebook_index_start()
+to index the rest pages in background.
+
+@fpath:		Path of the book file, the index file is put next to it.
+@faddr:		The book in memory, MUST end with '\0', as FTsymbol
+		 string functions stop at '\0'.
+@fsize:		Size of the book.
+@mtime:		Modification time of the book file.
+@face:		FT_Face to lay out the book.
+@fw,fh:		Font size.
+@pixpl:		Pixels per line.
+@lines:		Lines per page.
+
+Return:
+	Pointer to an EBOOK_INDEX	OK
+	NULL				Fails
+-------------------------------------------------------------------*/
+EBOOK_INDEX* ebook_index_open(const char *fpath, const unsigned char *faddr, off_t fsize, time_t mtime,
+			      FT_Face face, int fw, int fh, int pixpl, int lines)
+{
+	EBOOK_INDEX *idx;
+
+	if( fpath==NULL || faddr==NULL || fsize<1 || face==NULL || pixpl<1 || lines<1 ) {
+		printf("%s: Invalid input params!\n",__func__);
+		return NULL;
+	}
+
+	idx=calloc(1, sizeof(EBOOK_INDEX));
+	if(idx==NULL) {
+		printf("%s: Fail to calloc idx!\n",__func__);
+		return NULL;
+	}
+	pthread_mutex_init(&idx->mutex, NULL);
+	idx->faddr=faddr;
+	idx->fsize=fsize;
+	idx->face=face;
+	idx->fd=-1;
+
+	idx->head.magic=EBOOK_INDEX_MAGIC;
+	idx->head.key=ebook_index_key(face, fw, fh, pixpl, lines);
+	idx->head.fsize=fsize;
+	idx->head.mtime=mtime;
+	idx->head.fw=fw;
+	idx->head.fh=fh;
+	idx->head.pixpl=pixpl;
+	idx->head.lines=lines;
+
+	idx->path=malloc(strlen(fpath)+32);
+	if(idx->path==NULL) {
+		printf("%s: Fail to malloc path!\n",__func__);
+		ebook_index_close(&idx);
+		return NULL;
+	}
+	sprintf(idx->path, "%s.%08x.pgidx", fpath, idx->head.key);
+
+	/* Index works in memory even if the file can't be created, as on a read-only media */
+	idx->fd=open(idx->path, O_RDWR|O_CREAT, 0644);
+	if(idx->fd<0)
+		printf("%s: Fail to open '%s', index will not be saved.\n",__func__, idx->path);
+
+	if( idx->fd<0 || ebook_index_load(idx)!=0 ) {
+		if( ebook_index_reserve(idx, 1) !=0 ) {
+			ebook_index_close(&idx);
+			return NULL;
+		}
+		idx->offs[0]=0;
+		idx->head.npages=1;
+		idx->head.complete=0;
+		idx->nsaved=0;
+		if(idx->fd>=0 && ftruncate(idx->fd, 0)<0)
+			printf("%s: Fail to truncate '%s'.\n",__func__, idx->path);
+	}
+
+	return idx;
+}
+
+
+/*-----------------------------------------------------
+Start to index the rest pages of the book in background.
+
+Return:
+	0	OK, or the index is complete already.
+	<0	Fails
+------------------------------------------------------*/
+int ebook_index_start(EBOOK_INDEX *idx)
+{
+	if(idx==NULL)
+		return -1;
+
+	if( idx->head.complete || idx->running )
+		return 0;
+
+	idx->stop=false;
+	if( pthread_create(&idx->thread, NULL, ebook_index_thread, idx) !=0 ) {
+		printf("%s: Fail to create index thread!\n",__func__);
+		return -2;
+	}
+	idx->running=true;
+
+	return 0;
+}
+
+
+/*-----------------------------------------------------
+Stop the index thread, save the index and free it.
+------------------------------------------------------*/
+void ebook_index_close(EBOOK_INDEX **idx)
+{
+	if( idx==NULL || *idx==NULL )
+		return;
+
+	if( (*idx)->running ) {
+		(*idx)->stop=true;
+		pthread_join((*idx)->thread, NULL);
+		(*idx)->running=false;
+	}
+
+	if( (*idx)->fd >=0 ) {
+		ebook_index_save(*idx);
+		close((*idx)->fd);
+	}
+
+	pthread_mutex_destroy(&(*idx)->mutex);
+	free((*idx)->offs);
+	free((*idx)->path);
+	free(*idx);
+	*idx=NULL;
+}
+
+
+/*-----------------------------------------------------
+Thread to lay out pages one by one, from the last page
+indexed, until the end of the book.
+------------------------------------------------------*/
+static void *ebook_index_thread(void *arg)
+{
+	EBOOK_INDEX *idx=(EBOOK_INDEX *)arg;
+	int off;
+	int nwrite;
+	int count=0;
+
+	off=idx->offs[idx->head.npages-1];	/* Only this thread changes offs[] */
+
+	while( !idx->stop ) {
+		nwrite=FTsymbol_uft8strings_writeFB(NULL, idx->face, idx->head.fw, idx->head.fh,
+						   idx->faddr+off, idx->head.pixpl, idx->head.lines, 0,
+						   0, 0, -1, -1, -1, NULL, NULL, NULL, NULL);
+		if(nwrite<=0)
+			break;
+		off+=nwrite;
+
+		pthread_mutex_lock(&idx->mutex);
+		if( off>=idx->fsize || idx->faddr[off]=='\0' ) {
+			idx->head.complete=1;
+			pthread_mutex_unlock(&idx->mutex);
+			break;
+		}
+		if( ebook_index_reserve(idx, idx->head.npages+1) !=0 ) {
+			pthread_mutex_unlock(&idx->mutex);
+			break;
+		}
+		idx->offs[idx->head.npages++]=off;
+		pthread_mutex_unlock(&idx->mutex);
+
+		if( ++count % EBOOK_INDEX_SYNCPAGES == 0 )
+			ebook_index_save(idx);
+	}
+
+	ebook_index_save(idx);
+
+	if(idx->head.complete)
+		printf("%s: %d pages indexed to '%s'.\n",__func__, idx->head.npages, idx->path);
+
+	return (void *)0;
+}
+
+
+/*-----------------------------------------------------
+Get number of pages indexed.
+
+@complete:	If not NULL, pass out whether all pages
+		are indexed.
+Return:
+	>0	Pages indexed
+	<0	Fails
+------------------------------------------------------*/
+int ebook_index_pages(EBOOK_INDEX *idx, bool *complete)
+{
+	int npages;
+
+	if(idx==NULL)
+		return -1;
+
+	pthread_mutex_lock(&idx->mutex);
+	npages=idx->head.npages;
+	if(complete)
+		*complete=idx->head.complete;
+	pthread_mutex_unlock(&idx->mutex);
+
+	return npages;
+}
+
+
+/*-----------------------------------------------------
+Get offset of a page.
+
+@page:	Page index, from 0.
+Return:
+	>=0	Offset of the page.
+	<0	Fails, or the page is not indexed yet.
+------------------------------------------------------*/
+int ebook_index_seek_page(EBOOK_INDEX *idx, int page)
+{
+	int off=-1;
+
+	if( idx==NULL || page<0 )
+		return -1;
+
+	pthread_mutex_lock(&idx->mutex);
+	if( page < idx->head.npages )
+		off=idx->offs[page];
+	pthread_mutex_unlock(&idx->mutex);
+
+	return off;
+}
+
+
+/*------------------------------------------------------------
+Get offset of the page at some percentage of the book.
+If that part of the book is not indexed yet, offset of the
+nearest line beginning(or UTF-8 char) to the percentage of
+file size is returned.
+
+@percent:	0.0-100.0
+
+Return:
+	>=0	Offset in the book.
+	<0	Fails
+------------------------------------------------------------*/
+int ebook_index_seek_percent(EBOOK_INDEX *idx, float percent)
+{
+	int off;
+	int page;
+	int i;
+
+	if(idx==NULL)
+		return -1;
+
+	if(percent<0.0) percent=0.0;
+	if(percent>100.0) percent=100.0;
+
+	/* 1. All pages are indexed, by page number */
+	pthread_mutex_lock(&idx->mutex);
+	if(idx->head.complete) {
+		page=percent*idx->head.npages/100.0;
+		if(page>idx->head.npages-1)
+			page=idx->head.npages-1;
+		off=idx->offs[page];
+		pthread_mutex_unlock(&idx->mutex);
+		return off;
+	}
+	pthread_mutex_unlock(&idx->mutex);
+
+	/* 2. By file size, and within indexed part, align to the page */
+	off=percent*(idx->fsize-1)/100.0;
+	page=ebook_index_page_of(idx, off);
+	if( page>=0 && page < ebook_index_pages(idx, NULL)-1 )
+		return ebook_index_seek_page(idx, page);
+
+	/* 3. Reel back to beginning of the line, or at least to a leading byte of UTF-8 */
+	for( i=off; i>0 && off-i<1024; i-- ) {
+		if(idx->faddr[i-1]=='\n')
+			return i;
+	}
+	while( off>0 && (idx->faddr[off]&0xC0)==0x80 )
+		off--;
+
+	return off;
+}
+
+
+/*-----------------------------------------------------
+Get index of the page where an offset of the book is in.
+Page starting at offs[npages-1] is considered to extend
+to the end of the book.
+
+Return:
+	>=0	Page index
+	<0	Fails
+------------------------------------------------------*/
+int ebook_index_page_of(EBOOK_INDEX *idx, int off)
+{
+	int low, high, mid;
+
+	if( idx==NULL || off<0 )
+		return -1;
+
+	pthread_mutex_lock(&idx->mutex);
+	low=0;
+	high=idx->head.npages-1;
+	while( low<high ) {
+		mid=(low+high+1)/2;
+		if( idx->offs[mid] <= off )
+			low=mid;
+		else
+			high=mid-1;
+	}
+	pthread_mutex_unlock(&idx->mutex);
+
+	return low;
+}
+
+
+/*-----------------------------------------------------
+Get offset of the page next to an offset.
+
+Return:
+	>0	Offset of the next page
+	<0	Not indexed yet, or it's the last page.
+------------------------------------------------------*/
+int ebook_index_next(EBOOK_INDEX *idx, int off)
+{
+	int page;
+
+	page=ebook_index_page_of(idx, off);
+	if(page<0)
+		return -1;
+
+	return ebook_index_seek_page(idx, page+1);
+}
+
+
+/*-----------------------------------------------------
+Get offset of the page before an offset, which may be
+NOT at the beginning of a page, as after layout changed.
+
+Return:
+	>=0	Offset of the previous page
+	<0	Not indexed yet, or it's the first page.
+------------------------------------------------------*/
+int ebook_index_prev(EBOOK_INDEX *idx, int off)
+{
+	int page;
+	int pgoff;
+	bool complete;
+
+	if( idx==NULL || off<=0 )
+		return -1;
+
+	page=ebook_index_page_of(idx, off);
+	pgoff=ebook_index_seek_page(idx, page);
+
+	/* Beyond the last page indexed, a page may start between pgoff and off */
+	if( page==ebook_index_pages(idx, &complete)-1 && !complete && pgoff!=off )
+		return -1;
+
+	if( pgoff < off )
+		return pgoff;
+
+	return ebook_index_seek_page(idx, page-1);
+}
@@ -0,0 +1,76 @@
+/*----------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+Page-offset index for an UTF-8 ebook.
+
+1. A background thread paginates the whole book with FreeType metrics
+   only(no glyph rendering, no FB), and records the byte offset of
+   each page.
+2. The index is saved as '<book>.<key>.pgidx' next to the book, where
+   key is a hash of font face and size, pixels per line and lines per
+   page. So each layout has its own index file, and a partial index is
+   resumed when it's opened again.
+3. Once a page is indexed, seeking by page number or by percentage is
+   instant, no need to lay out the book from the beginning.
+
+Midas Zhou
+-----------------------------------------------------------------*/
+#ifndef __EBOOK_INDEX_H__
+#define __EBOOK_INDEX_H__
+
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#define EBOOK_INDEX_MAGIC	0x58444945	/* "EIDX" */
+#define EBOOK_INDEX_SYNCPAGES	64		/* Append offsets to index file for every N pages */
+
+/* Head of an index file, followed by int offs[npages] */
+typedef struct ebook_index_head {
+	unsigned int	magic;		/* EBOOK_INDEX_MAGIC */
+	unsigned int	key;		/* Layout hash */
+	off_t		fsize;		/* Size of the book file */
+	time_t		mtime;		/* Modification time of the book file */
+	int		fw, fh;		/* Font size */
+	int		pixpl;		/* Pixels per line */
+	int		lines;		/* Lines per page */
+	int		npages;		/* Pages indexed */
+	int		complete;	/* 1: all pages are indexed */
+} EBOOK_INDEX_HEAD;
+
+typedef struct ebook_index {
+	pthread_mutex_t	mutex;		/* For head.npages, head.complete and offs */
+	pthread_t	thread;
+	bool		running;	/* The thread is created */
+	bool		stop;		/* Request the thread to quit */
+
+	char		*path;		/* Path of the index file */
+	int		fd;		/* Index file, <0 if it can't be saved */
+	int		nsaved;		/* Offsets saved in index file */
+
+	const unsigned char *faddr;	/* Book in memory, end with '\0' */
+	off_t		fsize;
+	FT_Face		face;
+
+	EBOOK_INDEX_HEAD head;
+	int		*offs;		/* offs[k]: start of page k, offs[0]=0 */
+	int		capacity;	/* Capacity of offs[] */
+} EBOOK_INDEX;
+
+EBOOK_INDEX*	ebook_index_open(const char *fpath, const unsigned char *faddr, off_t fsize, time_t mtime,
+				 FT_Face face, int fw, int fh, int pixpl, int lines);
+int		ebook_index_start(EBOOK_INDEX *idx);
+void		ebook_index_close(EBOOK_INDEX **idx);
+
+int		ebook_index_pages(EBOOK_INDEX *idx, bool *complete);
+int		ebook_index_seek_page(EBOOK_INDEX *idx, int page);
+int		ebook_index_seek_percent(EBOOK_INDEX *idx, float percent);
+int		ebook_index_page_of(EBOOK_INDEX *idx, int off);
+int		ebook_index_next(EBOOK_INDEX *idx, int off);
+int		ebook_index_prev(EBOOK_INDEX *idx, int off);
+
+#endif
@@ -44,6 +44,7 @@ midaszhou@yahoo.com
 #include "egi_cstring.h"
 #include "egi_FTsymbol.h"
 #include "page_ebook.h"
+#include "ebook_index.h"
 
 /* icon code for button symbols */
 #define ICON_CODE_PREV 		0
@@ -65,6 +66,7 @@ static int ebook_next(EGI_EBOX * ebox, EGI_TOUCH_DATA * touch_data);
 static int ebook_exit(EGI_EBOX * ebox, EGI_TOUCH_DATA * touch_data);
 static int ebook_hangup(EGI_EBOX * ebox, EGI_TOUCH_DATA * touch_data);
 static int ebook_decorate(EGI_EBOX *ebox);
+static int ebook_reindex(void);
 
 
 /* ebook file */
@@ -86,7 +88,8 @@ static  int x0,y0;
 static  int wtotal;
 static  int nwrite;
 static  bool refresh_ebook;
-static  EGI_FILO *filo;
+static  EGI_FILO *filo;		/* Pages read, in case they're not indexed yet */
+static  EBOOK_INDEX *eindex;	/* Page-offset index for current layout */
 
 
 /*----------------------------------------------------------
@@ -135,11 +138,17 @@ static int page_refresh_ebook(EGI_PAGE *page)
                 return -2;
         }
         fsize=sb.st_size;
-        /* 1.3 mmap txt file */
-        faddr=mmap(NULL, fsize, PROT_READ, MAP_PRIVATE, fd, 0);
-        if(faddr==MAP_FAILED) {
+        /* 1.3 mmap txt file, over an anonymous map with one more byte, so the book always
+         *     ends with '\0', even if fsize is a multiple of page size.
+	 */
+        faddr=mmap(NULL, fsize+1, PROT_READ, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if( faddr==MAP_FAILED
+	    || mmap((void *)faddr, fsize, PROT_READ, MAP_PRIVATE|MAP_FIXED, fd, 0)==MAP_FAILED ) {
 		EGI_PLOG(LOGLV_ERROR,"%s: Fail to call mmap() for file %s.", __func__, fpath);
                 perror("---mmap---");
+		if(faddr!=MAP_FAILED)
+			munmap((void *)faddr, fsize+1);
+		faddr=NULL;
                 return -3;
         }
 
@@ -148,7 +157,10 @@ static int page_refresh_ebook(EGI_PAGE *page)
 	EGI_PLOG(LOGLV_TEST,"%s: Finish open and MMAP file %s, totally %d characters in the book.",
 										__func__, fpath, wtotal);
 
-        /* 1.5 write book title  */
+	/* 1.5 page-offset index, pages are indexed in background */
+	ebook_reindex();
+
+        /* 1.6 write book title  */
         FTsymbol_unicstrings_writeFB(&gv_fb_dev, egi_appfonts.bold,  	/* FBdev, fontface */
                                           35, 35, title,               	/* fw,fh, pstr */
                                           240, 1,  gap,           	/* pixpl, lines, gap */
@@ -160,16 +172,27 @@ static int page_refresh_ebook(EGI_PAGE *page)
 #if 1 /* TODO: TXT display area can NOT be auto. refreshed, to define it as a txt_EBOX! later. */
    /* 2. If (fd>0), write to FB from the last start_reading position of the book */
    else if(refresh_ebook==true) {
-	/* reel back to the last start_reading position */
-	//offp = offp-nwrite>0 ? offp-nwrite : 0;
-        /* write book content: UFT-8 string to FB */
-	egi_filo_push(filo,(void *)(&offp)); /* push current starting offp */
+	char strpg[32];
+	int  npages;
+	bool complete;
+
+        /* write book content from offp: UFT-8 string to FB */
        	nwrite=FTsymbol_uft8strings_writeFB(&gv_fb_dev, egi_appfonts.regular,   /* FBdev, fontface */
                                           fw, fh, faddr+offp,     	 	 /* fw,fh, pstr */
                                           pixpl-x0, lines,  gap,         /* pixpl, lines, gap */
                                           x0, y0,                      	 /* x0,y0, */
-                                          WEGI_COLOR_BLACK, -1, -1 );    /* fontcolor, stranscolor,opaque */
-	offp+=nwrite;
+                                          WEGI_COLOR_BLACK, -1, -1,      /* fontcolor, stranscolor,opaque */
+					  NULL, NULL, NULL, NULL);	 /* cnt, lnleft, penx, peny */
+
+	/* page number, with '+' if the book is still being indexed */
+	npages=ebook_index_pages(eindex, &complete);
+	if(npages>0) {
+		snprintf(strpg, sizeof(strpg), "%d/%d%s", ebook_index_page_of(eindex, offp)+1,
+								npages, complete ? "" : "+" );
+		FTsymbol_uft8strings_writeFB(&gv_fb_dev, egi_appfonts.regular, 12, 12,
+					  (const unsigned char *)strpg, 240-x0, 1, 0, 240-80, 8,
+					  WEGI_COLOR_GRAY, -1, -1, NULL, NULL, NULL, NULL);
+	}
 
 	refresh_ebook=false;
    }
@@ -328,9 +351,18 @@ static int ebook_prev(EGI_EBOX * ebox, EGI_TOUCH_DATA * touch_data)
         if(touch_data->status != pressing)
                 return btnret_IDLE;
 
-	/* reel back to the previous offp */
-	egi_filo_pop(filo, NULL);
-	egi_filo_pop(filo,(void *)&offp);
+	int off, last;
+
+	/* Pop pages read anyway, to keep it paired with pushing in ebook_next() */
+	if( egi_filo_pop(filo,(void *)&last)!=0 )
+		last=-1;
+
+	/* reel back to the previous page, by the index, or by pages read */
+	off=ebook_index_prev(eindex, offp);
+	if(off<0)
+		off=last;
+	if(off>=0)
+		offp=off;
 
 	refresh_ebook=true;
 
@@ -360,6 +392,22 @@ static int ebook_next(EGI_EBOX * ebox, EGI_TOUCH_DATA * touch_data)
         if(touch_data->status != pressing)
                 return btnret_IDLE;
 
+	int off;
+
+	/* If current page is displayed, turn to next page */
+	if(nwrite>0) {
+		/* End of the book */
+		if( faddr[offp+nwrite]=='\0' )
+			return btnret_IDLE;
+
+		/* Take the indexed page, unless it skips over what's just displayed */
+		off=ebook_index_next(eindex, offp);
+		if( off<0 || off>offp+nwrite )
+			off=offp+nwrite;
+
+		egi_filo_push(filo,(void *)(&offp)); /* push current starting offp */
+		offp=off;
+	}
 	refresh_ebook=true;
 
 	return pgret_OK; 	/* fore to refresh page */
@@ -408,10 +456,8 @@ static int ebook_hangup(EGI_EBOX * ebox, EGI_TOUCH_DATA * touch_data)
    * 3. To be handled by page routine.
    */
 
-	/* set ebook need_refresh token here */
-	offp-=nwrite;		/* Reel back reading position */
+	/* set ebook need_refresh token here, offp is still at the beginning of current page */
 	refresh_ebook=true;
-	if(offp<0)offp=0;
 
 	/* need refresh page, a trick here to activate the page after CONT signal */
 	return pgret_OK;
@@ -423,6 +469,39 @@ static int ebook_hangup(EGI_EBOX * ebox, EGI_TOUCH_DATA * touch_data)
 }
 
 
+/*----------------------------------------------------------
+Open the page-offset index for current layout, and start to
+index pages in background. Call it again if layout is
+changed, then offp is realigned to a page of the new layout
+if that part is indexed already, otherwise it's kept and
+the index will catch up later.
+-----------------------------------------------------------*/
+static int ebook_reindex(void)
+{
+	int page;
+
+	ebook_index_close(&eindex);
+
+	eindex=ebook_index_open(fpath, faddr, fsize, sb.st_mtime, egi_appfonts.regular,
+						fw, fh, pixpl-x0, lines);
+	if(eindex==NULL) {
+		EGI_PLOG(LOGLV_ERROR,"%s: Fail to open page index for %s.", __func__, fpath);
+		return -1;
+	}
+
+	page=ebook_index_page_of(eindex, offp);
+	if( ebook_index_next(eindex, offp)>=0 )
+		offp=ebook_index_seek_page(eindex, page);
+
+	if( ebook_index_start(eindex)!=0 ) {
+		EGI_PLOG(LOGLV_ERROR,"%s: Fail to start indexing %s.", __func__, fpath);
+		return -2;
+	}
+
+	return 0;
+}
+
+
 /*-----------------------------------------
 	Decoration for the page
 -----------------------------------------*/
@@ -441,10 +520,13 @@ Release and free all resources
 ------------------------------*/
 void free_ebook_page(void)
 {
+   /* stop indexing before unmap the book */
+   ebook_index_close(&eindex);
+
    if(fd>0) {
 	 close(fd);
 	 fd=-1;
-	 munmap(faddr, fsize);
+	 munmap((void *)faddr, fsize+1);
 	 faddr=NULL;
    }
 
@@ -722,8 +722,9 @@ void*  ff_display_spectrum(void *argv)
         unsigned int    nexp=10;		/* !!!2^nexp=FFT_POINTS */
         unsigned int    aexp=11;        	/* Max. Amp=1<<aexp */
         unsigned int    np=1<<nexp;  		/* input element number for FFT */
-        EGI_FCOMPLEX    ffx[FFT_POINTS];        /* FFT result */
-static  EGI_FCOMPLEX	wang[FFT_POINTS];
+        int32_t		fft_re[FFT_POINTS];     /* FFT input, and real part of result */
+        int32_t		fft_im[FFT_POINTS/2+1]; /* imaginary part of result */
+	EGI_FFT_PLAN	*plan=NULL;		/* FFT plan, tables computed once */
 static  EGI_FVAL	hamming[FFT_POINTS];    /* Hamming window factor */
 static  bool	factors_ready=false;
         unsigned int    ns=1<<5;//6;    	/* points for spectrum diagram */
@@ -737,7 +738,7 @@ static  bool	factors_ready=false;
 	int		hlimit=120; //60;	/* displaying spectrum height limit */
 	int		dybase=210;     	/* Y, base line for spectrum */
 	int		dylimit=dybase-hlimit;
-	int		nk[32]=			/* sort index of ffx[] for sdx[], ng=32 */
+	int		nk[32]=			/* sort index of fft_re/im[] for sdx[], ng=32 */
 	{   2, 4, 8, 16, 24, 32, 40, 48,
             64, 72, 80, 88, 96, 104, 112, 120,
 	    128, 136, 144, 152, 160, 168, 176, 184,
@@ -757,11 +758,16 @@ static  bool	factors_ready=false;
        	        sdx[i]=sx0+(spwidth/(ns-1))*i;
         }
 
+	/* Prepare FFT plan */
+	plan=mat_fft_create_plan(np);
+	if(plan==NULL) {
+		release_fbdev(&fbdev);
+		return (void*)-1;
+	}
+
 	/* Prepare factors */
 	if(!factors_ready) {
 		for(i=0; i<np; i++) {
-		        /* prepare FFT phase angle */
-			wang[i]=MAT_CPANGLE(i, np);
 			/* prepare hamming window factors */
 			hamming[i]=MAT_FHAMMING(i, np);
 		}
@@ -780,21 +786,21 @@ static  bool	factors_ready=false;
      if(FFTdata_ready) {
 #if 1   /* Apply Hamming window  */
 	for(i=0; i<FFT_POINTS; i++)
-		 fft_nx[i]=mat_FixIntMult(hamming[i], fft_nx[i]);
-
+		 fft_re[i]=mat_FixIntMult(hamming[i], fft_nx[i]);
+#else
+	for(i=0; i<FFT_POINTS; i++)
+		 fft_re[i]=fft_nx[i];
 #endif
-	//printf("call egiFFF...\n");
-        /*-------------------------  Call mat_egiFFFT() ---------------------------
-	 *  1. Run FFT with INT type input nx[].
-	 *  2. Input nx[] data has been trimmed in ff_load_FFTdata()
-	 *  3. ( point number, angle factor, float input, int input, fft output )
+        /*-------------------------  Call mat_fft_real_int() ---------------------------
+	 *  1. Run real input FFT with INT type fft_re[], result X[0]...X[np/2] in fft_re/im[].
+	 *  2. Input fft_nx[] data has been trimmed in ff_load_FFTdata()
 	 -------------------------------------------------------------------------*/
-        mat_egiFFFT(np, wang, NULL, fft_nx, ffx);
+        mat_fft_real_int(plan, fft_re, fft_im);
 
         /* update sdy */
 #if 0  /***   1. Symmetric spectrum diagram (TBD)  */
         for(i=0; i<ns; i++) {
-                sdy[i]=dybase-( mat_uintCompAmp( ffx[i*ng])>>(nexp-1 -5) ); //(nexp-1) );
+                sdy[i]=dybase-( mat_intCompAmp(fft_re[i*ng],fft_im[i*ng])>>(nexp-1 -5) ); //(nexp-1) );
                 /* trim sdy[] */
                 if(sdy[i]<0)
                        sdy[i]=0;
@@ -813,11 +819,11 @@ static  bool	factors_ready=false;
 		   #if 1  /* 16 point average */
 			sdy[i]=0;
 			for(j=0; j<16; j++) {
-				sdy[i] += dybase-( mat_uintCompAmp(ffx[nk[i]+j])>>(nexp-1 +0) );
+				sdy[i] += dybase-( mat_intCompAmp(fft_re[nk[i]+j],fft_im[nk[i]+j])>>(nexp-1 +0) );
 			}
 			sdy[i]=sdy[i]>>4;
 		   #else  /* normal sample point */
-	                sdy[i]=dybase-( mat_uintCompAmp(ffx[nk[i]])>>(nexp-1 +2) ); //(nexp-1) );
+	                sdy[i]=dybase-( mat_intCompAmp(fft_re[nk[i]],fft_im[nk[i]])>>(nexp-1 +2) ); //(nexp-1) );
 		   #endif
 
 		}
@@ -825,11 +831,11 @@ static  bool	factors_ready=false;
 		   #if 1  /* 16 point average */
 			sdy[i]=0;
 			for(j=0; j<16; j++) {
-				sdy[i] += dybase-( mat_uintCompAmp(ffx[nk[i]+j])>>(nexp-1 -1) );
+				sdy[i] += dybase-( mat_intCompAmp(fft_re[nk[i]+j],fft_im[nk[i]+j])>>(nexp-1 -1) );
 			}
 			sdy[i]=sdy[i]>>4;
 		   #else  /* normal sample point */
-	                sdy[i]=dybase-( mat_uintCompAmp(ffx[nk[i]])>>(nexp-1 -1) ); //(nexp-1) );
+	                sdy[i]=dybase-( mat_intCompAmp(fft_re[nk[i]],fft_im[nk[i]])>>(nexp-1 -1) ); //(nexp-1) );
 		   #endif
 		}
 
@@ -877,5 +883,6 @@ static  bool	factors_ready=false;
    //fb_filo_dump(&fbdev); /* to dump */
    fb_filo_flush(&fbdev); /*  flush and restore old FB pixel data */
    release_fbdev(&fbdev);
+   mat_fft_free_plan(&plan);
 }
 
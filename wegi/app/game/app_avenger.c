@@ -12,6 +12,7 @@ midaszhou@yahoo.com
 #include "egi_cstring.h"
 #include "egi_FTsymbol.h"
 #include "page_avenger.h"
+#include "avg_sound.h"
 
 #include <signal.h>
 #include <sys/types.h>
@@ -87,7 +88,10 @@ int main(int argc, char **argv)
 
 	/* --- 3. Free page --- */
 	tm_delayms(2000); /* let page log_calling finish */
-        egi_page_free(page_avenger);
+        egi_page_free(page_avenger);	/* game thread is joined */
+
+	/* Close the sound mixer, and free sound data */
+	avg_release_sound();
 
 
 	ret=pgret_OK;
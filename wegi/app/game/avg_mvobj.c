@@ -15,6 +15,42 @@ Midas Zhou
 #define AVG_FIXED_POINT
 
 
+/* --------------------------------------------------------------
+Rotate refimg into actimg according to heading, actimg is reused
+if its size and alpha layout are the same as rotated refimg, or
+it's recreated.
+
+Return:
+	0	OK
+	<0	Fails
+-----------------------------------------------------------------*/
+static int avg_rotate_actimg(EGI_IMGBUF **actimg, const EGI_IMGBUF *refimg, int angle)
+{
+	int height, width;
+
+	if( actimg==NULL || refimg==NULL )
+		return -1;
+
+	if( egi_imgbuf_rotsize(refimg, angle, &height, &width) !=0 )
+		return -1;
+
+	if( *actimg==NULL || (*actimg)->height!=height || (*actimg)->width!=width
+	    || ( (*actimg)->alpha==NULL ) != ( refimg->alpha==NULL ) )
+	{
+		egi_imgbuf_free(*actimg);
+		*actimg=egi_imgbuf_create(height, width, 0, 0); /* H, W, alpah, color */
+		if(*actimg==NULL)
+			return -2;
+		if(refimg->alpha==NULL) {
+			free((*actimg)->alpha);
+			(*actimg)->alpha=NULL;
+		}
+	}
+
+	return egi_imgbuf_rotate_into(*actimg, refimg, angle, false);
+}
+
+
 /* --------------------------------------------------------------
 		Create a new mvobj
 
@@ -50,8 +86,8 @@ AVG_MVOBJ* avg_create_mvobj(    EGI_IMGBUF *icons,  int icon_index,
 		return NULL;
 
 	/* Create actimg according to heading */
-	actimg=egi_imgbuf_rotate(refimg, heading);
-	if(actimg==NULL) {
+	if( avg_rotate_actimg(&actimg, refimg, heading) !=0 ) {
+		egi_imgbuf_free(actimg);
 		egi_imgbuf_free(refimg);
 		return NULL;
 	}
@@ -260,8 +296,7 @@ int avg_renew_plane(AVG_MVOBJ *plane)
 	plane->refimg=egi_imgbuf_subImgCopy( plane->icons, egi_random_max(16)-1 );
 
         /* Create actimg according to heading */
-	egi_imgbuf_free(plane->actimg); plane->actimg=NULL;
-       	plane->actimg=egi_imgbuf_rotate(plane->refimg, -plane->heading); /* Here clockwise is positive */
+	avg_rotate_actimg(&plane->actimg, plane->refimg, -plane->heading); /* Here clockwise is positive */
 
 
 	/* NOTE: Assume that other params need NOT re_assign */
@@ -402,8 +437,7 @@ int plane_trail(AVG_MVOBJ *mvobj)
 #endif
 
         /* 6. Update actimg, Create actimg according to heading */
-	egi_imgbuf_free(mvobj->actimg); mvobj->actimg=NULL;
-       	mvobj->actimg=egi_imgbuf_rotate(mvobj->refimg, -mvobj->heading); /* Here clockwise is positive */
+	avg_rotate_actimg(&mvobj->actimg, mvobj->refimg, -mvobj->heading); /* Here clockwise is positive */
 
 	return 0;
 }
@@ -490,8 +524,7 @@ int bullet_trail(AVG_MVOBJ *bullet)
 #endif
 
         /* 5. Update actimg, Create actimg according to heading */
-	egi_imgbuf_free(bullet->actimg); bullet->actimg=NULL;
-       	bullet->actimg=egi_imgbuf_rotate(bullet->refimg, -bullet->heading); /* Here clockwise is positive */
+	avg_rotate_actimg(&bullet->actimg, bullet->refimg, -bullet->heading); /* Here clockwise is positive */
 
 	return 0;
 }
@@ -528,8 +561,7 @@ int turn_trail(AVG_MVOBJ *mvobj)
 	}
 
         /* 1. Rotate the object:  update actimg, Create actimg according to heading */
-	egi_imgbuf_free(mvobj->actimg); mvobj->actimg=NULL;
-       	mvobj->actimg=egi_imgbuf_rotate(mvobj->refimg, -mvobj->heading); /* Here clockwise is positive */
+	avg_rotate_actimg(&mvobj->actimg, mvobj->refimg, -mvobj->heading); /* Here clockwise is positive */
 
 	return 0;
 }
@@ -4,32 +4,36 @@ it under the terms of the GNU General Public License version 2 as
 published by the Free Software Foundation.
 
 Note:
-	1. To make sample rate of effect sound same as of alsa config
-	   value will improve sound mixing speed?
-	   OR a fraction of Max HW sample rate?
+	1. All sound effects are mixed by egi_mixer in one PCM stream,
+	   opened with params of launch.wav, so all sound files should
+	   be of the same sample rate and channels to avoid resampling.
 
 Midas Zhou
 midaszhou@yahoo.com
 ------------------------------------------------------------------*/
 #include "egi_pcm.h"
+#include "egi_mixer.h"
 
 static EGI_PCMBUF *pcmbuf_launch;	/* Sound data for launching a missle */
 static EGI_PCMBUF *pcmbuf_explode;	/* Sound data for exploding */
 
-static void *  thread_sound_launch(void *arg);
-static void *  thread_sound_explode(void *arg);
+#define AVG_SOUND_PRIO_LAUNCH	0	/* Exploding sound is more important */
+#define AVG_SOUND_PRIO_EXPLODE	1
 
 
-/*------------------------------------
-    Load sound file to EGI_PCMBUFs
+/*---------------------------------------------------
+Load sound file to EGI_PCMBUFs, and open the mixer
+with params of the sound data, so no resampling is
+needed for mixing.
 
 Return:
 	0	OK
 	<0	Fails
-------------------------------------*/
+---------------------------------------------------*/
 int avg_load_sound(void)
 {
 	int ret=0;
+	EGI_PCMBUF *pcmbuf;
 
 	/* launching sound */
 	#ifdef LETS_NOTE
@@ -53,59 +57,53 @@ int avg_load_sound(void)
 		ret--;
 	}
 
-	return ret;
-}
-
-
-/* -----------------------------------------
-      Sound effect for launching a missle
--------------------------------------------*/
-static void *  thread_sound_launch(void *arg)
-{
-     pthread_detach(pthread_self());
-
-     egi_pcmbuf_playback("default", (const EGI_PCMBUF *)pcmbuf_launch, 1024);
-     usleep(10000);
-
-     pthread_exit((void *)0);
-}
-
-
-/*------------------------------------------
-      Sound effect for plane exploding
--------------------------------------------*/
-static void *  thread_sound_explode(void *arg)
-{
-     pthread_detach(pthread_self());
-
-     egi_pcmbuf_playback("default", (const EGI_PCMBUF *)pcmbuf_explode, 1024);
-     usleep(10000);
+	/* One PCM stream for all sound effects */
+	pcmbuf= pcmbuf_launch!=NULL ? pcmbuf_launch : pcmbuf_explode;
+	if(pcmbuf!=NULL) {
+		if( egi_mixer_open("default", pcmbuf->nchanl, pcmbuf->srate) !=0 ) {
+			printf("%s: Fail to open sound mixer.\n", __func__);
+			ret--;
+		}
+	}
 
-     pthread_exit((void *)0);
+	return ret;
 }
 
 
 /*-------------------------------------
- Create thread to play launching sound
+ Play launching sound, it never blocks.
 --------------------------------------*/
 void avg_sound_launch(void)
 {
-	pthread_t thread;
-
-	if( pthread_create( &thread, NULL, thread_sound_launch, NULL ) !=0 )
-		printf("%s:Fail to create pthread for sound launching!\n",__func__);
+	if(pcmbuf_launch==NULL)
+		return;
 
+	if( egi_mixer_play(pcmbuf_launch, EGI_MIXER_GAIN_UNITY, 1, AVG_SOUND_PRIO_LAUNCH) <0 )
+		printf("%s: Fail to play sound launching!\n",__func__);
 }
 
 
 /*-------------------------------------
- Create thread to play launching sound
+ Play exploding sound, it never blocks.
 --------------------------------------*/
 void avg_sound_explode(void)
 {
-	pthread_t thread;
+	if(pcmbuf_explode==NULL)
+		return;
 
-	if( pthread_create( &thread, NULL, thread_sound_explode, NULL ) !=0 )
-		printf("%s:Fail to create pthread for sound launching!\n",__func__);
+	if( egi_mixer_play(pcmbuf_explode, EGI_MIXER_GAIN_UNITY, 1, AVG_SOUND_PRIO_EXPLODE) <0 )
+		printf("%s: Fail to play sound exploding!\n",__func__);
+}
+
+
+/*---------------------------------------------------
+Close the mixer and free sound data, call it after
+the game thread ends, as voices refer to the data.
+---------------------------------------------------*/
+void avg_release_sound(void)
+{
+	egi_mixer_close();
 
+	egi_pcmbuf_free(&pcmbuf_launch);
+	egi_pcmbuf_free(&pcmbuf_explode);
 }
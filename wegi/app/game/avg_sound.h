@@ -13,5 +13,6 @@ midaszhou@yahoo.com
 int avg_load_sound(void);
 void avg_sound_launch(void);
 void avg_sound_explode(void);
+void avg_release_sound(void);
 
 #endif
@@ -43,6 +43,8 @@ midaszhou@yahoo.com
 #include "sys_list.h"
 #include "egi_symbol.h"
 #include "egi_color.h"
+#include "egi_touch.h"
+#include "egi_hitgrid.h"
 
 /* button touch status:
  * corresponding to enum egi_touch_status in egi.h
@@ -310,6 +312,10 @@ EGI_EBOX *egi_hit_pagebox(int px, int py, EGI_PAGE *page, enum egi_ebox_type typ
         }
 
 
+	/* Use hit grid, it's lock free and safe with runners updating eboxes */
+	if( page->hitgrid!=NULL && !page->hitgrid->overflow )
+		return egi_hitgrid_lookup(page->hitgrid, x, y, type);
+
         /* traverse the list, not safe */
         list_for_each(tnode, &page->list_head)
         {
@@ -414,6 +420,8 @@ inline void egi_ebox_needrefresh(EGI_EBOX *ebox)
        if(ebox->container != NULL)
 		pthread_mutex_unlock(&(ebox->container)->pgmutex);
 
+	/* wake up page routine waiting for touch event, to refresh the ebox */
+	egi_touch_wakeup();
 }
 
 
@@ -422,13 +430,22 @@ inline void egi_ebox_needrefresh(EGI_EBOX *ebox)
 ---------------------------------------*/
 inline void egi_ebox_set_touchbox(EGI_EBOX *ebox, EGI_BOX box)
 {
-    if(ebox != NULL)
-	ebox->touchbox=box;
+    if(ebox == NULL)
+	return;
+
+    ebox->touchbox=box;
+
+    /* re-bin it in hit grid of the PAGE */
+    if(ebox->container != NULL && ebox->container->hitgrid != NULL)
+	egi_hitgrid_update(ebox->container->hitgrid, ebox);
 }
 
 
 /*----------------------------------------------------
 ebox refresh: default method
+The ebox is re-binned in hit grid of its PAGE after
+refresh, as it may move, or its touchbox is coupled
+with its position, as a slider.
 
 reutrn:
 	1	use default method
@@ -437,6 +454,8 @@ reutrn:
 ------------------------------------------------------*/
 int egi_ebox_refresh(EGI_EBOX *ebox)
 {
+	int ret;
+
 	/* 1. check data */
 	if( ebox==NULL || ebox->egi_data==NULL )
         {
@@ -452,7 +471,13 @@ int egi_ebox_refresh(EGI_EBOX *ebox)
 	/* 3. ebox object defined method */
 	else
 	{
-		return ebox->method.refresh(ebox); /*only if need_refresh flag is true */
+		ret=ebox->method.refresh(ebox); /*only if need_refresh flag is true */
+
+		/* 4. re-bin it in hit grid of the PAGE, if its touch area changes */
+		if( ebox->type!=type_page && ebox->container!=NULL && ebox->container->hitgrid!=NULL )
+			egi_hitgrid_update(ebox->container->hitgrid, ebox);
+
+		return ret;
 	}
 
 }
@@ -464,7 +489,7 @@ int egi_ebox_refresh(EGI_EBOX *ebox)
 ----------------------------------------*/
 int egi_ebox_forcerefresh(EGI_EBOX *ebox)
 {
-	int ret;
+	int ret=0;
 
 	if(ebox==NULL)
 		return -1;
@@ -485,6 +510,9 @@ int egi_ebox_forcerefresh(EGI_EBOX *ebox)
 	if(ebox->container != NULL)
        		pthread_mutex_unlock(&(ebox->container)->pgmutex);
 
+	/* Bring dirty areas of the back buffer to screen, if dirty tracking is on */
+	if( gv_fb_dev.dirty_on )
+		fb_dirty_flush(&gv_fb_dev, 0);
 
 	return ret;
 }
@@ -522,6 +550,8 @@ reutrn:
 ------------------------------------------------------*/
 int egi_ebox_sleep(EGI_EBOX *ebox)
 {
+	int ret;
+
 	/* 1. put default methods here ...*/
 	if(ebox->method.sleep == NULL)
 	{
@@ -530,8 +560,13 @@ int egi_ebox_sleep(EGI_EBOX *ebox)
 	}
 
 	/* 2. ebox object defined method */
-	else
-		return ebox->method.sleep(ebox);
+	ret=ebox->method.sleep(ebox);
+
+	/* 3. re-bin it in hit grid of the PAGE, sleeping status itself is checked in each lookup */
+	if(ebox->container != NULL && ebox->container->hitgrid != NULL)
+		egi_hitgrid_update(ebox->container->hitgrid, ebox);
+
+	return ret;
 }
 
 /*----------------------------------------------------
@@ -561,7 +596,8 @@ int egi_ebox_decorate(EGI_EBOX *ebox)
 
 
 /*----------------------------------------------------
-ebox refresh: default method
+ebox free: default method
+The ebox is removed from hit grid of its PAGE first.
 
 reutrn:
 	1	use default method
@@ -577,6 +613,10 @@ int egi_ebox_free(EGI_EBOX *ebox)
 		return -1;
 	}
 
+	/* 0. remove it from hit grid of the PAGE, so a lookup never returns it */
+	if( ebox->type!=type_page && ebox->container!=NULL && ebox->container->hitgrid!=NULL )
+		egi_hitgrid_remove(ebox->container->hitgrid, ebox);
+
 	/* 1. put default methods here ...*/
 	if(ebox->method.free == NULL)
 	{
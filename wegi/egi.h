@@ -36,6 +36,7 @@ typedef struct egi_data_btn 	EGI_DATA_BTN;
 typedef struct egi_data_list 	EGI_DATA_LIST;
 typedef struct egi_data_slider 	EGI_DATA_SLIDER;
 typedef struct egi_data_pic 	EGI_DATA_PIC;
+typedef struct egi_hitgrid	EGI_HITGRID;	/* see egi_hitgrid.h */
 
 
 /* A group of pages that logically connected together that serves for an application.
@@ -642,6 +643,9 @@ struct egi_page
 	 */
 	struct list_head list_head; /* list head for child eboxes */
 
+	/* spatial index of child eboxes for egi_hit_pagebox(), NULL if not available */
+	EGI_HITGRID *hitgrid;
+
 	/* --- !!! page routine function : threads pusher and job pusher ----
          *  1. detect pen_touch and trigger buttons.
 	 *  2. refresh page (wallpaper and ebox in list).
@@ -14,7 +14,10 @@ Midas Zhou
 #include <freetype2/ft2build.h>
 #include <freetype2/ftglyph.h>
 #include <arpa/inet.h>
+#include <pthread.h>
+#include <stdlib.h>
 //#include FT_FREETYPE_H
+#include FT_OUTLINE_H
 
 /* <<<<<<<<<<<<<<<<<<   FreeType Fonts  >>>>>>>>>>>>>>>>>>>>>>*/
 
@@ -24,6 +27,413 @@ EGI_FONTS  egi_sysfonts = {.ftname="sysfonts",};
 EGI_FONTS  egi_appfonts = {.ftname="appfonts",};
 
 
+/* <<<<<<<<<<<<<<<<<<   FreeType Glyph Cache  >>>>>>>>>>>>>>>>>>>>>>*/
+
+/*-------------------------------------------------------------------------------
+An LRU cache of rendered FT glyphs, keyed on (face, fw, fh, wcode).
+
+1. Alpha bitmaps of all cached glyphs are packed in one atlas(byte pool), one
+   row after another with width as stride, so they can be passed to
+   symbol_writeFB() directly.
+2. Atlas space is allocated by bumping atlas_used. When it runs out, glyphs
+   at LRU tail are evicted until the live data is less than half of the atlas,
+   then live bitmaps are moved down to squeeze out the holes.
+3. A glyph too big for the atlas is rendered every time, and NOT cached.
+4. Cached glyphs of a face are flushed before the face is released, and again
+   when a new face is created, since a new face may have the same address.
+5. A glyph bitmap is copied out of the atlas before drawing, so FB writing
+   is NOT serialized by the cache lock.
+-------------------------------------------------------------------------------*/
+#define FTGLYPH_CACHE_MAX	1024		/* Max. number of glyphs in cache */
+#define FTGLYPH_HASH_SIZE	2048		/* power of 2 */
+#define FTGLYPH_ATLAS_SIZE	(512*1024)	/* bytes of alpha atlas */
+#define FTGLYPH_MAX_BITMAP	(FTGLYPH_ATLAS_SIZE/16)	/* Max. bytes of a cached bitmap */
+#define FTGLYPH_COPY_STACK	(64*64)		/* Max. bytes of a bitmap copied to stack for drawing */
+
+typedef struct
+{
+	FT_Face		face;		/* Key: face, fw, fh, wcode */
+	int		fw;
+	int		fh;
+	wchar_t		wcode;
+
+	int		hnext;		/* next in hash chain, or in free list, -1 as end */
+	int		prev;		/* LRU list, head as the most recently used */
+	int		next;
+
+	int		offset;		/* offset of alpha in atlas, -1 as no bitmap */
+	int		width;		/* slot->bitmap.width */
+	int		rows;		/* slot->bitmap.rows */
+	int		left;		/* slot->bitmap_left */
+	int		top;		/* slot->bitmap_top */
+	int		advanceX;	/* slot->advance.x>>6 */
+} FTGLYPH;
+
+static struct {
+	pthread_mutex_t	lock;
+	bool		ready;
+
+	FTGLYPH		glyph[FTGLYPH_CACHE_MAX];
+	int		hash[FTGLYPH_HASH_SIZE];	/* head of hash chains */
+	int		lru_head;
+	int		lru_tail;
+	int		free_head;
+	int		count;
+
+	unsigned char	*atlas;
+	int		atlas_used;	/* bytes allocated in atlas, including holes */
+	int		atlas_dead;	/* bytes of holes left by evicted glyphs */
+
+	unsigned long	hits;
+	unsigned long	misses;
+} ftcache = { .lock=PTHREAD_MUTEX_INITIALIZER };
+
+
+/* Reset all slots, with ftcache.lock locked. */
+static void FTglyph_cache_reset(void)
+{
+	int i;
+
+	for(i=0; i<FTGLYPH_HASH_SIZE; i++)
+		ftcache.hash[i]=-1;
+	for(i=0; i<FTGLYPH_CACHE_MAX; i++)
+		ftcache.glyph[i].hnext = (i<FTGLYPH_CACHE_MAX-1 ? i+1 : -1);
+	ftcache.free_head=0;
+	ftcache.lru_head=-1;
+	ftcache.lru_tail=-1;
+	ftcache.count=0;
+	ftcache.atlas_used=0;
+	ftcache.atlas_dead=0;
+}
+
+static inline int FTglyph_hash(FT_Face face, int fw, int fh, wchar_t wcode)
+{
+	unsigned long h;
+
+	h = (unsigned long)face>>4;
+	h = h*31 + fw;
+	h = h*31 + fh;
+	h = h*2654435761u + (unsigned long)wcode;
+
+	return (h ^ (h>>13)) & (FTGLYPH_HASH_SIZE-1);
+}
+
+static void FTglyph_lru_unlink(int k)
+{
+	FTGLYPH *g=&ftcache.glyph[k];
+
+	if(g->prev>=0)	ftcache.glyph[g->prev].next=g->next;
+	else		ftcache.lru_head=g->next;
+	if(g->next>=0)	ftcache.glyph[g->next].prev=g->prev;
+	else		ftcache.lru_tail=g->prev;
+}
+
+static void FTglyph_lru_push(int k)
+{
+	FTGLYPH *g=&ftcache.glyph[k];
+
+	g->prev=-1;
+	g->next=ftcache.lru_head;
+	if(ftcache.lru_head>=0)
+		ftcache.glyph[ftcache.lru_head].prev=k;
+	else
+		ftcache.lru_tail=k;
+	ftcache.lru_head=k;
+}
+
+/* Evict glyph k from hash chain and LRU list, and put it to free list */
+static void FTglyph_evict(int k)
+{
+	FTGLYPH *g=&ftcache.glyph[k];
+	int *pk;
+
+	for( pk=&ftcache.hash[FTglyph_hash(g->face, g->fw, g->fh, g->wcode)]; *pk!=k; pk=&ftcache.glyph[*pk].hnext );
+	*pk=g->hnext;
+
+	FTglyph_lru_unlink(k);
+
+	if(g->offset>=0)
+		ftcache.atlas_dead += g->width*g->rows;
+
+	g->hnext=ftcache.free_head;
+	ftcache.free_head=k;
+	ftcache.count--;
+}
+
+static int FTglyph_cmp_offset(const void *a, const void *b)
+{
+	return ftcache.glyph[*(const int *)a].offset - ftcache.glyph[*(const int *)b].offset;
+}
+
+/*-----------------------------------------------------
+Allocate size bytes in atlas, evict LRU glyphs and pack
+the atlas if necessary.
+Return: offset in atlas.
+-----------------------------------------------------*/
+static int FTglyph_atlas_alloc(int size)
+{
+	int idx[FTGLYPH_CACHE_MAX];
+	int i,n,k;
+	int pos;
+
+	if( ftcache.atlas_used+size > FTGLYPH_ATLAS_SIZE ) {
+		/* Evict LRU glyphs, until live data is less than half */
+		while( ftcache.lru_tail>=0
+			&& ftcache.atlas_used-ftcache.atlas_dead+size > FTGLYPH_ATLAS_SIZE/2 )
+			FTglyph_evict(ftcache.lru_tail);
+
+		/* Move live bitmaps down, in order of offset */
+		for(n=0, k=ftcache.lru_head; k>=0; k=ftcache.glyph[k].next) {
+			if(ftcache.glyph[k].offset>=0)
+				idx[n++]=k;
+		}
+		qsort(idx, n, sizeof(int), FTglyph_cmp_offset);
+		for(pos=0, i=0; i<n; i++) {
+			FTGLYPH *g=&ftcache.glyph[idx[i]];
+			if(g->offset != pos)
+				memmove(ftcache.atlas+pos, ftcache.atlas+g->offset, g->width*g->rows);
+			g->offset=pos;
+			pos += g->width*g->rows;
+		}
+		ftcache.atlas_used=pos;
+		ftcache.atlas_dead=0;
+	}
+
+	pos=ftcache.atlas_used;
+	ftcache.atlas_used += size;
+
+	return pos;
+}
+
+/*-----------------------------------------------------------------------
+Get a glyph from cache, or render it by FreeType and put it in cache.
+Call it with ftcache.lock locked, and *alpha is valid until it unlocks.
+
+@glyph:	   To pass out glyph metrics.
+@alpha:	   To pass out pointer to alpha bitmap, NULL if the glyph has none.
+
+Return:
+	0	OK
+	<0	Fails
+------------------------------------------------------------------------*/
+static int FTglyph_get(FT_Face face, int fw, int fh, wchar_t wcode, FTGLYPH *glyph, unsigned char **alpha)
+{
+	FT_Error	error;
+	FT_GlyphSlot	slot;
+	FTGLYPH		*g;
+	int		h, k, i;
+	int		size;
+
+	if(!ftcache.ready) {
+		ftcache.atlas=malloc(FTGLYPH_ATLAS_SIZE);
+		if(ftcache.atlas==NULL)
+			printf("%s: Fail to malloc glyph atlas, glyphs will not be cached!\n",__func__);
+		FTglyph_cache_reset();
+		ftcache.ready=true;
+	}
+
+	/* 1. Search in cache */
+	h=FTglyph_hash(face, fw, fh, wcode);
+	for( k=ftcache.hash[h]; k>=0; k=ftcache.glyph[k].hnext ) {
+		g=&ftcache.glyph[k];
+		if( g->wcode==wcode && g->face==face && g->fw==fw && g->fh==fh ) {
+			if(ftcache.lru_head!=k) {
+				FTglyph_lru_unlink(k);
+				FTglyph_lru_push(k);
+			}
+			ftcache.hits++;
+			*glyph=*g;
+			*alpha = g->offset>=0 ? ftcache.atlas+g->offset : NULL;
+			return 0;
+		}
+	}
+	ftcache.misses++;
+
+	/* 2. Render by FreeType, set character size in pixels */
+	error = FT_Set_Pixel_Sizes(face, fw, fh);
+   	/* OR set character size in 26.6 fractional points, and resolution in dpi
+   	   error = FT_Set_Char_Size( face, 32*32, 0, 100,0 ); */
+	if(error) {
+		printf("%s: FT_Set_Pixel_Sizes() fails!\n",__func__);
+		return -1;
+	}
+
+	/* Do not set transform, keep up_right and pen position(0,0)
+    		FT_Set_Transform( face, &matrix, &pen ); */
+
+	/* Load char and render, old data in face->glyph will be cleared */
+    	error = FT_Load_Char( face, wcode, FT_LOAD_RENDER );
+    	if (error) {
+		printf("%s: FT_Load_Char() fails!\n",__func__);
+		return -2;
+	}
+
+	slot=face->glyph;
+	glyph->face=face;
+	glyph->fw=fw;
+	glyph->fh=fh;
+	glyph->wcode=wcode;
+	glyph->width=slot->bitmap.width;
+	glyph->rows=slot->bitmap.rows;
+	glyph->left=slot->bitmap_left;
+	glyph->top=slot->bitmap_top;
+	glyph->advanceX=slot->advance.x>>6;
+	glyph->offset=-1;
+	*alpha=slot->bitmap.buffer;
+
+	/* 3. Put it in cache, a big one is NOT cached */
+	size=glyph->width*glyph->rows;
+	if( ftcache.atlas==NULL || size > FTGLYPH_MAX_BITMAP )
+		return 0;
+
+	if(ftcache.free_head<0)
+		FTglyph_evict(ftcache.lru_tail);
+	k=ftcache.free_head;
+	ftcache.free_head=ftcache.glyph[k].hnext;
+	g=&ftcache.glyph[k];
+	*g=*glyph;
+
+	/* Pack rows with width as stride, bitmap.pitch may be bigger */
+	if( slot->bitmap.buffer!=NULL && size>0 ) {
+		g->offset=FTglyph_atlas_alloc(size);
+		for(i=0; i<g->rows; i++)
+			memcpy( ftcache.atlas+g->offset+i*g->width,
+				slot->bitmap.buffer+i*slot->bitmap.pitch, g->width);
+		*alpha=ftcache.atlas+g->offset;
+	}
+	glyph->offset=g->offset;
+
+	/* Link to head of hash chain, after eviction which may change it */
+	g->hnext=ftcache.hash[h];
+	ftcache.hash[h]=k;
+	FTglyph_lru_push(k);
+	ftcache.count++;
+
+	return 0;
+}
+
+/*------------------------------------------------
+Flush all glyphs in cache, keep the atlas.
+-------------------------------------------------*/
+void FTsymbol_glyphcache_flush(void)
+{
+	pthread_mutex_lock(&ftcache.lock);
+	if(ftcache.ready)
+		FTglyph_cache_reset();
+	pthread_mutex_unlock(&ftcache.lock);
+}
+
+/*------------------------------------------------
+Flush cached glyphs of a face, call it before the
+face is released by FT_Done_Face().
+-------------------------------------------------*/
+void FTsymbol_glyphcache_flushFace(FT_Face face)
+{
+	int k, next;
+
+	if(face==NULL)
+		return;
+
+	pthread_mutex_lock(&ftcache.lock);
+	if(ftcache.ready) {
+		for( k=ftcache.lru_head; k>=0; k=next ) {
+			next=ftcache.glyph[k].next;
+			if(ftcache.glyph[k].face==face)
+				FTglyph_evict(k);
+		}
+	}
+	pthread_mutex_unlock(&ftcache.lock);
+}
+
+/*----------------------------------------------------
+Get statistics of the glyph cache, any param may be NULL.
+@hits, misses:	Counts of cache hits and misses.
+@count:		Number of glyphs in cache.
+@atlas_used:	Bytes used in atlas.
+----------------------------------------------------*/
+void FTsymbol_glyphcache_stats(unsigned long *hits, unsigned long *misses, int *count, int *atlas_used)
+{
+	pthread_mutex_lock(&ftcache.lock);
+	if(hits)	*hits=ftcache.hits;
+	if(misses)	*misses=ftcache.misses;
+	if(count)	*count=ftcache.count;
+	if(atlas_used)	*atlas_used=ftcache.atlas_used-ftcache.atlas_dead;
+	pthread_mutex_unlock(&ftcache.lock);
+}
+
+/*----------------------------------------------------------------------------
+Get X space that a wchar takes in FTsymbol_unicode_writeFB(), without rendering.
+
+Metrics of a cached glyph are taken if available, otherwise the glyph is loaded
+without FT_LOAD_RENDER, and its bitmap size is derived from the outline CBox,
+in the same way as FreeType presets the bitmap before rendering.
+It's for text layout only, such as pagination of a long text.
+
+@face:		A face object in FreeType2 library.
+@fh,fw:		Height and width of the wchar.
+@wcode:		UNICODE of the wchar.
+
+Return:
+	>=0	X space in pixels, as bbox_W in FTsymbol_unicode_writeFB().
+	<0	Fails
+-----------------------------------------------------------------------------*/
+int FTsymbol_unicode_bboxW(FT_Face face, int fw, int fh, wchar_t wcode)
+{
+	FT_GlyphSlot	slot;
+	FT_BBox		cbox;
+	FTGLYPH		*g;
+	int		k;
+	int		width=0, rows=0;
+	int		advanceX;
+
+	if(face==NULL)
+		return -1;
+
+	pthread_mutex_lock(&ftcache.lock);
+
+	/* 1. Search in cache, LRU order is NOT changed */
+	if(ftcache.ready) {
+		for( k=ftcache.hash[FTglyph_hash(face, fw, fh, wcode)]; k>=0; k=ftcache.glyph[k].hnext ) {
+			g=&ftcache.glyph[k];
+			if( g->wcode==wcode && g->face==face && g->fw==fw && g->fh==fh ) {
+				width=g->width;
+				rows=g->rows;
+				advanceX=g->advanceX;
+				pthread_mutex_unlock(&ftcache.lock);
+				goto GET_BBOXW;
+			}
+		}
+	}
+
+	/* 2. Load glyph metrics and outline only */
+	if( FT_Set_Pixel_Sizes(face, fw, fh) || FT_Load_Char(face, wcode, FT_LOAD_DEFAULT) ) {
+		pthread_mutex_unlock(&ftcache.lock);
+		printf("%s: Fail to load char 0x%x!\n",__func__, wcode);
+		return -2;
+	}
+	slot=face->glyph;
+	advanceX=slot->advance.x>>6;
+	if( slot->format==FT_GLYPH_FORMAT_OUTLINE ) {
+		FT_Outline_Get_CBox(&slot->outline, &cbox);
+		width= ( ((cbox.xMax+63)&~63) - (cbox.xMin&~63) )>>6;
+		rows = ( ((cbox.yMax+63)&~63) - (cbox.yMin&~63) )>>6;
+	}
+	else {	/* Embedded bitmap */
+		width=slot->bitmap.width;
+		rows=slot->bitmap.rows;
+	}
+	pthread_mutex_unlock(&ftcache.lock);
+
+GET_BBOXW:
+	/* Same as FTsymbol_unicode_writeFB() */
+	if( width*rows==0 && wcode==12288 )	/* LOCALE SPACE without bitmap */
+		return fw;
+
+	return advanceX > width ? advanceX : width;
+}
+
+
+
 /*--------------------------------------
 Load FreeType2 EGI_FONT egi_sysfonts
 for main process, as small as possible.
@@ -256,10 +666,10 @@ int FTsymbol_load_library( EGI_FONTS *symlib )
 
 
 FT_FAIL:
- 	FT_Done_Face    ( symlib->regular );
-  	FT_Done_Face    ( symlib->light );
-  	FT_Done_Face    ( symlib->bold );
-  	FT_Done_Face    ( symlib->special );
+	FTsymbol_release_face( symlib->regular );
+	FTsymbol_release_face( symlib->light );
+	FTsymbol_release_face( symlib->bold );
+	FTsymbol_release_face( symlib->special );
   	FT_Done_FreeType( symlib->library );
 
 	return error;
@@ -305,10 +715,27 @@ FT_Face FTsymbol_create_newFace( EGI_FONTS *symlib, const char *ftpath)
         }
         EGI_PLOG(LOGLV_CRITICAL,"%s: Succeed to open and read font file '%s'.", __func__, ftpath);
 
+	/* In case an old face at the same address was released without flushing */
+	FTsymbol_glyphcache_flushFace(face);
+
 	return face;
 }
 
 
+/*--------------------------------------------------
+Release a FT_Face created by FTsymbol_create_newFace(),
+and flush its cached glyphs.
+---------------------------------------------------*/
+void FTsymbol_release_face(FT_Face face)
+{
+	if(face==NULL)
+		return;
+
+	FTsymbol_glyphcache_flushFace(face);
+	FT_Done_Face(face);
+}
+
+
 
 /*--------------------------------------------------
 	Rlease FT library.
@@ -318,10 +745,11 @@ void FTsymbol_release_library( EGI_FONTS *symlib )
 	if(symlib==NULL)
 		return;
 
- 	FT_Done_Face    ( symlib->regular );
-  	FT_Done_Face    ( symlib->light );
-  	FT_Done_Face    ( symlib->bold );
-	FT_Done_Face	( symlib->special );
+	/* Flush cached glyphs of each face before it's released */
+	FTsymbol_release_face( symlib->regular );
+	FTsymbol_release_face( symlib->light );
+	FTsymbol_release_face( symlib->bold );
+	FTsymbol_release_face( symlib->special );
   	FT_Done_FreeType( symlib->library );
 }
 
@@ -691,9 +1119,12 @@ int  FTsymbol_load_asciis_from_fontfile(  EGI_SYMPAGE *symfont_page, const char
 
 	} /* end transversing all ASCII chars */
 
+	/* 6. build glyph atlas for symbol_string_writeFB() */
+	if( symbol_build_atlas(symfont_page)!=0 )
+		printf("%s: Fail to build glyph atlas!\n", __func__);
 
 FT_FAILS:
-  	FT_Done_Face    ( face );
+	FTsymbol_release_face( face );
   	FT_Done_FreeType( library );
 
   	return ret;
@@ -713,6 +1144,7 @@ FT_FAILS:
 6. Or to get symheight just as in symbol_load_asciis_from_fontfile() as BBOX_H. However it's maybe
    a good idea to display CJK and wester charatcters separately by calling differenct functions.
    i.e. symbol_writeFB() for alphabets and FTsymbol_unicode_writeFB() for CJKs.
+7. The glyph is taken from the glyph cache, FreeType renders it only when it's not cached.
 
 
 @fbdev:         FB device
@@ -745,43 +1177,53 @@ use following COLOR:
 void FTsymbol_unicode_writeFB(FBDEV *fb_dev, FT_Face face, int fw, int fh, wchar_t wcode, int *xleft,
 				int x0, int y0, int fontcolor, int transpcolor,int opaque)
 {
-  	FT_Error      error;
-  	FT_GlyphSlot slot = face->glyph;
+	FTGLYPH glyph;
+	unsigned char *alpha;
+	unsigned char abuff[FTGLYPH_COPY_STACK];	/* copy of alpha, for small glyphs */
 	EGI_SYMPAGE ftsympg={0};	/* a symbol page to hold the character bitmap */
 	ftsympg.symtype=symtype_FT2;
 
-	int advanceX;   /* X advance in pixels */
 	int bbox_W;	/* boundary box width, taken bbox_H=fh */
 	int delX;	/* adjust bitmap position in boundary box, according to bitmap_top */
 	int delY;
 
-	/* set character size in pixels */
-	error = FT_Set_Pixel_Sizes(face, fw, fh);
-   	/* OR set character size in 26.6 fractional points, and resolution in dpi
-   	   error = FT_Set_Char_Size( face, 32*32, 0, 100,0 ); */
-	if(error) {
-		printf("%s: FT_Set_Pixel_Sizes() fails!\n",__func__);
+	/* No FB, only get xleft renewed, the glyph is NOT rendered */
+	if(fb_dev==NULL) {
+		bbox_W=FTsymbol_unicode_bboxW(face, fw, fh, wcode);
+		if(bbox_W>0)
+			*xleft -= bbox_W;
 		return;
 	}
 
-	/* Do not set transform, keep up_right and pen position(0,0)
-    		FT_Set_Transform( face, &matrix, &pen ); */
-
-	/* Load char and render, old data in face->glyph will be cleared */
-    	error = FT_Load_Char( face, wcode, FT_LOAD_RENDER );
-    	if (error) {
-		printf("%s: FT_Load_Char() fails!\n",__func__);
+	/* Get glyph from cache, or render it. alpha is valid until unlock, so copy it out
+	 * and draw without the lock. Alpha of an uncached glyph has a stride of pitch.
+	 */
+	pthread_mutex_lock(&ftcache.lock);
+	if( FTglyph_get(face, fw, fh, wcode, &glyph, &alpha) !=0 ) {
+		pthread_mutex_unlock(&ftcache.lock);
 		return;
 	}
+	if( alpha!=NULL ) {
+		int size=glyph.width*glyph.rows;
+		int pitch= glyph.offset>=0 ? glyph.width : face->glyph->bitmap.pitch;
+		unsigned char *src=alpha;
+		int i;
+
+		alpha= size<=FTGLYPH_COPY_STACK ? abuff : malloc(size);
+		if(alpha!=NULL) {
+			for(i=0; i<glyph.rows; i++)
+				memcpy(alpha+i*glyph.width, src+i*pitch, glyph.width);
+		}
+	}
+	pthread_mutex_unlock(&ftcache.lock);
 
 	/* Assign alpha to ftsympg, Ownership IS NOT transfered! */
-	ftsympg.alpha 	  = slot->bitmap.buffer;
-	ftsympg.symheight = slot->bitmap.rows; //fh; /* font height in pixels is bigger than bitmap.rows! */
-	ftsympg.ftwidth   = slot->bitmap.width; /* ftwidth <= (slot->advance.x>>6) */
+	ftsympg.alpha 	  = alpha;
+	ftsympg.symheight = glyph.rows; //fh; /* font height in pixels is bigger than bitmap.rows! */
+	ftsympg.ftwidth   = glyph.width; /* ftwidth <= advanceX */
 
 	/* Check whether xleft is used up first. */
-	advanceX = slot->advance.x>>6;
-	bbox_W = (advanceX > slot->bitmap.width ? advanceX : slot->bitmap.width);
+	bbox_W = (glyph.advanceX > glyph.width ? glyph.advanceX : glyph.width);
 
 	/* check bitmap data, we need bbox_W here */
 	if(ftsympg.alpha==NULL) {
@@ -805,7 +1247,7 @@ void FTsymbol_unicode_writeFB(FBDEV *fb_dev, FT_Face face, int fw, int fh, wchar
 	/* reduce xleft */
 	*xleft -= bbox_W;
 	if( *xleft < 0 )
-		return;
+		goto END_FUNC;
 	/* taken bbox_H as fh */
 
 #if 0 /* ----TEST: Display Boundary BOX------- */
@@ -815,14 +1257,18 @@ void FTsymbol_unicode_writeFB(FBDEV *fb_dev, FT_Face face, int fw, int fh, wchar
 
 #endif
 	/* adjust bitmap position relative to boundary box */
-	delX= slot->bitmap_left;
-	delY= -slot->bitmap_top + fh;
+	delX= glyph.left;
+	delY= -glyph.top + fh;
 
 	/* write to FB,  symcode =0, whatever  */
 	if(fb_dev != NULL) {
 		//printf("%s: symbol_writeFB...\n",__func__);
 		symbol_writeFB(fb_dev, &ftsympg, fontcolor, transpcolor, x0+delX, y0+delY, 0, opaque);
 	}
+
+END_FUNC:
+	if(alpha!=abuff)
+		free(alpha);
 }
 
 
@@ -1191,7 +1637,7 @@ int  FTsymbol_uft8strings_pixlen( FT_Face face, int fw, int fh, const unsigned c
 			continue;
 		}
 
-		/* write unicode bitmap to FB, and get xleft renewed. */
+		/* fb_dev==NULL, only get xleft renewed, with metrics from the glyph cache. */
 		FTsymbol_unicode_writeFB(NULL, face, fw, fh, wcstr[0], &xleft,
 							 0, 0, WEGI_COLOR_BLACK, -1, -1 );
 
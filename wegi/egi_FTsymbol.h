@@ -53,6 +53,7 @@ extern EGI_FONTS   egi_appfonts; /* APP font set */
 
 int 	FTsymbol_load_library( EGI_FONTS *symlib );
 FT_Face FTsymbol_create_newFace( EGI_FONTS *symlib, const char *ftpath);
+void	FTsymbol_release_face(FT_Face face);
 void 	FTsymbol_release_library( EGI_FONTS *symlib );
 int	FTsymbol_load_allpages(void);
 void 	FTsymbol_release_allpages(void);
@@ -75,6 +76,11 @@ int  	FTsymbol_uft8strings_writeFB( FBDEV *fb_dev, FT_Face face, int fw, int fh,
 			       int fontcolor, int transpcolor, int opaque,
  			       int *cnt, int *lnleft, int* penx, int* peny );
 
+void	FTsymbol_glyphcache_flush(void);
+void	FTsymbol_glyphcache_flushFace(FT_Face face);
+void	FTsymbol_glyphcache_stats(unsigned long *hits, unsigned long *misses, int *count, int *atlas_used);
+int	FTsymbol_unicode_bboxW(FT_Face face, int fw, int fh, wchar_t wcode);
+
 int  	FTsymbol_uft8strings_pixlen( FT_Face face, int fw, int fh, const unsigned char *pstr);
 
 #endif
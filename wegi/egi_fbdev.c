@@ -87,6 +87,12 @@ int init_fbdev(FBDEV *fb_dev)
         fb_dev->pixcolor=(30<<11)|(10<<5)|10;
         fb_dev->pixalpha=255;
 
+        /* reset dirty rects */
+	fb_dev->dirty_on=false;
+	fb_dev->ndirty=0;
+	fb_dev->dotbox_set=false;
+	pthread_mutex_init(&fb_dev->dirty_lock, NULL);
+
         /* init fb_filo */
         fb_dev->filo_on=0;
         fb_dev->fb_filo=egi_malloc_filo(1<<13, sizeof(FBPIX), FILO_AUTO_DOUBLE);//|FILO_AUTO_HALVE
@@ -158,6 +164,8 @@ void release_fbdev(FBDEV *dev)
 
         close(dev->fbfd);
         dev->fbfd=-1;
+
+	pthread_mutex_destroy(&dev->dirty_lock);
 }
 
 
@@ -190,6 +198,10 @@ int init_virt_fbdev(FBDEV *fb_dev, EGI_IMGBUF *eimg)
 	fb_dev->map_fb=NULL;
 	fb_dev->fb_filo=NULL;
 	fb_dev->filo_on=0;
+	fb_dev->dirty_on=false;
+	fb_dev->ndirty=0;
+	fb_dev->dotbox_set=false;
+	pthread_mutex_init(&fb_dev->dirty_lock, NULL);
 
 	/* reset virtual FB, as EGI_IMGBUF */
 	fb_dev->virt_fb=eimg;
@@ -239,6 +251,7 @@ void release_virt_fbdev(FBDEV *dev)
 {
 	dev->virt=false;
 	dev->virt_fb=NULL;
+	pthread_mutex_destroy(&dev->dirty_lock);
 }
 
 /*-----------------------------------------------------------
@@ -325,6 +338,9 @@ void fb_clear_backBuff(FBDEV *fb_dev, uint32_t color)
 			*(uint32_t *)(fb_dev->map_bk+(i<<2))=color;
 	}
         //else 	--- NOT SUPPORT --
+
+	/* mark dirty area */
+	fb_dirty_add(fb_dev, 0, 0, fb_dev->vinfo.xres-1, fb_dev->vinfo.yres-1);
 }
 
 
@@ -374,24 +390,103 @@ void fb_page_refresh(FBDEV *dev, unsigned int numpg)
 -------------------------------------------------------------------------------------*/
 void fb_lines_refresh(FBDEV *dev, unsigned int numpg, unsigned int sind, unsigned int n)
 {
-	unsigned int xres;
+        if(dev==NULL)
+                return;
+	if( n==0 || sind > dev->vinfo.yres-1 )
+		return;
+
+	if( sind+n > dev->vinfo.yres ) /* sind+n-1 > dev->vinfo.yres-1 */
+		n=dev->vinfo.yres-sind;
+
+	fb_rect_refresh(dev, numpg, 0, sind, dev->vinfo.xres-1, sind+n-1);
+}
+
+
+/*------------------------------------------------------------------
+Copy a rectangle area of FB back buffer map_buff[numpg] to the FB.
+No VSYNC here, the rect MUST be within the screen.
+------------------------------------------------------------------*/
+static void fb_copy_rect(FBDEV *dev, unsigned int numpg, const FB_RECT *rect)
+{
 	unsigned int Bpp; /* byte per pixel */
 	unsigned int Bpl; /* bytes per line */
+	unsigned int len; /* bytes per rect row */
+	unsigned char *src;
+	unsigned char *dest;
+	int i;
+
+	Bpp=dev->vinfo.bits_per_pixel>>3;
+	Bpl=Bpp*dev->vinfo.xres;
+	len=Bpp*(rect->x2-rect->x1+1);
+
+	src=dev->map_buff+dev->screensize*numpg+rect->y1*Bpl+rect->x1*Bpp;
+	dest=dev->map_fb+rect->y1*Bpl+rect->x1*Bpp;
+
+	/* Full width lines are consecutive in mem */
+	if( len==Bpl ) {
+		memcpy(dest, src, Bpl*(rect->y2-rect->y1+1));
+		return;
+	}
+
+	for(i=rect->y1; i<=rect->y2; i++) {
+		memcpy(dest, src, len);
+		src +=Bpl;
+		dest +=Bpl;
+	}
+}
+
+
+/*------------------------------------------------------------------------
+Clip a rect to the screen and sort its points.
+
+Return:
+	0	OK
+	<0	The rect is totally out of the screen.
+-------------------------------------------------------------------------*/
+static int fb_clip_rect(FBDEV *dev, FB_RECT *rect)
+{
+	int tmp;
+
+	if(rect->x1 > rect->x2) {
+		tmp=rect->x1; rect->x1=rect->x2; rect->x2=tmp;
+	}
+	if(rect->y1 > rect->y2) {
+		tmp=rect->y1; rect->y1=rect->y2; rect->y2=tmp;
+	}
+
+	if( rect->x2<0 || rect->y2<0 || rect->x1 > (int)dev->vinfo.xres-1
+					|| rect->y1 > (int)dev->vinfo.yres-1 )
+		return -1;
+
+	if(rect->x1<0) rect->x1=0;
+	if(rect->y1<0) rect->y1=0;
+	if(rect->x2 > (int)dev->vinfo.xres-1) rect->x2=dev->vinfo.xres-1;
+	if(rect->y2 > (int)dev->vinfo.yres-1) rect->y2=dev->vinfo.yres-1;
+
+	return 0;
+}
+
+
+/*------------------------------------------------------------------------------------
+ Refresh a rectangle area of FB screen with FB back buffer map_buff[numpg],
+ as a generalized fb_lines_refresh().
+ !!! NOTE: Soft Pos_roation has NO effect for this function. !!!
+
+@x1,y1,x2,y2:	Two diagonal points of the rect, in raw FB coordinates.
+		The rect will be clipped to the screen.
+-------------------------------------------------------------------------------------*/
+void fb_rect_refresh(FBDEV *dev, unsigned int numpg, int x1, int y1, int x2, int y2)
+{
+	FB_RECT rect={ x1, y1, x2, y2 };
 
         if(dev==NULL)
                 return;
         if( dev->map_bk==NULL || dev->map_fb==NULL )
                 return;
-	if( n==0 || sind > dev->vinfo.yres-1 )
+	if( fb_clip_rect(dev, &rect) !=0 )
 		return;
 
-	if( sind+n > dev->vinfo.yres ) /* sind+n-1 > dev->vinfo.yres-1 */
-		n=dev->vinfo.yres-sind;
-
         numpg=numpg%FBDEV_BUFFER_PAGES; /* Note: Modulo result is compiler depended */
-	xres=dev->vinfo.xres;
-	Bpp=dev->vinfo.bits_per_pixel>>3;
-	Bpl=Bpp*xres;
 
         /* Try to synchronize with FB kernel VSYNC */
         if( ioctl( dev->fbfd, FBIO_WAITFORVSYNC, 0) !=0 ) {
@@ -399,24 +494,254 @@ void fb_lines_refresh(FBDEV *dev, unsigned int numpg, unsigned int sind, unsigne
                 printf("Fail to ioctl FBIO_WAITFORVSYNC.\n");
         } else { /* memcpy to FB, ignore VSYNC signal. */
 #endif
-		switch(numpg) {
-			case 0:
-				memcpy(dev->map_fb+sind*Bpl, dev->map_buff+sind*Bpl, n*Bpl);
-				break;
-			case 1:
-				memcpy(dev->map_fb+sind*Bpl, dev->map_buff+dev->screensize+sind*Bpl, n*Bpl);
-				break;
-			case 2:
-				memcpy(dev->map_fb+sind*Bpl, dev->map_buff+(dev->screensize<<1)+sind*Bpl, n*Bpl);
-				break;
-			default:
-				memcpy(dev->map_fb+sind*Bpl, dev->map_buff+dev->screensize*numpg+sind*Bpl, n*Bpl);
-				break;
+		fb_copy_rect(dev, numpg, &rect);
+	}
+}
+
+
+/*-------------------------------------------------------------
+Turn on/off dirty region tracking for a real FBDEV.
+Dirty rects are cleared in both cases.
+
+Note:
+1. Drawing functions mark dirty areas only when it's on.
+2. When it's off, fb_dirty_flush() refreshes the whole page.
+--------------------------------------------------------------*/
+void fb_dirty_on(FBDEV *dev)
+{
+	if(dev==NULL || dev->virt)
+		return;
+
+	fb_dirty_clear(dev);
+	dev->dirty_on=true;
+}
+
+void fb_dirty_off(FBDEV *dev)
+{
+	if(dev==NULL)
+		return;
+
+	dev->dirty_on=false;
+	fb_dirty_clear(dev);
+}
+
+/*------------------------------------
+Clear all dirty rects of the FBDEV.
+------------------------------------*/
+inline void fb_dirty_clear(FBDEV *dev)
+{
+	if(dev==NULL)
+		return;
+
+	pthread_mutex_lock(&dev->dirty_lock);
+	dev->ndirty=0;
+	dev->dotbox_set=false;
+	pthread_mutex_unlock(&dev->dirty_lock);
+}
+
+
+/*------------------------------------------------------------------------
+Add a clipped rect to dirty rects, dev->dirty_lock MUST be held.
+See fb_dirty_add().
+-------------------------------------------------------------------------*/
+static void fb_dirty_merge(FBDEV *dev, FB_RECT rect)
+{
+	FB_RECT *pr;
+	int x1, y1, x2, y2;
+	int i;
+	int k;
+	long area, incr, min_incr;
+
+	/* Merge with all overlapped or adjacent rects */
+	for(i=0; i<dev->ndirty; i++) {
+		pr=&dev->dirty[i];
+		if( rect.x1 > pr->x2+1 || rect.x2+1 < pr->x1 || rect.y1 > pr->y2+1 || rect.y2+1 < pr->y1 )
+			continue;
+
+		/* Already covered */
+		if( rect.x1>=pr->x1 && rect.x2<=pr->x2 && rect.y1>=pr->y1 && rect.y2<=pr->y2 )
+			return;
+
+		if(pr->x1 < rect.x1) rect.x1=pr->x1;
+		if(pr->y1 < rect.y1) rect.y1=pr->y1;
+		if(pr->x2 > rect.x2) rect.x2=pr->x2;
+		if(pr->y2 > rect.y2) rect.y2=pr->y2;
+
+		/* Remove it and check all over again, as the rect grows */
+		dev->dirty[i]=dev->dirty[--dev->ndirty];
+		i=-1;
+	}
+
+	/* List full, merge into the one which costs least area increment */
+	if( dev->ndirty == FBDEV_MAX_DIRTY_RECTS ) {
+		k=0;
+		min_incr=-1;
+		for(i=0; i<dev->ndirty; i++) {
+			pr=&dev->dirty[i];
+			area=(long)(pr->x2-pr->x1+1)*(pr->y2-pr->y1+1);
+			incr=(long)( (rect.x2>pr->x2?rect.x2:pr->x2) - (rect.x1<pr->x1?rect.x1:pr->x1) +1 )
+			          *( (rect.y2>pr->y2?rect.y2:pr->y2) - (rect.y1<pr->y1?rect.y1:pr->y1) +1 ) - area;
+			if( min_incr<0 || incr<min_incr ) {
+				min_incr=incr;
+				k=i;
+			}
 		}
+		pr=&dev->dirty[k];
+		x1= rect.x1 < pr->x1 ? rect.x1 : pr->x1;
+		y1= rect.y1 < pr->y1 ? rect.y1 : pr->y1;
+		x2= rect.x2 > pr->x2 ? rect.x2 : pr->x2;
+		y2= rect.y2 > pr->y2 ? rect.y2 : pr->y2;
+
+		/* The bigger one may overlap others, so add it again */
+		dev->dirty[k]=dev->dirty[--dev->ndirty];
+		rect.x1=x1; rect.y1=y1;
+		rect.x2=x2; rect.y2=y2;
+		fb_dirty_merge(dev, rect);
+		return;
+	}
+
+	dev->dirty[dev->ndirty++]=rect;
+}
+
+/*------------------------------------------------------------------------
+Add a rect to dirty rects of the FBDEV.
+
+If it overlaps or touches any of existing dirty rects, they are merged
+into their bounding box, and so on, so all dirty rects in list are NOT
+overlapped. If the list is full, the new rect will be merged into the
+one which costs least area increment.
+It's thread safe, the list is guarded by dev->dirty_lock.
+
+@x1,y1,x2,y2:	Two diagonal points of the rect, in raw FB coordinates.
+		The rect will be clipped to the screen.
+-------------------------------------------------------------------------*/
+void fb_dirty_add(FBDEV *dev, int x1, int y1, int x2, int y2)
+{
+	FB_RECT rect={ x1, y1, x2, y2 };
+
+	if(dev==NULL || !dev->dirty_on)
+		return;
+	if( fb_clip_rect(dev, &rect) !=0 )
+		return;
+
+	pthread_mutex_lock(&dev->dirty_lock);
+	fb_dirty_merge(dev, rect);
+	pthread_mutex_unlock(&dev->dirty_lock);
+}
+
+
+/*------------------------------------------------------------------------
+Same as fb_dirty_add(), but points are in FB.pos_rotate coordinates.
+-------------------------------------------------------------------------*/
+void fb_dirty_add_pos(FBDEV *dev, int x1, int y1, int x2, int y2)
+{
+	int xres, yres;
+
+	if(dev==NULL || !dev->dirty_on)
+		return;
+
+	xres=dev->vinfo.xres;
+	yres=dev->vinfo.yres;
+
+	/* Same mapping as in draw_dot() */
+	switch(dev->pos_rotate) {
+		case 1:			/* Clockwise 90 deg */
+			fb_dirty_add(dev, (xres-1)-y1, x1, (xres-1)-y2, x2);
+			break;
+		case 2:			/* Clockwise 180 deg */
+			fb_dirty_add(dev, (xres-1)-x1, (yres-1)-y1, (xres-1)-x2, (yres-1)-y2);
+			break;
+		case 3:			/* Clockwise 270 deg */
+			fb_dirty_add(dev, y1, (yres-1)-x1, y2, (yres-1)-x2);
+			break;
+		default:
+			fb_dirty_add(dev, x1, y1, x2, y2);
+			break;
 	}
 }
 
 
+/*------------------------------------------------------------------------
+Refresh FB screen with dirty areas of FB back buffer map_buff[numpg] only,
+then clear dirty rects.
+If dirty tracking is off, it refreshes the whole page as fb_page_refresh().
+
+Return:
+	>=0	Number of dirty rects refreshed.
+	<0	Fails
+-------------------------------------------------------------------------*/
+int fb_dirty_flush(FBDEV *dev, unsigned int numpg)
+{
+	FB_RECT rects[FBDEV_MAX_DIRTY_RECTS];
+	FB_RECT rect;
+	int i;
+	int n;
+
+	if(dev==NULL)
+		return -1;
+	if( dev->map_bk==NULL || dev->map_fb==NULL )
+		return -1;
+
+	if( !dev->dirty_on ) {
+		fb_page_refresh(dev, numpg);
+		return 1;
+	}
+
+	/* Take all dirty rects, drawing threads may add new ones while copying */
+	pthread_mutex_lock(&dev->dirty_lock);
+
+	/* Merge pixels by draw_dot() */
+	if(dev->dotbox_set) {
+		dev->dotbox_set=false;
+		rect=dev->dotbox;
+		if( fb_clip_rect(dev, &rect)==0 )
+			fb_dirty_merge(dev, rect);
+	}
+
+	n=dev->ndirty;
+	memcpy(rects, dev->dirty, n*sizeof(FB_RECT));
+	dev->ndirty=0;
+
+	pthread_mutex_unlock(&dev->dirty_lock);
+
+	if( n==0 )
+		return 0;
+
+        numpg=numpg%FBDEV_BUFFER_PAGES; /* Note: Modulo result is compiler depended */
+
+        /* Try to synchronize with FB kernel VSYNC */
+        if( ioctl( dev->fbfd, FBIO_WAITFORVSYNC, 0) !=0 ) {
+#ifdef LETS_NOTE
+                printf("Fail to ioctl FBIO_WAITFORVSYNC.\n");
+        } else { /* memcpy to FB, ignore VSYNC signal. */
+#endif
+		for(i=0; i<n; i++)
+			fb_copy_rect(dev, numpg, &rects[i]);
+	}
+
+	return n;
+}
+
+
+/*-----------------------------------------------------------------
+Restore the working back buffer dev->map_bk with dev->map_buff[buffNum],
+normally a background image saved there, and mark the whole screen
+dirty.
+------------------------------------------------------------------*/
+void fb_restore_bkBuff(FBDEV *dev, unsigned int buffNum)
+{
+	if( dev==NULL || dev->map_bk==NULL || dev->map_buff==NULL )
+		return;
+
+        buffNum=buffNum%FBDEV_BUFFER_PAGES; /* Note: Modulo result is compiler depended */
+
+	memcpy(dev->map_bk, dev->map_buff+buffNum*dev->screensize, dev->screensize);
+
+	/* mark dirty area */
+	fb_dirty_add(dev, 0, 0, dev->vinfo.xres-1, dev->vinfo.yres-1);
+}
+
+
 /*-----------------------------------------------------
  Backup current page data in dev->map_fb
  to dev->map_buff[index], which normally is
@@ -599,12 +924,33 @@ Midas Zhou
 inline void fb_filo_flush(FBDEV *dev)
 {
         FBPIX fpix;
+	FB_RECT box={ 0, 0, -1, -1 };	/* bounding box of restored pixels, empty */
+	int Bpp;
+	int fx, fy;
 
         if(!dev || !dev->fb_filo)
                 return;
 
+	Bpp=dev->vinfo.bits_per_pixel>>3;
+
         while( egi_filo_pop(dev->fb_filo, &fpix)==0 )
         {
+		/* expand dirty box, position is in bytes, see fb_blit_span() and draw_dot() */
+		if( dev->dirty_on && Bpp>0 ) {
+			fy=fpix.position/dev->finfo.line_length-dev->vinfo.yoffset;
+			fx=(fpix.position%dev->finfo.line_length)/Bpp-dev->vinfo.xoffset;
+			if( box.x2<box.x1 ) {
+				box.x1=box.x2=fx;
+				box.y1=box.y2=fy;
+			}
+			else {
+				if(fx < box.x1) box.x1=fx;
+				else if(fx > box.x2) box.x2=fx;
+				if(fy < box.y1) box.y1=fy;
+				else if(fy > box.y2) box.y2=fy;
+			}
+		}
+
                 /* write back to FB */
                 //printf("EGI FILO pop out: pos=%ld, color=%d\n",fpix.position,fpix.color);
 
@@ -619,6 +965,10 @@ inline void fb_filo_flush(FBDEV *dev)
 		   #endif
 		#endif
         }
+
+	/* mark dirty area */
+	if( box.x2>=box.x1 )
+		fb_dirty_add(dev, box.x1, box.y1, box.x2, box.y2);
 }
 
 /*----------------------------------------------
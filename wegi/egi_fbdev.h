@@ -20,6 +20,7 @@ Modified and appended by: Midas Zhou
 #include <linux/fb.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <pthread.h>
 //#include "egi.h"  /* definition conflict */
 #include "egi_filo.h"
 #include "egi_imgbuf.h"
@@ -32,6 +33,15 @@ Modified and appended by: Midas Zhou
 #endif
 
 #define FBDEV_BUFFER_PAGES 3	/* Max FB buffer pages */
+#define FBDEV_MAX_DIRTY_RECTS 16	/* Max. dirty rectangles kept in FBDEV, see fb_dirty_add() */
+
+/* A rectangle in raw FB coordinates, pos_rotate NOT applied. */
+typedef struct fb_rect {
+	int x1;		/* left top point */
+	int y1;
+	int x2;		/* right bottom point, inclusive */
+	int y2;
+}FB_RECT;
 
 typedef struct fbdev{
         int 		fbfd; 		/* FB device file descriptor, open "dev/fbx" */
@@ -101,6 +111,19 @@ typedef struct fbdev{
 	EGI_FILO 	*fb_filo;
 	int 		filo_on;	/* >0, activate FILO push */
 
+	/*  Dirty region tracking: Not applicable for virtual FBDEV!
+	 *  Call fb_dirty_on() to activate, then fb_dirty_flush() copies only dirty
+	 *  areas of the back buffer to the FB.
+	 */
+	bool		dirty_on;	/* default/init as off */
+	pthread_mutex_t	dirty_lock;	/* for ndirty, dirty[] and dotbox, drawing threads may share an FBDEV */
+	int		ndirty;		/* number of rects in dirty[] */
+	FB_RECT		dirty[FBDEV_MAX_DIRTY_RECTS];	/* merged dirty rects, no overlapping */
+	bool		dotbox_set;	/* dotbox is effective */
+	FB_RECT		dotbox;		/* bounding box of pixels by draw_dot(), merged into dirty[]
+					 * only when flushing, so draw_dot() pays only 4 compares.
+					 */
+
 //	uint16_t 	*buffer[FBDEV_BUFFER_PAGES];  /* FB image data buffer */
 
 }FBDEV;
@@ -129,6 +152,14 @@ void 	fb_init_FBbuffers(FBDEV *fb_dev);
 void 	fb_clear_backBuff(FBDEV *dev, uint32_t color);
 void 	fb_page_refresh(FBDEV *dev, unsigned int numpg);
 void 	fb_lines_refresh(FBDEV *dev, unsigned int numpg, unsigned int sind, unsigned int n);
+void 	fb_rect_refresh(FBDEV *dev, unsigned int numpg, int x1, int y1, int x2, int y2);
+void 	fb_dirty_on(FBDEV *dev);
+void 	fb_dirty_off(FBDEV *dev);
+void 	fb_dirty_clear(FBDEV *dev);
+void 	fb_dirty_add(FBDEV *dev, int x1, int y1, int x2, int y2);
+void 	fb_dirty_add_pos(FBDEV *dev, int x1, int y1, int x2, int y2);
+int 	fb_dirty_flush(FBDEV *dev, unsigned int numpg);
+void 	fb_restore_bkBuff(FBDEV *dev, unsigned int buffNum);
 //void	fb_render()
 int 	fb_page_saveToBuff(FBDEV *dev, unsigned int buffNum);
 int 	fb_page_restoreFromBuff(FBDEV *dev, unsigned int buffNum);
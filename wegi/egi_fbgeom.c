@@ -262,6 +262,9 @@ void fbclear_bkBuff(FBDEV *fb_dev, uint16_t color)
 
 	for(location=0; location < (fb_dev->screensize/bytes_per_pixel); location++)
 	        *((uint16_t*)(fb_dev->map_bk+location*bytes_per_pixel))=color;
+
+	/* mark dirty area */
+	fb_dirty_add(fb_dev, 0, 0, fb_dev->vinfo.xres-1, fb_dev->vinfo.yres-1);
 }
 
 
@@ -432,6 +435,26 @@ int draw_dot(FBDEV *fb_dev,int x,int y)
    /* ------------------------ ( for real FB ) ---------------------- */
    else {
 
+	/* expand bounding box of dirty pixels, lock only when it grows */
+	if( fb_dev->dirty_on && ( !fb_dev->dotbox_set
+				  || fx < fb_dev->dotbox.x1 || fx > fb_dev->dotbox.x2
+				  || fy < fb_dev->dotbox.y1 || fy > fb_dev->dotbox.y2 ) )
+	{
+		pthread_mutex_lock(&fb_dev->dirty_lock);
+		if(!fb_dev->dotbox_set) {
+			fb_dev->dotbox.x1=fb_dev->dotbox.x2=fx;
+			fb_dev->dotbox.y1=fb_dev->dotbox.y2=fy;
+			fb_dev->dotbox_set=true;
+		}
+		else {
+			if(fx < fb_dev->dotbox.x1) fb_dev->dotbox.x1=fx;
+			else if(fx > fb_dev->dotbox.x2) fb_dev->dotbox.x2=fx;
+			if(fy < fb_dev->dotbox.y1) fb_dev->dotbox.y1=fy;
+			else if(fy > fb_dev->dotbox.y2) fb_dev->dotbox.y2=fy;
+		}
+		pthread_mutex_unlock(&fb_dev->dirty_lock);
+	}
+
     #ifdef LETS_NOTE /* --------- FOR 32BITS COLOR (ARGB) FBDEV ------------ */
 
 	/*(in bytes:) data location of the point pixel */
@@ -547,6 +570,323 @@ int draw_dot(FBDEV *fb_dev,int x,int y)
 }
 
 
+/*------------------------------------------------------------------------
+Clip a displaying window for the span blitter, so that per-pixel boundary
+checks can be dropped in the inner loops.
+The window is clipped to the screen(as per @pos_rotate) and, when @clip_img
+is true, also to the image area.
+
+@fb_dev:	FB under consideration
+@pos_rotate:	FB position rotation to apply, normally fb_dev->pos_rotate.
+		0 for raw FB coordinates.
+@imgw,imgh:	Size of the image.
+@xp,yp:		Image block origin, relative to the image.
+@xw,yw:		Displaying window origin, relative to the screen.
+@winw,winh:	Size of the displaying window.
+@clip_img:	True: Also clip to the image area.
+@win:		Pointer to pass out clipped window.
+
+Return:
+	0	OK, win is NOT empty.
+	<0	Fails, or nothing to display.
+-------------------------------------------------------------------------*/
+int fb_blit_clip( FBDEV *fb_dev, int pos_rotate, int imgw, int imgh, int xp, int yp,
+			int xw, int yw, int winw, int winh, bool clip_img, FB_BLITWIN *win )
+{
+	int xres,yres;
+	int dx,dy;
+
+	if( fb_dev==NULL || win==NULL )
+		return -1;
+
+	/* Screen size as seen in pos_rotate coordinates, virtual FB rotates as draw_dot() does */
+	if(fb_dev->virt_fb) {
+		xres=fb_dev->virt_fb->width;
+		yres=fb_dev->virt_fb->height;
+	}
+	else {
+		xres=fb_dev->vinfo.xres;
+		yres=fb_dev->vinfo.yres;
+	}
+	if( pos_rotate & 0x1 ) {	/* Landscape mode */
+		dx=xres; xres=yres; yres=dx;
+	}
+
+	/* Clip to screen */
+	dx= xw<0 ? -xw : 0;
+	dy= yw<0 ? -yw : 0;
+	xp += dx;  xw += dx;  winw -= dx;
+	yp += dy;  yw += dy;  winh -= dy;
+	if( xw+winw > xres )
+		winw=xres-xw;
+	if( yw+winh > yres )
+		winh=yres-yw;
+
+	/* Clip to image */
+	if(clip_img) {
+		dx= xp<0 ? -xp : 0;
+		dy= yp<0 ? -yp : 0;
+		xp += dx;  xw += dx;  winw -= dx;
+		yp += dy;  yw += dy;  winh -= dy;
+		if( xp+winw > imgw )
+			winw=imgw-xp;
+		if( yp+winh > imgh )
+			winh=imgh-yp;
+	}
+
+	if( winw<=0 || winh<=0 )
+		return -2;
+
+	win->xp=xp;	win->yp=yp;
+	win->xw=xw;	win->yw=yw;
+	win->w=winw;	win->h=winh;
+	win->pos_rotate=pos_rotate & 0x3;
+
+	return 0;
+}
+
+
+/*------------------------------------------------------------------------
+Write a horizontal span of pixels to FB, as a fast replacement of calling
+draw_dot() for each pixel.
+
+The span starts at (x,y) and goes n pixels in X direction of the pos_rotate
+coordinate system. The whole span MUST be within the screen, call
+fb_blit_clip() first to get a safe window.
+
+Mode is decided by input params:
+1. subcolor>=0:		Use subcolor as front color, alphas applied if not NULL.
+			( colors ignored, so it also fills a span with subcolor )
+2. alphas!=NULL:	Blend colors with alphas, alpha==0 pixels are skipped.
+3. Otherwise:		Opaque copy of colors.
+
+Note:
+1. FB FILO is effective if fb_dev->filo_on, unless FB_BLIT_NOFILO is set
+   in @pos_rotate. Likewise the dirty area is marked unless FB_BLIT_NODIRTY.
+2. For virtual FB, alpha values are summed up to virt_fb->alpha, same as
+   draw_dot() does.
+3. fb_dev->pixcolor and fb_dev->pixalpha are NOT used and NOT changed.
+
+@fb_dev:	FB under consideration
+@pos_rotate:	FB position rotation, as in FB_BLITWIN, optionally OR'ed
+		with FB_BLIT_NOFILO and FB_BLIT_NODIRTY.
+@x,y:		Start point of the span.
+@n:		Number of pixels.
+@colors:	Source 16bit colors.
+@alphas:	Source alpha values, or NULL.
+@subcolor:	Substituting color, only applicable when >=0.
+-------------------------------------------------------------------------*/
+void fb_blit_span( FBDEV *fb_dev, int pos_rotate, int x, int y, int n,
+		   const EGI_16BIT_COLOR *colors, const unsigned char *alphas, int subcolor )
+{
+	EGI_IMGBUF *virt_fb;
+	unsigned char *map;
+	long int location;	/* in bytes */
+	int step;		/* in bytes, signed */
+	int xres, yres;
+	int fx=0, fy=0;
+	int Bpp;
+	FBPIX fpix;
+	int i;
+	int sumalpha;
+	bool filo, dirty;
+
+	if( fb_dev==NULL || n<=0 || (colors==NULL && subcolor<0) )
+		return;
+
+	filo= fb_dev->filo_on && !(pos_rotate & FB_BLIT_NOFILO);
+	dirty= fb_dev->dirty_on && !(pos_rotate & FB_BLIT_NODIRTY);
+	pos_rotate &= 0x3;
+
+   /* ---------------- ( for virtual FB :: for 16bit color only ) ------------------ */
+   virt_fb=fb_dev->virt_fb;
+   if(virt_fb) {
+	EGI_16BIT_COLOR *pix;
+	unsigned char *pa;
+
+	xres=virt_fb->width;
+	yres=virt_fb->height;
+
+	/* Map start point and get step for X++, in pixels, same mapping as in draw_dot() */
+	switch(pos_rotate) {
+		case 0:
+		default:
+			fx=x;		fy=y;		step=1;
+			break;
+		case 1:
+			fx=(xres-1)-y;	fy=x;		step=xres;
+			break;
+		case 2:
+			fx=(xres-1)-x;	fy=(yres-1)-y;	step=-1;
+			break;
+		case 3:
+			fx=y;		fy=(yres-1)-x;	step=-xres;
+			break;
+	}
+	pix=virt_fb->imgbuf+fy*xres+fx;
+	pa= virt_fb->alpha ? virt_fb->alpha+fy*xres+fx : NULL;
+
+	if( alphas==NULL ) {
+		if(subcolor>=0) {
+			for(i=0; i<n; i++)
+				pix[i*step]=subcolor;
+		}
+		else if(step==1)
+			memcpy(pix, colors, n*sizeof(EGI_16BIT_COLOR));
+		else {
+			for(i=0; i<n; i++)
+				pix[i*step]=colors[i];
+		}
+		if(pa) {
+			for(i=0; i<n; i++)
+				pa[i*step]=255;
+		}
+	}
+	else {
+		for(i=0; i<n; i++) {
+			if( alphas[i]==0 )
+				continue;
+			if( alphas[i]==255 )
+				pix[i*step]= subcolor>=0 ? subcolor : colors[i];
+			else
+				pix[i*step]=COLOR_16BITS_BLEND( subcolor>=0 ? subcolor : colors[i], pix[i*step], alphas[i] );
+			if(pa) {
+				sumalpha=pa[i*step]+alphas[i];
+				pa[i*step]= sumalpha>255 ? 255 : sumalpha;
+			}
+		}
+	}
+	return;
+   }
+
+   /* ------------------------ ( for real FB ) ---------------------- */
+
+	/* <<<<<<  FB BUFFER SELECT  >>>>>> */
+	#if defined(ENABLE_BACK_BUFFER) || defined(LETS_NOTE)
+	map=fb_dev->map_bk; /* write to back buffer */
+	#else
+	map=fb_dev->map_fb; /* write directly to FB map */;
+	#endif
+
+	xres=fb_dev->vinfo.xres;
+	yres=fb_dev->vinfo.yres;
+	Bpp=fb_dev->vinfo.bits_per_pixel>>3;
+
+	/* Map start point and get step for X++, same mapping as in draw_dot() */
+	switch(pos_rotate) {
+		case 0:
+		default:
+			fx=x;		fy=y;
+			step=Bpp;
+			break;
+		case 1:			/* Clockwise 90 deg */
+			fx=(xres-1)-y;	fy=x;
+			step=fb_dev->finfo.line_length;
+			break;
+		case 2:			/* Clockwise 180 deg */
+			fx=(xres-1)-x;	fy=(yres-1)-y;
+			step=-Bpp;
+			break;
+		case 3:			/* Clockwise 270 deg */
+			fx=y;		fy=(yres-1)-x;
+			step=-fb_dev->finfo.line_length;
+			break;
+	}
+        location=(fx+fb_dev->vinfo.xoffset)*Bpp+(fy+fb_dev->vinfo.yoffset)*fb_dev->finfo.line_length;
+
+	/* mark dirty area, start point and end point of the span */
+	if(dirty) {
+		switch(pos_rotate) {
+			case 1:	 fb_dirty_add(fb_dev, fx, fy, fx, fy+n-1); break;
+			case 2:	 fb_dirty_add(fb_dev, fx-(n-1), fy, fx, fy); break;
+			case 3:	 fb_dirty_add(fb_dev, fx, fy-(n-1), fx, fy); break;
+			default: fb_dirty_add(fb_dev, fx, fy, fx+n-1, fy); break;
+		}
+	}
+
+	/* push old data to FB FILO */
+	if(filo) {
+		for(i=0; i<n; i++) {
+			if( alphas && alphas[i]==0 )
+				continue;
+	                fpix.position=location+i*step;
+			#ifdef LETS_NOTE
+			fpix.argb=*(uint32_t *)(map+fpix.position);
+			#else
+			fpix.color=*(uint16_t *)(map+fpix.position);
+			#endif
+	                egi_filo_push(fb_dev->fb_filo, &fpix);
+		}
+	}
+
+    #ifdef LETS_NOTE /* --------- FOR 32BITS COLOR (ARGB) FBDEV ------------ */
+	{
+	uint32_t *pix=(uint32_t *)(map+location);
+	int pstep=step>>2;
+	uint32_t argb;
+
+	if( alphas==NULL ) {
+		if(subcolor>=0) {
+			argb=COLOR_16TO24BITS(subcolor)+(255<<24);
+			for(i=0; i<n; i++, pix+=pstep)
+				*pix=argb;
+		}
+		else {
+			for(i=0; i<n; i++, pix+=pstep)
+				*pix=COLOR_16TO24BITS(colors[i])+(255<<24);
+		}
+	}
+	else {
+		for(i=0; i<n; i++, pix+=pstep) {
+			if( alphas[i]==0 )
+				continue;
+			argb=COLOR_16TO24BITS( subcolor>=0 ? subcolor : colors[i] );
+			if( alphas[i]!=255 )
+				argb=COLOR_24BITS_BLEND( argb, (*pix)&0xFFFFFF, alphas[i] );
+			*pix=argb+(255<<24);
+		}
+	}
+	}
+
+    #else /* --------- FOR 16BITS COLOR FBDEV ------------ */
+	{
+	uint16_t *pix=(uint16_t *)(map+location);
+	int pstep=step>>1;
+
+	if( alphas==NULL ) {
+		if(subcolor>=0) {
+			for(i=0; i<n; i++, pix+=pstep)
+				*pix=subcolor;
+		}
+		else if(pstep==1) {	/* pos_rotate 0: a whole row at once */
+			memcpy(pix, colors, n*sizeof(uint16_t));
+		}
+		else {
+			for(i=0; i<n; i++, pix+=pstep)
+				*pix=colors[i];
+		}
+	}
+	else if(subcolor>=0) {
+		for(i=0; i<n; i++, pix+=pstep) {
+			if( alphas[i]==255 )
+				*pix=subcolor;
+			else if( alphas[i]!=0 )
+				*pix=COLOR_16BITS_BLEND( subcolor, *pix, alphas[i] );
+		}
+	}
+	else {
+		for(i=0; i<n; i++, pix+=pstep) {
+			if( alphas[i]==255 )
+				*pix=colors[i];
+			else if( alphas[i]!=0 )
+				*pix=COLOR_16BITS_BLEND( colors[i], *pix, alphas[i] );
+		}
+	}
+	}
+    #endif /* --------- END 16/32BITS BPP FBDEV SELECT ------------ */
+}
+
+
 
 /*---------------------------------------------------
 	Draw a simple line
@@ -1646,6 +1986,9 @@ void draw_blend_filled_circle( FBDEV *dev, int x, int y, int r,
 		yd=y1;
 	}
 
+	/* mark dirty area */
+	fb_dirty_add(fb_dev, xl, yd, xr, yu);
+
 
 #ifdef FB_DOTOUT_ROLLBACK /* -------------   ROLLBACK  ------------------*/
 
@@ -31,6 +31,21 @@ midaszhou@yahoo.com
 
 extern EGI_BOX gv_fb_box;
 
+/* Clipped window for span blitter, see fb_blit_clip() */
+typedef struct fb_blitwin {
+	int xp;		/* Image block origin, relative to the image */
+	int yp;
+	int xw;		/* Window origin, relative to the screen */
+	int yw;
+	int w;		/* Window size */
+	int h;
+	int pos_rotate;	/* FB position rotation applied */
+} FB_BLITWIN;
+
+/* OR'ed to pos_rotate of fb_blit_span() */
+#define FB_BLIT_NOFILO	0x10	/* do not push to FB FILO */
+#define FB_BLIT_NODIRTY	0x20	/* do not mark dirty area, the caller marks it */
+
 /* functions */
 #if 0
 int 	init_fbdev(FBDEV *dev);
@@ -77,6 +92,12 @@ void 	draw_filled_triangle(FBDEV *dev, EGI_POINT *points);
 void 	draw_filled_annulus(FBDEV *dev, int x0, int y0, int r, unsigned int w);
 void 	draw_filled_circle(FBDEV *dev, int x, int y, int r);
 
+//////////////// span blitter, for 16bit color image data /////////////
+int 	fb_blit_clip( FBDEV *fb_dev, int pos_rotate, int imgw, int imgh, int xp, int yp,
+                        int xw, int yw, int winw, int winh, bool clip_img, FB_BLITWIN *win );
+void 	fb_blit_span( FBDEV *fb_dev, int pos_rotate, int x, int y, int n,
+                   const EGI_16BIT_COLOR *colors, const unsigned char *alphas, int subcolor );
+
 //////////////// new draw function, with color /////////////
 void 	draw_circle2(FBDEV *dev, int x, int y, int r, EGI_16BIT_COLOR color);
 void 	draw_filled_annulus2(FBDEV *dev, int x0, int y0, int r, unsigned int w, EGI_16BIT_COLOR color);
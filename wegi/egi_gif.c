@@ -16,6 +16,7 @@ Midas-Zhou
 #include <string.h>
 #include <errno.h>
 #include <signal.h>
+#include <time.h>
 #include "egi_gif.h"
 #include "egi_common.h"
 
@@ -32,6 +33,7 @@ inline static void egi_gif_rasterWriteFB( FBDEV *fbdev, EGI_GIF *egif,
 				   int trans_color, int User_TransColor,
 				   bool ImgTransp_ON );
 
+static void egi_gif_displayCachedCtxt( EGI_GIF_CONTEXT *gif_ctxt );
 static void *egi_gif_threadDisplay(void *argv);
 
 
@@ -389,7 +391,7 @@ if(!Silent_Mode) {
         /* Reset Simgbuf and working FB buffer, for the first block image only */
      	if(  GifFile->ImageCount ==0 && fbdev != NULL ) {
           	egi_imgbuf_resetColorAlpha( Simgbuf, img_bkcolor, ImgTransp_ON ? 0:255 );
-                memcpy(fbdev->map_bk, fbdev->map_buff+fbdev->screensize, fbdev->screensize);
+                fb_restore_bkBuff(fbdev, 1);
         }
 
 	/* get colormap */
@@ -450,7 +452,7 @@ if(!Silent_Mode) {
 
     	/* Refresh FB page if NOT DirectFB_ON */
     	if(!DirectFB_ON && fbdev != NULL )
-    		fb_page_refresh(fbdev,0);
+    		fb_dirty_flush(fbdev,0);
 
     #if 1 //////////////////////////////////////////////////////
     	/* Delay */
@@ -483,7 +485,7 @@ if(!Silent_Mode) {
 	        	}
     	        	/* Transparency set: Set area to FB background color/image */
 			if(fbdev != NULL) {
-	        		memcpy(fbdev->map_bk, fbdev->map_buff+fbdev->screensize, fbdev->screensize);
+	        		fb_restore_bkBuff(fbdev, 1);
 			}
 
 			break;
@@ -1116,6 +1118,9 @@ void egi_gif_free(EGI_GIF **egif)
 	egi_gif_FreeSavedImages(&(*egif)->SavedImages, (*egif)->ImageTotal);
     }
 
+    /* free frame cache */
+    egi_gif_freeFrameCache(*egif);
+
     /* free imgbuf */
     if ((*egif)->Simgbuf != NULL ) {
 	egi_imgbuf_free((*egif)->Simgbuf);
@@ -1372,6 +1377,7 @@ Note: If dev is NOT NULL, it will affect whole FB data with memcpy and page fres
 @winw,winh:     width and height(row/column for fb) of the displaying window.
                 !!! Note: You'd better set winw,winh not exceeds acutual LCD size, or it will
                 waste time calling draw_dot() for pixels outsie FB zone. --- OK
+@Cache_Started:  Init. it as false for a new context, it's set when pre-decoded frames are played.
 
 ----------------------------------------------------------------------------------------------------*/
 //void egi_gif_displayFrame( FBDEV *fbdev, EGI_GIF *egif, int nloop, bool DirectFB_ON,
@@ -1422,6 +1428,13 @@ void egi_gif_displayGifCtxt( EGI_GIF_CONTEXT *gif_ctxt )
     fbdev=gif_ctxt->fbdev;
     DirectFB_ON=gif_ctxt->DirectFB_ON;
 
+    /* Play pre-decoded frames, if no user imposed params */
+    if( egif->FrameCache != NULL && gif_ctxt->User_DisposalMode<0
+			&& gif_ctxt->User_TransColor<0 && gif_ctxt->User_BkgColor<0 ) {
+	egi_gif_displayCachedCtxt(gif_ctxt);
+	return;
+    }
+
     /* check ImageCount */
     if( egif->ImageCount > egif->ImageTotal-1 || egif->ImageCount < 0 ) {
 	        egif->ImageCount=0;
@@ -1469,7 +1482,7 @@ void egi_gif_displayGifCtxt( EGI_GIF_CONTEXT *gif_ctxt )
 	  egi_imgbuf_resetColorAlpha(egif->Simgbuf, bkcolor, egif->ImgTransp_ON ? 0:255 );
 
 	  if( fbdev != NULL )
-     		  memcpy(fbdev->map_bk, fbdev->map_buff+fbdev->screensize, fbdev->screensize);
+     		  fb_restore_bkBuff(fbdev, 1);
      }
 
      /* get Block image offset and size */
@@ -1591,7 +1604,7 @@ void egi_gif_displayGifCtxt( EGI_GIF_CONTEXT *gif_ctxt )
 
     /* Refresh FB page if NOT DirectFB_ON */
     if(!DirectFB_ON && fbdev != NULL )
-    	fb_page_refresh(fbdev,0);
+    	fb_dirty_flush(fbdev,0);
 
     /* Delay */
     tm_delayms(DelayMs); /* Need to hold on here, even fddev==NULL */
@@ -1615,7 +1628,7 @@ void egi_gif_displayGifCtxt( EGI_GIF_CONTEXT *gif_ctxt )
 
     	        /* Set area to FB background color/image */
 		if(fbdev != NULL) {
-	        	memcpy(fbdev->map_bk, fbdev->map_buff+fbdev->screensize, fbdev->screensize);
+	        	fb_restore_bkBuff(fbdev, 1);
 		}
 
 		break;
@@ -1657,7 +1670,7 @@ void egi_gif_displayGifCtxt( EGI_GIF_CONTEXT *gif_ctxt )
 	        }
     	        /* Set area to FB background color/image */
 		if(fbdev != NULL) {
-	        	memcpy(fbdev->map_bk, fbdev->map_buff+fbdev->screensize, fbdev->screensize);
+	        	fb_restore_bkBuff(fbdev, 1);
 		}
 
 		break;
@@ -1705,6 +1718,603 @@ void egi_gif_displayGifCtxt( EGI_GIF_CONTEXT *gif_ctxt )
 }
 
 
+/*------------------------------------------------------------------------
+Get disposal mode, transparent color index and delay time of a GIF frame
+from its graphics control extension block, same as egi_gif_displayGifCtxt().
+-------------------------------------------------------------------------*/
+static void egi_gif_getFrameGCB(const SavedImage *ImageData, int *Disposal_Mode,
+							int *trans_color, int *DelayMs)
+{
+    int j;
+    ExtensionBlock  *ExtBlock;
+    GraphicsControlBlock gcb;
+
+    *Disposal_Mode=0;
+    *trans_color=NO_TRANSPARENT_COLOR;
+    *DelayMs=0;
+
+    for( j=0; j< ImageData->ExtensionBlockCount; j++ ) {
+	ExtBlock=&ImageData->ExtensionBlocks[j];
+	if( ExtBlock->Function != GRAPHICS_EXT_FUNC_CODE )
+		continue;
+	if( DGifExtensionToGCB(ExtBlock->ByteCount, ExtBlock->Bytes, &gcb) == GIF_ERROR ) {
+		printf("%s: DGifExtensionToGCB() Fails!\n",__func__);
+		continue;
+	}
+	*Disposal_Mode=gcb.DisposalMode;
+	*trans_color=gcb.TransparentColor;
+	*DelayMs=gcb.DelayTime*10;
+	if(*DelayMs==0)		/* For some GIF it's 0! */
+		*DelayMs=50;
+    }
+}
+
+/*------------------------------------------------------------------
+Clip a rect to the GIF canvas.
+Return:
+	0	OK
+	<0	Out of canvas, or empty.
+-------------------------------------------------------------------*/
+static int egi_gif_clipRect(FB_RECT *rect, int SWidth, int SHeight)
+{
+    if(rect->x1<0) rect->x1=0;
+    if(rect->y1<0) rect->y1=0;
+    if(rect->x2>SWidth-1) rect->x2=SWidth-1;
+    if(rect->y2>SHeight-1) rect->y2=SHeight-1;
+
+    if( rect->x1 > rect->x2 || rect->y1 > rect->y2 )
+	return -1;
+
+    return 0;
+}
+
+/*-----------------------------------------------------------------------
+Shrink a rect to the bounding box of pixels which differ between canvas
+(color,alpha) and canvas (pcolor,palpha).
+
+Return:
+	0	OK
+	<0	No difference in the rect.
+------------------------------------------------------------------------*/
+static int egi_gif_diffRect(FB_RECT *rect, int SWidth,
+			    const EGI_16BIT_COLOR *color, const unsigned char *alpha,
+			    const EGI_16BIT_COLOR *pcolor, const unsigned char *palpha)
+{
+    int i,j;
+    int pos;
+    int x1=rect->x2+1, y1=-1, x2=rect->x1-1, y2=-1;
+
+    for(i=rect->y1; i<=rect->y2; i++) {
+	pos=i*SWidth;
+	for(j=rect->x1; j<=rect->x2; j++) {
+		if( color[pos+j]==pcolor[pos+j] && alpha[pos+j]==palpha[pos+j] )
+			continue;
+		if(y1<0) y1=i;
+		y2=i;
+		if(j<x1) x1=j;
+		if(j>x2) x2=j;
+	}
+    }
+
+    if(y1<0)
+	return -1;
+
+    rect->x1=x1;  rect->y1=y1;
+    rect->x2=x2;  rect->y2=y2;
+    return 0;
+}
+
+/*-----------------------------------------------------------------------
+Copy the rect of a canvas to a new EGI_GIF_FRAME, the rect may be empty.
+Return:
+	0	OK
+	<0	Fails, or out of memory budget.
+------------------------------------------------------------------------*/
+static int egi_gif_saveFrameRect( EGI_GIF_FRAMECACHE *fcache, EGI_GIF_FRAME *frame,
+				  const FB_RECT *rect, int SWidth, size_t maxbytes,
+				  const EGI_16BIT_COLOR *color, const unsigned char *alpha )
+{
+    int i;
+    size_t size;
+
+    if(rect==NULL) {
+	frame->x0=0;  frame->y0=0;
+	frame->w=0;   frame->h=0;
+	return 0;
+    }
+
+    frame->x0=rect->x1;
+    frame->y0=rect->y1;
+    frame->w=rect->x2-rect->x1+1;
+    frame->h=rect->y2-rect->y1+1;
+
+    size=(size_t)frame->w*frame->h*(sizeof(EGI_16BIT_COLOR)+1);
+    if( fcache->memsize+size > maxbytes ) {
+	printf("%s: Frame cache exceeds memory budget %zu bytes!\n", __func__, maxbytes);
+	return -1;
+    }
+
+    frame->color=malloc(frame->w*frame->h*sizeof(EGI_16BIT_COLOR));
+    frame->alpha=malloc(frame->w*frame->h);
+    if( frame->color==NULL || frame->alpha==NULL ) {
+	printf("%s: Fail to malloc frame data!\n", __func__);
+	return -2;
+    }
+    fcache->memsize += size;
+
+    for(i=0; i<frame->h; i++) {
+	memcpy( frame->color+i*frame->w, color+(frame->y0+i)*SWidth+frame->x0,
+					 frame->w*sizeof(EGI_16BIT_COLOR) );
+	memcpy( frame->alpha+i*frame->w, alpha+(frame->y0+i)*SWidth+frame->x0, frame->w );
+    }
+
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------------------------
+Decode all frames of an EGI_GIF into RGB565+alpha canvas data at once, and record the
+rect changed by each frame, so egi_gif_displayGifCtxt() can play them by blitting only
+the changed rects, instead of colormap lookup and compositing the whole canvas again
+for every frame of every loop.
+
+Note:
+1. Frames are composed same as egi_gif_rasterWriteFB(), with egif->ImgTransp_ON.
+   Disposal_Mode 3 is skipped as well.
+2. frames[0] holds the whole canvas, other frames hold only their changed rects.
+3. For small looping animations only, it fails if total data exceeds @maxbytes.
+4. Call it BEFORE egi_gif_runDisplayThread(), there is no lock for egif->FrameCache.
+5. The frame cache is freed by egi_gif_free(), or egi_gif_freeFrameCache().
+
+@egif:		An EGI_GIF with SavedImages.
+@maxbytes:	Memory budget for the frame cache, in bytes.
+		0 as EGI_GIF_CACHE_MAXBYTES.
+Return:
+	0	OK
+	<0	Fails, egif->FrameCache is NULL then.
+----------------------------------------------------------------------------------------*/
+int egi_gif_buildFrameCache(EGI_GIF *egif, size_t maxbytes)
+{
+    EGI_GIF_FRAMECACHE *fcache=NULL;
+    EGI_16BIT_COLOR *color=NULL;	/* Working canvas */
+    unsigned char *alpha=NULL;
+    EGI_16BIT_COLOR *pcolor=NULL;	/* Canvas of previous frame */
+    unsigned char *palpha=NULL;
+    SavedImage *ImageData;
+    ColorMapObject *ColorMap;
+    GifColorType *ColorMapEntry;
+    GifByteType *buffer;
+    EGI_16BIT_COLOR bkcolor;
+    FB_RECT blk, last_blk={0,0,-1,-1};
+    FB_RECT rect;
+    int last_Disposal_Mode=0;
+    int Disposal_Mode, trans_color, DelayMs;
+    int SWidth, SHeight;
+    int BWidth;
+    int i,j,n;
+    int pos, spos;
+    int ret=0;
+
+    if( egif==NULL || egif->SavedImages==NULL || egif->ImageTotal<1 ) {
+	printf("%s: Input EGI_GIF is NULL or its data invalid!\n", __func__);
+	return -1;
+    }
+    if( maxbytes==0 )
+	maxbytes=EGI_GIF_CACHE_MAXBYTES;
+
+    /* Free old cache */
+    egi_gif_freeFrameCache(egif);
+
+    SWidth=egif->SWidth;
+    SHeight=egif->SHeight;
+    if( SWidth<1 || SHeight<1 )
+	return -1;
+
+    fcache=calloc(1, sizeof(EGI_GIF_FRAMECACHE));
+    if(fcache==NULL) {
+	printf("%s: Fail to calloc fcache!\n", __func__);
+	return -2;
+    }
+    fcache->frames=calloc(egif->ImageTotal, sizeof(EGI_GIF_FRAME));
+    color=malloc(SWidth*SHeight*sizeof(EGI_16BIT_COLOR));
+    alpha=malloc(SWidth*SHeight);
+    pcolor=malloc(SWidth*SHeight*sizeof(EGI_16BIT_COLOR));
+    palpha=malloc(SWidth*SHeight);
+    if( fcache->frames==NULL || color==NULL || alpha==NULL || pcolor==NULL || palpha==NULL ) {
+	printf("%s: Fail to malloc working canvas!\n", __func__);
+	ret=-2;
+	goto END_FUNC;
+    }
+    fcache->FrameTotal=egif->ImageTotal;
+    fcache->memsize=sizeof(EGI_GIF_FRAMECACHE)+egif->ImageTotal*sizeof(EGI_GIF_FRAME);
+
+    for(n=0; n < egif->ImageTotal; n++)
+    {
+	ImageData=&egif->SavedImages[n];
+	ColorMap= ImageData->ImageDesc.ColorMap ? ImageData->ImageDesc.ColorMap : egif->SColorMap;
+	buffer=ImageData->RasterBits;
+	if( ColorMap==NULL || buffer==NULL ) {
+		printf("%s: Image %d has no colormap or raster data!\n", __func__, n);
+		ret=-3;
+		goto END_FUNC;
+	}
+
+	egi_gif_getFrameGCB(ImageData, &Disposal_Mode, &trans_color, &DelayMs);
+	fcache->frames[n].DelayMs=DelayMs;
+	fcache->frames[n].Disposal_Mode=Disposal_Mode;
+
+	/* Reset canvas for the first frame, as in egi_gif_displayGifCtxt() */
+	if( n==0 ) {
+		ColorMapEntry = &ColorMap->Colors[egif->SBackGroundColor];
+		bkcolor=COLOR_RGB_TO16BITS( ColorMapEntry->Red,
+					    ColorMapEntry->Green,
+					    ColorMapEntry->Blue );
+		for(i=0; i<SWidth*SHeight; i++)
+			color[i]=bkcolor;
+		memset(alpha, egif->ImgTransp_ON ? 0:255, SWidth*SHeight);
+	}
+	/* Clear last block for last_Disposal_Mode 2, as in egi_gif_rasterWriteFB() */
+	else if( last_Disposal_Mode==2 ) {
+		for(i=last_blk.y1; i<=last_blk.y2; i++) {
+			for(j=last_blk.x1; j<=last_blk.x2; j++) {
+				spos=i*SWidth+j;
+				if(egif->ImgTransp_ON)
+					alpha[spos]=0;
+				else {
+					color[spos]=egif->bkcolor;
+					alpha[spos]=255;
+				}
+			}
+		}
+	}
+
+	/* Write block image */
+	BWidth=ImageData->ImageDesc.Width;
+	blk.x1=ImageData->ImageDesc.Left;
+	blk.y1=ImageData->ImageDesc.Top;
+	blk.x2=blk.x1+BWidth-1;
+	blk.y2=blk.y1+ImageData->ImageDesc.Height-1;
+	if( egi_gif_clipRect(&blk, SWidth, SHeight)==0 ) {
+		for(i=blk.y1; i<=blk.y2; i++) {
+			pos=(i-ImageData->ImageDesc.Top)*BWidth-ImageData->ImageDesc.Left;
+			for(j=blk.x1; j<=blk.x2; j++) {
+				if( trans_color < 0 || trans_color != buffer[pos+j] ) {
+					ColorMapEntry = &ColorMap->Colors[buffer[pos+j]];
+					spos=i*SWidth+j;
+					color[spos]=COLOR_RGB_TO16BITS( ColorMapEntry->Red,
+									ColorMapEntry->Green,
+									ColorMapEntry->Blue );
+					alpha[spos]=255;
+				}
+			}
+		}
+	}
+	else {
+		blk.x1=0; blk.y1=0; blk.x2=-1; blk.y2=-1;	/* Empty */
+	}
+
+	/* Save the changed rect, frames[0] is always the whole canvas */
+	if( n==0 ) {
+		rect.x1=0;	 rect.y1=0;
+		rect.x2=SWidth-1;  rect.y2=SHeight-1;
+		ret=egi_gif_saveFrameRect(fcache, &fcache->frames[0], &rect, SWidth, maxbytes, color, alpha);
+		memcpy(pcolor, color, SWidth*SHeight*sizeof(EGI_16BIT_COLOR));
+		memcpy(palpha, alpha, SWidth*SHeight);
+	}
+	else {
+		/* Changed area is within the block and the last cleared block */
+		rect=blk;
+		if( last_Disposal_Mode==2 && last_blk.x1<=last_blk.x2 ) {
+			if( rect.x1>rect.x2 )
+				rect=last_blk;
+			else {
+				if(last_blk.x1<rect.x1) rect.x1=last_blk.x1;
+				if(last_blk.y1<rect.y1) rect.y1=last_blk.y1;
+				if(last_blk.x2>rect.x2) rect.x2=last_blk.x2;
+				if(last_blk.y2>rect.y2) rect.y2=last_blk.y2;
+			}
+		}
+
+		if( rect.x1<=rect.x2 && egi_gif_diffRect(&rect, SWidth, color, alpha, pcolor, palpha)==0 ) {
+			ret=egi_gif_saveFrameRect(fcache, &fcache->frames[n], &rect, SWidth, maxbytes, color, alpha);
+			for(i=rect.y1; i<=rect.y2; i++) {
+				memcpy( pcolor+i*SWidth+rect.x1, color+i*SWidth+rect.x1,
+						(rect.x2-rect.x1+1)*sizeof(EGI_16BIT_COLOR) );
+				memcpy( palpha+i*SWidth+rect.x1, alpha+i*SWidth+rect.x1, rect.x2-rect.x1+1 );
+			}
+		}
+		else
+			ret=egi_gif_saveFrameRect(fcache, &fcache->frames[n], NULL, SWidth, maxbytes, color, alpha);
+	}
+	if(ret!=0)
+		goto END_FUNC;
+
+	/* Disposal_Mode 3 is skipped, same as egi_gif_displayGifCtxt() */
+	last_Disposal_Mode=Disposal_Mode;
+	if( Disposal_Mode==2 )
+		last_blk=blk;
+    }
+
+    /* Changed rect from the last frame to frames[0], when looping. pcolor/palpha holds the last frame. */
+    rect.x1=0;	rect.y1=0;
+    rect.x2=SWidth-1;  rect.y2=SHeight-1;
+    memcpy(color, fcache->frames[0].color, SWidth*SHeight*sizeof(EGI_16BIT_COLOR));
+    memcpy(alpha, fcache->frames[0].alpha, SWidth*SHeight);
+    if( egi_gif_diffRect(&rect, SWidth, color, alpha, pcolor, palpha)==0 ) {
+	fcache->lx0=rect.x1;
+	fcache->ly0=rect.y1;
+	fcache->lw=rect.x2-rect.x1+1;
+	fcache->lh=rect.y2-rect.y1+1;
+    }
+
+    egif->FrameCache=fcache;
+
+END_FUNC:
+    free(color);
+    free(alpha);
+    free(pcolor);
+    free(palpha);
+
+    if(ret!=0) {
+	egif->FrameCache=fcache;
+	egi_gif_freeFrameCache(egif);
+    }
+
+    return ret;
+}
+
+
+/*-----------------------------------------
+Free frame cache of an EGI_GIF, if any.
+------------------------------------------*/
+void egi_gif_freeFrameCache(EGI_GIF *egif)
+{
+    int i;
+    EGI_GIF_FRAMECACHE *fcache;
+
+    if( egif==NULL || egif->FrameCache==NULL )
+	return;
+
+    fcache=egif->FrameCache;
+    if(fcache->frames) {
+	for(i=0; i < fcache->FrameTotal; i++) {
+		free(fcache->frames[i].color);
+		free(fcache->frames[i].alpha);
+	}
+	free(fcache->frames);
+    }
+    free(fcache);
+
+    egif->FrameCache=NULL;
+}
+
+
+/*---------------------------------------------------------------------------
+Get a window on screen(in pos_rotate coordinates) as a rect in raw FB
+coordinates, clipped to the screen. Same mapping as fb_dirty_add_pos().
+
+Return:
+	0	OK
+	<0	Out of screen, or not a real FB.
+----------------------------------------------------------------------------*/
+static int egi_gif_rawRect(FBDEV *fbdev, int xw, int yw, int w, int h, FB_RECT *raw)
+{
+    FB_BLITWIN win;
+    int xres=fbdev->vinfo.xres;
+    int yres=fbdev->vinfo.yres;
+    int x1,y1,x2,y2;
+    int tmp;
+
+    if( fbdev->virt || fbdev->virt_fb )
+	return -1;
+    if( fb_blit_clip(fbdev, fbdev->pos_rotate, w, h, 0, 0, xw, yw, w, h, false, &win) !=0 )
+	return -2;
+
+    x1=win.xw;		  y1=win.yw;
+    x2=win.xw+win.w-1;	  y2=win.yw+win.h-1;
+    switch(win.pos_rotate) {
+	case 1:
+		raw->x1=(xres-1)-y1;  raw->y1=x1;
+		raw->x2=(xres-1)-y2;  raw->y2=x2;
+		break;
+	case 2:
+		raw->x1=(xres-1)-x1;  raw->y1=(yres-1)-y1;
+		raw->x2=(xres-1)-x2;  raw->y2=(yres-1)-y2;
+		break;
+	case 3:
+		raw->x1=y1;  raw->y1=(yres-1)-x1;
+		raw->x2=y2;  raw->y2=(yres-1)-x2;
+		break;
+	default:
+		raw->x1=x1;  raw->y1=y1;
+		raw->x2=x2;  raw->y2=y2;
+		break;
+    }
+    if(raw->x1 > raw->x2) {
+	tmp=raw->x1; raw->x1=raw->x2; raw->x2=tmp;
+    }
+    if(raw->y1 > raw->y2) {
+	tmp=raw->y1; raw->y1=raw->y2; raw->y2=tmp;
+    }
+
+    return 0;
+}
+
+
+/*-----------------------------------------------------------------------------------
+Play pre-decoded frames in egif->FrameCache, called by egi_gif_displayGifCtxt().
+
+For each frame, only its changed rect is copied to egif->Simgbuf and blitted to FB,
+and only that rect of FB is refreshed. Frames are paced by GIF delay time on a
+monotonic clock, so time for blitting is NOT added to the delay.
+
+Note:
+1. It starts from egif->ImageCount, Simgbuf is supposed to hold the canvas of frame
+   ImageCount-1, as left by last calling of either playing mode. The whole window
+   is blitted for the initial frame of gif_ctxt only, as gif_ctxt->Cache_Started is
+   false, so nloop==0 calls for frame by frame blit changed rects after it.
+2. If egif->ImgTransp_ON, the rect is restored from FB background buffer page
+   map_buff[1] before blitting, as egi_gif_displayGifCtxt() does for the whole page.
+
+Parameters: Refert to egi_gif_displayGifCtxt( ), User_* params are ignored.
+------------------------------------------------------------------------------------*/
+static void egi_gif_displayCachedCtxt( EGI_GIF_CONTEXT *gif_ctxt )
+{
+    EGI_GIF *egif=gif_ctxt->egif;
+    FBDEV *fbdev=gif_ctxt->fbdev;
+    EGI_GIF_FRAMECACHE *fcache=egif->FrameCache;
+    EGI_GIF_FRAME *frame;
+    EGI_IMGBUF *Simgbuf=egif->Simgbuf;
+    GifImageDesc *ImageDesc;
+    struct timespec tm_next, tm_now;
+    FB_RECT raw;
+    bool first=!gif_ctxt->Cache_Started;
+    int x0,y0,w,h;	/* Rect to update, relative to canvas origin */
+    int fx0,fy0;	/* Rect origin relative to frame data */
+    int sx,sy;		/* Rect origin relative to screen */
+    unsigned int Bpp, Bpl;
+    int i,k;
+
+    if( Simgbuf==NULL || fcache->FrameTotal != egif->ImageTotal ) {
+	printf("%s: Simgbuf is NULL or frame cache invalid!\n", __func__);
+	return;
+    }
+
+    /* check ImageCount */
+    if( egif->ImageCount > egif->ImageTotal-1 || egif->ImageCount < 0 ) {
+	egif->ImageCount=0;
+	egif->last_Disposal_Mode=0;
+	egif->last_BWidth=0; 	egif->last_BHeight=0;
+	egif->last_offx=0;	egif->last_offy=0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &tm_next);
+
+ /* Do nloop times, or just one frame if nloop==0 */
+ k=0;
+ do {
+    frame=&fcache->frames[egif->ImageCount];
+
+    /* Rect to update in Simgbuf */
+    if( egif->ImageCount==0 && !first ) {
+	x0=fcache->lx0;  y0=fcache->ly0;
+	w=fcache->lw;	 h=fcache->lh;
+    }
+    else {
+	x0=frame->x0;	y0=frame->y0;
+	w=frame->w;	h=frame->h;
+    }
+    fx0=x0-frame->x0;
+    fy0=y0-frame->y0;
+
+    /* Update Simgbuf */
+    if( w>0 && h>0 ) {
+	if(pthread_mutex_lock(&Simgbuf->img_mutex) !=0){
+		EGI_PLOG(LOGLV_ERROR,"%s: Fail to lock Simgbuf->img_mutex!",__func__);
+		return;
+	}
+	for(i=0; i<h; i++) {
+		memcpy( Simgbuf->imgbuf+(y0+i)*Simgbuf->width+x0,
+			frame->color+(fy0+i)*frame->w+fx0, w*sizeof(EGI_16BIT_COLOR) );
+		if(Simgbuf->alpha)
+			memcpy( Simgbuf->alpha+(y0+i)*Simgbuf->width+x0,
+				frame->alpha+(fy0+i)*frame->w+fx0, w );
+	}
+	pthread_mutex_unlock(&Simgbuf->img_mutex);
+    }
+
+    /* Blit the rect to FB, the whole canvas for the first frame */
+    if( first ) {
+	x0=0;		y0=0;
+	w=egif->SWidth;	h=egif->SHeight;
+    }
+
+    /* Clip to the displaying window */
+    if( x0 < gif_ctxt->xp ) {
+	w -= gif_ctxt->xp-x0;  x0=gif_ctxt->xp;
+    }
+    if( y0 < gif_ctxt->yp ) {
+	h -= gif_ctxt->yp-y0;  y0=gif_ctxt->yp;
+    }
+    if( x0+w > gif_ctxt->xp+gif_ctxt->winw )
+	w=gif_ctxt->xp+gif_ctxt->winw-x0;
+    if( y0+h > gif_ctxt->yp+gif_ctxt->winh )
+	h=gif_ctxt->yp+gif_ctxt->winh-y0;
+
+    if( fbdev != NULL && w>0 && h>0 ) {
+	sx=gif_ctxt->xw+x0-gif_ctxt->xp;
+	sy=gif_ctxt->yw+y0-gif_ctxt->yp;
+
+	if( egi_gif_rawRect(fbdev, sx, sy, w, h, &raw)==0 ) {
+		/* Restore rect from FB background buffer */
+		if( egif->ImgTransp_ON && fbdev->map_bk != NULL ) {
+			Bpp=fbdev->vinfo.bits_per_pixel>>3;
+			Bpl=Bpp*fbdev->vinfo.xres;
+			for(i=raw.y1; i<=raw.y2; i++)
+				memcpy( fbdev->map_bk+i*Bpl+raw.x1*Bpp,
+					fbdev->map_buff+fbdev->screensize+i*Bpl+raw.x1*Bpp,
+					(raw.x2-raw.x1+1)*Bpp );
+			fb_dirty_add(fbdev, raw.x1, raw.y1, raw.x2, raw.y2);
+		}
+
+		egi_imgbuf_windisplay( Simgbuf, fbdev, -1, x0, y0, sx, sy, w, h );
+
+		/* Refresh the rect only */
+		if( !gif_ctxt->DirectFB_ON )
+			fb_rect_refresh(fbdev, 0, raw.x1, raw.y1, raw.x2, raw.y2);
+	}
+	else	/* Virtual FB */
+		egi_imgbuf_windisplay( Simgbuf, fbdev, -1, x0, y0, sx, sy, w, h );
+    }
+    first=false;
+    gif_ctxt->Cache_Started=true;
+
+    /* Delay to next frame, by an absolute deadline */
+    tm_next.tv_nsec += frame->DelayMs%1000*1000000;
+    tm_next.tv_sec += frame->DelayMs/1000 + tm_next.tv_nsec/1000000000;
+    tm_next.tv_nsec %= 1000000000;
+    clock_gettime(CLOCK_MONOTONIC, &tm_now);
+    if( tm_now.tv_sec > tm_next.tv_sec
+	|| ( tm_now.tv_sec == tm_next.tv_sec && tm_now.tv_nsec > tm_next.tv_nsec ) ) {
+	tm_next=tm_now;	/* Too late, catch up from now on */
+    }
+    else {
+	while( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &tm_next, NULL) == EINTR );
+    }
+
+    /* record last status, as in egi_gif_displayGifCtxt() */
+    egif->last_Disposal_Mode=frame->Disposal_Mode;
+    if( frame->Disposal_Mode==2 ) {
+	ImageDesc=&egif->SavedImages[egif->ImageCount].ImageDesc;
+	egif->last_BWidth=ImageDesc->Width;
+	egif->last_BHeight=ImageDesc->Height;
+	egif->last_offx=ImageDesc->Left;
+	egif->last_offy=ImageDesc->Top;
+    }
+
+    /* ImageCount incremental */
+    egif->ImageCount++;
+    if( egif->ImageCount > egif->ImageTotal-1) {
+	/* End of one round loop */
+	egif->ImageCount=0;
+
+	/* update statu params */
+	egif->last_Disposal_Mode=0;
+	egif->last_BWidth=0; 	egif->last_BHeight=0;
+	egif->last_offx=0;	egif->last_offy=0;
+
+	k++;
+    }
+
+    /* check request for quitting displaying */
+    if(egif->request_quit_display)
+	return;
+
+ }  while( k < gif_ctxt->nloop || gif_ctxt->nloop < 0 );  /* Do nloop times! OR loop forever if nloop<0 */
+
+}
+
+
 /*-------------------------------------------------------------------------
 A thread function to display an EGI_GIF by calling egi_gif_displayFrame().
 
@@ -39,6 +39,33 @@ typedef struct  {
 } EGI_GIF_DATA;
 
 
+/* Default memory budget for egi_gif_buildFrameCache(), in bytes */
+#define EGI_GIF_CACHE_MAXBYTES	(2*1024*1024)
+
+/*** A pre-decoded GIF frame: the composed canvas within the rect changed by this frame */
+typedef struct egi_gif_frame {
+    int		x0;			/* Changed rect relative to canvas origin */
+    int		y0;
+    int		w;			/* Size of the changed rect, w*h==0 if nothing changed */
+    int		h;
+    int		DelayMs;		/* Delay time after displaying, in ms */
+    int		Disposal_Mode;		/* Disposal mode in extension control block */
+    EGI_16BIT_COLOR *color;		/* w*h colors of the rect */
+    unsigned char   *alpha;		/* w*h alpha values of the rect */
+} EGI_GIF_FRAME;
+
+/*** Pre-decoded frames of an EGI_GIF, see egi_gif_buildFrameCache() */
+typedef struct egi_gif_framecache {
+    int			FrameTotal;	/* Same as EGI_GIF.ImageTotal */
+    EGI_GIF_FRAME	*frames;	/* frames[0] always holds the whole canvas */
+    int			lx0;		/* Changed rect from the last frame to frames[0], when looping */
+    int			ly0;
+    int			lw;
+    int			lh;
+    size_t		memsize;	/* Total bytes allocated */
+} EGI_GIF_FRAMECACHE;
+
+
 /*** 				--- NOTE ---
  * 1. For big GIF file, be careful to use EGI_GIF, it needs large mem space!
  * 2. No mutex lock applied for EGI_GIF, however EGI_IMGBUF HAS mutex lock imbedded.
@@ -104,6 +131,10 @@ typedef struct egi_gif {
     /* To be applied when at lease either RWidth or RHeigth to be >0 */
     EGI_IMGBUF		*RSimgbuf;	      /* resized to RWidthxRHeight */
 
+    EGI_GIF_FRAMECACHE	*FrameCache;	      /* Pre-decoded frames, NULL if not built.
+					       * If built, egi_gif_displayGifCtxt() plays it instead.
+					       */
+
     /*  Following for one producer and one consumer scenario only! */
     pthread_t		thread_display;	 	/* displaying thread ID */
     bool		thread_running;	 	/* True if thread is running */
@@ -131,6 +162,8 @@ typedef struct egi_gif_context
         int     xw;
         int     yw;
         int     winw, winh;
+	bool	Cache_Started;		/* Init. as false. Set by playing pre-decoded frames, the whole window
+					 * is blitted for the initial frame only */
 } EGI_GIF_CONTEXT;
 
 
@@ -162,6 +195,8 @@ void	  egi_gif_free(EGI_GIF **egif);
 //                                             int User_DisposalMode, int User_TransColor,int User_BkgColor,
 //                                             int xp, int yp, int xw, int yw, int winw, int winh );
 
+int	  egi_gif_buildFrameCache(EGI_GIF *egif, size_t maxbytes);
+void	  egi_gif_freeFrameCache(EGI_GIF *egif);
 void 	  egi_gif_displayGifCtxt( EGI_GIF_CONTEXT *gif_ctxt );
 
 int 	  egi_gif_runDisplayThread(EGI_GIF_CONTEXT *gif_ctxt);
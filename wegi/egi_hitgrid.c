@@ -0,0 +1,359 @@
+/*------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+Spatial hit-test index for child eboxes of an EGI_PAGE, see egi_hitgrid.h.
+
+Midas Zhou
+------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "egi_hitgrid.h"
+
+
+/*----------------------------------------------
+Create a hit grid covering the screen in all
+pos_rotate positions.
+
+@xres,yres:	Screen size.
+
+Return:
+	Pointer to EGI_HITGRID	OK
+	NULL			Fails
+-----------------------------------------------*/
+EGI_HITGRID* egi_hitgrid_create(int xres, int yres)
+{
+	EGI_HITGRID *grid;
+	int size= xres>yres ? xres : yres;
+
+	grid=calloc(1, sizeof(EGI_HITGRID));
+	if(grid==NULL) {
+		printf("%s: Fail to calloc grid!\n",__func__);
+		return NULL;
+	}
+
+	/* Square grid, so it needs no rebuilding when pos_rotate changes */
+	grid->cols=(size+EGI_HITGRID_CELLSIZE-1)/EGI_HITGRID_CELLSIZE;
+	if(grid->cols<1)
+		grid->cols=1;
+
+	grid->cells=calloc(grid->cols*grid->cols*EGI_HITGRID_WORDS, sizeof(uint32_t));
+	if(grid->cells==NULL) {
+		printf("%s: Fail to calloc cells!\n",__func__);
+		free(grid);
+		return NULL;
+	}
+
+	if(pthread_mutex_init(&grid->wmutex, NULL) !=0 ) {
+		printf("%s: Fail to init wmutex!\n",__func__);
+		free(grid->cells);
+		free(grid);
+		return NULL;
+	}
+
+	return grid;
+}
+
+
+/*---------------------------
+	Free a hit grid
+----------------------------*/
+void egi_hitgrid_free(EGI_HITGRID **grid)
+{
+	if(grid==NULL || *grid==NULL)
+		return;
+
+	pthread_mutex_destroy(&(*grid)->wmutex);
+	free((*grid)->cells);
+	free(*grid);
+	*grid=NULL;
+}
+
+
+/* Cell index in X or Y for a coordinate, clamped to the grid */
+static inline int egi_hitgrid_cellpos(const EGI_HITGRID *grid, int v)
+{
+	v/=EGI_HITGRID_CELLSIZE;
+	if(v<0)
+		return 0;
+	if(v>=grid->cols)
+		return grid->cols-1;
+	return v;
+}
+
+
+/*-----------------------------------------------------------
+Get touch area of an ebox, same as egi_hit_pagebox() does.
+Return:
+	true	Changed, compared with the entry.
+	false	Not changed.
+------------------------------------------------------------*/
+static bool egi_hitgrid_getbox(const EGI_HITGRID_ENTRY *ent, const EGI_EBOX *ebox,
+						int *x1, int *y1, int *x2, int *y2)
+{
+	/* If touch box NOT defined, use prime area */
+	if( ebox->touchbox.startxy.x==0 && ebox->touchbox.endxy.x==0 ) {
+		*x1=ebox->x0;
+		*y1=ebox->y0;
+		*x2=ebox->x0+ebox->width;
+		*y2=ebox->y0+ebox->height;
+	}
+	else {
+		*x1=ebox->touchbox.startxy.x;
+		*y1=ebox->touchbox.startxy.y;
+		*x2=ebox->touchbox.endxy.x;
+		*y2=ebox->touchbox.endxy.y;
+	}
+
+	return *x1!=ent->x1 || *y1!=ent->y1 || *x2!=ent->x2 || *y2!=ent->y2;
+}
+
+
+/*-----------------------------------------------------------
+Set or clear bit of entry k in its cells, with wmutex locked.
+------------------------------------------------------------*/
+static void egi_hitgrid_mark(EGI_HITGRID *grid, int k, bool set)
+{
+	EGI_HITGRID_ENTRY *ent=&grid->entries[k];
+	uint32_t *bits;
+	int i,j;
+
+	for(i=ent->cy1; i<=ent->cy2; i++) {
+		for(j=ent->cx1; j<=ent->cx2; j++) {
+			bits=grid->cells+(i*grid->cols+j)*EGI_HITGRID_WORDS;
+			if(set)
+				bits[k>>5] |= 1U<<(k&31);
+			else
+				bits[k>>5] &= ~(1U<<(k&31));
+		}
+	}
+}
+
+
+/*-----------------------------------------------------------
+Re-bin entry k with its new touch area, with wmutex locked.
+------------------------------------------------------------*/
+static void egi_hitgrid_rebin(EGI_HITGRID *grid, int k, int x1, int y1, int x2, int y2)
+{
+	EGI_HITGRID_ENTRY *ent=&grid->entries[k];
+
+	/* Odd sequence, readers will retry */
+	__atomic_store_n(&grid->seq, grid->seq+1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	egi_hitgrid_mark(grid, k, false);
+
+	ent->x1=x1;  ent->y1=y1;
+	ent->x2=x2;  ent->y2=y2;
+	if( x2-x1>1 && y2-y1>1 ) {	/* Points strictly inside */
+		ent->cx1=egi_hitgrid_cellpos(grid, x1+1);
+		ent->cy1=egi_hitgrid_cellpos(grid, y1+1);
+		ent->cx2=egi_hitgrid_cellpos(grid, x2-1);
+		ent->cy2=egi_hitgrid_cellpos(grid, y2-1);
+	}
+	else {				/* Can NOT be hit */
+		ent->cx1=ent->cy1=0;
+		ent->cx2=ent->cy2=-1;
+	}
+
+	egi_hitgrid_mark(grid, k, true);
+
+	__atomic_store_n(&grid->seq, grid->seq+1, __ATOMIC_RELEASE);
+}
+
+
+/*------------------------------------------------------
+Add an ebox to the grid, called when it's added to the
+page list.
+
+Return:
+	0	OK
+	<0	Fails, or the grid overflows.
+-------------------------------------------------------*/
+int egi_hitgrid_add(EGI_HITGRID *grid, EGI_EBOX *ebox)
+{
+	EGI_HITGRID_ENTRY *ent;
+	int x1,y1,x2,y2;
+
+	if(grid==NULL || ebox==NULL)
+		return -1;
+
+	if(pthread_mutex_lock(&grid->wmutex) !=0 ) {
+		printf("%s: Fail to lock wmutex!\n",__func__);
+		return -2;
+	}
+
+	if(grid->nents==EGI_HITGRID_MAXBOXES) {
+		if(!grid->overflow)
+			printf("%s: Too many eboxes, hit grid is turned off!\n",__func__);
+		grid->overflow=true;
+		pthread_mutex_unlock(&grid->wmutex);
+		return -3;
+	}
+
+	ent=&grid->entries[grid->nents];
+	ent->ebox=ebox;
+	ent->type=ebox->type;
+	ent->cx1=ent->cy1=0;
+	ent->cx2=ent->cy2=-1;
+	egi_hitgrid_getbox(ent, ebox, &x1, &y1, &x2, &y2);
+	egi_hitgrid_rebin(grid, grid->nents, x1, y1, x2, y2);
+
+	grid->nents++;
+
+	pthread_mutex_unlock(&grid->wmutex);
+	return 0;
+}
+
+
+/*------------------------------------------------------
+Re-bin an ebox if its touch area changes, called after
+an ebox is refreshed, put to sleep, or its touchbox is
+reset. Nothing is written if it doesn't change, so
+readers are not disturbed.
+
+Return:
+	0	OK
+	<0	Fails, or the ebox is not in the grid.
+-------------------------------------------------------*/
+int egi_hitgrid_update(EGI_HITGRID *grid, EGI_EBOX *ebox)
+{
+	int k;
+	int x1,y1,x2,y2;
+
+	if(grid==NULL || ebox==NULL)
+		return -1;
+
+	if(pthread_mutex_lock(&grid->wmutex) !=0 ) {
+		printf("%s: Fail to lock wmutex!\n",__func__);
+		return -2;
+	}
+
+	for(k=0; k<grid->nents; k++) {
+		if(grid->entries[k].ebox==ebox)
+			break;
+	}
+	if(k==grid->nents) {
+		pthread_mutex_unlock(&grid->wmutex);
+		return -3;
+	}
+
+	if( egi_hitgrid_getbox(&grid->entries[k], ebox, &x1, &y1, &x2, &y2) )
+		egi_hitgrid_rebin(grid, k, x1, y1, x2, y2);
+
+	pthread_mutex_unlock(&grid->wmutex);
+	return 0;
+}
+
+
+/*------------------------------------------------------
+Remove an ebox from the grid, called before it's freed.
+Entries after it are moved forward, so the order of
+adding is kept.
+
+Return:
+	0	OK
+	<0	Fails, or the ebox is not in the grid.
+-------------------------------------------------------*/
+int egi_hitgrid_remove(EGI_HITGRID *grid, EGI_EBOX *ebox)
+{
+	int i,k;
+
+	if(grid==NULL || ebox==NULL)
+		return -1;
+
+	if(pthread_mutex_lock(&grid->wmutex) !=0 ) {
+		printf("%s: Fail to lock wmutex!\n",__func__);
+		return -2;
+	}
+
+	for(k=0; k<grid->nents; k++) {
+		if(grid->entries[k].ebox==ebox)
+			break;
+	}
+	if(k==grid->nents) {
+		pthread_mutex_unlock(&grid->wmutex);
+		return -3;
+	}
+
+	/* Odd sequence, readers will retry */
+	__atomic_store_n(&grid->seq, grid->seq+1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	/* Entries from k are re-indexed, clear their bits and set them again */
+	for(i=k; i<grid->nents; i++)
+		egi_hitgrid_mark(grid, i, false);
+	grid->nents--;
+	memmove(grid->entries+k, grid->entries+k+1, (grid->nents-k)*sizeof(EGI_HITGRID_ENTRY));
+	for(i=k; i<grid->nents; i++)
+		egi_hitgrid_mark(grid, i, true);
+
+	__atomic_store_n(&grid->seq, grid->seq+1, __ATOMIC_RELEASE);
+
+	pthread_mutex_unlock(&grid->wmutex);
+	return 0;
+}
+
+
+/*----------------------------------------------------------------
+Find the first ebox hit by (x,y), in order of adding. Sleeping and
+hidden eboxes are ignored.
+It never blocks, and it retries if the grid is updated meanwhile.
+Only grid memory is read under the sequence, as an ebox may be removed
+and freed meanwhile, so status of the candidates is checked after it's
+validated.
+
+@x,y:	Point under current FB pos_rotate coordinates.
+@type:	Ebox types, may be multiple as type_btn|type_slider.
+
+Return:
+	Pointer to the ebox	OK
+	NULL			No ebox is hit.
+-----------------------------------------------------------------*/
+EGI_EBOX* egi_hitgrid_lookup(EGI_HITGRID *grid, int x, int y, int type)
+{
+	const EGI_HITGRID_ENTRY *ent;
+	const uint32_t *bits;
+	EGI_EBOX *cands[EGI_HITGRID_MAXBOXES];	/* Eboxes hit, in order of adding */
+	unsigned int seq;
+	uint32_t w;
+	int i,k,n;
+
+	if(grid==NULL)
+		return NULL;
+
+	bits=grid->cells+(egi_hitgrid_cellpos(grid, y)*grid->cols+egi_hitgrid_cellpos(grid, x))
+								*EGI_HITGRID_WORDS;
+	for(;;) {
+		seq=__atomic_load_n(&grid->seq, __ATOMIC_ACQUIRE);
+		if(seq&1) {		/* A writer is updating */
+			sched_yield();
+			continue;
+		}
+
+		n=0;
+		for(k=0; k<EGI_HITGRID_WORDS; k++) {
+			for( w=bits[k]; w!=0; w&=w-1 ) {
+				i=(k<<5)+__builtin_ctz(w);
+				ent=&grid->entries[i];
+				if( (ent->type & type) && x > ent->x1 && x < ent->x2 && y > ent->y1 && y < ent->y2 )
+					cands[n++]=ent->ebox;
+			}
+		}
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if( __atomic_load_n(&grid->seq, __ATOMIC_RELAXED)==seq )
+			break;
+	}
+
+	/* Candidates are still in the page, check their status now */
+	for(i=0; i<n; i++) {
+		if( cands[i]->status!=status_sleep && cands[i]->status!=status_hidden )
+			return cands[i];
+	}
+
+	return NULL;
+}
@@ -0,0 +1,61 @@
+/*------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+Spatial hit-test index for child eboxes of an EGI_PAGE.
+
+1. Screen is divided into a uniform grid of EGI_HITGRID_CELLSIZE cells,
+   each cell holds a bitmap of eboxes whose touch areas cover it, so
+   egi_hit_pagebox() only checks a few eboxes in one cell.
+2. Entry index is the order in which eboxes are added to the page, so
+   overlapped eboxes are resolved in the same order as the page list.
+3. Touch areas are cached and re-binned only when an ebox is added,
+   refreshed(moved), put to sleep or its touchbox is reset. Sleeping
+   and hidden status is checked live in each lookup. An ebox is
+   removed from the grid when it's freed.
+4. Writers are serialized by a mutex and bump a sequence counter,
+   readers(the touch path) never take a lock, they just retry if the
+   sequence changes during a lookup.
+
+Midas Zhou
+------------------------------------------------------------------*/
+#ifndef __EGI_HITGRID_H__
+#define __EGI_HITGRID_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "egi.h"
+
+#define EGI_HITGRID_CELLSIZE	32	/* in pixels */
+#define EGI_HITGRID_MAXBOXES	64	/* Max. eboxes to index, more eboxes in a page turn off the grid */
+#define EGI_HITGRID_WORDS	(EGI_HITGRID_MAXBOXES/32)
+
+typedef struct egi_hitgrid_entry {
+	EGI_EBOX	*ebox;
+	int		type;		/* ebox->type */
+	int		x1, y1;		/* Cached touch area, hit if x1<x<x2 && y1<y<y2 */
+	int		x2, y2;
+	int		cx1, cy1;	/* Cells covered, cx1>cx2 if none */
+	int		cx2, cy2;
+} EGI_HITGRID_ENTRY;
+
+struct egi_hitgrid {
+	pthread_mutex_t		wmutex;		/* For writers only */
+	unsigned int		seq;		/* Sequence counter, odd while updating */
+	int			cols;		/* Cells in X and Y, as the grid is square */
+	int			nents;
+	bool			overflow;	/* Too many eboxes, the grid is NOT usable */
+	EGI_HITGRID_ENTRY	entries[EGI_HITGRID_MAXBOXES];
+	uint32_t		*cells;		/* cols*cols*EGI_HITGRID_WORDS, bitmap of entries for each cell */
+};
+
+EGI_HITGRID*	egi_hitgrid_create(int xres, int yres);
+void		egi_hitgrid_free(EGI_HITGRID **grid);
+int		egi_hitgrid_add(EGI_HITGRID *grid, EGI_EBOX *ebox);
+int		egi_hitgrid_update(EGI_HITGRID *grid, EGI_EBOX *ebox);
+int		egi_hitgrid_remove(EGI_HITGRID *grid, EGI_EBOX *ebox);
+EGI_EBOX*	egi_hitgrid_lookup(EGI_HITGRID *grid, int x, int y, int type);
+
+#endif
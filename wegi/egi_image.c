@@ -13,6 +13,7 @@ Midas Zhou
 #include <math.h>
 #include "egi_image.h"
 #include "egi_bjp.h"
+#include "egi_fbgeom.h"
 #include "egi_utils.h"
 #include "egi_log.h"
 #include "egi_math.h"
@@ -545,22 +546,196 @@ EGI_IMGBUF *egi_imgbuf_newFrameImg( int height, int width,
 }
 
 
+/*------------------------------------------------------------------------
+Box filter a line of n pixels with a sliding window of 2*r+1 pixels.
+Running sums of R,G,B(in RGB565 bits) and alpha are updated by adding the
+pixel entering the window and subtracting the one leaving it, so cost is
+O(1) for each pixel, whatever the radius is.
+Pixels out of the line are taken as the edge pixel.
+
+@dcolors,dalphas:  Output, with dstride between two pixels.
+@scolors,salphas:  Input, with sstride between two pixels.
+		   NOT the same memory as output!
+		   If salphas is NULL, alpha is ignored.
+@n:	Number of pixels in the line.
+@r:	Radius of the window.
+@inv:	(1<<24)/(2*r+1), to replace division.
+-------------------------------------------------------------------------*/
+static void boxblur_line( EGI_16BIT_COLOR *dcolors, unsigned char *dalphas, int dstride,
+			  const EGI_16BIT_COLOR *scolors, const unsigned char *salphas, int sstride,
+			  int n, int r, unsigned int inv )
+{
+	int i, k;
+	int add, sub;
+	unsigned int sR, sG, sB, sA=0;
+	EGI_16BIT_COLOR c;
+
+	/* init window [-r, r] for pixel 0 */
+	c=scolors[0];
+	sR=(r+1)*(c>>11);
+	sG=(r+1)*((c>>5)&0x3F);
+	sB=(r+1)*(c&0x1F);
+	if(salphas)
+		sA=(r+1)*salphas[0];
+	for(k=1; k<=r; k++) {
+		i= k<n ? k : n-1;
+		c=scolors[i*sstride];
+		sR += c>>11;
+		sG += (c>>5)&0x3F;
+		sB += c&0x1F;
+		if(salphas)
+			sA += salphas[i*sstride];
+	}
+
+	for(i=0; i<n; i++) {
+		/* fix point average, rounded */
+		dcolors[i*dstride]= ((sR*inv+(1U<<23))>>24)<<11
+				  | ((sG*inv+(1U<<23))>>24)<<5
+				  | ((sB*inv+(1U<<23))>>24);
+		if(salphas)
+			dalphas[i*dstride]=(sA*inv+(1U<<23))>>24;
+
+		/* slide the window: pixel i+r+1 in, pixel i-r out */
+		add= i+r+1<n ? (i+r+1)*sstride : (n-1)*sstride;
+		sub= i-r>0 ? (i-r)*sstride : 0;
+		sR += (scolors[add]>>11) - (scolors[sub]>>11);
+		sG += ((scolors[add]>>5)&0x3F) - ((scolors[sub]>>5)&0x3F);
+		sB += (scolors[add]&0x1F) - (scolors[sub]&0x1F);
+		if(salphas)
+			sA += salphas[add] - salphas[sub];
+	}
+}
+
+
+/*------------------------------------------------------------------------------
+Blur an image with separable box filters, the window size is 2*radius+1 pixels,
+centered at each pixel. Rows are filtered first, then columns.
+Running sums are applied, so cost for each pixel is independent of the radius.
+Repeating box filters approaches Gaussian blur, 3 passes is a good approximation.
+
+Note:
+1. If srcimg is NULL or same as eimg, eimg will be blurred in place.
+   Otherwise eimg MUST have the same size as srcimg, and srcimg keeps intact.
+2. Only a line buffer and a column strip buffer are allocated, no 2D arrays.
+3. Pixels out of the image are taken as edge pixels.
+4. Alpha values of srcimg are copied to eimg if alpha_on is false, only if both
+   of them have alpha.
+
+@eimg:		Output EGI_IMGBUF.
+@srcimg:	Input EGI_IMGBUF, or NULL.
+@radius:	Radius of filter window, adjusted to [0 EGI_BOXBLUR_MAXRADIUS].
+		If radius==0, just copy srcimg to eimg.
+@passes:	Times of box filtering, Min. 1.
+@alpha_on:	True:  Also blur alpha values, only if the image has alpha values.
+		False: Do not blur alpha values.
+
+Return:
+	0	OK
+	<0	Fail
+------------------------------------------------------------------------------*/
+int egi_imgbuf_blur_box(EGI_IMGBUF *eimg, const EGI_IMGBUF *srcimg, int radius, int passes, bool alpha_on)
+{
+	int i, j, k;
+	int x0, sw;
+	int height, width;
+	unsigned int inv;
+	EGI_16BIT_COLOR *lcolors=NULL;	/* line buffer, also for column strips */
+	unsigned char *lalphas=NULL;
+	EGI_16BIT_COLOR *colors;
+	unsigned char *alphas;
+
+	if( eimg==NULL || eimg->imgbuf==NULL )
+		return -1;
+
+	height=eimg->height;
+	width=eimg->width;
+
+	/* copy srcimg to eimg, then blur in place */
+	if( srcimg!=NULL && srcimg!=eimg ) {
+		if( srcimg->imgbuf==NULL || srcimg->height!=height || srcimg->width!=width ) {
+			printf("%s: Input srcimg is invalid or NOT the same size as eimg!\n",__func__);
+			return -1;
+		}
+		memcpy(eimg->imgbuf, srcimg->imgbuf, height*width*sizeof(EGI_16BIT_COLOR));
+		if( eimg->alpha && srcimg->alpha )
+			memcpy(eimg->alpha, srcimg->alpha, height*width*sizeof(unsigned char));
+		alpha_on = ( alpha_on && srcimg->alpha ) ? true : false;
+	}
+
+	/* alpha_on: only image has alpha value AND input alpha_on is true! */
+	alpha_on = ( alpha_on && eimg->alpha ) ? true : false;
+
+	/* adjust radius and passes */
+	if(radius<=0)
+		return 0;
+	if(radius>EGI_BOXBLUR_MAXRADIUS)
+		radius=EGI_BOXBLUR_MAXRADIUS;
+	if(passes<1)
+		passes=1;
+	inv=(1U<<24)/(2*radius+1);
+
+	/* line buffer for a row, or a strip of EGI_BOXBLUR_STRIP columns */
+	k= width > height*EGI_BOXBLUR_STRIP ? width : height*EGI_BOXBLUR_STRIP;
+	lcolors=malloc(k*sizeof(EGI_16BIT_COLOR));
+	if(alpha_on)
+		lalphas=malloc(k*sizeof(unsigned char));
+	if( lcolors==NULL || (alpha_on && lalphas==NULL) ) {
+		printf("%s: Fail to malloc line buffer!\n",__func__);
+		free(lcolors);
+		free(lalphas);
+		return -2;
+	}
+
+	for(k=0; k<passes; k++) {
+		/* --- STEP 1:  blur rows --- */
+		for(i=0; i<height; i++) {
+			colors=eimg->imgbuf+i*width;
+			alphas= alpha_on ? eimg->alpha+i*width : NULL;
+			memcpy(lcolors, colors, width*sizeof(EGI_16BIT_COLOR));
+			if(alpha_on)
+				memcpy(lalphas, alphas, width*sizeof(unsigned char));
+			boxblur_line(colors, alphas, 1, lcolors, alpha_on ? lalphas : NULL, 1, width, radius, inv);
+		}
+
+		/* --- STEP 2:  blur columns, strip by strip to keep memory access in rows --- */
+		for(x0=0; x0<width; x0+=EGI_BOXBLUR_STRIP) {
+			sw= width-x0 > EGI_BOXBLUR_STRIP ? EGI_BOXBLUR_STRIP : width-x0;
+			/* gather the strip, lcolors[height][sw] */
+			for(i=0; i<height; i++) {
+				memcpy(lcolors+i*sw, eimg->imgbuf+i*width+x0, sw*sizeof(EGI_16BIT_COLOR));
+				if(alpha_on)
+					memcpy(lalphas+i*sw, eimg->alpha+i*width+x0, sw*sizeof(unsigned char));
+			}
+			for(j=0; j<sw; j++) {
+				boxblur_line( eimg->imgbuf+x0+j, alpha_on ? eimg->alpha+x0+j : NULL, width,
+					      lcolors+j, alpha_on ? lalphas+j : NULL, sw, height, radius, inv );
+			}
+		}
+	}
+
+	free(lcolors);
+	free(lalphas);
+
+	return 0;
+}
+
+
 /*------------------------------------------------------------------------------
-To soft/blur an image by averaging pixel colors/alpha, with allocating 2D arrays
-in input ineimg(ineimg->pcolors[][] and ineimg->palphas[][]).
-The 2D arrays are to buffer color/alpha data and improve sorting speed, the final
-results will be remainded in them.
+To soft/blur an image by averaging pixel colors/alpha, it calls egi_imgbuf_blur_box()
+with 2 passes of box filter with radius size/2, which is a tent filter of about the
+same window as of old forward/backward averaging.
 
 Note:
 1. The original EGI_IMGBUF keeps intact, a new EGI_IMGBUF with modified
    color/alpha values will be created.
 
-2. If succeeds, 2D array of ineimg->pcolors and ineimg->palpha(if ineimg has alpha values)
-   will be created for ineimg!(NOT for outeimg, but for imtermediate buffer!!!)
-   and will NOT be freed here, he final results will be remainded in them.
+2. If hold_on is true, or ineimg->pcolors already exists, the results will be
+   remainded in ineimg->pcolors[][] and ineimg->palphas[][](if alpha_on), they
+   will NOT be freed here, let egi_imgbuf_free() do it.
+   2D arrays are NOT allocated if hold_on is false.
 
-3. !!! WARNING !!! After avgsoft, ineimg->pcolors/palphas has been processed/blured
-   and NOT an exact copy of ineimg->imbuf any more!
+3. !!! WARNING !!! After avgsoft, ineimg->pcolors/palphas(if exist) has been
+   processed/blured and NOT an exact copy of ineimg->imbuf any more!
 
 4. If input ineimg has no alpha values, so will the outeimg.
 
@@ -580,9 +755,9 @@ Note:
 	    !!!NOTE!!!: Even if alpha_on if False, ineimg->alpha will be copied to
 	   	         outeimg->alpha if it exists.
 
-@holdon:    True: To continue to use ineimg->pcolors(palphas) as intermediate results,
-		  DO NOT re_memcpy from ineimg->imgbuf(palphas).
-	    False: Re_memcpy from ineimg->imgbuf(palphas).
+@holdon:    True: To continue to blur ineimg->pcolors(palphas), the intermediate results
+		  of last call, and keep new results in them.
+	    False: Blur from ineimg->imgbuf(alpha).
 
 Return:
 	A pointer to a new EGI_IMGBUF with blured image  	OK
@@ -590,17 +765,10 @@ Return:
 ------------------------------------------------------------------------------*/
 EGI_IMGBUF  *egi_imgbuf_avgsoft( EGI_IMGBUF *ineimg, int size, bool alpha_on, bool hold_on)
 {
-	int i,j,k;
-	EGI_16BIT_COLOR *colors;	/* to hold colors in avg filter windown */
-	unsigned int avgALPHA;
+	int i;
 	int height, width;
 	EGI_IMGBUF *outeimg=NULL;
 
-	/* a copy to ineimg->pcolors and palphas */
-	EGI_16BIT_COLOR **pcolors=NULL; /* WARNING!!! pointer same as ineimg->pcolors */
-	unsigned char 	**palphas=NULL; /* WARNING!!! pointer same as ineimg->palphas */
-
-
 	if( ineimg==NULL || ineimg->imgbuf==NULL )
 		return NULL;
 
@@ -611,311 +779,105 @@ EGI_IMGBUF  *egi_imgbuf_avgsoft( EGI_IMGBUF *ineimg, int size, bool alpha_on, bo
 	if(size<1)
 		size=1;
 
-	/***  ---- Redefine and adjust alpha_on ----
-	 * alpha_on: only image has alpha value AND input alpha_on is true!
-	 */
+	/* alpha_on: only image has alpha value AND input alpha_on is true! */
 	alpha_on = ( ineimg->alpha && alpha_on ) ? true : false;
-	if(alpha_on) { printf("%s: --- alpha on ---\n",__func__); }
-	else 	     { printf("%s: --- alpha off ---\n",__func__); }
-
-	/* adjust Max. of filter window size to be Min(width/2, height/2) */
-#if 0  /* Not necessary any more */
-	if(size>width/2 || size>height/2) {
-		size=width/2;
-		if( size > height/2 )
-			size=height/2;
-	}
-#endif
-
-	/* calloc colors */
-	colors=calloc(size, sizeof(EGI_16BIT_COLOR));
-	if(colors==NULL) {
-		printf("%s: Fail to calloc colors!\n",__func__);
-		return NULL;
-	}
-
-/* -------- Malloc/assign  2D array ineimg->pcolors and ineimg->palphas  --------- */
-if( ineimg->pcolors==NULL || ( alpha_on && ineimg->alpha !=NULL && ineimg->palphas==NULL ) )
-{
-	printf("%s: malloc 2D array for ineimg->pcolros, palphas ...\n",__func__);
-
-	/* free them both before re_malloc */
-	egi_free_buff2D((unsigned char **)ineimg->pcolors, height);
-	egi_free_buff2D(ineimg->palphas, height);
-
-	/* alloc pcolors */
-	ineimg->pcolors=(EGI_16BIT_COLOR **)egi_malloc_buff2D(height,width*sizeof(EGI_16BIT_COLOR));
-	pcolors=ineimg->pcolors; /* WARNING!!! pointing to the same data */
-	if(pcolors==NULL) {
-		printf("%s: Fail to malloc pcolors.\n",__func__);
-		return NULL;
-	}
-	/* copy color from input ineimg */
-	for(i=0; i<height; i++)
-		memcpy( pcolors[i], ineimg->imgbuf+i*width, width*sizeof(EGI_16BIT_COLOR) );
-
-	/* alloc alpha if alpha_on and original image has alpha!!! */
-	if(alpha_on && ineimg->alpha) {
-		ineimg->palphas=egi_malloc_buff2D(height,width*sizeof(unsigned char));
-		palphas=ineimg->palphas; /* WARNING!!! pointing to the same data */
-		if(palphas==NULL) {
-			printf("%s: Fail to malloc palphas.\n",__func__);
-			egi_free_buff2D((unsigned char **)ineimg->pcolors, height);
-			pcolors=NULL;
-			return NULL;
-		}
-		/* copy color from input ineimg */
-		for(i=0; i<height; i++)
-			memcpy( palphas[i], ineimg->alpha+i*width, width*sizeof(unsigned char) );
-	}
-
-}
-else  {
-	/*** 	<<<<  If pcolors/palphas already allocated in input ineimg  >>>
-	 * 2D array data may have been contanimated/processed already !!!
-	 * If we don't want to continue to use it, then we NEED to update to the same as
-	 * original ineimg->imgbuf and ineimg->alpha
-	 */
-
-	/* WARNING!!! make a copy pointers. before we use 'pcolors' instead of 'ineimg->pcolors' */
-	pcolors=ineimg->pcolors;
-	palphas=ineimg->palphas;
-
-	/* If do not hold to use old ineimg->pcolors(palphas) */
-	if(!hold_on) {
-		for(i=0; i<height; i++) {
-			//printf("%s: memcpy to update ineimg->pcolros...\n",__func__);
-			memcpy( pcolors[i], ineimg->imgbuf+i*width, width*sizeof(EGI_16BIT_COLOR) );
-
-			//printf("%s: memcpy to update ineimg->alphas...\n",__func__);
-			if(alpha_on && ineimg->alpha ) /* only if alpha_on AND ineimg has alpha value */
-				memcpy( palphas[i], ineimg->alpha+i*width, width*sizeof(unsigned char) );
-		}
-	}
-
-} /* ------------ END 2D ARRAY MALLOC --------------- */
 
 	/* create output imgbuf */
-	outeimg= egi_imgbuf_create( height, width, 0, 0); /* (h,w,alpha,color) will be replaced by avg later */
-	if(outeimg==NULL) {
-		free(colors);
-		egi_free_buff2D((unsigned char **)ineimg->pcolors, height);
-		egi_free_buff2D(ineimg->palphas, height);
-		pcolors=NULL; palphas=NULL;
+	outeimg= egi_imgbuf_create( height, width, 0, 0); /* (h,w,alpha,color) will be replaced later */
+	if(outeimg==NULL)
 		return NULL;
-	}
 
 	/* free alpha if original is NULL, ingore alpha_on for this.*/
 	if(ineimg->alpha==NULL) {
 		free(outeimg->alpha);
 		outeimg->alpha=NULL;
 	}
+	else
+		memcpy( outeimg->alpha, ineimg->alpha, height*width*sizeof(unsigned char));
 
-	/* --- STEP 1:  blur rows --- */
-	for(i=0; i< height; i++) {
-		/* first avg, for left to right */
-		for(j=0; j< width; j++) {
-			avgALPHA=0;
-			/* in the avg filter window */
-			for(k=0; k<size; k++) {
-				if( j+k > width-1 ) {
-					colors[k]=pcolors[i][j+k-width]; /* loop back */
-					if(alpha_on)
-						avgALPHA += palphas[i][j+k-width];
-				}
-				else {
-					colors[k]=pcolors[i][j+k];
-					if(alpha_on)
-						avgALPHA += palphas[i][j+k];
-				}
-			}
-			/* --- update intermediatey pcolors[] and alphas[] here --- */
-			pcolors[i][j]=egi_16bitColor_avg(colors,size);
-			if(alpha_on)
-				palphas[i][j]=avgALPHA/size;
-		}
-		/* second avg, for right to left */
-		for(j=width-1; j>=0; j--) {
-			avgALPHA=0;
-			/* in the avg filter window */
-			for(k=0; k<size; k++) {
-				if( j-k < 0) {		/* loop back if out of range */
-					colors[k]=pcolors[i][j-k+width];
-					if(alpha_on)
-						avgALPHA += palphas[i][j-k+width];
-				}
-				else  {
-					colors[k]=pcolors[i][j-k];
-					if(alpha_on)
-						avgALPHA += palphas[i][j-k];
-				}
-			}
-			/* --- update intermediatey pcolors[] and alphas[] here --- */
-			pcolors[i][j]=egi_16bitColor_avg(colors,size);
-			if(alpha_on)
-				palphas[i][j]=avgALPHA/size;
-		}
-	}
+	/* -------- Malloc 2D array ineimg->pcolors and ineimg->palphas, only if hold_on  --------- */
+	if( hold_on && ( ineimg->pcolors==NULL || ( alpha_on && ineimg->palphas==NULL ) ) )
+	{
+		/* free them both before re_malloc */
+		egi_free_buff2D((unsigned char **)ineimg->pcolors, height);
+		egi_free_buff2D(ineimg->palphas, height);
+		ineimg->palphas=NULL;
 
-	/* --- STEP 2:  blur columns --- */
-	for(i=0; i< width; i++) {
-		/* first avg, from top to bottom */
-		for(j=0; j< height; j++) {
-			avgALPHA=0;
-			/* in the avg filter window */
-			for(k=0; k<size; k++) {
-				if( j+k > height-1 ) {
-					colors[k]=pcolors[j+k-height][i]; /* loop back */
-					if(alpha_on)
-						avgALPHA += palphas[j+k-height][i];
-				}
-				else {
-					colors[k]=pcolors[j+k][i];
-					if(alpha_on)
-						avgALPHA += palphas[j+k][i];
-				}
-			}
-			/*  ---- final output to outeimg ---- */
-			pcolors[j][i]=egi_16bitColor_avg(colors,size);
-			if(alpha_on)
-				palphas[j][i]=avgALPHA/size;
+		ineimg->pcolors=(EGI_16BIT_COLOR **)egi_malloc_buff2D(height,width*sizeof(EGI_16BIT_COLOR));
+		if(ineimg->pcolors==NULL) {
+			printf("%s: Fail to malloc pcolors.\n",__func__);
+			egi_imgbuf_free(outeimg);
+			return NULL;
 		}
-		/* second avg, from bottom to top */
-		for(j=height-1; j>=0; j--) {
-			avgALPHA=0;
-			/* in the avg filter window */
-			for(k=0; k<size; k++) {
-				if( j-k < 0 ) {		/* loop back if out of range */
-					colors[k]=pcolors[j-k+height][i];
-					if(alpha_on)
-						avgALPHA += palphas[j-k+height][i];
-				}
-				else {
-					colors[k]=pcolors[j-k][i];
-					if(alpha_on)
-						avgALPHA += palphas[j-k][i];
-				}
+		if(alpha_on) {
+			ineimg->palphas=egi_malloc_buff2D(height,width*sizeof(unsigned char));
+			if(ineimg->palphas==NULL) {
+				printf("%s: Fail to malloc palphas.\n",__func__);
+				egi_free_buff2D((unsigned char **)ineimg->pcolors, height);
+				ineimg->pcolors=NULL;
+				egi_imgbuf_free(outeimg);
+				return NULL;
 			}
-			/*  ---- final output to outeimg ---- */
-			//outeimg->imgbuf[j*width+i]=egi_16bitColor_avg(colors, size);
-			pcolors[j][i]=egi_16bitColor_avg(colors,size);
-			if(alpha_on)
-				//outeimg->alpha[j*width+i]=avgALPHA/size;
-				palphas[j][i]=avgALPHA/size;
 		}
+		hold_on=false; /* No intermediate results yet */
 	}
 
-		/* ------- memcpy finished data ------ */
-	/* now ineimg->pcolors[]/palphas[] has final processed data, memcpy to outeimg->imgbuf */
-	for( i=0; i<height; i++ ) {
-		memcpy(outeimg->imgbuf+i*width, ineimg->pcolors[i], width*sizeof(EGI_16BIT_COLOR));
-
-		/*** !!!Remind that if(alpha_on), ineimg MUST has alpha values
-		 * SEE redifinition of alpha_on at the very beginning of the func.
-		 */
-		if(alpha_on)
-			memcpy( outeimg->alpha+i*width, ineimg->palphas[i], width*sizeof(unsigned char));
+	/* Source data: last results in ineimg->pcolors(palphas), or ineimg->imgbuf(alpha) */
+	for(i=0; i<height; i++) {
+		if(hold_on)
+			memcpy(outeimg->imgbuf+i*width, ineimg->pcolors[i], width*sizeof(EGI_16BIT_COLOR));
+		else
+			memcpy(outeimg->imgbuf+i*width, ineimg->imgbuf+i*width, width*sizeof(EGI_16BIT_COLOR));
+		if(hold_on && alpha_on)
+			memcpy(outeimg->alpha+i*width, ineimg->palphas[i], width*sizeof(unsigned char));
 	}
 
-	/* If ineimg has alpha values, but alpha_on set is false, just copy alpha to outeimg */
-	if( !alpha_on && ineimg->alpha != NULL)
-		memcpy( outeimg->alpha, ineimg->alpha, height*width*sizeof(unsigned char));
-
-
-	/* free colors */
-	free(colors);
+	/* blur in place */
+	if( egi_imgbuf_blur_box(outeimg, NULL, size/2, 2, alpha_on) !=0 ) {
+		egi_imgbuf_free(outeimg);
+		return NULL;
+	}
 
-	/* Don NOT free here, let egi_imgbuf_free() do it! */
-//	egi_free_buff2D((unsigned char **)ineimg->pcolors, height);
-//	egi_free_buff2D(ineimg->palphas, height);
+	/* keep results in 2D arrays, if they exist */
+	if(ineimg->pcolors) {
+		for(i=0; i<height; i++) {
+			memcpy(ineimg->pcolors[i], outeimg->imgbuf+i*width, width*sizeof(EGI_16BIT_COLOR));
+			if(alpha_on && ineimg->palphas)
+				memcpy(ineimg->palphas[i], outeimg->alpha+i*width, width*sizeof(unsigned char));
+		}
+	}
 
 	return outeimg;
 }
 
 
 /*-------------------- !!! NO 2D ARRAYS APPLIED !!!------------------------
-Nearly same speed as of egi_imgbuf_avgsoft(), But beware of the size of the
-picture, especailly like 1024x901(odd)   !!! FAINT !!!
+Blur an image by averaging pixel colors/alpha, same as egi_imgbuf_avgsoft()
+without hold_on, it calls egi_imgbuf_blur_box() with 2 passes of box filter
+with radius size/2.
 
 !!! --- NOTICE --- !!!
 If size==1, the result outeimg has a copy of original eimg's colors/alphas data.
 
-Note:
-1. Function same as egi_imgbuf_avgsoft(), but without allocating  additional
-   2D array for color/alpha data processsing.
-2. For small size picture, 240x320 etc, this func is a litter faster than
-   egi_imgbuf_avgsoft().
-
-3. For big size picture, depends on picture size ???????
-   study cases:
-
-	1.   1000x500 JPG        nearly same speed for all blur_size.
-
-	     	( !!!!!  Strange for 1024x901  !!!!! )
-	2.   1024x901 PNG,RBG    blur_size>13, 2D faster; blur_size<13, nearly same speed.
-	     1024x900 PNG,RBG    nearly same speed for all blur_size, 1D just a litter slower.
-
-	3.   1200x1920 PNG,RGBA  nearly same speed for all blur_size.
-     	     1922x1201 PNG,RGBA  nearly same speed for all blur_size.
-
-
 Return:
 	A pointer to a new EGI_IMGBUF with blured image  	OK
 	NULL							Fail
 ----------------------------------------------------------------------------*/
 EGI_IMGBUF  *egi_imgbuf_avgsoft2(const EGI_IMGBUF *ineimg, int size, bool alpha_on)
 {
-	int i,j,k;
-	EGI_16BIT_COLOR *colors;	/* to hold colors in avg filter windown */
-	unsigned int avgALPHA;
-	int height, width;
-	unsigned int index;
 	EGI_IMGBUF *outeimg=NULL;
 
 	if( ineimg==NULL || ineimg->imgbuf==NULL )
 		return NULL;
 
-	height=ineimg->height;
-	width=ineimg->width;
-
 	/* adjust size to Min. 1 */
 	if(size<1)
 		size=1;
 
-
-	/***   Redefine alpha_on
-	 * alpha_on: only image has alpha value AND input alpha_on is true!
-	 */
-	alpha_on = (ineimg->alpha && alpha_on) ? true : false;
-	if(alpha_on) { printf("%s: --- alpha on ---\n",__func__); }
-	else 	     { printf("%s: --- alpha off ---\n",__func__); }
-
-	/* adjust Max. of filter window size to be Min(width/2, height/2) */
-#if 0  /* Not necessary any more */
-	if(size>width/2 || size>height/2) {
-		size=width/2;
-		if( size > height/2 )
-			size=height/2;
-	}
-#endif
-
-	/* calloc colors */
-	colors=calloc(size, sizeof(EGI_16BIT_COLOR));
-	if(colors==NULL) {
-		printf("%s: Fail to calloc colors!\n",__func__);
-		return NULL;
-	}
-
 	/* create output imgbuf */
-	outeimg= egi_imgbuf_create( height, width, 0, 0); /* (h,w,alpha,color) alpha/color will be replaced by avg later */
-	if(outeimg==NULL) {
-		free(colors);
+	outeimg= egi_imgbuf_create( ineimg->height, ineimg->width, 0, 0); /* (h,w,alpha,color) */
+	if(outeimg==NULL)
 		return NULL;
-	}
-	/***
-	 * copy ineimg->imgbuf to outeimg->imgbuf, we'll process on outeimg!
-	 *  Or, in 'first blur rows, from left to right' we update outeimg->imgbuf with proceeded data! */
-	//memcpy(outeimg->imgbuf, ineimg->imgbuf, height*width*sizeof(EGI_16BIT_COLOR));
 
 	/* free alpha is original is NULL*/
 	if(ineimg->alpha==NULL) {
@@ -923,128 +885,239 @@ EGI_IMGBUF  *egi_imgbuf_avgsoft2(const EGI_IMGBUF *ineimg, int size, bool alpha_
 		outeimg->alpha=NULL;
 	}
 
-	/* --- STEP 1:  blur rows, pick data in ineimg  --- */
-	for(i=0; i< height; i++) {
-		/* first avg, for left to right */
-		for(j=0; j< width; j++) {
-			avgALPHA=0;
-			/* in the avg filter window */
-			for(k=0; k<size; k++) {
-				if( j+k > width-1 ) {
-					index=i*width+j+k-width; /* loop back */
-					/* Since outeimg has data in imgbuf[] now, do not pick from ineimg!
-					 * Same for alpha data.
-					 */
-					//colors[k]=ineimg->imgbuf[index];
-					colors[k]=outeimg->imgbuf[index];
-					if(alpha_on)
-						//avgALPHA += ineimg->alpha[index];
-						avgALPHA += outeimg->alpha[index];
-				}
-				else {
-					index=i*width+j+k;
-					/* outeimg has NO data in imgbuf[], need to pick from ineimg */
-					colors[k]=ineimg->imgbuf[index];
-					if(alpha_on)
-						avgALPHA += ineimg->alpha[index];
-				}
+	if( egi_imgbuf_blur_box(outeimg, ineimg, size/2, 2, alpha_on) !=0 ) {
+		egi_imgbuf_free(outeimg);
+		return NULL;
+	}
+
+	return outeimg;
+}
+
+
+/*------------------------------------------------------------------------------
+Prepare index and weight tables for resizing one dimension from oldn to n pixels.
+
+Bilinear(area==false):
+	Output pixel j is interpolated between old pixels idx[j] and idx[j]+1,
+	wt[j] is weight of idx[j]+1, in [0 256]. End pixels are aligned, as
+	position of j is j*(oldn-1)/(n-1).
+Area(area==true):
+	Output pixel j is the average of old pixels [idx[j] idx[j+1]),
+	wt[j]=(1<<24)/(idx[j+1]-idx[j]), to replace division.
+
+@idx:	n+1 items.
+@wt:	n items.
+------------------------------------------------------------------------------*/
+static void resize_tables(int *idx, unsigned int *wt, int oldn, int n, bool area)
+{
+	int j;
+	long long pos;
+
+	if(area) {
+		for(j=0; j<=n; j++)
+			idx[j]=(long long)j*oldn/n;
+		for(j=0; j<n; j++) {
+			if(idx[j+1]<=idx[j])	/* at least one pixel */
+				idx[j+1]=idx[j]+1;
+			wt[j]=(1U<<24)/(idx[j+1]-idx[j]);
+		}
+	}
+	else {
+		for(j=0; j<n; j++) {
+			pos= n>1 ? (long long)j*(oldn-1)*256/(n-1) : 0;	/* in 1/256 pixel */
+			idx[j]=pos>>8;
+			wt[j]=pos&0xFF;
+			if(idx[j]>=oldn-1) {	/* last one, no more pixel at its right */
+				idx[j]=oldn-1;
+				wt[j]=0;
 			}
-			/* --- update intermediatey pcolors and alphas here --- */
-			index=i*width+j;
-			outeimg->imgbuf[index]=egi_16bitColor_avg(colors,size);
-			if(alpha_on)
-				outeimg->alpha[index]=avgALPHA/size;
 		}
-		/* second avg, for right to left !!!Now we have proceed data in outeimg->imgbuf  */
-		for(j=width-1; j>=0; j--) {
-			avgALPHA=0;
-			/* in the avg filter window */
-			for(k=0; k<size; k++) {
-				if( j-k < 0) {		/* loop back if out of range */
-					index=i*width+j-k+width;
-					//colors[k]=ineimg->imgbuf[index];
-					colors[k]=outeimg->imgbuf[index];   /* outeimg has proceeded data now! */
-					if(alpha_on)
-						//avgALPHA += ineimg->alpha[index];
-						avgALPHA += outeimg->alpha[index];
-				}
-				else  {
-					index=i*width+j-k;
-					//colors[k]=ineimg->imgbuf[index];
-					colors[k]=outeimg->imgbuf[index]; /* outeimg has proceeded data! */
-					if(alpha_on)
-						//avgALPHA += ineimg->alpha[index];
-						avgALPHA += outeimg->alpha[index];
-				}
+		idx[n]=oldn-1;
+	}
+}
+
+/*------------------------------------------------------------------------------
+Scale a row of pixels horizontally, channels are split into hrow[]:
+R[n],G[n],B[n],A[n] with RGB565 bits, and in fix point of 1/256.
+If alphas is NULL, A[] is not touched.
+------------------------------------------------------------------------------*/
+static void resize_hrow( unsigned short *hrow, const EGI_16BIT_COLOR *colors, const unsigned char *alphas,
+			 int n, const int *idx, const unsigned int *wt, bool area )
+{
+	int j, k;
+	unsigned int r,g,b,a;
+	unsigned int w1, w2;
+	EGI_16BIT_COLOR c1, c2;
+
+	for(j=0; j<n; j++) {
+		if(area) {
+			r=g=b=a=0;
+			for(k=idx[j]; k<idx[j+1]; k++) {
+				c1=colors[k];
+				r += c1>>11;
+				g += (c1>>5)&0x3F;
+				b += c1&0x1F;
+				if(alphas)
+					a += alphas[k];
 			}
-			/* --- update intermediatey pcolors and alphas here --- */
-			index=i*width+j;
-			outeimg->imgbuf[index]=egi_16bitColor_avg(colors,size);
-			if(alpha_on)
-				outeimg->alpha[index]=avgALPHA/size;
+			/* sum*256/cnt */
+			hrow[j]=(r*wt[j])>>16;
+			hrow[n+j]=(g*wt[j])>>16;
+			hrow[2*n+j]=(b*wt[j])>>16;
+			if(alphas)
+				hrow[3*n+j]=(a*wt[j])>>16;
+		}
+		else {
+			k=idx[j];
+			w2=wt[j];
+			w1=256-w2;
+			c1=colors[k];
+			c2= w2 ? colors[k+1] : c1;
+			hrow[j]=(c1>>11)*w1 + (c2>>11)*w2;
+			hrow[n+j]=((c1>>5)&0x3F)*w1 + ((c2>>5)&0x3F)*w2;
+			hrow[2*n+j]=(c1&0x1F)*w1 + (c2&0x1F)*w2;
+			if(alphas)
+				hrow[3*n+j]=alphas[k]*w1 + (w2 ? alphas[k+1]*w2 : 0);
 		}
 	}
+}
 
-	/* --- STEP 2:  blur columns, pick data in outeimg now.  --- */
-	for(i=0; i< width; i++) {
-		/* first avg, from top to bottom */
-		for(j=0; j< height; j++) {
-			avgALPHA=0;
-			/* in the avg filter window */
-			for(k=0; k<size; k++) {
-				if( j+k > height-1 ) {
-					index=(j+k-height)*width+i; /* loop back */
-					colors[k]=outeimg->imgbuf[index]; /* now use outeimg instead of ineimg */
-					if(alpha_on)
-						avgALPHA += outeimg->alpha[index];
-				}
-				else {
-					index=(j+k)*width+i;
-					colors[k]=outeimg->imgbuf[index];
-					if(alpha_on)
-						avgALPHA += outeimg->alpha[index];
-				}
+
+/*-----------------------------------------------------------------------
+Resize ineimg to the size of outeimg, and write results directly into
+outeimg->imgbuf(alpha). Caller may keep outeimg to reuse its memory for
+each frame, such as GIF frames or thumbnails.
+
+NOTE:
+1. Each dimension is scaled separately:
+   If it's shrinked to less than half, pixels are averaged over the
+   area(box filter), otherwise they are bilinear interpolated.
+2. Index and weight tables are prepared for all rows and columns first,
+   and only one scratch buffer is allocated for tables and two
+   horizontally scaled rows, no division in inner loops.
+3. Alpha values are resized only if both ineimg and outeimg have alpha.
+   If ineimg has no alpha, outeimg->alpha keeps intact.
+
+@outeimg:	Output EGI_IMGBUF with size and memory allocated.
+		Its memory may be allocated for a bigger size and reused,
+		data is laid out as width*height of outeimg.
+@ineimg:	Input EGI_IMGBUF holding the original image data.
+
+Return:
+	0	OK
+	<0	Fails
+------------------------------------------------------------------------*/
+int egi_imgbuf_resize_into(EGI_IMGBUF *outeimg, const EGI_IMGBUF *ineimg)
+{
+	int i,j,k;
+	int width, height, oldwidth, oldheight;
+	bool alpha_on;
+	bool xarea, yarea;
+	void *scratch;
+	int *xidx, *yidx;
+	unsigned int *xwt, *ywt;
+	unsigned short *hrows[2];	/* two horizontally scaled rows */
+	int hrow_y[2]={-1,-1};		/* source row index of hrows[] */
+	unsigned int *acc;		/* accumulator for area averaging of rows */
+	unsigned short *h1, *h2;
+	unsigned int w1, w2, inv;
+	unsigned int v[4];
+	int ch, nch;
+
+	if( ineimg==NULL || ineimg->imgbuf==NULL || outeimg==NULL || outeimg->imgbuf==NULL )
+		return -1;
+
+	width=outeimg->width;
+	height=outeimg->height;
+	oldwidth=ineimg->width;
+	oldheight=ineimg->height;
+	if( width<1 || height<1 || oldwidth<1 || oldheight<1 )
+		return -1;
+
+	alpha_on = ( ineimg->alpha && outeimg->alpha ) ? true : false;
+	nch= alpha_on ? 4 : 3;
+
+	/* if same size, just memcpy data */
+	if( height==oldheight && width==oldwidth ) {
+		memcpy( outeimg->imgbuf, ineimg->imgbuf, sizeof(EGI_16BIT_COLOR)*height*width);
+		if(alpha_on)
+			memcpy( outeimg->alpha, ineimg->alpha, sizeof(unsigned char)*height*width);
+		return 0;
+	}
+
+	/* area averaging if shrinked to less than half */
+	xarea = ( oldwidth >= 2*width );
+	yarea = ( oldheight >= 2*height );
+
+	/* One scratch buffer: tables, 2 hrows[4][width], and acc[4][width] */
+	scratch=malloc( (width+1+height+1)*sizeof(int) + (width+height)*sizeof(unsigned int)
+			+ 4*width*sizeof(unsigned int) + 2*4*width*sizeof(unsigned short) );
+	if(scratch==NULL) {
+		printf("%s: Fail to malloc scratch buffer.\n",__func__);
+		return -2;
+	}
+	acc=(unsigned int *)scratch;
+	xwt=acc+4*width;
+	ywt=xwt+width;
+	xidx=(int *)(ywt+height);
+	yidx=xidx+width+1;
+	hrows[0]=(unsigned short *)(yidx+height+1);
+	hrows[1]=hrows[0]+4*width;
+
+	resize_tables(xidx, xwt, oldwidth, width, xarea);
+	resize_tables(yidx, ywt, oldheight, height, yarea);
+
+	for(i=0; i<height; i++) {
+		if(yarea) {
+			/* average horizontally scaled rows [yidx[i] yidx[i+1]) */
+			memset(acc, 0, nch*width*sizeof(unsigned int));
+			for(k=yidx[i]; k<yidx[i+1]; k++) {
+				resize_hrow( hrows[0], ineimg->imgbuf+k*oldwidth,
+					     alpha_on ? ineimg->alpha+k*oldwidth : NULL, width, xidx, xwt, xarea );
+				for(j=0; j<nch*width; j++)
+					acc[j] += hrows[0][j];
+			}
+			inv=ywt[i];
+			for(j=0; j<width; j++) {
+				for(ch=0; ch<nch; ch++)
+					v[ch]=( (acc[ch*width+j]>>8)*inv + (1U<<23) )>>24;
+				outeimg->imgbuf[i*width+j]=(v[0]<<11)|(v[1]<<5)|v[2];
+				if(alpha_on)
+					outeimg->alpha[i*width+j]=v[3];
 			}
-			/*  ---- final output to outeimg ---- */
-			index=j*width+i;
-			outeimg->imgbuf[index]=egi_16bitColor_avg(colors, size);
-			if(alpha_on)
-				outeimg->alpha[index]= avgALPHA/size;
 		}
-		/* second avg, from bottom to top */
-		for(j=height-1; j>=0; j--) {
-			avgALPHA=0;
-			/* in the avg filter window */
-			for(k=0; k<size; k++) {
-				if( j-k < 0 ) {		/* loop back if out of range */
-					index=(j-k+height)*width+i;
-					colors[k]=outeimg->imgbuf[index];
-					if(alpha_on)
-						avgALPHA += outeimg->alpha[index];
-				}
-				else {
-					index=(j-k)*width+i;
-					colors[k]=outeimg->imgbuf[index];
-					if(alpha_on)
-						avgALPHA += outeimg->alpha[index];
+		else {
+			/* bilinear between source rows yidx[i] and yidx[i]+1, keep them for next row */
+			for(k=0; k<2; k++) {
+				int y= yidx[i]+k < oldheight ? yidx[i]+k : oldheight-1;
+				if( hrow_y[k]==y )
+					continue;
+				if( k==0 && hrow_y[1]==y ) {  /* last bottom row is the top row now */
+					h1=hrows[0]; hrows[0]=hrows[1]; hrows[1]=h1;
+					hrow_y[1]=hrow_y[0]; hrow_y[0]=y;
+					continue;
 				}
+				resize_hrow( hrows[k], ineimg->imgbuf+y*oldwidth,
+					     alpha_on ? ineimg->alpha+y*oldwidth : NULL, width, xidx, xwt, xarea );
+				hrow_y[k]=y;
+			}
+			h1=hrows[0];
+			h2=hrows[1];
+			w2=ywt[i];
+			w1=256-w2;
+			for(j=0; j<width; j++) {
+				for(ch=0; ch<nch; ch++)
+					v[ch]=( h1[ch*width+j]*w1 + h2[ch*width+j]*w2 + (1U<<15) )>>16;
+				outeimg->imgbuf[i*width+j]=(v[0]<<11)|(v[1]<<5)|v[2];
+				if(alpha_on)
+					outeimg->alpha[i*width+j]=v[3];
 			}
-			/*  ---- final output to outeimg ---- */
-			index=j*width+i;
-			outeimg->imgbuf[index]=egi_16bitColor_avg(colors, size);
-			if(alpha_on)
-				outeimg->alpha[index]=avgALPHA/size;
 		}
 	}
 
-	/* If ineimg has alpha values, but alpha_on is false, just copy alpha to outeimg */
-	if( !alpha_on && ineimg->alpha != NULL)
-		memcpy( outeimg->alpha, ineimg->alpha, height*width*sizeof(unsigned char)) ;
-
-	/* free colors */
-	free(colors);
+	free(scratch);
 
-	return outeimg;
+	return 0;
 }
 
 
@@ -1053,21 +1126,11 @@ Resize an image and create a new EGI_IMGBUF to hold the new image data.
 Only size/color/alpha of ineimg will be transfered to outeimg, others
 such as subimg will be ignored. )
 
-TODO: Before scale down an image, merge and shrink it to a certain size first!!!
-
 NOTE:
-1. Linear interpolation is carried out with fix point calculation.
+1. It calls egi_imgbuf_resize_into(), bilinear interpolation with fix point
+   calculation, or area averaging if shrinked to less than half.
 2. If either width or height is <1, then adjust width/height proportional to oldwidth/oldheight.
-3. !!! --- LIMIT --- !!!
-   Fix point data type: 			int
-   Pixel 16bit color:				16bit
-   Fix point multiplier(or divisor): 		f15 ( *(1U<<15) )
-   interpolation ratio:				[0 1]
-   Scale limit/Interpolation resolution:
-
-   Min. ratio 1/(1U<<15), so more than 1k points can be interpolated between
-   two pixels.
-
+3. Interpolation resolution is 1/256 pixel.
 
 @ineimg:	Input EGI_IMGBUF holding the original image data.
 @width:		Width for new image.
@@ -1085,21 +1148,7 @@ EGI_IMGBUF  *egi_imgbuf_resize( const EGI_IMGBUF *ineimg,
 				//unsigned int width, unsigned int height )
 				int width, int height )
 {
-	int i,j;
-	int ln,rn;		/* left/right(or up/down) index of pixel in a row of ineimg */
-	int f15_ratio;
-	unsigned int color_rowsize, alpha_rowsize;
 	EGI_IMGBUF *outeimg=NULL;
-//	EGI_IMGBUF *tmpeimg=NULL;
-
-	/* for intermediate processing */
-	EGI_16BIT_COLOR **icolors=NULL;
-	unsigned char 	**ialphas=NULL;
-
-	/* for final processing */
-	EGI_16BIT_COLOR **fcolors=NULL;
-	unsigned char 	**falphas=NULL;
-
 
 	if( ineimg==NULL || ineimg->imgbuf==NULL ) //|| width<=0 || height<=0 ) adjust to 2
 		return NULL;
@@ -1107,10 +1156,6 @@ EGI_IMGBUF  *egi_imgbuf_resize( const EGI_IMGBUF *ineimg,
 	unsigned int oldwidth=ineimg->width;
 	unsigned int oldheight=ineimg->height;
 
-	bool alpha_on=false;
-	if(ineimg->alpha!=NULL)
-			alpha_on=true;
-
 	/* If W or H is <=0: Adjust width/height proportional to oldwidth/oldheight */
 	if(width<1 && height<1)
 		return NULL;
@@ -1119,223 +1164,33 @@ EGI_IMGBUF  *egi_imgbuf_resize( const EGI_IMGBUF *ineimg,
 	else if(height<1)
 		height=width*oldheight/oldwidth;
 
-	/* adjust width and height to 2, ==1 will cause Devide_By_Zero exception. */
+	/* adjust width and height to Min. 2 */
 	if(width<2) width=2;
 	if(height<2) height=2;
 
-#if 0 /* ----- FOR TEST ONLY ----- */
-	/* create temp imgbuf */
-	tmpeimg= egi_imgbuf_create(oldheight, width, 0, 0); /* (h,w,alpha,color) alpha/color will be replaced later */
-	if(tmpeimg==NULL) {
-		return NULL;
-	}
-	if(!alpha_on) {
-		free(tmpeimg->alpha);
-		tmpeimg->alpha=NULL;
-	}
-#endif /* ----- TEST ONLY ----- */
-
 	/* create output imgbuf */
 	outeimg= egi_imgbuf_create( height, width, 0, 0); /* (h,w,alpha,color) alpha/color will be replaced later */
 	if(outeimg==NULL) {
 		return NULL;
 	}
-	if(!alpha_on) {
+	if(ineimg->alpha==NULL) {
 		free(outeimg->alpha);
 		outeimg->alpha=NULL;
 	}
 
-	/* if same size, just memcpy data */
-	if( height==ineimg->height && width==ineimg->width ) {
-		memcpy( outeimg->imgbuf, ineimg->imgbuf, sizeof(EGI_16BIT_COLOR)*height*width);
-		if(alpha_on) {
-			memcpy( outeimg->alpha, ineimg->alpha, sizeof(unsigned char)*height*width);
-		}
-
-		return outeimg;
-	}
-
-	/* TODO: if height or width is the same size, to speed up */
-
-	/* Allocate mem to hold oldheight x width image for intermediate processing */
-	icolors=(EGI_16BIT_COLOR **)egi_malloc_buff2D(oldheight,width*sizeof(EGI_16BIT_COLOR));
-	if(icolors==NULL) {
-		printf("%s: Fail to malloc icolors.\n",__func__);
-		egi_imgbuf_free(outeimg);
-		return NULL;
-	}
-	if(alpha_on) {
-	   ialphas=egi_malloc_buff2D(oldheight,width*sizeof(unsigned char));
-	   if(ialphas==NULL) {
-		printf("%s: Fail to malloc ipalphas.\n",__func__);
-		egi_imgbuf_free(outeimg);
-		egi_free_buff2D((unsigned char **)icolors, oldheight);
-		return NULL;
-	   }
-	}
-
-	/* Allocate mem to hold final image size height x width  */
-	fcolors=(EGI_16BIT_COLOR **)egi_malloc_buff2D(height,width*sizeof(EGI_16BIT_COLOR));
-	if(fcolors==NULL) {
-		printf("%s: Fail to malloc fcolors.\n",__func__);
-		egi_imgbuf_free(outeimg);
-		egi_free_buff2D((unsigned char **)icolors, oldheight);
-		if(alpha_on)
-			egi_free_buff2D(ialphas, oldheight);
-		return NULL;
-	}
-	if(alpha_on) {
-	    falphas=egi_malloc_buff2D(height,width*sizeof(unsigned char));
-	    if(falphas==NULL) {
-		printf("%s: Fail to malloc ipalphas.\n",__func__);
+	if( egi_imgbuf_resize_into(outeimg, ineimg) !=0 ) {
 		egi_imgbuf_free(outeimg);
-		egi_free_buff2D((unsigned char **)icolors, oldheight);
-		egi_free_buff2D(ialphas, oldheight);
-		egi_free_buff2D((unsigned char **)fcolors, height);
 		return NULL;
-	    }
-	}
-
-	printf("%s: height=%d, width=%d, oldheight=%d, oldwidth=%d \n", __func__,
-								height, width, oldheight, oldwidth );
-
-	/* get new rowsize in bytes */
-	color_rowsize=width*sizeof(EGI_16BIT_COLOR);
-	alpha_rowsize=width*sizeof(unsigned char);
-
-	/* ----- STEP 1 -----  scale image from [oldheight_X_oldwidth] to [oldheight_X_width] */
-	for(i=0; i<oldheight; i++)
-	{
-//		printf(" \n STEP 1: ----- row %d ----- \n",i);
-		for(j=0; j<width; j++) /* apply new width */
-		{
-			/* Note:
-			 *   1. Here ln is left point index, and rn is right point index of a row of pixels.
-			 *      ln and rn are index of original image row.
-			 *      The inserted new point is between ln and rn.
-			 *   2. Notice that (oldwidth-1)/(width-1) is acutual width ratio.
-			 */
-			ln=j*(oldwidth-1)/(width-1);/* xwidth-1 is gap numbers */
-			f15_ratio=(j*(oldwidth-1)-ln*(width-1))*(1U<<15)/(width-1); /* >= 0 */
-			/* If last point, the ratio must be 0! no more point at its right now! */
-			if(ln == oldwidth-1)
-				rn=ln;
-			else
-				rn=ln+1;
-#if 0 /* --- TEST --- */
-			printf( "row: ln=%d, rn=%d,  f15_ratio=%d, ratio=%f \n",
-						ln, rn, f15_ratio, 1.0*f15_ratio/(1U<<15) );
-#endif
-			/* interpolate pixel color/alpha value, and store to icolors[]/ialphas[]  */
-			if(alpha_on) {
-				//printf("alpha_on interpolate ...\n");
-				egi_16bitColor_interplt(ineimg->imgbuf[i*oldwidth+ln], /* color1 */
-							ineimg->imgbuf[i*oldwidth+rn], /* color2 */
-			                                /* uchar alpha1,  uchar alpha2 */
-					 	ineimg->alpha[i*oldwidth+ln], ineimg->alpha[i*oldwidth+rn],
-                                         /* int f15_ratio, EGI_16BIT_COLOR* color, unsigned char *alpha */
-					 	f15_ratio, icolors[i]+j, ialphas[i]+j  );
-			}
-			else {
-				//printf("alpha_off interpolate ...\n");
-				egi_16bitColor_interplt(ineimg->imgbuf[i*oldwidth+ln], /* color1 */
-							ineimg->imgbuf[i*oldwidth+rn], /* color2 */
-			                                /* uchar alpha1,  uchar alpha2 */
-					 		 0, 0,   /* whatever when out pointer is NULL */
-                                         /* int f15_ratio, EGI_16BIT_COLOR* color, unsigned char *alpha */
-					 		f15_ratio, icolors[i]+j, NULL );
-			}
-		}
-#if 0 /* ----- FOR TEST ONLY ----- */
-		/* copy row data to tmpeimg */
-		memcpy( tmpeimg->imgbuf+i*width, icolors[i], color_rowsize );
-		if(alpha_on)
-		    memcpy( tmpeimg->alpha+i*width, ialphas[i], alpha_rowsize );
-#endif
-	}
-
-	/* NOTE: rowsize keep same here! Just need to scale height. */
-
-	/* ----- STEP 2 -----  scale image from [oldheight_X_width] to [height_X_width] */
-	for(i=0; i<width; i++)
-	{
-//		printf(" \n STEP 2: ----- column %d ----- \n",i);
-		for(j=0; j<height; j++) /* apply new height */
-		{
-			/* Here ln is upper point index, and rn is lower point index of a column of pixels.
-			 * ln and rn are index of original image column.
-			 * The inserted new point is between ln and rn.
-			 */
-			ln=j*(oldheight-1)/(height-1);/* xwidth-1 is gap numbers */
-			f15_ratio=(j*(oldheight-1)-ln*(height-1))*(1U<<15)/(height-1); /* >= 0 */
-			/* If last point, the ratio must be 0! no more point at its lower position now! */
-			if( ln == oldheight-1 )
-				rn=ln;
-			else
-				rn=ln+1;
-#if 0 /* --- TEST --- */
-			printf( "column: ln=%d, rn=%d,  f15_ratio=%d, ratio=%f \n",
-						ln, rn, f15_ratio, 1.0*f15_ratio/(1U<<15) );
-#endif
-			/* interpolate pixel color/alpha value, and store data to fcolors[]/falphas[]  */
-			if(alpha_on) {
-				//printf("column: alpha_on interpolate ...\n");
-				egi_16bitColor_interplt(
-							//ineimg->imgbuf[ln*width+i], /* color1 */
-							//ineimg->imgbuf[rn*width+i], /* color2 */
-							 icolors[ln][i], icolors[rn][i], /* old: color1, color2 */
-			                                /* old: uchar alpha1,  uchar alpha2 */
-					 	//ineimg->alpha[ln*width+i], ineimg->alpha[rn*width+i],
-						   	 ialphas[ln][i], ialphas[rn][i],
-                                         /* int f15_ratio, EGI_16BIT_COLOR* color, unsigned char *alpha */
-					 	         f15_ratio, fcolors[j]+i, falphas[j]+i  );
-			}
-			else {
-				//printf("column: alpha_off interpolate ...\n");
-				egi_16bitColor_interplt(
-							//ineimg->imgbuf[ln*width+i], /* color1 */
-							//ineimg->imgbuf[rn*width+i], /* color2 */
-							 icolors[ln][i], icolors[rn][i], /* color1, color2 */
-			                                /* uchar alpha1,  uchar alpha2 */
-					 		 0, 0,   /* whatever, when passout pointer is NULL */
-                                         /* int f15_ratio, EGI_16BIT_COLOR* color, unsigned char *alpha */
-					 		f15_ratio, fcolors[j]+i, NULL );
-			}
-		}
-		/* Can NOT copy row data here! as it transverses column.  */
-	}
-
-	/* Copy row data to outeimg when all finish. */
-//	printf(" STEP 2: copy row data to outeimg...\n");
-	for( i=0; i<height; i++) {
-		memcpy( outeimg->imgbuf+i*width, fcolors[i], color_rowsize );
-		if(alpha_on)
-		    memcpy( outeimg->alpha+i*width, falphas[i], alpha_rowsize );
 	}
 
-	/* free buffers */
-	printf("%s: Free buffers...\n", __func__);
-	egi_free_buff2D((unsigned char **)icolors, oldheight);
-	egi_free_buff2D(ialphas, oldheight);   /* no matter alpha off */
-	egi_free_buff2D((unsigned char **)fcolors, height);
-	egi_free_buff2D(falphas, height);      /* no matter alpha off */
-
-#if 0 /* ----- FOR TEST ONLY ----- */
-	if(tmpeimg!=NULL) {
-		printf("return tmpeimg...\n");
-		egi_imgbuf_free(outeimg);
-		return tmpeimg;
-	}
-#endif /* ----- FOR TEST ONLY ----- */
-
 	return outeimg;
 }
 
 
 
 /*--------------------------------------------------------------------
-Blur an EGI_IMGBUF by calling  egi_imgbuf_softavg2(). If it succeeds,
-the original imgbuf data will be updated then.
+Blur an EGI_IMGBUF in place by calling egi_imgbuf_blur_box(), same
+filter as egi_imgbuf_avgsoft2(), but no new imgbuf is created.
 
 Return:
 	0  	OK
@@ -1343,20 +1198,12 @@ Return:
 --------------------------------------------------------------------*/
 int egi_imgbuf_blur_update(EGI_IMGBUF **pimg, int size, bool alpha_on)
 {
-	EGI_IMGBUF  *tmpimg=NULL;
-
 	if( pimg==NULL || *pimg==NULL )
 		return -1;
 
-	/* Create a blured image by egi_imgbuf_softavg2() */
-	tmpimg=egi_imgbuf_avgsoft2(*pimg, size, alpha_on);
-	if(tmpimg==NULL)
+	if( egi_imgbuf_blur_box(*pimg, NULL, size/2, 2, alpha_on) !=0 )
 		return -2;
 
-	/* Free original imgbuf and replaced by tmpimg */
-	egi_imgbuf_free(*pimg);
-	*pimg=tmpimg;
-
 	return 0;
 }
 
@@ -1477,70 +1324,277 @@ int egi_imgbuf_blend_imgbuf(EGI_IMGBUF *eimg, int xb, int yb, const EGI_IMGBUF *
 
 
 /*-------------------------------------------------------------------------------
-Create an EGI_IMGBUF by rotating the input eimg.
-
-1. The new imgbuf size(H&W) are made odd, so it has a symmetrical center point.
-2. Only imgbuf and alpha data are created in new EGI_IMGBUF, other memebers such
-   as subimgs are ignored hence.
+Get size of an imgbuf to hold rotated eimg, the size is made odd, so it has a
+symmetrical center point.
 
 @eimg:		Original imgbuf;
 @angle: 	Rotating angle in degree, positive as clockwise.
+@height,width:	Pointer to pass out size of rotated imgbuf.
 
 Return:
-	A pointer to EGI_IMGBUF with new image 		OK
-	NULL						Fails
+	0	OK
+	<0	Fails
 --------------------------------------------------------------------------------*/
-EGI_IMGBUF* egi_imgbuf_rotate(EGI_IMGBUF *eimg, int angle)
+int egi_imgbuf_rotsize(const EGI_IMGBUF *eimg, int angle, int *height, int *width)
 {
-	int i,j;
-	int m,n;
-	int xr,yr;
-	int width, height;	/* W,H for outimg */
+	int ang;
 	int wsin,wcos, hsin,hcos;
-	int index_in, index_out;
-	int ang, asign;
-	EGI_IMGBUF *outimg=NULL;
-
-        /* Normalize angle to be within [0-360] */
-        ang=angle%360;      /* !!! WARING !!!  The modulo result is depended on the Compiler
-			     * For C99: a%b=a-(a/b)*b	,whether a is positive or negative.
-			     */
-        asign= ang >= 0 ? 1 : -1; /* angle sign */
-        ang= ang>=0 ? ang : -ang ;
 
-        if(eimg==NULL || eimg->imgbuf==NULL || eimg->height<=0 || eimg->width<=0 ) {
-                printf("%s: input holding eimg is NULL or uninitiliazed!\n", __func__);
-                return NULL;
-        }
+	if( eimg==NULL || eimg->height<=0 || eimg->width<=0 || height==NULL || width==NULL )
+		return -1;
 
         /* Check whether lookup table fp16_cos[] and fp16_sin[] is generated */
         if( fp16_sin[30] == 0)
                 mat_create_fpTrigonTab();
 
-	/* Get size for rotated imgbuf, which shall cover original eimg at least */
-#if 0	/* Float point method */
-	height=0.5+abs(eimg->width*sin(ang/180.0*MATH_PI))+abs(eimg->height*cos(ang/180.0*MATH_PI));
-	width=0.5+abs(eimg->width*cos(ang/180.0*MATH_PI))+abs(eimg->height*sin(ang/180.0*MATH_PI));
-#else	/* Fixed point method */
+	/* Normalize angle to be within [0-360), sign is ignored as only abs values are used */
+	ang=angle%360;
+	ang= ang>=0 ? ang : -ang;
+
+	/* Fixed point method */
 	wsin=eimg->width*fp16_sin[ang]>>16;
 	wsin=wsin>0 ? wsin : -wsin;
 	hcos=eimg->height*fp16_cos[ang]>>16;
 	hcos=hcos>0 ? hcos : -hcos;
-	height=wsin+hcos;
+	*height=wsin+hcos;
 
 	wcos=eimg->width*fp16_cos[ang]>>16;
 	wcos=wcos>0 ? wcos : -wcos;
 	hsin=eimg->height*fp16_sin[ang]>>16;
 	hsin=hsin>0 ? hsin : -hsin;
-	width=wcos+hsin;
-#endif
+	*width=wcos+hsin;
 
 	/* Make H/W an odd value, then it has a symmetrical center point.   */
-	height |= 0x1;
-	width |= 0x1;
-	if(height<3)height=3;
-	if(width<3)width=3;
-//	printf("Angle=%d, rotated imgbuf: height=%d, width=%d \n", ang, height, width);
+	*height |= 0x1;
+	*width |= 0x1;
+	if(*height<3) *height=3;
+	if(*width<3) *width=3;
+
+	return 0;
+}
+
+/* Floor of a/b, b>0 */
+static inline long long rot_floordiv(long long a, long long b)
+{
+	return a>=0 ? a/b : -((-a+b-1)/b);
+}
+
+/*---------------------------------------------------------------------
+Get span [*js, *je] of j, such that lo <= a+j*c <= hi.
+Return:
+	0	OK
+	<0	No valid j
+---------------------------------------------------------------------*/
+static int rot_span(long long a, long long c, long long lo, long long hi, int *js, int *je)
+{
+	long long low, high;
+	long long jmin, jmax;
+
+	if(c==0) {
+		if( a<lo || a>hi )
+			return -1;
+		return 0;	/* all j valid, keep js/je */
+	}
+
+	/* low <= j*c <= high, c>0 */
+	if(c>0) {
+		low=lo-a;
+		high=hi-a;
+	}
+	else {
+		c=-c;
+		low=a-hi;
+		high=a-lo;
+	}
+	jmin=-rot_floordiv(-low, c);	/* ceil */
+	jmax=rot_floordiv(high, c);
+
+	if(jmin > *js) *js=jmin;
+	if(jmax < *je) *je=jmax;
+
+	return *js <= *je ? 0 : -1;
+}
+
+/*-------------------------------------------------------------------------------
+Rotate eimg and write results into outimg, eimg is rotated around its center
+and put at center of outimg, call egi_imgbuf_rotsize() to get a size that
+covers the whole rotated image.
+
+1. For each row of outimg, the span [xstart xend] which is mapped into eimg is
+   calculated first, pixels out of the span are cleared(color 0, alpha 0),
+   and in the span, mapped position in eimg is just added by sin/cos steps
+   for each pixel, no multiplication or bounds test.
+2. Mapping is the same as old egi_imgbuf_rotate(), nearest pixel(floor), or
+   bilinear interpolated if bilinear is true.
+3. outimg may be reused for each frame, as all its pixels are rewritten.
+   If eimg has no alpha, alpha of outimg in span is set to 255.
+
+@outimg:	Output imgbuf, with memory allocated.
+@eimg:		Original imgbuf;
+@angle: 	Rotating angle in degree, positive as clockwise.
+@bilinear:	True: bilinear interpolation, False: nearest pixel.
+
+Return:
+	0	OK
+	<0	Fails
+--------------------------------------------------------------------------------*/
+int egi_imgbuf_rotate_into(EGI_IMGBUF *outimg, const EGI_IMGBUF *eimg, int angle, bool bilinear)
+{
+	int i,j;
+	int m,n;
+	int ang;
+	int fsin, fcos;
+	int cx, cy;
+	int js, je;
+	int xr, yr;		/* in fixed point f16, origin at left_top of eimg */
+	int x, y, fx, fy;
+	int width, height;	/* W,H for outimg */
+	int inw, inh;
+	int index_out, index_in;
+	EGI_16BIT_COLOR *colors;
+	unsigned char *alphas;
+	EGI_16BIT_COLOR c00,c01,c10,c11;
+	unsigned int w00,w01,w10,w11;
+	unsigned int a00,a01,a10,a11;
+
+	if( outimg==NULL || outimg->imgbuf==NULL || eimg==NULL || eimg->imgbuf==NULL
+	    || eimg->height<=0 || eimg->width<=0 || outimg->height<=0 || outimg->width<=0 ) {
+                printf("%s: input holding eimg or outimg is NULL or uninitiliazed!\n", __func__);
+                return -1;
+        }
+
+        /* Check whether lookup table fp16_cos[] and fp16_sin[] is generated */
+        if( fp16_sin[30] == 0)
+                mat_create_fpTrigonTab();
+
+        /* Normalize angle to be within [0-360], and take sign as of old egi_imgbuf_rotate() */
+        ang=angle%360;      /* !!! WARING !!!  The modulo result is depended on the Compiler
+			     * For C99: a%b=a-(a/b)*b	,whether a is positive or negative.
+			     */
+	fsin= ang>=0 ? fp16_sin[ang] : -fp16_sin[-ang];
+	fcos= ang>=0 ? fp16_cos[ang] : fp16_cos[-ang];
+
+	height=outimg->height;
+	width=outimg->width;
+	inw=eimg->width;
+	inh=eimg->height;
+	cx=inw>>1;
+	cy=inh>>1;
+	m=height>>1;
+	n=width>>1;
+	colors=eimg->imgbuf;
+	alphas=eimg->alpha;
+
+	for(i=-m; i<height-m; i++) {
+		index_out=width*(i+m);
+
+		/***  Map (j,i) to original coordiante, Origin at center:
+		 *	xr = j*cos + i*sin
+		 *	yr = -j*sin + i*cos
+		 *   Get span of j, so that 0 <= (xr>>16)+cx < inw, 0 <= (yr>>16)+cy < inh
+		 */
+		js=-n; je=width-n-1;
+		if( rot_span( (long long)i*fsin, fcos, -(long long)cx<<16, ((long long)(inw-cx)<<16)-1, &js, &je) !=0
+		    || rot_span( (long long)i*fcos, -fsin, -(long long)cy<<16, ((long long)(inh-cy)<<16)-1, &js, &je) !=0 ) {
+			/* whole row is empty */
+			memset(outimg->imgbuf+index_out, 0, width*sizeof(EGI_16BIT_COLOR));
+			if(outimg->alpha)
+				memset(outimg->alpha+index_out, 0, width);
+			continue;
+		}
+
+		/* Clear out of span */
+		memset(outimg->imgbuf+index_out, 0, (js+n)*sizeof(EGI_16BIT_COLOR));
+		memset(outimg->imgbuf+index_out+je+n+1, 0, (width-n-1-je)*sizeof(EGI_16BIT_COLOR));
+		if(outimg->alpha) {
+			memset(outimg->alpha+index_out, 0, js+n);
+			memset(outimg->alpha+index_out+je+n+1, 0, width-n-1-je);
+		}
+
+		/* Start point, shift Origin to left_top, as of eimg->imgbuf */
+		xr = js*fcos+i*fsin + (cx<<16);
+		yr = -js*fsin+i*fcos + (cy<<16);
+		index_out += js+n;
+
+		if(!bilinear) {
+			for(j=js; j<=je; j++, index_out++) {
+				index_in=inw*(yr>>16)+(xr>>16);
+				outimg->imgbuf[index_out]=colors[index_in];
+				if(outimg->alpha)
+					outimg->alpha[index_out]= alphas ? alphas[index_in] : 255;
+				xr += fcos;
+				yr -= fsin;
+			}
+		}
+		else {
+			for(j=js; j<=je; j++, index_out++) {
+				x=xr>>16; y=yr>>16;
+				fx=(xr>>8)&0xFF; fy=(yr>>8)&0xFF;
+				index_in=inw*y+x;
+
+				/* 4 pixels, clamped at edges */
+				c00=colors[index_in];
+				c01= x<inw-1 ? colors[index_in+1] : c00;
+				c10= y<inh-1 ? colors[index_in+inw] : c00;
+				c11= x<inw-1 ? (y<inh-1 ? colors[index_in+inw+1] : c01) : c10;
+				w00=(256-fx)*(256-fy);
+				w01=fx*(256-fy);
+				w10=(256-fx)*fy;
+				w11=fx*fy;
+				outimg->imgbuf[index_out]=
+				   ( ((c00>>11)*w00 + (c01>>11)*w01 + (c10>>11)*w10 + (c11>>11)*w11 + (1U<<15))>>16 )<<11
+				 | ( (((c00>>5)&0x3F)*w00 + ((c01>>5)&0x3F)*w01 + ((c10>>5)&0x3F)*w10
+				      + ((c11>>5)&0x3F)*w11 + (1U<<15))>>16 )<<5
+				 | ( ((c00&0x1F)*w00 + (c01&0x1F)*w01 + (c10&0x1F)*w10 + (c11&0x1F)*w11 + (1U<<15))>>16 );
+
+				if(outimg->alpha) {
+					if(alphas) {
+						a00=alphas[index_in];
+						a01= x<inw-1 ? alphas[index_in+1] : a00;
+						a10= y<inh-1 ? alphas[index_in+inw] : a00;
+						a11= x<inw-1 ? (y<inh-1 ? alphas[index_in+inw+1] : a01) : a10;
+						outimg->alpha[index_out]=(a00*w00+a01*w01+a10*w10+a11*w11+(1U<<15))>>16;
+					}
+					else
+						outimg->alpha[index_out]=255;
+				}
+				xr += fcos;
+				yr -= fsin;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*-------------------------------------------------------------------------------
+Create an EGI_IMGBUF by rotating the input eimg.
+
+1. The new imgbuf size(H&W) are made odd, so it has a symmetrical center point.
+2. Only imgbuf and alpha data are created in new EGI_IMGBUF, other memebers such
+   as subimgs are ignored hence.
+3. It calls egi_imgbuf_rotate_into() with nearest pixel mapping, to reuse
+   an imgbuf for each frame, call egi_imgbuf_rotate_into() instead.
+
+@eimg:		Original imgbuf;
+@angle: 	Rotating angle in degree, positive as clockwise.
+
+Return:
+	A pointer to EGI_IMGBUF with new image 		OK
+	NULL						Fails
+--------------------------------------------------------------------------------*/
+EGI_IMGBUF* egi_imgbuf_rotate(EGI_IMGBUF *eimg, int angle)
+{
+	int width, height;	/* W,H for outimg */
+	EGI_IMGBUF *outimg=NULL;
+
+        if(eimg==NULL || eimg->imgbuf==NULL || eimg->height<=0 || eimg->width<=0 ) {
+                printf("%s: input holding eimg is NULL or uninitiliazed!\n", __func__);
+                return NULL;
+        }
+
+	/* Get size for rotated imgbuf, which shall cover original eimg at least */
+	egi_imgbuf_rotsize(eimg, angle, &height, &width);
 
 	/* Create an imgbuf accordingly */
 	outimg=egi_imgbuf_create( height, width, 0, 0); /* H, W, alpah, color */
@@ -1555,29 +1609,7 @@ EGI_IMGBUF* egi_imgbuf_rotate(EGI_IMGBUF *eimg, int angle)
 	}
 
 	/* Rotation map and copy */
-	m=height>>1;
-	n=width>>1;
-	for(i=-m; i<=m; i++) {
-		for(j=-n; j<=n; j++) {
-			/* Map to original coordiante (xr,yr), Origin at center. */
-			xr = (j*fp16_cos[ang]+i*asign*fp16_sin[ang])>>16; /* !!! Arithmetic_Right_Shifting */
-                        yr = (-j*asign*fp16_sin[ang]+i*fp16_cos[ang])>>16;
-
-			/* Shift Origin to left_top, as of eimg->imgbuf */
-			xr += eimg->width>>1;
-			yr += eimg->height>>1;
-
-			/* Copy pixel alpha and color */
-			if( xr >= 0 && xr < eimg->width && yr >=0 && yr < eimg->height) {
-				index_out=width*(i+m)+(j+n);
-				index_in=eimg->width*yr+xr;
-				outimg->imgbuf[index_out]=eimg->imgbuf[index_in];
-				if(eimg->alpha!=NULL)
-					outimg->alpha[index_out]=eimg->alpha[index_in];
-			}
-		}
-	}
-
+	egi_imgbuf_rotate_into(outimg, eimg, angle, false);
 
 	return outimg;
 }
@@ -1641,26 +1673,23 @@ int egi_imgbuf_rotate_update(EGI_IMGBUF **eimg, int angle)
 For 16bits color only!!!!
 
 Note:
-1. Advantage: call draw_dot(), it is effective for FILO,
-2. Advantage: draw_dot() will ensure x,y range within screen.
+1. Image data are written row by row through span blitter fb_blit_span(), the displaying
+   window is clipped to both the screen and the image only once, so there is no more
+   per-pixel boundary check and draw_dot() calling.
+2. It is effective for FB FILO and virtual FB, same as draw_dot().
 3. Write image data of an EGI_IMGBUF to a window in FB.
-4. Set outside color as black.
+4. FB.pos_rotate is supported.
 5. window(xw, yw) defines a looking window to the original picture, (xp,yp) is the left_top
-   start point of the window. If the looking window covers area ouside of the picture,then
-   those area will be filled with BLACK.
-
-6. ??? Carefully defining (xp,yp),(xw,yw) and (winw,winh)to narrow down displaying area MAY
-       improve running speed considerably when you deal with a big picture ???
+   start point of the window. If the looking window covers area ouside of the picture,
+   those area will NOT be drawn.
 
 @egi_imgbuf:    an EGI_IMGBUF struct which hold bits_color image data of a picture.
 @fb_dev:	FB device
-@subcolor:	substituting color, only applicable when >0.
+@subcolor:	substituting color, only applicable when >=0.
 @(xp,yp):       Displaying image block origin(left top) point coordinate, relative to
                 the coord system of the image(also origin at left top).
 @(xw,yw):       displaying window origin, relate to the LCD coord system.
 @(winw,winh):   width and height(row/column for fb) of the displaying window.
-                !!! Note: You'd better set winw,winh not exceeds acutual LCD size, or it will
-                waste time calling draw_dot() for pixels outsie FB zone. --- OK
 
 
 Return:
@@ -1670,6 +1699,10 @@ Return:
 int egi_imgbuf_windisplay( EGI_IMGBUF *egi_imgbuf, FBDEV *fb_dev, int subcolor,
 			   		int xp, int yp, int xw, int yw, int winw, int winh)
 {
+	FB_BLITWIN win;
+	long int locimg; /* location of image buf, in pixel */
+	int i;
+
         /* check data */
         if(egi_imgbuf == NULL) {
                 printf("%s: egi_imgbuf is NULL. fail to display.\n",__func__);
@@ -1681,9 +1714,7 @@ int egi_imgbuf_windisplay( EGI_IMGBUF *egi_imgbuf, FBDEV *fb_dev, int subcolor,
         }
 
 	/* get mutex lock */
-//	printf("%s: Start lock image mutext...\n",__func__);
 	if(pthread_mutex_lock(&egi_imgbuf->img_mutex) !=0){
-		//printf("%s: Fail to lock image mutex!\n",__func__);
 		EGI_PLOG(LOGLV_ERROR,"%s: Fail to lock image mutex!", __func__);
 		return -1;
 	}
@@ -1698,185 +1729,37 @@ int egi_imgbuf_windisplay( EGI_IMGBUF *egi_imgbuf, FBDEV *fb_dev, int subcolor,
 		EGI_PLOG(LOGLV_ERROR,"%s: imgbuf width or height is <=0!", __func__);
                 return -2;
         }
-//	printf("%s: height=%d, width=%d \n",__func__, imgh,imgw);
-
-        int i,j;
-        int xres;
-        int yres;
-        long int screen_pixels;
-
-        unsigned char *fbp=fb_dev->map_fb;
-        uint16_t *imgbuf=egi_imgbuf->imgbuf;
-        unsigned char *alpha=egi_imgbuf->alpha;
-
-//        long int locfb=0; /* location of FB mmap, in pxiel, xxxxxbyte */
-        long int locimg=0; /* location of image buf, in pixel, xxxxin byte */
-//      int bytpp=2; /* bytes per pixel */
-
-  /* If FB position rotate 90deg or 270deg, swap xres and yres */
-  if(fb_dev->pos_rotate & 0x1) {	/* Landscape mode */
-	xres=fb_dev->vinfo.yres;
-	yres=fb_dev->vinfo.xres;
-  }
-  else {				/* Portrait mode */
-	xres=fb_dev->vinfo.xres;
-	yres=fb_dev->vinfo.yres;
-  }
-
-   /* pixel total number */
-   screen_pixels=xres*yres;
-
-  /* reset winh and winw */
-//  if( winh > yres) winh=yres;
-//  if( winw > xres) winw=xres;
-
-  /* if no alpha channle*/
-  if( egi_imgbuf->alpha==NULL )
-  {
-        for(i=0; i<winh; i++) {  /* row of the displaying window */
-                for(j=0; j<winw; j++) {
-
-			/* Rule out points which are out of the SCREEN boundary */
-			if( i+yw<0 || i+yw>yres-1 || j+xw<0 || j+xw>xres-1 )
-				continue;
-
-                        /* FB data location */
-//                        locfb = (i+yw)*xres+(j+xw);
-
-                     /*  ---- draw only within screen  ---- */
-//                     if( locfb>=0 && locfb <= (screen_pixels-1) ) {
-
-                        /* check if exceeds IMAGE(not screen) boundary */
-                        if( ( xp+j > imgw-1 || xp+j <0 ) || ( yp+i > imgh-1 || yp+i <0 ) )
-                        {
-//replaced by draw_dot()        *(uint16_t *)(fbp+locfb)=0; /* black for outside */
-
-				#if 0 /* 0- DO NOT draw outside pixels, for it will affect FB FILO */
-                                fbset_color2(fb_dev,0);     /* black for outside */
-                                draw_dot(fb_dev,j+xw,i+yw); /* call draw_dot */
-				#endif
-                        }
-                        else {
-                                /* image data location */
-                                locimg= (i+yp)*imgw+(j+xp);
-
-				if(subcolor<0) {
-	                                fbset_color2(fb_dev,imgbuf[locimg]);
-				}
-				else {  /* use subcolor */
-	                                fbset_color2(fb_dev,(uint16_t)subcolor);
-				}
-
-                                draw_dot(fb_dev,j+xw,i+yw); /* call draw_dot */
-                         }
-
-//                     } /* --- if within screen --- */
-
-                }
-        }
-  }
-  else /* with alpha channel */
-  {
-	//printf("----- alpha ON -----\n");
-        for(i=0;i<winh;i++)  { /* row of the displaying window */
-                for(j=0;j<winw;j++)  {
-
-			/* Rule out points which are out of the SCREEN boundary */
-			if( i+yw<0 || i+yw>yres-1 || j+xw<0 || j+xw>xres-1 )
-				continue;
-
-                        /* FB data location, in pixel */
-//                        locfb = (i+yw)*xres+(j+xw); /*in pixel,  2 bytes per pixel */
-
-                     /*  ---- draw_dot() only within screen  ---- */
-//                     if(  locfb>=0 && locfb<screen_pixels ) {
-
-                        /* check if exceeds IMAGE(not screen) boundary */
-                        if( ( xp+j > imgw-1 || xp+j <0 ) || ( yp+i > imgh-1 || yp+i <0 ) )
-                        {
-				#if 0 /* 0- DO NOT draw outside pixels, for it will affect FB FILO */
-                                fbset_color2(fb_dev,0); /* black for outside */
-                                draw_dot(fb_dev,j+xw,i+yw); /* call draw_dot */
-				#endif
-                        }
-                        else {
-                                /* image data location, 2 bytes per pixel */
-                                locimg= (i+yp)*imgw+(j+xp);
-
-                                if( alpha[locimg]==0 ) {   /* ---- 100% backgroud color ---- */
-                                        /* Transparent for background, do nothing */
-                                        //fbset_color2(fb_dev,*(uint16_t *)(fbp+(locfb<<1)));
-
-				    	/* for Virt FB ???? */
-                                }
-
-				else if(subcolor<0) {	/* ---- No subcolor ---- */
-#if 0  ///////////////////////////// replaced by fb.pxialpha ///////////////////////
-                                     if(alpha[locimg]==255) {    /* 100% front color */
-                                          fbset_color2(fb_dev,*(uint16_t *)(imgbuf+locimg));
-				     }
-                                     else {                           /* blend */
-                                          fbset_color2(fb_dev,
-                                              COLOR_16BITS_BLEND( *(uint16_t *)(imgbuf+locimg),   /* front pixel */
-                                                            *(uint16_t *)(fbp+(locfb<<1)),  /* background */
-                                                             alpha[locimg]  )               /* alpha value */
-                                             );
-                                     }
-#endif  ///////////////////////////////////////////////////////////////////////////
-				     fb_dev->pixalpha=alpha[locimg];
-				     fbset_color2(fb_dev,imgbuf[locimg]);
-                                     draw_dot(fb_dev,j+xw,i+yw);
-				}
-
-				else  {  		/* ---- use subcolor ----- */
-#if 0  ///////////////////////////// replaced by fb.pxialpha ////////////////////////
-                                    if(alpha[locimg]==255) {    /* 100% subcolor as front color */
-                                          fbset_color2(fb_dev,subcolor);
-				     }
-                                     else {                           /* blend */
-                                          fbset_color2(fb_dev,
-                                              COLOR_16BITS_BLEND( subcolor,   /* subcolor as front pixel */
-                                                            *(uint16_t *)(fbp+(locfb<<1)),  /* background */
-                                                             alpha[locimg]  )               /* alpha value */
-                                             );
-                                     }
-#endif  //////////////////////////////////////////////////////////////////////////
-				     fb_dev->pixalpha=alpha[locimg];
-				     fbset_color2(fb_dev,subcolor);
-                                     draw_dot(fb_dev,j+xw,i+yw);
-				}
-
-                            }
 
-//                        }  /* --- if within screen --- */
+	/* Clip the window to the screen and the image, nothing to display if fails. */
+	if( fb_blit_clip( fb_dev, fb_dev->pos_rotate, imgw, imgh, xp, yp, xw, yw,
+							winw, winh, true, &win ) != 0 ) {
+		pthread_mutex_unlock(&egi_imgbuf->img_mutex);
+		return 0;
+	}
 
-                } /* for() */
-        }/* for()  */
-  }/* end alpha case */
+	/* Blit row by row */
+	for(i=0; i<win.h; i++) {
+		locimg=(win.yp+i)*imgw+win.xp;
+		fb_blit_span( fb_dev, win.pos_rotate, win.xw, win.yw+i, win.w,
+			      egi_imgbuf->imgbuf+locimg,
+			      egi_imgbuf->alpha ? egi_imgbuf->alpha+locimg : NULL,
+			      subcolor );
+	}
 
-  /* put mutex lock */
-  pthread_mutex_unlock(&egi_imgbuf->img_mutex);
+	/* put mutex lock */
+	pthread_mutex_unlock(&egi_imgbuf->img_mutex);
 
-  return 0;
+	return 0;
 }
 
 
-
-#if 1 ////////////////////////// TODO: range limit check ///////////////////////////
 /*---------------------------------------------------------------------------------------
 For 16bits color only!!!!
 
-WARING:
-1. Writing directly to FB without calling draw_dot()!!!
-   FB_FILO, Virt_FB disabled!!!
-2. Take care of image boudary check and locfb check to avoid outrange points skipping
-   to next line !!!!
-3. No range limit check, which may cause segmentation fault!!!
-
 Note:
-1. No subcolor and write directly to FB, so FB FILO is ineffective !!!!!
-2. FB.pos_rotate is NOT supported.
-3. Write image data of an EGI_IMGBUF to a window in FB.
+1. No subcolor and FB FILO is ineffective !!!!!
+2. FB.pos_rotate is NOT supported, (xw,yw) is in raw FB coordinates.
+3. Write image data of an EGI_IMGBUF to a window in FB, row by row through fb_blit_span().
 4. Set outside color as black.
 5. window(xw, yw) defines a looking window to the original picture, (xp,yp) is the left_top
    start point of the window. If the looking window covers area ouside of the picture,then
@@ -1888,8 +1771,6 @@ fb_dev:		FB device
                 the coordinate system of the picture(also origin at left top).
 (xw,yw):        displaying window origin, relate to the LCD coord system.
 winw,winh:      width and height(row/column for fb) of the displaying window.
-                !!! Note: You'd better set winw,winh not exceeds acutual LCD size, or it will
-                waste time calling draw_dot() for pixels outsie FB zone.
 
 Return:
 		0	OK
@@ -1898,21 +1779,25 @@ Return:
 int egi_imgbuf_windisplay2(EGI_IMGBUF *egi_imgbuf, FBDEV *fb_dev,
 			   		int xp, int yp, int xw, int yw, int winw, int winh)
 {
+	FB_BLITWIN win;
+	long int locimg; /* location of image buf, in pixel */
+	int i;
+	int y;
+	int xs, xe;	/* image span [xs xe), relative to the window */
+
         /* check data */
-        if(egi_imgbuf == NULL)
+        if(egi_imgbuf == NULL || egi_imgbuf->imgbuf == NULL )
         {
                 printf("%s: egi_imgbuf is NULL. fail to display.\n",__func__);
                 return -1;
         }
 
-
 	/* get mutex lock */
 	if( pthread_mutex_lock(&egi_imgbuf->img_mutex)!=0 ){
 		printf("%s: Fail to lock image mutex!\n",__func__);
 		return -2;
 	}
 
-
         int imgw=egi_imgbuf->width;     /* image Width and Height */
         int imgh=egi_imgbuf->height;
         if( imgw<0 || imgh<0 )
@@ -1922,125 +1807,45 @@ int egi_imgbuf_windisplay2(EGI_IMGBUF *egi_imgbuf, FBDEV *fb_dev,
                 return -3;
         }
 
-        int i,j;
-        int xres=fb_dev->vinfo.xres;
-        int yres=fb_dev->vinfo.yres;
-        long int screen_pixels=xres*yres;
-
-	#ifdef ENABLE_BACK_BUFFER
-        unsigned char *fbp =fb_dev->map_bk;
-	#else
-        unsigned char *fbp =fb_dev->map_fb;
-	#endif
-
-        uint16_t *imgbuf = egi_imgbuf->imgbuf;
-        unsigned char *alpha=egi_imgbuf->alpha;
-        long int locfb=0; /* location of FB mmap, in pxiel, xxxxxbyte */
-        long int locimg=0; /* location of image buf, in pixel, xxxxin byte */
-//      int bytpp=2; /* bytes per pixel */
-
-
-  /* if no alpha channle*/
-  if( egi_imgbuf->alpha==NULL )
-  {
-        for(i=0;i<winh;i++) {  /* row of the displaying window */
-                for(j=0;j<winw;j++) {
-
-			/* Rule out points which are out of the SCREEN boundary */
-			if( i+yw<0 || i+yw>yres-1 || j+xw<0 || j+xw>xres-1 )
-				continue;
+	/* Clip the window to the screen only, area out of the image will be filled with black. */
+	if( fb_blit_clip( fb_dev, 0, imgw, imgh, xp, yp, xw, yw, winw, winh, false, &win ) != 0 ) {
+		pthread_mutex_unlock(&egi_imgbuf->img_mutex);
+		return 0;
+	}
 
-                        /* FB data location */
-                        locfb = (i+yw)*xres+(j+xw);
-
-                        /* check if exceed image boundary */
-                        if( ( xp+j > imgw-1 || xp+j <0 ) || ( yp+i > imgh-1 || yp+i <0 ) )
-                        {
-				#ifdef LETS_NOTE /*--- 4 bytes per pixel ---*/
-				*(uint32_t *)(fbp+(locfb<<2))=0;
-				#else		/*--- 2 bytes per pixel ---*/
-			        *(uint16_t *)(fbp+(locfb<<1))=0; /* black for outside */
-				#endif
-                        }
-                        else {
-                                /* image data location */
-                                locimg= (i+yp)*imgw+(j+xp);
-				#ifdef LETS_NOTE /*--- 4 bytes per pixel ---*/
-	         		*(uint32_t *)(fbp+(locfb<<2))=COLOR_16TO24BITS(*(imgbuf+locimg))+(255<<24);
-				#else		/*--- 2 bytes per pixel ---*/
-			         *(uint16_t *)(fbp+(locfb<<1))=*(uint16_t *)(imgbuf+locimg);
-				#endif
-
-                            }
-                }
-        }
-  }
-  else /* with alpha channel */
-  {
-        for(i=0;i<winh;i++)  { /* row of the displaying window */
-                for(j=0;j<winw;j++)  {
-
-			/* Rule out points which are out of the SCREEN boundary */
-			if( i+yw<0 || i+yw>yres-1 || j+xw<0 || j+xw>xres-1 )
-				continue;
+	/* Image span in the window, same for all rows */
+	xs= win.xp<0 ? -win.xp : 0;
+	xe= imgw-win.xp < win.w ? imgw-win.xp : win.w;
+	if(xe<xs)
+		xe=xs;
 
-                        /* FB data location, in pixel */
-                        locfb = (i+yw)*xres+(j+xw); /*in pixel,  2 bytes per pixel */
-
-                        if( ( xp+j > imgw-1 || xp+j <0 ) || ( yp+i > imgh-1 || yp+i <0 ) )
-                        {
-				#ifdef LETS_NOTE /*--- 4 bytes per pixel ---*/
-				*(uint32_t *)(fbp+(locfb<<2))=0;
-				#else		/*--- 2 bytes per pixel ---*/
-       				*(uint16_t *)(fbp+(locfb<<1))=0;   /* black */
-				#endif
-                        }
-                        else {
-                            /* image data location, 2 bytes per pixel */
-                            locimg= (i+yp)*imgw+(j+xp);
-
-                            /*  ---- draw only within screen  ---- */
-                            if( locfb>=0 && locfb <= (screen_pixels-1) ) {
-
-                                if(alpha[locimg]==0) {           /* use backgroud color */
-                                        /* Transparent for background, do nothing */
-                                        //fbset_color2(fb_dev,*(uint16_t *)(fbp+(locfb<<1)));
-                                }
-
-			     #ifdef LETS_NOTE   /* ------- 4 bytes per pixel ------ */
-                                else if(alpha[locimg]==255) {    /* use front color */
-	         		       *(uint32_t *)(fbp+(locfb<<2))=COLOR_16TO24BITS(*(imgbuf+locimg)) \
-												+(255<<24);
-				}
-                                else {                           /* blend */
-				       *(uint32_t *)(fbp+(locfb<<2))=COLOR_16TO24BITS(*(imgbuf+locimg))	\
-										     +(alpha[locimg]<<24);
-				}
+	/* FB FILO is ineffective here, fb_dev->filo_on is left untouched for other writers */
+	for(i=0; i<win.h; i++) {
+		y=win.yw+i;
 
-			     #else 		/* ------ 2 bytes per pixel ------- */
-                                else if(alpha[locimg]==255) {    /* use front color */
-			               *(uint16_t *)(fbp+(locfb<<1))=*(uint16_t *)(imgbuf+locimg);
-				}
-                                else {                           /* blend */
-                                            *(uint16_t *)(fbp+(locfb<<1))= COLOR_16BITS_BLEND(
-							*(uint16_t *)(imgbuf+locimg),   /* front pixel */
-                                                        *(uint16_t *)(fbp+(locfb<<1)),  /* background */
-                                                        alpha[locimg]  );               /* alpha value */
-				}
+		/* Out of image rows */
+		if( win.yp+i<0 || win.yp+i>imgh-1 || xs==xe ) {
+			fb_blit_span(fb_dev, FB_BLIT_NOFILO, win.xw, y, win.w, NULL, NULL, 0);  /* black */
+			continue;
+		}
 
-			    #endif /*  <<< end 4/2 Bpp select  >>> */
-                            }
-                       } /* if  within screen */
-                } /* for() */
-        }/* for()  */
-  }/* end alpha case */
+		/* Left and right side out of image */
+		if( xs>0 )
+			fb_blit_span(fb_dev, FB_BLIT_NOFILO, win.xw, y, xs, NULL, NULL, 0);
+		if( xe<win.w )
+			fb_blit_span(fb_dev, FB_BLIT_NOFILO, win.xw+xe, y, win.w-xe, NULL, NULL, 0);
 
-  /* put mutex lock */
-  pthread_mutex_unlock(&egi_imgbuf->img_mutex);
+		locimg=(win.yp+i)*imgw+win.xp+xs;
+		fb_blit_span( fb_dev, FB_BLIT_NOFILO, win.xw+xs, y, xe-xs,
+			      egi_imgbuf->imgbuf+locimg,
+			      egi_imgbuf->alpha ? egi_imgbuf->alpha+locimg : NULL, -1 );
+	}
 
-  return 0;
+	/* put mutex lock */
+	pthread_mutex_unlock(&egi_imgbuf->img_mutex);
+
+	return 0;
 }
-#endif ///////////////////////////////////////////////////////////////////////
 
 
 /*-----------------------------------------------------------------------------------
@@ -52,7 +52,12 @@ EGI_IMGBUF*	egi_imgbuf_newFrameImg( int height, int width,
                         	     enum imgframe_type type,
                                      int pn, const int *param );
 
- /* use 2D array ineimg->pcolors(palphas) */
+/* Separable box filter with running sums, O(1) for each pixel */
+#define EGI_BOXBLUR_MAXRADIUS	4095	/* keep fix point sums in 32bits */
+#define EGI_BOXBLUR_STRIP	16	/* columns filtered in one strip */
+int	egi_imgbuf_blur_box(EGI_IMGBUF *eimg, const EGI_IMGBUF *srcimg, int radius, int passes, bool alpha_on);
+
+ /* hold_on: keep results in 2D array ineimg->pcolors(palphas) */
 EGI_IMGBUF  *egi_imgbuf_avgsoft( EGI_IMGBUF *ineimg, int size, bool alpha_on, bool hold_on);
 /***
  * Function same as egi_imgbuf_avgsoft(), but without allocating  additional
@@ -61,9 +66,12 @@ EGI_IMGBUF  *egi_imgbuf_avgsoft( EGI_IMGBUF *ineimg, int size, bool alpha_on, bo
 EGI_IMGBUF  *egi_imgbuf_avgsoft2(const EGI_IMGBUF *ineimg, int size, bool alpha_on); /* use 1D array data */
 //EGI_IMGBUF  *egi_imgbuf_resize(const EGI_IMGBUF *ineimg, unsigned int width, unsigned int height);
 EGI_IMGBUF  *egi_imgbuf_resize(const EGI_IMGBUF *ineimg, int width, int height);
+int	egi_imgbuf_resize_into(EGI_IMGBUF *outeimg, const EGI_IMGBUF *ineimg);
 int 	egi_imgbuf_blur_update(EGI_IMGBUF **pimg, int size, bool alpha_on);
 int 	egi_imgbuf_resize_update(EGI_IMGBUF **pimg, unsigned int width, unsigned int height);
 int	egi_imgbuf_blend_imgbuf(EGI_IMGBUF *eimg, int xb, int yb, const EGI_IMGBUF *addimg );
+int	egi_imgbuf_rotsize(const EGI_IMGBUF *eimg, int angle, int *height, int *width);
+int	egi_imgbuf_rotate_into(EGI_IMGBUF *outimg, const EGI_IMGBUF *eimg, int angle, bool bilinear);
 EGI_IMGBUF* egi_imgbuf_rotate(EGI_IMGBUF *eimg, int ang);
 int 	egi_imgbuf_rotate_update(EGI_IMGBUF **eimg, int angle);
 
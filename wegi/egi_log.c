@@ -7,38 +7,52 @@ published by the Free Software Foundation.
 Try to write a thread_safe log system. :))))
 
 1. Run egi_init_log() first to initiliaze log porcess.
-   A egi_log_thread_write() then will be running as a log checking thread, It monitors
-   log_buff_count, and write log_buff[] items into log file if the counter>0.
+   A egi_log_thread_write() then will be running as a log writing thread, it drains log
+   rings of all threads and writes them into log file.
 
-2. Other threads just push log string into log_buff by calling egi_push_log().
-   High level log string (>= LOGLV_NOBUFF_THRESHOLD) will be wirtten directly to log file without
-   pushing to log_buff. So critical debug information will be recorded even if process exits abruptly
-   just after egi_push_log() operation.
+2. Other threads just push log string by calling egi_push_log().
+   Each thread pushes into its own log ring, which is a lock-free SPSC(single producer and single
+   consumer) byte ring, so threads never contend for a lock when logging.
+   A log record takes exactly its string length in the ring, records are NOT cut into fixed slots.
+   High level log string (>= LOGLV_NOBUFF_THRESHOLD) will be written directly to log file by one
+   write(), without pushing to log rings. So critical debug information will be recorded even if
+   process exits abruptly just after egi_push_log() operation.
 
-3. Call egi_quit_log() finally to end egi log process. Before that, you'd better
+3. The write thread drains all rings with one writev() for each batch. It sleeps adaptively:
+   EGI_LOG_WRITE_MINGAP after a busy batch, then doubled each idle round up to EGI_LOG_WRITE_MAXGAP.
+   A producer wakes it up when its ring is over half full.
+
+4. If a ring is full, the log string is dropped and counted, NOT written synchronously by the
+   caller thread. The write thread notes number of dropped logs in log file.
+
+5. Log levels not in egi_log_levels are returned at once, before any formatting.
+   Call egi_log_set_levels() to change it.
+
+6. Call egi_quit_log() finally to end egi log process. Before that, you'd better
    wait for a while to let other threads finish in_hand log pushing jobs.
    Set EGI_LOG_QUITWAIT for default wait time before quit.
 
-4. In egi_push_log() you can turn on print for the pushing log information.
+7. In egi_push_log() you can turn on print for the pushing log information.
 
-5. setbuf() to NULL, so we use log_buff[] instead of system buffer.
+8. When a thread exits, its log ring is released after it's drained by the write thread.
+   If all EGI_LOG_MAX_RINGS rings are taken, other threads share a ring under log_share_mutex.
+
+9. egi_push_log() holds log_rwlock for read while it writes the log file or pushes a ring,
+   egi_quit_log() takes it for write to close the log file and free log rings.
 
 
 Note:
-1. log_buff_mutex will not be destroyed after egi_quit_log().
-2. Log items are not written sorted by time, because of buff FILO and thread operation.
-3. Give log string a '/n' and makes fprint flush immediately.
+1. Log items from different threads are not written sorted by time.
+2. Give log string a '/n' and makes fprint flush immediately.
 
 TODO:
 0. TO add __FILE__, __FUNCTION__ at EGI_PLOG() macro.
 1. egi_init_log() can be called only once! It's NOT reentrant!!!!
-   !!! consider to destroy and re-initiliate log_buff_mutex. !!!
 2. sort lof_buff by time. 	--- Not necessary
 3. egi_push_log() after when egi_quit_log(), must wait for all egi_push_log(). --- Not necessary.
-4. Be ware of system buffer for file write,print,..etc.
-5. Fail to use access() to check file existance.
+4. Fail to use access() to check file existance.
 
-6. A rush of (big) data writing may cause SD card unmount ????
+5. A rush of (big) data writing may cause SD card unmount ????
 
 
 Midas Zhou
@@ -51,20 +65,44 @@ Midas Zhou
 #include <stdarg.h> /* va_list, va_start */
 #include <pthread.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/uio.h> /* writev() */
 #include "egi_log.h"
 #include "egi_timer.h"
 #include "egi_utils.h"
 
+/* A per-thread log ring, SPSC: the owner thread pushes, the write thread drains. */
+typedef struct egi_log_ring {
+	char		buff[EGI_LOG_RING_SIZE];
+	unsigned int	head;		/* write position, only modified by producer, free running */
+	unsigned int	tail;		/* read position, only modified by the write thread, free running */
+	unsigned int	dropped;	/* number of dropped logs, as ring is full */
+	int		state;		/* LOGRING_FREE, LOGRING_USED, or LOGRING_CLOSING */
+} EGI_LOG_RING;
+
+enum {
+	LOGRING_FREE=0,
+	LOGRING_USED,
+	LOGRING_CLOSING,	/* owner thread exits, free it after drained */
+};
+
 static pthread_t log_write_thread;
 
-/* NOT APPLIED YET!:  following variables to be mutex lock protected  by log_buff_mutex */
-static pthread_mutex_t log_buff_mutex;
-static FILE *egi_log_fp; /* log_buff_mutex lock */
-static unsigned char **log_buff;  /* log_buff_mutex lock */
-/* !!! WARNING !!! use volatile to disable compiler optimization to avoid mutex_lock failure */
-volatile static int log_buff_count; /* count number, or number of the first available log buff,log_buffer_mutex lock */
-volatile static bool log_is_running; /* log_buff_mutex lock */
-//static bool write_thread_running;
+static int egi_log_fd=-1; 	/* log file */
+static EGI_LOG_RING *log_rings;	/* [EGI_LOG_MAX_RINGS+1], the last one is shared */
+static pthread_key_t log_ring_key;
+static pthread_once_t log_key_once=PTHREAD_ONCE_INIT;
+static pthread_mutex_t log_share_mutex=PTHREAD_MUTEX_INITIALIZER; /* for producers of the shared ring */
+static pthread_rwlock_t log_rwlock=PTHREAD_RWLOCK_INITIALIZER;	/* egi_log_fd and log_rings, against egi_quit_log() */
+
+/* for adaptive wakeup of the write thread */
+static pthread_mutex_t log_wake_mutex=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_wake_cond;
+
+/* !!! WARNING !!! use volatile to disable compiler optimization */
+volatile static bool log_is_running;
+volatile int egi_log_levels=DEFAULT_LOG_LEVELS;	/* log levels effective in egi_push_log() */
 
 
 /*-----------------------------------------------------------------
@@ -87,20 +125,141 @@ static inline const char *egi_loglv_to_string(enum egi_log_level log_level)
 	return "LOGLV_Unknown";
 }
 
+
+/*------------------------------------------------------
+Set log levels effective in egi_push_log(), logs of other
+levels are returned at once without formatting.
+@levels:  OR of enum egi_log_level.
+------------------------------------------------------*/
+void egi_log_set_levels(int levels)
+{
+	egi_log_levels=levels;
+}
+
+/*------------------------------------------------------
+Get total number of dropped logs, as log rings are full.
+------------------------------------------------------*/
+unsigned int egi_log_dropped(void)
+{
+	unsigned int i, cnt=0;
+
+	pthread_rwlock_rdlock(&log_rwlock);
+	if(log_rings!=NULL) {
+		for(i=0; i<EGI_LOG_MAX_RINGS+1; i++)
+			cnt+=__atomic_load_n(&log_rings[i].dropped, __ATOMIC_RELAXED);
+	}
+	pthread_rwlock_unlock(&log_rwlock);
+
+	return cnt;
+}
+
+/* Check if pring is one of current log rings, it may be left over from a quit log process */
+static inline bool egi_log_ring_valid(const EGI_LOG_RING *pring)
+{
+	return log_rings!=NULL && pring>=log_rings && pring<=&log_rings[EGI_LOG_MAX_RINGS];
+}
+
+/* Destructor of log_ring_key, called when a thread exits */
+static void egi_log_release_ring(void *ring)
+{
+	EGI_LOG_RING *pring=(EGI_LOG_RING *)ring;
+
+	pthread_rwlock_rdlock(&log_rwlock);
+	if( egi_log_ring_valid(pring) && pring!=&log_rings[EGI_LOG_MAX_RINGS] )
+		__atomic_store_n(&pring->state, LOGRING_CLOSING, __ATOMIC_RELEASE);
+	pthread_rwlock_unlock(&log_rwlock);
+}
+
+static void egi_log_create_key(void)
+{
+	pthread_key_create(&log_ring_key, egi_log_release_ring);
+}
+
+/*---------------------------------------------------------
+Get log ring of the caller thread, take a free one at its
+first call. If all rings are used, return the shared one.
+Call it with log_rwlock held for read.
+---------------------------------------------------------*/
+static EGI_LOG_RING *egi_log_get_ring(void)
+{
+	EGI_LOG_RING *pring;
+	int i;
+	int state;
+
+	pring=pthread_getspecific(log_ring_key);
+	if(pring!=NULL && egi_log_ring_valid(pring))
+		return pring;
+	pring=NULL;
+
+	for(i=0; i<EGI_LOG_MAX_RINGS; i++) {
+		state=LOGRING_FREE;
+		if( __atomic_compare_exchange_n(&log_rings[i].state, &state, LOGRING_USED, false,
+							__ATOMIC_ACQUIRE, __ATOMIC_RELAXED) ) {
+			pring=&log_rings[i];
+			break;
+		}
+	}
+	if(pring==NULL)
+		pring=&log_rings[EGI_LOG_MAX_RINGS]; /* the shared one */
+
+	pthread_setspecific(log_ring_key, pring);
+	return pring;
+}
+
+/*----------------------------------------------------------
+Push a log string into a ring.
+Return:
+	>=0	OK, bytes used in the ring after push.
+	<0	Ring is full, log string is dropped.
+----------------------------------------------------------*/
+static int egi_log_ring_push(EGI_LOG_RING *pring, const char *str, unsigned int len)
+{
+	unsigned int head, tail;
+	unsigned int pos, n;
+
+	head=pring->head; /* only this thread modifies head */
+	tail=__atomic_load_n(&pring->tail, __ATOMIC_ACQUIRE);
+
+	if( EGI_LOG_RING_SIZE-(head-tail) < len ) {
+		__atomic_add_fetch(&pring->dropped, 1, __ATOMIC_RELAXED);
+		return -1;
+	}
+
+	/* copy, may wrap around the end */
+	pos=head&(EGI_LOG_RING_SIZE-1);
+	n= EGI_LOG_RING_SIZE-pos < len ? EGI_LOG_RING_SIZE-pos : len;
+	memcpy(pring->buff+pos, str, n);
+	if(n<len)
+		memcpy(pring->buff, str+n, len-n);
+
+	/* publish the record */
+	__atomic_store_n(&pring->head, head+len, __ATOMIC_RELEASE);
+
+	return head+len-tail;
+}
+
+/* Wake up the write thread */
+static inline void egi_log_wakeup(void)
+{
+	pthread_mutex_lock(&log_wake_mutex);
+	pthread_cond_signal(&log_wake_cond);
+	pthread_mutex_unlock(&log_wake_mutex);
+}
+
 /*---------------------------------------------------------------------------------------
-1. For high level log(>LOGLV_WARN),it will be written directly to log file with nobuffer.
-2. Otherwise, push log string to log_buff[] and wait for write_thread to
+1. Logs of levels not in egi_log_levels are ignored before formatting.
+2. For high level log(>=LOGLV_NOBUFF_THRESHOLD),it will be written directly to log file by
+   one write(), only with log_rwlock held for read.
+3. Otherwise, push log string to the caller thread's log ring and let write_thread to
    write to log file later.
-3. Log string that exceeds length of log_buff[] will be trimmed to EGI_LOG_MAX_ITEMLEN-1.
-4. Do NOT put code '\n' at user input log string, just let egi_push_log() to put it after
+4. Log string that exceeds EGI_LOG_MAX_ITEMLEN will be trimmed to EGI_LOG_MAX_ITEMLEN-1.
+5. Do NOT put code '\n' at user input log string, just let egi_push_log() to put it after
    attrReset! otherwise attrReset will be ineffective!
 
-TODO: check log string total length!!!
-
 return:
 	0	OK
 	<0	Fails
-	>0	Log buff is full.
+	>0	Log ring is full, log string is dropped.
 --------------------------------------------------------------------------------------*/
 int egi_push_log(enum egi_log_level log_level, const char *fmt, ...)
 {
@@ -146,16 +305,30 @@ int egi_push_log(enum egi_log_level log_level, const char *fmt, ...)
 	const char *pattrcolor=NULL;
 
 	char strlog[EGI_LOG_MAX_ITEMLEN]={0}; /* for temp. use */
-	struct tm *tm;
+	struct tm tm;
+	time_t t;
 	int tmlen;
+	EGI_LOG_RING *pring;
+	int ret;
+
+	/* Fast path: skip formatting for ineffective levels */
+	if( !(log_level & egi_log_levels) )
+		return 0;
+
+	/* check if log_is_running, check again under log_rwlock before using log file or rings */
+	if(!log_is_running)
+	{
+		printf("%s(): egi log is not running! try egi_init_log() first. \n",__FUNCTION__);
+		return -1;
+	}
 
 	/* get extended parameters */
 	va_list arg;
 	va_start(arg,fmt);/* ----- start of extracting extended parameters to arg ... */
 
-	/* get time stamp */
-	time_t t=time(NULL);
-	tm=localtime(&t);
+	/* get time stamp, localtime() is NOT thread safe */
+	t=time(NULL);
+	localtime_r(&t, &tm);
 
 	/* set log consol output color */
 	switch(log_level) {
@@ -181,191 +354,241 @@ int egi_push_log(enum egi_log_level log_level, const char *fmt, ...)
 			pattrcolor=attrReset;
 	}
 
-	/* Clear,seems not necessary */
-	// memset(strlog,0,sizeof(strlog));
-
 	/* SET CONSOLE COLOR >>>>>,  and prepare time stamp string and log_level. */
-	sprintf(strlog, "%s[%d-%02d-%02d %02d:%02d:%02d] [%s] ", pattrcolor,
-				tm->tm_year+1900,tm->tm_mon+1,tm->tm_mday,tm->tm_hour, tm->tm_min,tm->tm_sec,
+	tmlen=snprintf(strlog, EGI_LOG_MAX_ITEMLEN, "%s[%d-%02d-%02d %02d:%02d:%02d] [%s] ", pattrcolor,
+				tm.tm_year+1900,tm.tm_mon+1,tm.tm_mday,tm.tm_hour, tm.tm_min,tm.tm_sec,
 				egi_loglv_to_string(log_level) );
-	//printf("time string for strlog: %s \n",strlog);
 
 	/* push log string into temp. strlog */
-	tmlen=strlen(strlog);
 	vsnprintf(strlog+tmlen, EGI_LOG_MAX_ITEMLEN-tmlen-1, fmt, arg); /* -1 for /0 */
 
 	/* <<<<< RESET CONSOLE COLOR to default */
 	tmlen=strlen(strlog); /* new length with log string */
-	if( EGI_LOG_MAX_ITEMLEN-tmlen-1 < strlen(attrReset) )
+	if( EGI_LOG_MAX_ITEMLEN-tmlen-1 < strlen(attrReset)+1 ) {
 		fprintf(stderr, "\e[31m %s  ---- WARNING: log message truncated! ---\e[0m\n",__func__);
-	snprintf(strlog+tmlen, EGI_LOG_MAX_ITEMLEN-tmlen-1, "%s\n", attrReset); /* -1 for /0 */
+		/* keep room for attrReset and '\n' */
+		tmlen=EGI_LOG_MAX_ITEMLEN-1-strlen(attrReset)-1;
+	}
+	tmlen+=snprintf(strlog+tmlen, EGI_LOG_MAX_ITEMLEN-tmlen, "%s\n", attrReset);
 
 #ifdef ENABLE_LOGBUFF_PRINT
-	//printf("EGI_Logger: %s",strlog);
 	printf("%s",strlog); /* no '/n', Let log caller to decide return token */
 #endif
 	va_end(arg); /* ----- end of extracting extended parameters ... */
 
-#if 0///////////////////////////////////////////////////////////////////////////////////
-	///////   FOR HIGHT LEVEL LOG:  write directly to log file //////
+	/* egi_quit_log() may close log file and free rings meanwhile */
+	pthread_rwlock_rdlock(&log_rwlock);
+	if(!log_is_running || egi_log_fd<0)
+	{
+		pthread_rwlock_unlock(&log_rwlock);
+		return -1;
+	}
+
+	///////   FOR HIGH LEVEL LOG:  write directly to log file //////
 	if(log_level >= LOGLV_NOBUFF_THRESHOLD)
 	{
-		if( fprintf(egi_log_fp,"%s",strlog) < 0 )
+		/* one write() to a O_APPEND file, it will not be interleaved with others */
+		ret=write(egi_log_fd, strlog, tmlen);
+		pthread_rwlock_unlock(&log_rwlock);
+		if( ret < 0 )
 		{
 			printf("egi_push_log(): fail to write strlog to log file.\n");
 			return -1;
 		}
-
 		return 0;
 	}
-#endif//////////////////////////////////////////////////////////////////////////////////
-
-   	/* get mutex lock */
-   	if(pthread_mutex_lock(&log_buff_mutex) != 0)
-   	{
-		printf("egi_quit_log():fail to get mutex lock.\n");
-		return -1;
-   	}
 
- /* -------------- entering critical zone ---------------- */
-	/* check if log_is_running */
-	if(!log_is_running)
-	{
-		printf("%s(): egi log is not running! try egi_init_log() first. \n",__FUNCTION__);
-		pthread_mutex_unlock(&log_buff_mutex);
-		return -1;
+	///////   FOR NORMAL LEVEL LOG: push to the thread's ring ////////
+	pring=egi_log_get_ring();
+	if(pring==&log_rings[EGI_LOG_MAX_RINGS]) {
+		pthread_mutex_lock(&log_share_mutex);
+		ret=egi_log_ring_push(pring, strlog, tmlen);
+		pthread_mutex_unlock(&log_share_mutex);
 	}
+	else
+		ret=egi_log_ring_push(pring, strlog, tmlen);
+	pthread_rwlock_unlock(&log_rwlock);
 
-	///////   FOR HIGHT LEVEL LOG:  write directly to log file //////
-	if(log_level >= LOGLV_NOBUFF_THRESHOLD)
-	{
-		if( fprintf(egi_log_fp,"%s",strlog) < 0 )
-		{
-			printf("egi_push_log(): fail to write strlog to log file.\n");
-			return -1;
-		}
+	if(ret<0)
+		return 1;  /* Ring is full, dropped */
 
-		pthread_mutex_unlock(&log_buff_mutex);
+	/* wake up write thread if the ring is over half full */
+	if(ret > EGI_LOG_RING_SIZE/2)
+		egi_log_wakeup();
 
-		return 0;
+   	return 0;
+}
+
+
+/*--------------------------------------------------------
+Drain all log rings to log file, with one writev().
+Each ring gives 1 or 2 segments, as data may wrap around.
+For a short writev(), each ring tail advances only by its
+bytes written, the rest is written in next round.
+
+Return:
+	>=0	bytes written.
+	<0	Fails
+---------------------------------------------------------*/
+static int egi_log_drain(void)
+{
+	static unsigned int last_dropped;
+	struct iovec iov[2*(EGI_LOG_MAX_RINGS+1)+1];
+	int iovring[2*(EGI_LOG_MAX_RINGS+1)+1];	/* ring index of each iov, -1 for strdrop */
+	unsigned int tails[EGI_LOG_MAX_RINGS+1];
+	unsigned int heads[EGI_LOG_MAX_RINGS+1];
+	unsigned int head, tail, pos, len;
+	unsigned int dropped;
+	char strdrop[64];
+	int i, niov=0;
+	ssize_t ret;
+	size_t left, n;
+
+	/* note dropped logs */
+	dropped=egi_log_dropped();
+	if(dropped!=last_dropped) {
+		len=snprintf(strdrop, sizeof(strdrop), "--- %u log(s) dropped, log rings are full! ---\n",
+										dropped-last_dropped);
+		iov[niov].iov_base=strdrop;
+		iov[niov].iov_len=len;
+		iovring[niov]=-1;
+		niov++;
 	}
-	///////   FOR NORMAL LEVEL LOG: push to puff 		 ////////
-	else
-	{
-		/* check if log_buff overflow */
-		if(log_buff_count>EGI_LOG_MAX_BUFFITEMS-1)
-		{
-			printf("egi_push_log(): log_buff[] is full, fail to push strlog, unlock mutex and return...\n");
-			pthread_mutex_unlock(&log_buff_mutex);
-			return 1;
+
+	for(i=0; i<EGI_LOG_MAX_RINGS+1; i++) {
+		tail=log_rings[i].tail;
+		head=__atomic_load_n(&log_rings[i].head, __ATOMIC_ACQUIRE);
+		tails[i]=tail;
+		heads[i]=head;
+		if(head==tail)
+			continue;
+
+		/* [tail, head), maybe 2 segments */
+		pos=tail&(EGI_LOG_RING_SIZE-1);
+		len=head-tail;
+		if(pos+len > EGI_LOG_RING_SIZE) {
+			iov[niov].iov_base=log_rings[i].buff+pos;
+			iov[niov].iov_len=EGI_LOG_RING_SIZE-pos;
+			iovring[niov]=i;
+			niov++;
+			len-=EGI_LOG_RING_SIZE-pos;
+			pos=0;
 		}
+		iov[niov].iov_base=log_rings[i].buff+pos;
+		iov[niov].iov_len=len;
+		iovring[niov]=i;
+		niov++;
+	}
 
-		/* copy log string to log_buf */
-	/*
-		printf("egi_push_log(): start strncpy...  log_buff_count=%d, strlen(strlog)=%d\n",
-									log_buff_count, strlen(strlog) );
-	*/
-		memset(log_buff[log_buff_count],0,EGI_LOG_MAX_ITEMLEN); /* clear buff item */
-		strncpy((char *)log_buff[log_buff_count],strlog,strlen(strlog)); /* copy to log_buff */
+	if(niov==0)
+		return 0;
+
+	ret=writev(egi_log_fd, iov, niov);
 
-		/* increase count */
-		log_buff_count++;
+	/* advance tails by bytes written, in order of iovs. If writev() fails, release all
+	 * space to producers, so they'll not be blocked.
+	 */
+	left= ret<0 ? (size_t)-1 : (size_t)ret;
+	for(i=0; i<niov && left>0; i++) {
+		n= iov[i].iov_len < left ? iov[i].iov_len : left;
+		if(iovring[i]<0) {
+			if(n==iov[i].iov_len)
+				last_dropped=dropped;
+		}
+		else
+			tails[iovring[i]]+=n;
+		left-=n;
+	}
+	if(ret<0) {
+		for(i=0; i<EGI_LOG_MAX_RINGS+1; i++)
+			tails[i]=heads[i];
 	}
 
-	/* put mutex lock */
-   	pthread_mutex_unlock(&log_buff_mutex);
+	for(i=0; i<EGI_LOG_MAX_RINGS+1; i++) {
+		__atomic_store_n(&log_rings[i].tail, tails[i], __ATOMIC_RELEASE);
 
- /* -------------- exiting critical zone ---------------- */
+		/* free the ring of an exited thread, after it's drained */
+		if( __atomic_load_n(&log_rings[i].state, __ATOMIC_ACQUIRE)==LOGRING_CLOSING
+		    && __atomic_load_n(&log_rings[i].head, __ATOMIC_ACQUIRE)==tails[i] )
+			__atomic_store_n(&log_rings[i].state, LOGRING_FREE, __ATOMIC_RELEASE);
+	}
 
-   	return 0;
+	return ret;
 }
 
 /*--------------------------------------------
-It's a thread function, running detached????
+It's a thread function.
 Note
 1. exits when log_is_running is false.
-2. flush log file before exit.
+2. drain all rings before exit.
 -------------------------------------------*/
 static void egi_log_thread_write(void)
 {
-	int i;
+	struct timespec ts;
+	int gap=EGI_LOG_WRITE_MINGAP; /* in ms */
+	int ret;
 
 	/* check log file */
-  	if(egi_log_fp==NULL)
+  	if(egi_log_fd<0)
   	{
-		printf("egi_log_thread_write(): Log file is not open, egi_log_fp is NULL.\n");
-		return;
-  	}
-	/* check log_buff */
-  	if(log_buff==NULL || log_buff[EGI_LOG_MAX_BUFFITEMS-1]==NULL)
-  	{
-		printf("egi_log_thread_write(): log_buff is NULL.\n");
+		printf("egi_log_thread_write(): Log file is not open.\n");
 		return;
   	}
 
-	/* loop checking and write log buff to log file */
+	/* loop checking and write log rings to log file */
   	while(1)
   	{
-		/* get buff lock */
-		if(pthread_mutex_lock(&log_buff_mutex) != 0)
+		ret=egi_log_drain();
+		if(ret<0)
 		{
-			printf("egi_log_thread_write():fail to get mutex lock.\n");
-			tm_delayms(25);
-			continue;
-			//return;
-		}
-
-	 /* -------------- entering critical zone ---------------- */
-
-		/* write log buff items to log file */
-		if(log_buff_count>0)
-		{
-			for(i=0;i<log_buff_count;i++)
+			printf("egi_log_thread_write(): fail to write log rings to log file!\n");
+			/* in case that log file is corrupted */
+			if( access(EGI_LOGFILE_PATH,F_OK) !=0 )
 			{
-				//printf("egi_log_thread_write(): start fprintf() log_buff[%d]: %s \n",	i, log_buff[i] );
-				if( fprintf(egi_log_fp,"%s",log_buff[i]) < 0 )
-				{
-					printf("egi_log_thread_write(): fail to write log_buff[] to log file!\n");
-					/* in case that log file is corrupted */
-					if( access(EGI_LOGFILE_PATH,F_OK) !=0 )
-					{
-						printf("egi_log_thread_write(): log file %s dose NOT exist. exit thread...\n",EGI_LOGFILE_PATH);
-						/* reset running token */
-						log_is_running=false;
-						pthread_mutex_unlock(&log_buff_mutex);
-						pthread_exit(0);
-					}
-				}
+				printf("egi_log_thread_write(): log file %s dose NOT exist. exit thread...\n",EGI_LOGFILE_PATH);
+				/* reset running token */
+				log_is_running=false;
+				pthread_exit(0);
 			}
-			/* reset count */
-			log_buff_count=0;
 		}
 
 		/* check log_is_running token */
-		if( !log_is_running ) /* !!! log_buff[] may already have been freed then */
+		if( !log_is_running )
 		{
+			egi_log_drain(); /* logs pushed at last */
 			printf("egi_log_thread_write(): Detect false of log_is_running , exit pthread now...\n");
-			pthread_mutex_unlock(&log_buff_mutex);
 			pthread_exit(0);
 		}
 
-		/* put buff lock */
-		pthread_mutex_unlock(&log_buff_mutex);
-
-      /* -------------- exiting critical zone ---------------- */
+		/* adaptive gap: short after a busy batch, doubled for each idle round */
+		if(ret>0)
+			gap=EGI_LOG_WRITE_MINGAP;
+		else if(gap<EGI_LOG_WRITE_MAXGAP) {
+			gap<<=1;
+			if(gap>EGI_LOG_WRITE_MAXGAP)
+				gap=EGI_LOG_WRITE_MAXGAP;
+		}
 
-		/* sleep for a while, let other process to get locker */
-		tm_delayms(EGI_LOG_WRITE_SLEEPGAP);
+		/* wait for gap, or wakeup by producers */
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		ts.tv_sec += gap/1000;
+		ts.tv_nsec += (gap%1000)*1000000;
+		if(ts.tv_nsec>=1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec-=1000000000;
+		}
+		pthread_mutex_lock(&log_wake_mutex);
+		if(log_is_running)
+			pthread_cond_timedwait(&log_wake_cond, &log_wake_mutex, &ts);
+		pthread_mutex_unlock(&log_wake_mutex);
    	}
-
-	//pthread_exit(0);
 }
 
 
 
 /*-------------------------------------------
-1. allocate log buff itmes
-2. reset log_count;
+1. allocate log rings
+2. open log file
 3. start to run log_writting thread
 4. set log_is_running.
 
@@ -375,40 +598,41 @@ return:
 -------------------------------------------*/
 int egi_init_log(const char *fpath)
 {
+	pthread_condattr_t attr;
 	int ret=0;
 
-	/* 1. init buff mutex */
-	if(pthread_mutex_init(&log_buff_mutex,NULL) != 0)
+	/* 1. key for per-thread log rings */
+	pthread_once(&log_key_once, egi_log_create_key);
+
+	/* 2. init wakeup cond, with monotonic clock */
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	if(pthread_cond_init(&log_wake_cond,&attr) != 0)
 	{
-		printf("egi_init_log(): fail to initiate log_buff_mutex.\n");
+		printf("egi_init_log(): fail to initiate log_wake_cond.\n");
+		pthread_condattr_destroy(&attr);
 		return -1;
 	}
+	pthread_condattr_destroy(&attr);
 
-	/* 2. malloc log buff */
-//	if(egi_malloc_buff2D(&log_buff,EGI_LOG_MAX_BUFFITEMS,EGI_LOG_MAX_ITEMLEN)<0)
-	log_buff=egi_malloc_buff2D(EGI_LOG_MAX_BUFFITEMS,EGI_LOG_MAX_ITEMLEN);
-	if(log_buff==NULL)
+	/* 3. malloc log rings, the last one is shared by threads not getting a ring */
+	log_rings=calloc(EGI_LOG_MAX_RINGS+1, sizeof(EGI_LOG_RING));
+	if(log_rings==NULL)
 	{
-		printf("egi_init_log(): fail to malloc log_buff.\n");
+		printf("egi_init_log(): fail to calloc log_rings.\n");
+		ret=-2;
 		goto init_fail;
-		return -2;
 	}
+	log_rings[EGI_LOG_MAX_RINGS].state=LOGRING_USED;
 
-	printf("egi_init_log(): finish egi_malloc_buff2D().\n");
-
-	/* 3. reset log_buff_count */
-	log_buff_count=0;
-
-	/* 4. open log file */
-	egi_log_fp=fopen(fpath,"ae+");//EGI_LOGFILE_PATH,"a+");
-	if(egi_log_fp==NULL)
+	/* 4. open log file, O_APPEND: each write() is appended at end, as fopen(,"a") */
+	egi_log_fd=open(fpath, O_WRONLY|O_CREAT|O_APPEND|O_CLOEXEC, 0644);
+	if(egi_log_fd<0)
 	{
 		printf("egi_init_log(): %s\n", strerror(errno)); //fail to open log file %s\n", fpath);
 		ret=-3;
 		goto init_fail;
 	}
-	/* set stream buffer as NULL, write directly without any buffer */
-	setbuf(egi_log_fp,NULL);
 
 	/* 5. set log_is_running before log_writring thread, which will refer to it.*/
 	log_is_running=true;
@@ -424,102 +648,35 @@ int egi_init_log(const char *fpath)
 	}
 	printf("egi_init_log(): finish creating pthread log_write_thread().\n");
 
-
-
-#if 0 /* -----------FOR TEST: test log_buf[] ------------ */
-	int i;
-
-	printf("egi_init_log(): test log_buff[] ...\n");
-
-	for(i=0;i<EGI_LOG_MAX_BUFFITEMS;i++)
-	{
-		/* test log string buff, MAX. 254bytes printed for each item, 254 = 256-1'\n'-1'\0' */
-		snprintf(log_buff[i],EGI_LOG_MAX_ITEMLEN-1,"---1--------------------- TEST LOG_BUFF: %03d ---\
---2------------------------------------------------\
---3------------------------------------------------\
---4------------------------------------------------\
---5---------------------------------------------0123\n",i);
-		//printf("%s\n",log_buff[i]);
-		//printf("strlen(log_buff[%d])=%d\n",i,strlen(log_buff[i]) ); /* 254=256-1'\n'-1'\0' */
-		fprintf(egi_log_fp,"%s",log_buff[i]);
-		fflush(NULL);
-	}
-
-#endif
-
-
 	return 0; /* OK */
 
 
 init_fail:
-	pthread_mutex_destroy(&log_buff_mutex); /* destroy mutex */
+	pthread_cond_destroy(&log_wake_cond);
 
-	egi_free_buff2D(log_buff,EGI_LOG_MAX_BUFFITEMS);
+	free(log_rings);
+	log_rings=NULL;
 
-	if(egi_log_fp != NULL)/* close file */
-		fclose(egi_log_fp);
+	if(egi_log_fd >= 0) { /* close file */
+		close(egi_log_fd);
+		egi_log_fd=-1;
+	}
 
 	return ret;
 }
 
 /*-------------------------------------------------------------------
-set log_is_running to false to invoke egi_log_thread_write() to end.
-
-NOte:
-1. let egi_log_thread_write() to flush log file.
+set log_is_running to false and wake up egi_log_thread_write() to end.
 
 Return:
 	0	OK
-	<0	Fails
 -------------------------------------------------------------------*/
 static int egi_stop_log(void)
 {
-
-	/* get mutex lock */
-	if(pthread_mutex_lock(&log_buff_mutex) != 0)
-	{
-		printf("egi_quit_log():fail to get mutex lock.\n");
-		return -1;
-	}
-      /* -------------- entering critical zone ---------------- */
-		/* reset log_is_running, to let wirte thread stop
-		   ignore all log items in the log_buff. */
-		log_is_running=false;
-	/* put mutex lock */
-	pthread_mutex_unlock(&log_buff_mutex);
-      /* -------------- exiting critical zone ---------------- */
-
-	return 0;
-}
-
-
-/*-------------------------------------------------------------------
-free all log buff
-
-Return:
-	0	OK
-	<0	Fails
--------------------------------------------------------------------*/
-static int egi_free_logbuff(void)
-{
-
-	/* get mutex lock */
-	if(pthread_mutex_lock(&log_buff_mutex) != 0)
-	{
-		printf("egi_free_logbuff():fail to get mutex lock.\n");
-		return -1;
-	}
-      /* -------------- entering critical zone ---------------- */
-
-	/* free log buff */
-	egi_free_buff2D(log_buff,EGI_LOG_MAX_BUFFITEMS);
-
-	/* put mutex lock */
-	pthread_mutex_unlock(&log_buff_mutex);
-
-	/* */
-
-      /* -------------- exiting critical zone ---------------- */
+	pthread_mutex_lock(&log_wake_mutex);
+	log_is_running=false;
+	pthread_cond_signal(&log_wake_cond);
+	pthread_mutex_unlock(&log_wake_mutex);
 
 	return 0;
 }
@@ -530,7 +687,9 @@ quit log process...
 
 !!!! join thread of egi_log_thread_write()
 
-??? pthread_joint() return 
+Note: log file is closed and log rings are freed with log_rwlock held
+      for write. Pointers to freed rings left in thread specific keys
+      are checked by egi_log_ring_valid() and never used again.
 
 Return:
 	0	OK
@@ -544,14 +703,9 @@ int egi_quit_log(void)
 	tm_delayms(EGI_LOG_QUITWAIT);
 
 	/* stop log to let egi_log_thread_write() end */
-	if( egi_stop_log() !=0 )
-	{
-		printf("egi_quit_log():fail to stop log.\n");
-		return -1;
-	}
-
-	/* wait log_write_thread to end writing buff to log file. */
+	egi_stop_log();
 
+	/* wait log_write_thread to end writing rings to log file. */
 	printf("egi_quit_log(): start pthread_join(log_write_thread)...\n" );
 	ret=pthread_join(log_write_thread,NULL);
 	if( ret !=0 )
@@ -561,20 +715,18 @@ int egi_quit_log(void)
 		return -2;
 	}
 
-	/* free log buff */
-	if(egi_free_logbuff() !=0 )
-	{
-		printf("egi_quit_log():fail to free log_buff .\n");
-		return -1;
-	}
-
-	/* destroy mutex lock */
-	if(pthread_mutex_destroy(&log_buff_mutex)!=0) {
-		printf("%s: Fail to call pthread_mutex_destroy()!\n",__func__);
+	/* destroy cond */
+	if(pthread_cond_destroy(&log_wake_cond)!=0) {
+		printf("%s: Fail to call pthread_cond_destroy()!\n",__func__);
 	}
 
-	/* close log file */
-	fclose(egi_log_fp);
+	/* close log file and free log rings, after in_hand egi_push_log() */
+	pthread_rwlock_wrlock(&log_rwlock);
+	close(egi_log_fd);
+	egi_log_fd=-1;
+	free(log_rings);
+	log_rings=NULL;
+	pthread_rwlock_unlock(&log_rwlock);
 
 	return 0;
 }
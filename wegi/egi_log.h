@@ -16,9 +16,11 @@ Midas Zhou
 
 #define ENABLE_LOGBUFF_PRINT 	/* enable to print log buff content */
 
-#define EGI_LOG_MAX_BUFFITEMS	128 	/* MAX. number of log buff items */
+#define EGI_LOG_MAX_RINGS	16	/* MAX. number of threads that have their own log rings, others share one */
+#define EGI_LOG_RING_SIZE	(1<<14)	/* bytes of each log ring, MUST be power of 2 */
 #define EGI_LOG_MAX_ITEMLEN	512 //256 	/* Max length for each log string item */
-#define EGI_LOG_WRITE_SLEEPGAP	10  	/* in ms, sleep gap between two buff write session in egi_log_thread_write() */
+#define EGI_LOG_WRITE_MINGAP	2  	/* in ms, wait gap after a busy write session in egi_log_thread_write() */
+#define EGI_LOG_WRITE_MAXGAP	200  	/* in ms, Max. wait gap when log rings are idle */
 #define EGI_LOG_QUITWAIT 	55 	/* in ms, wait for other thread to finish pushing inhand log string,
 				     	 * before quit the log process */
 
@@ -37,32 +39,35 @@ enum egi_log_level
 
 #define ENABLE_EGI_PLOG
 
-/* Only log levels included in DEFAULT_LOG_LEVELS will be effective in EGI_PLOG() */
+/* Only log levels included in egi_log_levels will be effective in EGI_PLOG(), default DEFAULT_LOG_LEVELS */
 #define DEFAULT_LOG_LEVELS   (LOGLV_NONE|LOGLV_TEST|LOGLV_INFO|LOGLV_WARN|LOGLV_ERROR|LOGLV_CRITICAL|LOGLV_ASSERT)
 
-/* Only log level gets threshold(>=) that will be written to log file directly, without putting to buffer */
+/* Only log level gets threshold(>=) that will be written to log file directly, without putting to log rings */
 #define LOGLV_NOBUFF_THRESHOLD		LOGLV_WARN
 
 
+extern volatile int egi_log_levels;
+
 /* --- logger functions --- */
 int egi_push_log(enum egi_log_level log_level, const char *fmt, ...) __attribute__(( format(printf,2,3) ));
 //static void egi_log_thread_write(void);
 int egi_init_log(const char *fpath); //void);
 //static int egi_stop_log(void);
-//static int egi_free_logbuff(void)
 int egi_quit_log(void);
+void egi_log_set_levels(int levels);
+unsigned int egi_log_dropped(void);
 
 
 #ifdef ENABLE_EGI_PLOG
-   /* define egi_plog(), push to log_buff
+   /* define egi_plog(), push to log rings
     * Let the caller to put FILE and FUNCTION, we can not ensure that two egi_push_log()
-    * will push string to the log buff exactly one after the other,because of concurrency
+    * will push string to the log rings exactly one after the other,because of concurrency
     * race condition.
     * egi_push_log(" From file %s, %s(): \n",__FILE__,__FUNCTION__);
     */
 	#define EGI_PLOG(level, fmt, args...)                 \
         	do {                                            \
-                	if(level & DEFAULT_LOG_LEVELS)          \
+                	if(level & egi_log_levels)              \
                	 	{                                       \
 				egi_push_log(level,fmt, ## args);	\
                 	}                                       \
@@ -444,6 +444,9 @@ Fixed point Fast Fourier Transform
 
      !!! --- WARNING: Static arrays applied, for one running instance only --- !!!
 		( Use variable length arrays instead ??!?!?! )
+
+     !!! --- Obsolete: use plan-based mat_fft_int()/mat_fft_real_int() instead, which are
+	     reentrant and much faster. This one is kept for old codes. --- !!!
 Parameter:
 @np:    Total number of data for FFT, will be ajusted to a number of 2 powers;
         np=1, result is 0!
@@ -516,6 +519,8 @@ int mat_egiFFFT( uint16_t np, const EGI_FCOMPLEX *wang,
 		if(ffodd != NULL)   free(ffodd);
 		if(ffeven != NULL)  free(ffeven);
 		if(ffnin != NULL)   free(ffnin);
+		ffodd=NULL; ffeven=NULL; ffnin=NULL;
+		nn=0;
 		return 0;
 	}
 
@@ -662,6 +667,302 @@ int mat_egiFFFT( uint16_t np, const EGI_FCOMPLEX *wang,
 }
 
 
+/*-------------------------------------------------------------------------------------
+Create an FFT plan for np points, with bit-reverse index and twiddle factor tables
+computed once, so they need NOT to be computed again for each FFT session.
+
+A plan is read only after creation, so different threads may run FFT with the
+same plan at the same time, each with its own data arrays.
+
+@np:	Number of points, will be ajusted(down) to a number of 2 powers, Min. 2.
+
+Return:
+	Pointer to EGI_FFT_PLAN		OK
+	NULL				Fails
+---------------------------------------------------------------------------------------*/
+EGI_FFT_PLAN *mat_fft_create_plan(unsigned int np)
+{
+	EGI_FFT_PLAN *plan;
+	unsigned int i,j;
+	int exp;
+
+	if(np<2) {
+		printf("%s: Input np must be >=2!\n",__func__);
+		return NULL;
+	}
+
+	/* get exponent number of 2 */
+	exp=mat_uint32Log2(np);
+
+	plan=calloc(1, sizeof(EGI_FFT_PLAN));
+	if(plan==NULL) {
+		printf("%s: Fail to calloc plan!\n",__func__);
+		return NULL;
+	}
+	plan->nexp=exp;
+	plan->np=1<<exp;
+
+	plan->brev=malloc(plan->np*sizeof(int));
+	plan->qcos=malloc(plan->np/2*sizeof(int32_t));
+	plan->qsin=malloc(plan->np/2*sizeof(int32_t));
+	plan->fcos=malloc(plan->np/2*sizeof(float));
+	plan->fsin=malloc(plan->np/2*sizeof(float));
+	if( plan->brev==NULL || plan->qcos==NULL || plan->qsin==NULL
+	    || plan->fcos==NULL || plan->fsin==NULL ) {
+		printf("%s: Fail to malloc plan tables!\n",__func__);
+		mat_fft_free_plan(&plan);
+		return NULL;
+	}
+
+	/* 1. bit-reversed index, brev[i] from brev[i>>1] */
+	plan->brev[0]=0;
+	for(i=1; i<plan->np; i++)
+		plan->brev[i] = (plan->brev[i>>1]>>1) | ((i&1)<<(exp-1));
+
+	/* 2. twiddle factors W^k=cos(2*PI*k/np)-j*sin(2*PI*k/np), k=[0 np/2) */
+	for(j=0; j<plan->np/2; j++) {
+		double a=2.0*MATH_PI*j/plan->np;
+		plan->fcos[j]=cos(a);
+		plan->fsin[j]=sin(a);
+		plan->qcos[j]=lround(cos(a)*(1<<MAT_FFT_QBITS));
+		plan->qsin[j]=lround(sin(a)*(1<<MAT_FFT_QBITS));
+	}
+
+	return plan;
+}
+
+/*---------------------------------------
+Free an FFT plan and reset it to NULL.
+---------------------------------------*/
+void mat_fft_free_plan(EGI_FFT_PLAN **plan)
+{
+	if(plan==NULL || *plan==NULL)
+		return;
+
+	free((*plan)->brev);
+	free((*plan)->qcos);
+	free((*plan)->qsin);
+	free((*plan)->fcos);
+	free((*plan)->fsin);
+	free(*plan);
+	*plan=NULL;
+}
+
+/*-------------------------------------------------------------------
+In-place radix-2 FFT of n=1<<nexp points, n is np or np/2 of the plan.
+For a butterfly group of 2m points, twiddle factor W_2m^k=W_np^(k*np/2m),
+so the same tables serve both sizes.
+--------------------------------------------------------------------*/
+static void mat_fft_int_core(const EGI_FFT_PLAN *plan, unsigned int nexp, int32_t *re, int32_t *im)
+{
+	unsigned int n=1<<nexp;
+	unsigned int bshift=plan->nexp-nexp; /* brev of n points is brev of np points >>bshift */
+	unsigned int i,j,k,m,step;
+	int64_t wr,wi;
+	int32_t tr,ti;
+
+	/* 1. reorder input by bit-reversed index */
+	for(i=0; i<n; i++) {
+		j=plan->brev[i]>>bshift;
+		if(i<j) {
+			tr=re[i]; re[i]=re[j]; re[j]=tr;
+			ti=im[i]; im[i]=im[j]; im[j]=ti;
+		}
+	}
+
+	/* 2. stage 2^1 -> 2^2 -> ... -> n points DFT, one complex multiply for each butterfly */
+	for(m=1; m<n; m<<=1) {
+		step=plan->np/(m<<1);
+		for(k=0; k<m; k++) {
+			wr=plan->qcos[k*step];
+			wi=plan->qsin[k*step];
+			for(i=k; i<n; i+=m<<1) {
+				j=i+m;
+				/* (re+j*im)*(wr-j*wi) */
+				tr=(wr*re[j]+wi*im[j]+(1<<(MAT_FFT_QBITS-1)))>>MAT_FFT_QBITS;
+				ti=(wr*im[j]-wi*re[j]+(1<<(MAT_FFT_QBITS-1)))>>MAT_FFT_QBITS;
+				re[j]=re[i]-tr;
+				im[j]=im[i]-ti;
+				re[i]+=tr;
+				im[i]+=ti;
+			}
+		}
+	}
+}
+
+/*-------------------------------------------------------------------------------------
+Fixed point FFT, in place.
+
+@plan:	 An FFT plan, with np points.
+@re,im:	 Real and imaginary part of input data, [np], and FFT result is put back.
+
+Note:
+1. No scaling in stages, result is the same as DFT definition, so to keep it from
+   overflow: Max.|input| * np < 2^31.
+   Example: 12bits amplitude with 1024 points gives 22bits result.
+2. Actual amplitude is Amp/(np/2), where Amp=mat_intCompAmp(re[k],im[k]).
+
+Return:
+	0	OK
+	<0	Fails
+---------------------------------------------------------------------------------------*/
+int mat_fft_int(const EGI_FFT_PLAN *plan, int32_t *re, int32_t *im)
+{
+	if(plan==NULL || re==NULL || im==NULL)
+		return -1;
+
+	mat_fft_int_core(plan, plan->nexp, re, im);
+	return 0;
+}
+
+/*-------------------------------------------------------------------------------------
+Float point FFT, in place.
+
+@plan:	 An FFT plan, with np points.
+@re,im:	 Real and imaginary part of input data, [np], and FFT result is put back.
+
+Return:
+	0	OK
+	<0	Fails
+---------------------------------------------------------------------------------------*/
+int mat_fft_float(const EGI_FFT_PLAN *plan, float *re, float *im)
+{
+	unsigned int n;
+	unsigned int i,j,k,m,step;
+	float wr,wi;
+	float tr,ti;
+
+	if(plan==NULL || re==NULL || im==NULL)
+		return -1;
+
+	n=plan->np;
+
+	/* 1. reorder input by bit-reversed index */
+	for(i=0; i<n; i++) {
+		j=plan->brev[i];
+		if(i<j) {
+			tr=re[i]; re[i]=re[j]; re[j]=tr;
+			ti=im[i]; im[i]=im[j]; im[j]=ti;
+		}
+	}
+
+	/* 2. butterflies, see mat_fft_int_core() */
+	for(m=1; m<n; m<<=1) {
+		step=n/(m<<1);
+		for(k=0; k<m; k++) {
+			wr=plan->fcos[k*step];
+			wi=plan->fsin[k*step];
+			for(i=k; i<n; i+=m<<1) {
+				j=i+m;
+				tr=wr*re[j]+wi*im[j];
+				ti=wr*im[j]-wi*re[j];
+				re[j]=re[i]-tr;
+				im[j]=im[i]-ti;
+				re[i]+=tr;
+				im[i]+=ti;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*-------------------------------------------------------------------------------------
+Fixed point FFT for real input data, in place.
+
+Input np real points are taken as np/2 complex points z[k]=x[2k]+j*x[2k+1], then
+after an np/2 points FFT, the spectrum of x[] is split out from Z[]:
+	X[k] = ( Z[k]+conj(Z[np/2-k]) )/2 + W^k*( Z[k]-conj(Z[np/2-k]) )/2j
+It's about twice as fast as mat_fft_int() for the same np.
+
+@plan:	 An FFT plan, with np points.
+@re:	 [np] Input real data.
+	 Output real part of X[0]...X[np/2].
+@im:	 [np/2+1] Output imaginary part of X[0]...X[np/2], its input is ignored.
+	 X[np/2+1]...X[np-1] are NOT given, they are conj(X[np-k]).
+
+Note: Same overflow limit as mat_fft_int().
+
+Return:
+	0	OK
+	<0	Fails
+---------------------------------------------------------------------------------------*/
+int mat_fft_real_int(const EGI_FFT_PLAN *plan, int32_t *re, int32_t *im)
+{
+	unsigned int hn;
+	unsigned int k;
+	int64_t wr,wi;
+	int32_t ar,ai,br,bi;
+	int32_t sr,si,dr,di,tr,ti;
+
+	if(plan==NULL || re==NULL || im==NULL)
+		return -1;
+
+	hn=plan->np/2;
+
+	/* 1. pack x[] into z[], re[] is compacted from the front */
+	for(k=0; k<hn; k++) {
+		im[k]=re[2*k+1];
+		re[k]=re[2*k];
+	}
+
+	/* 2. np/2 points FFT */
+	mat_fft_int_core(plan, plan->nexp-1, re, im);
+
+	/* 3. split X[k] and X[np/2-k] from Z[k] and Z[np/2-k] */
+	ar=re[0]; ai=im[0];
+	re[0]=ar+ai;	im[0]=0;
+	re[hn]=ar-ai;	im[hn]=0;
+
+	for(k=1; k<=hn/2; k++) {
+		ar=re[k];	ai=im[k];
+		br=re[hn-k];	bi=im[hn-k];
+
+		/* S=Z[k]+conj(Z[np/2-k]), D=( Z[k]-conj(Z[np/2-k]) )/j */
+		sr=ar+br;	si=ai-bi;
+		dr=ai+bi;	di=br-ar;
+
+		/* T=W^k*D */
+		wr=plan->qcos[k];
+		wi=plan->qsin[k];
+		tr=(wr*dr+wi*di+(1<<(MAT_FFT_QBITS-1)))>>MAT_FFT_QBITS;
+		ti=(wr*di-wi*dr+(1<<(MAT_FFT_QBITS-1)))>>MAT_FFT_QBITS;
+
+		/* X[k]=(S+T)/2, X[np/2-k]=conj(S-T)/2 */
+		re[k]=(sr+tr)>>1;	im[k]=(si+ti)>>1;
+		re[hn-k]=(sr-tr)>>1;	im[hn-k]=-((si-ti)>>1);
+	}
+
+	return 0;
+}
+
+/*---------------------------------------------------
+Amplitude(modulus) of a complex number re+j*im,
+as for result of mat_fft_int() and mat_fft_real_int().
+----------------------------------------------------*/
+unsigned int mat_intCompAmp(int32_t re, int32_t im)
+{
+	uint64_t x=(uint64_t)((int64_t)re*re)+(uint64_t)((int64_t)im*im);
+	uint64_t r=0;
+	uint64_t bit=1ULL<<62;
+
+	/* integer square root, bit by bit */
+	while(bit>x)
+		bit>>=2;
+	while(bit) {
+		if(x>=r+bit) {
+			x-=r+bit;
+			r=(r>>1)+bit;
+		}
+		else
+			r>>=1;
+		bit>>=2;
+	}
+
+	return r;
+}
+
+
 /*--------------------------------------------------------------
 Create fixed point lookup table for
 trigonometric functions: sin(),cos()
@@ -60,6 +60,21 @@ EGI_FVAL       imag;	/* imaginery part */
 */
 #define MAT_FHAMMING(n, N)  ( MAT_FVAL(0.54-0.46*cos(2.0*n*MATH_PI/N)) )
 
+/* FFT plan, tables are computed once in mat_fft_create_plan(), and shared(read only) by all
+ * FFT sessions of the same np, so one plan may be used by several threads at the same time.
+ */
+#define MAT_FFT_QBITS	30	/* Q format of twiddle factors in qcos[]/qsin[] */
+typedef struct egi_fft_plan EGI_FFT_PLAN;
+struct egi_fft_plan {
+	unsigned int	nexp;	/* np=1<<nexp */
+	unsigned int	np;	/* number of points */
+	int		*brev;	/* [np], bit-reversed index */
+	int32_t		*qcos;	/* [np/2], cos(2*PI*k/np) in Q30 */
+	int32_t		*qsin;	/* [np/2], sin(2*PI*k/np) in Q30 */
+	float		*fcos;	/* [np/2], float cos(2*PI*k/np) */
+	float		*fsin;	/* [np/2], float sin(2*PI*k/np) */
+};
+
 /* complex and FFT functions */
 void 		mat_FixPrint(EGI_FVAL a);
 void 		mat_CompPrint(EGI_FCOMPLEX a);
@@ -81,6 +96,14 @@ EGI_FCOMPLEX 	*mat_CompFFTAng(uint16_t np);
 int 		mat_egiFFFT( uint16_t np, const EGI_FCOMPLEX *wang,
                                      const float *x, const int *nx, EGI_FCOMPLEX *ffx);
 
+/* plan-based FFT functions */
+EGI_FFT_PLAN	*mat_fft_create_plan(unsigned int np);
+void		mat_fft_free_plan(EGI_FFT_PLAN **plan);
+int		mat_fft_int(const EGI_FFT_PLAN *plan, int32_t *re, int32_t *im);
+int		mat_fft_float(const EGI_FFT_PLAN *plan, float *re, float *im);
+int		mat_fft_real_int(const EGI_FFT_PLAN *plan, int32_t *re, int32_t *im);
+unsigned int	mat_intCompAmp(int32_t re, int32_t im);
+
 /* other math functions */
 void 		mat_create_fpTrigonTab(void);
 uint64_t 	mat_fp16_sqrtu32(uint32_t x);
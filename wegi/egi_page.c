@@ -20,6 +20,7 @@ Midas Zhou
 #include "egi_bjp.h"
 #include "egi_touch.h"
 #include "egi_log.h"
+#include "egi_hitgrid.h"
 
 
 /*---------------------------------------------
@@ -76,6 +77,11 @@ EGI_PAGE * egi_page_new(char *tag)
 	/* 8. init list */
         INIT_LIST_HEAD(&page->list_head);
 
+	/* 8.1 hit grid for child eboxes, page works without it */
+	page->hitgrid=egi_hitgrid_create(gv_fb_dev.vinfo.xres, gv_fb_dev.vinfo.yres);
+	if(page->hitgrid==NULL)
+		printf("%s: Fail to create hit grid for page '%s'.\n", __func__, tag);
+
 	/* 9. init pgmutex */
 	if(pthread_mutex_init(&page->pgmutex,NULL) !=0 ) {
 		EGI_PLOG(LOGLV_ERROR, "%s: Fail to pathread_mutex_init page.pgmutex!", __func__ );
@@ -160,6 +166,9 @@ int egi_page_free(EGI_PAGE *page)
         	}
 	}
 
+	/* free hit grid */
+	egi_hitgrid_free(&page->hitgrid);
+
 	/* free self ebox */
 	if(page->ebox != NULL) {
 		//free(page->ebox);
@@ -387,6 +396,10 @@ int egi_page_addlist(EGI_PAGE *page, EGI_EBOX *ebox)
 
 	/* add to list tail */
 	list_add_tail(&ebox->node, &page->list_head);
+
+	/* index its touch area, in the same order as the list */
+	if(page->hitgrid)
+		egi_hitgrid_add(page->hitgrid, ebox);
 	EGI_PDEBUG(DBG_PAGE,"ebox '%s' is added to page '%s' \n",
 								ebox->tag, page->ebox->tag);
 
@@ -692,7 +705,7 @@ int egi_page_refresh(EGI_PAGE *page)
 	list_for_each(tnode, &page->list_head)
 	{
 		ebox=list_entry(tnode, EGI_EBOX, node);
-		ret *= ebox->refresh(ebox);
+		ret *= ebox->refresh(ebox);	/* re-binned in hit grid if it moves */
 
 #if 0 /* Debug only, it will prints out whether need_refresh flag is on or off! */
 		if(ret==0) {
@@ -722,6 +735,10 @@ int egi_page_refresh(EGI_PAGE *page)
 	/* put PAGE.pgmutex */
         pthread_mutex_unlock(&page->pgmutex);
 
+	/* Bring dirty areas of the back buffer to screen, if dirty tracking is on */
+	if( ret==0 && gv_fb_dev.dirty_on )
+		fb_dirty_flush(&gv_fb_dev, 0);
+
 	return ret; /* if any ebox refreshed, return 0 */
 }
 
@@ -810,6 +827,8 @@ int egi_page_needrefresh(EGI_PAGE *page)
 	/* 6.put PAGE.pgmutex */
         pthread_mutex_unlock(&page->pgmutex);
 
+	/* 7. wake up page routine waiting for touch event */
+	egi_touch_wakeup();
 
 	return 0;
 }
@@ -972,6 +991,26 @@ int egi_page_start_runners(EGI_PAGE *page)
 }
 
 
+/*-------------------------------------------------------------------
+Wait until the finger is off the screen, then discard queued events.
+A timeout or wakeup of egi_touch_waitdata() is NOT a release, only a
+real 'released_hold' event or the touch state machine tells it.
+--------------------------------------------------------------------*/
+static void egi_page_waitrelease(void)
+{
+	EGI_TOUCH_DATA touch_data;
+	int ret;
+
+	do {
+		ret=egi_touch_waitdata(&touch_data, EGI_PAGE_IDLE_TICK);
+		if( ret<0 )
+			break;
+	} while( ret==0 ? touch_data.status!=released_hold : !egi_touch_released() );
+
+	egi_touch_flushdata();
+}
+
+
 /*-------------------------------------------
 Default page routine job ,No sliding handling
 
@@ -1060,13 +1099,16 @@ int egi_page_routine(EGI_PAGE *page)
 
 	/* Try to discard first obsolete data, just to inform egi_touch_loopread() to start loop_read */
 	egi_touch_getdata(&touch_data);
+	egi_touch_flushdata();
 
 	while(1)
 	{
-		/* 1. read touch data */
-		if(!egi_touch_getdata(&touch_data) )
+		/* 1. Wait for touch event, sleep until a touch, or a needrefresh wakeup, or an idle tick.
+		 *    Time out(or wakeup) is taken as 'released_hold', to refresh the page.
+		 */
+		if( egi_touch_waitdata(&touch_data, EGI_PAGE_IDLE_TICK) <0 )
 		{
-//			EGI_PDEBUG(DBG_PAGE,"egi_page_routine(): egi_touch_getdata() no updated touch data found, retry...\n");
+			tm_delayms(EGI_PAGE_IDLE_TICK); /* touch_loopread not running */
 			continue;
 		}
 		sx=touch_data.coord.x;
@@ -1196,11 +1238,7 @@ int egi_page_routine(EGI_PAGE *page)
 						 * especially 'pressed_hold' and 'releasing', which may trigger
 						 * refreshed page again!!!
 						 */
-						do {
-							tm_delayms(200);
-						 	egi_touch_getdata(&touch_data);
-
-						}while(touch_data.status != released_hold);
+						egi_page_waitrelease();
 
 					}
 					else
@@ -1234,10 +1272,9 @@ int egi_page_routine(EGI_PAGE *page)
 			* Conclusion: activating touch_status(signal) for all eboxes shall be the same type!
 	               */
 
-			/* refresh page, OR sleep a while */
+			/* refresh page, no more sleep here, egi_touch_waitdata() holds on for a tick */
 			if(egi_page_refresh(page)!=0) {
-				/* hold on for a while, otherwise the screen will be  ...heheheheheh... */
-#if 1
+#if 0
 				tm_delayms(75); //55
 #endif
 #if 0 /* conflict with timer */
@@ -1380,6 +1417,7 @@ int egi_homepage_routine(EGI_PAGE *page)
 
 	/* Try to discard first obsolete data, just to inform egi_touch_loopread() to start loop_read */
 	egi_touch_getdata(&touch_data);
+	egi_touch_flushdata();
 
 	while(1)
 	{
@@ -1396,10 +1434,10 @@ int egi_homepage_routine(EGI_PAGE *page)
 			flip_status=pressing;
 		}
 
-		/* 1. Read touch data, loop back if there is no new data.  */
-		if(!egi_touch_getdata(&touch_data) )
+		/* 1. Wait for touch event, time out(or wakeup) is taken as 'released_hold' */
+		if( egi_touch_waitdata(&touch_data, EGI_PAGE_IDLE_TICK) <0 )
 		{
-//			EGI_PDEBUG(DBG_PAGE,"egi_page_routine(): egi_touch_getdata() no updated touch data found, retry...\n");
+			tm_delayms(EGI_PAGE_IDLE_TICK); /* touch_loopread not running */
 			continue;
 		}
 		sx=touch_data.coord.x;
@@ -1607,11 +1645,7 @@ int egi_homepage_routine(EGI_PAGE *page)
 						 * especially 'pressed_hold' and 'releasing', which may trigger
 						 * refreshed page again!!!
 						 */
-						do {
-							tm_delayms(100);
-						 	egi_touch_getdata(&touch_data);
-
-						}while(touch_data.status != released_hold);
+						egi_page_waitrelease();
 
 					}
 					else
@@ -1627,9 +1661,9 @@ int egi_homepage_routine(EGI_PAGE *page)
 
 		else /* last_status == released_hold */
 		{
-			/* refresh page, OR sleep a while */
+			/* refresh page, no more sleep here, egi_touch_waitdata() holds on for a tick */
 			if(egi_page_refresh(page)!=0) {  /* refresh ebox always */
-#if 1
+#if 0
 				tm_delayms(75); //55
 #endif
 #if 0 /* conflict with timer */
@@ -12,6 +12,10 @@ Midas Zhou
 #include <stdio.h>
 #include "egi.h"
 
+#define EGI_PAGE_IDLE_TICK	75	/* in ms, max. time for page routine to wait for a touch event
+					 * before it refreshes the page.
+					 */
+
 EGI_PAGE * egi_page_new(char *tag);
 int egi_page_free(EGI_PAGE *page);
 int egi_suspend_runner(EGI_PAGE *page, int runnerID);
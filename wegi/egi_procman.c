@@ -15,6 +15,7 @@ Midas_Zhou
 #include "egi_FTsymbol.h"
 #include "egi_utils.h"
 #include "egi_procman.h"
+#include "egi_surface.h"
 
 __attribute__((weak)) const char *app_name="etouch test";
 
@@ -306,3 +307,68 @@ int egi_process_activate_APP(pid_t *apid, char* app_path)
 }
 
 
+
+
+/*-----------------------------------------------------------------
+Activate an APP which draws to an EGI_SURFACE of the compositor.
+
+Unlike egi_process_activate_APP(), the APP is never stopped and the
+caller will NOT wait for it, to switch to an APP just raise its
+surface, so there is no full screen repainting.
+
+1. If apid<0 then vfork() and execv() the APP, the APP shall create
+   its surface with name surf_name.
+2. If apid>0, check if it's still alive, then raise its surface.
+
+@apid:          PID of the subprocess.
+@app_path:      Path to an executiable APP file.
+@surf_name:	Name of the surface of the APP.
+
+Return:
+        <0      Fail to execute the APP or raise its surface.
+        0       Ok
+------------------------------------------------------------------*/
+int egi_process_raise_APP(pid_t *apid, char* app_path, const char *surf_name)
+{
+	int status;
+	char *argv[2]={ app_path, NULL };
+
+	/* Reap it if it has quit */
+	if( *apid>0 && waitpid(*apid, &status, WNOHANG)==*apid
+	    && ( WIFEXITED(status) || WIFSIGNALED(status) ) ) {
+                EGI_PLOG(LOGLV_CRITICAL, "%s: APP '%s' has quit, launch again.", __func__, app_path);
+		*apid=-1;
+	}
+
+        /* 1. If APP not running, fork() and execv() to launch it. */
+	if(*apid<0) {
+	        if( access(app_path, X_OK) !=0 ) {
+        	        EGI_PDEBUG(DBG_PAGE,"'%s' is not a recognizble executive file.\n", app_path);
+                	return -1;
+	        }
+
+                *apid=vfork();
+                if(*apid==0) {
+                        execv(app_path, argv);
+                        EGI_PLOG(LOGLV_ERROR, "%s: fail to execv '%s' after fork(), error:%s",
+                                                                __func__, app_path, strerror(errno) );
+                        exit(255);
+                }
+                else if(*apid <0) {
+                        EGI_PLOG(LOGLV_ERROR, "%s: Fail to launch APP '%s'!",__func__, app_path);
+                        return -2;
+                }
+
+                EGI_PLOG(LOGLV_CRITICAL, "%s: APP '%s' launched successfully!", __func__, app_path);
+		return 0;	/* A new surface is put on top by the compositor */
+	}
+
+        /* 2. Else raise its surface */
+	if( egi_surface_command(surf_name, SURFMSG_RAISE, 0, 0, 0) !=0 ) {
+                EGI_PLOG(LOGLV_ERROR, "%s: Fail to raise surface '%s' of APP '%s'.",
+                                                        __func__, surf_name, app_path);
+		return -3;
+	}
+
+	return 0;
+}
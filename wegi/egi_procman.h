@@ -14,5 +14,6 @@ void __attribute__((constructor)) app_common_constructor(void);
 void __attribute__((destructor)) app_common_destructor(void);
 int egi_assign_AppSigActions(void);
 int egi_process_activate_APP(pid_t *apid, char* app_path);
+int egi_process_raise_APP(pid_t *apid, char* app_path, const char *surf_name);
 
 #endif
@@ -0,0 +1,787 @@
+/*------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+Shared-memory surfaces and a compositor for EGI APPs.
+Refer to egi_surface.h for a brief description.
+
+An APP with a surface:
+	surf=egi_surface_create("ebook", 0, 0, 240, 320, SURF_LAYER_APP, false);
+	init_virt_fbdev(&vfb_dev, surf->eimg);
+	... draw to vfb_dev ...
+	egi_surface_damage(surf, x1, y1, x2, y2);
+
+Note:
+1. There is no lock between an APP drawing and the compositor reading
+   surface data, so tear lines are possible in a damaged area.
+2. EGI_SURFACE_HEAD.pid is checked by the compositor every second, a
+   surface is dropped if its owner process is gone.
+
+Midas Zhou
+------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "egi_surface.h"
+#include "egi_fbdev.h"
+#include "egi_fbgeom.h"
+
+static int  surface_map(EGI_SURFACE *surf, const char *name, int width, int height, bool create);
+static void surface_unmap(EGI_SURFACE *surf);
+static int  surface_send(int sockfd, const EGI_SURFMSG *msg);
+
+
+/*---------------------------------------------------------------
+Map surface data in shared memory, and create surf->eimg with it.
+
+@create:	True: Create the shared memory, it fails if the name
+		      is taken already, so a name is exclusive.
+		False: Map an existing one only, as the compositor
+		      does, it never creates one for a bogus message.
+Return:
+	0	OK
+	<0	Fails
+---------------------------------------------------------------*/
+static int surface_map(EGI_SURFACE *surf, const char *name, int width, int height, bool create)
+{
+	EGI_IMGBUF *eimg;
+
+	strncpy(surf->name, name, EGI_SURFACE_NAME_MAX-1);
+	snprintf(surf->shm_name, sizeof(surf->shm_name), "egisurf_%s", surf->name);
+
+	surf->shmem.shm_name=surf->shm_name;
+	surf->shmem.shm_map=NULL;
+	surf->shmem.shm_size=sizeof(EGI_SURFACE_HEAD)+width*height*(sizeof(EGI_16BIT_COLOR)+1);
+	if( egi_shmem_open_flags(&surf->shmem, create ? O_CREAT|O_EXCL : 0) !=0 ) {
+		printf("%s: Fail to open shmem '%s'!\n", __func__, surf->shm_name);
+		surf->shmem.shm_map=NULL;
+		return -1;
+	}
+	surf->head=(EGI_SURFACE_HEAD *)surf->shmem.shm_map;
+
+	/* EGI_IMGBUF with data in shmem, NOT to be freed by egi_imgbuf_free() */
+	eimg=calloc(1, sizeof(EGI_IMGBUF));
+	if(eimg==NULL) {
+		printf("%s: Fail to calloc eimg!\n", __func__);
+		egi_shmem_close(&surf->shmem);
+		return -2;
+	}
+	pthread_mutex_init(&eimg->img_mutex, NULL);
+	eimg->width=width;
+	eimg->height=height;
+	eimg->imgbuf=(EGI_16BIT_COLOR *)(surf->shmem.shm_map+sizeof(EGI_SURFACE_HEAD));
+	eimg->alpha=(unsigned char *)(eimg->imgbuf+width*height);
+	surf->eimg=eimg;
+
+	return 0;
+}
+
+/*---------------------------------------------
+Unmap surface data, and free surf->eimg.
+---------------------------------------------*/
+static void surface_unmap(EGI_SURFACE *surf)
+{
+	if(surf->eimg) {
+		pthread_mutex_destroy(&surf->eimg->img_mutex);
+		free(surf->eimg);
+		surf->eimg=NULL;
+	}
+	if(surf->shmem.shm_map) {
+		egi_shmem_close(&surf->shmem);
+		surf->shmem.shm_map=NULL;
+	}
+	surf->head=NULL;
+}
+
+/*---------------------------------------------
+Send an EGI_SURFMSG to the compositor.
+Return:
+	0	OK
+	<0	Fails
+---------------------------------------------*/
+static int surface_send(int sockfd, const EGI_SURFMSG *msg)
+{
+	struct sockaddr_un addr;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family=AF_UNIX;
+	strncpy(addr.sun_path, EGI_COMPOSITOR_SOCK, sizeof(addr.sun_path)-1);
+
+	if( sendto(sockfd, msg, sizeof(EGI_SURFMSG), 0, (struct sockaddr *)&addr, sizeof(addr)) != sizeof(EGI_SURFMSG) ) {
+		printf("%s: Fail to send msg to compositor: %s\n", __func__, strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/*------------------------------------------------------------------------------
+Create a surface in shared memory, and register it to the compositor.
+Then call init_virt_fbdev() with surf->eimg to draw on it.
+
+@name:		Name of the surface, unique for all APPs. It fails if the
+		name is taken by another surface.
+@x0,y0:		Position of the surface, relative to the compositor screen.
+@width,height:	Size of the surface.
+@layer:		Layer of the surface, see enum egi_surface_layer.
+@alpha_on:	True: surf->eimg->alpha is effective, and init as transparent.
+		False: The surface is opaque.
+
+Return:
+	A pointer to EGI_SURFACE	OK
+	NULL				Fails, or no compositor running.
+-------------------------------------------------------------------------------*/
+EGI_SURFACE* egi_surface_create(const char *name, int x0, int y0, int width, int height,
+								int layer, bool alpha_on)
+{
+	EGI_SURFACE *surf;
+	EGI_SURFMSG msg;
+
+	if( name==NULL || name[0]=='\0' || width<1 || height<1 ) {
+		printf("%s: Input params invalid!\n", __func__);
+		return NULL;
+	}
+
+	surf=calloc(1, sizeof(EGI_SURFACE));
+	if(surf==NULL) {
+		printf("%s: Fail to calloc surf!\n", __func__);
+		return NULL;
+	}
+	surf->sockfd=-1;
+
+	if( surface_map(surf, name, width, height, true) !=0 ) {
+		printf("%s: Fail to create surface '%s', name taken?\n", __func__, name);
+		free(surf);
+		return NULL;
+	}
+	surf->owner=true;
+
+	surf->head->magic=EGI_SURFACE_MAGIC;
+	surf->head->pid=getpid();
+	surf->head->width=width;
+	surf->head->height=height;
+	surf->head->alpha_on=alpha_on;
+	memset(surf->eimg->imgbuf, 0, width*height*sizeof(EGI_16BIT_COLOR));
+	memset(surf->eimg->alpha, alpha_on ? 0:255, width*height);
+	if(!alpha_on)
+		surf->eimg->alpha=NULL;	/* So drawing functions will not touch it */
+
+	surf->sockfd=socket(AF_UNIX, SOCK_DGRAM, 0);
+	if(surf->sockfd<0) {
+		printf("%s: Fail to create socket: %s\n", __func__, strerror(errno));
+		egi_surface_free(&surf);
+		return NULL;
+	}
+
+	/* Register to the compositor */
+	memset(&msg, 0, sizeof(msg));
+	msg.cmd=SURFMSG_REGISTER;
+	strncpy(msg.name, surf->name, EGI_SURFACE_NAME_MAX-1);
+	msg.pid=surf->head->pid;
+	msg.x1=x0;	msg.y1=y0;
+	msg.x2=width;	msg.y2=height;
+	msg.layer=layer;
+	msg.alpha_on=alpha_on;
+	if( surface_send(surf->sockfd, &msg) !=0 ) {
+		printf("%s: Fail to register surface '%s', compositor NOT running?\n", __func__, name);
+		egi_surface_free(&surf);
+		return NULL;
+	}
+
+	return surf;
+}
+
+
+/*-----------------------------------------------------
+Unregister a surface from the compositor, and free it.
+-----------------------------------------------------*/
+void egi_surface_free(EGI_SURFACE **surf)
+{
+	if(surf==NULL || *surf==NULL)
+		return;
+
+	if( (*surf)->sockfd >=0 ) {
+		egi_surface_sendmsg(*surf, SURFMSG_UNREGISTER, 0, 0, 0);
+		close((*surf)->sockfd);
+	}
+
+	surface_unmap(*surf);
+	if( (*surf)->owner )
+		egi_shmem_remove((*surf)->shm_name);
+
+	free(*surf);
+	*surf=NULL;
+}
+
+
+/*------------------------------------------------------------
+Submit a damaged rect of the surface to the compositor, the
+compositor will refresh the area on the screen.
+
+@x1,y1,x2,y2:	Two diagonal points of the rect, relative to
+		the surface.
+Return:
+	0	OK
+	<0	Fails
+------------------------------------------------------------*/
+int egi_surface_damage(EGI_SURFACE *surf, int x1, int y1, int x2, int y2)
+{
+	EGI_SURFMSG msg;
+
+	if(surf==NULL || surf->sockfd<0)
+		return -1;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.cmd=SURFMSG_DAMAGE;
+	strncpy(msg.name, surf->name, EGI_SURFACE_NAME_MAX-1);
+	msg.pid=getpid();
+	msg.x1= x1<x2 ? x1:x2;	msg.x2= x1<x2 ? x2:x1;
+	msg.y1= y1<y2 ? y1:y2;	msg.y2= y1<y2 ? y2:y1;
+
+	return surface_send(surf->sockfd, &msg);
+}
+
+
+/*------------------------------------------------------------
+Send a command for the surface to the compositor.
+
+@cmd:	SURFMSG_MOVE, SURFMSG_LAYER, SURFMSG_SHOW, SURFMSG_HIDE,
+	SURFMSG_RAISE or SURFMSG_UNREGISTER.
+@x1,y1:	New position, for SURFMSG_MOVE.
+@layer:	New layer, for SURFMSG_LAYER.
+
+Return:
+	0	OK
+	<0	Fails
+------------------------------------------------------------*/
+int egi_surface_sendmsg(EGI_SURFACE *surf, int cmd, int x1, int y1, int layer)
+{
+	EGI_SURFMSG msg;
+
+	if(surf==NULL || surf->sockfd<0)
+		return -1;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.cmd=cmd;
+	strncpy(msg.name, surf->name, EGI_SURFACE_NAME_MAX-1);
+	msg.pid=getpid();
+	msg.x1=x1;	msg.y1=y1;
+	msg.layer=layer;
+
+	return surface_send(surf->sockfd, &msg);
+}
+
+
+/*------------------------------------------------------------
+Send a command for a surface by its name, usually by a process
+other than the owner, such as a launcher to raise an APP.
+Params: Refer to egi_surface_sendmsg().
+
+Return:
+	0	OK
+	<0	Fails
+------------------------------------------------------------*/
+int egi_surface_command(const char *name, int cmd, int x1, int y1, int layer)
+{
+	EGI_SURFMSG msg;
+	int sockfd;
+	int ret;
+
+	if(name==NULL)
+		return -1;
+
+	sockfd=socket(AF_UNIX, SOCK_DGRAM, 0);
+	if(sockfd<0) {
+		printf("%s: Fail to create socket: %s\n", __func__, strerror(errno));
+		return -2;
+	}
+
+	memset(&msg, 0, sizeof(msg));
+	msg.cmd=cmd;
+	strncpy(msg.name, name, EGI_SURFACE_NAME_MAX-1);
+	msg.pid=getpid();
+	msg.x1=x1;	msg.y1=y1;
+	msg.layer=layer;
+
+	ret=surface_send(sockfd, &msg);
+	close(sockfd);
+
+	return ret<0 ? -3 : 0;
+}
+
+
+/*==================================  COMPOSITOR  ====================================*/
+
+/*--------------------------------------------------
+Find a surface by name.
+Return index in comp->surfs[], or -1 if not found.
+--------------------------------------------------*/
+static int comp_find(EGI_COMPOSITOR *comp, const char *name)
+{
+	int i;
+
+	for(i=0; i<comp->nsurfs; i++) {
+		if( strncmp(comp->surfs[i]->surf.name, name, EGI_SURFACE_NAME_MAX)==0 )
+			return i;
+	}
+
+	return -1;
+}
+
+/*--------------------------------------------------
+Sort surfaces by layer and stamp, bottom first.
+Insertion sort, there are only a few of them.
+--------------------------------------------------*/
+static void comp_sort(EGI_COMPOSITOR *comp)
+{
+	int i,j;
+	EGI_COMPSURF *cs;
+
+	for(i=1; i<comp->nsurfs; i++) {
+		cs=comp->surfs[i];
+		for(j=i; j>0; j--) {
+			if( comp->surfs[j-1]->layer < cs->layer
+			    || ( comp->surfs[j-1]->layer == cs->layer && comp->surfs[j-1]->stamp <= cs->stamp ) )
+				break;
+			comp->surfs[j]=comp->surfs[j-1];
+		}
+		comp->surfs[j]=cs;
+	}
+}
+
+/*----------------------------------------------------------------
+Add a rect of a surface to FB dirty rects.
+@x1,y1,x2,y2:	Damaged rect relative to the surface, x1<=x2, y1<=y2.
+----------------------------------------------------------------*/
+static void comp_damage(EGI_COMPOSITOR *comp, EGI_COMPSURF *cs, int x1, int y1, int x2, int y2)
+{
+	if(x1<0) x1=0;
+	if(y1<0) y1=0;
+	if(x2>cs->surf.head->width-1) x2=cs->surf.head->width-1;
+	if(y2>cs->surf.head->height-1) y2=cs->surf.head->height-1;
+	if( x1>x2 || y1>y2 )
+		return;
+
+	fb_dirty_add_pos(comp->fbdev, cs->x0+x1, cs->y0+y1, cs->x0+x2, cs->y0+y2);
+}
+
+static void comp_damage_all(EGI_COMPOSITOR *comp, EGI_COMPSURF *cs)
+{
+	comp_damage(comp, cs, 0, 0, cs->surf.head->width-1, cs->surf.head->height-1);
+}
+
+/*--------------------------------------------
+Remove comp->surfs[index] and free it.
+--------------------------------------------*/
+static void comp_remove(EGI_COMPOSITOR *comp, int index, bool remove_shm)
+{
+	EGI_COMPSURF *cs=comp->surfs[index];
+
+	if(cs->visible)
+		comp_damage_all(comp, cs);
+
+	surface_unmap(&cs->surf);
+	if(remove_shm)
+		egi_shmem_remove(cs->surf.shm_name);
+	free(cs);
+
+	comp->nsurfs--;
+	memmove(comp->surfs+index, comp->surfs+index+1, (comp->nsurfs-index)*sizeof(EGI_COMPSURF *));
+}
+
+/*----------------------------------------------
+Register a surface, by mapping its shmem.
+Return:
+	0	OK
+	<0	Fails
+----------------------------------------------*/
+static int comp_register(EGI_COMPOSITOR *comp, const EGI_SURFMSG *msg)
+{
+	EGI_COMPSURF *cs;
+	int index;
+
+	/* Re_register */
+	index=comp_find(comp, msg->name);
+	if(index>=0)
+		comp_remove(comp, index, false);
+
+	if( comp->nsurfs >= EGI_COMPOSITOR_MAX_SURFACES ) {
+		printf("%s: Surfaces reach Max. number %d!\n", __func__, EGI_COMPOSITOR_MAX_SURFACES);
+		return -1;
+	}
+	if( msg->x2<1 || msg->y2<1 )
+		return -1;
+
+	cs=calloc(1, sizeof(EGI_COMPSURF));
+	if(cs==NULL) {
+		printf("%s: Fail to calloc cs!\n", __func__);
+		return -2;
+	}
+	cs->surf.sockfd=-1;
+
+	if( surface_map(&cs->surf, msg->name, msg->x2, msg->y2, false) !=0 ) {
+		free(cs);
+		return -3;
+	}
+	if( cs->surf.head->magic != EGI_SURFACE_MAGIC || cs->surf.head->width != msg->x2
+						      || cs->surf.head->height != msg->y2 ) {
+		printf("%s: Surface '%s' data invalid!\n", __func__, msg->name);
+		surface_unmap(&cs->surf);
+		free(cs);
+		return -4;
+	}
+	if( !cs->surf.head->alpha_on )
+		cs->surf.eimg->alpha=NULL;
+
+	cs->x0=msg->x1;
+	cs->y0=msg->y1;
+	cs->layer=msg->layer;
+	cs->stamp=++comp->stamp;
+	cs->visible=true;
+
+	comp->surfs[comp->nsurfs++]=cs;
+	comp_sort(comp);
+	comp_damage_all(comp, cs);
+
+	return 0;
+}
+
+/*--------------------------------------------
+Handle a message from APPs.
+--------------------------------------------*/
+static void comp_handle_msg(EGI_COMPOSITOR *comp, EGI_SURFMSG *msg)
+{
+	EGI_COMPSURF *cs;
+	int index;
+
+	msg->name[EGI_SURFACE_NAME_MAX-1]='\0';
+
+	if( msg->cmd==SURFMSG_REGISTER ) {
+		if( comp_register(comp, msg) !=0 )
+			printf("%s: Fail to register surface '%s'.\n", __func__, msg->name);
+		return;
+	}
+
+	index=comp_find(comp, msg->name);
+	if(index<0)
+		return;
+	cs=comp->surfs[index];
+
+	switch(msg->cmd) {
+		case SURFMSG_UNREGISTER:
+			comp_remove(comp, index, false);
+			break;
+		case SURFMSG_DAMAGE:
+			if(cs->visible)
+				comp_damage(comp, cs, msg->x1, msg->y1, msg->x2, msg->y2);
+			break;
+		case SURFMSG_MOVE:
+			if(cs->visible)
+				comp_damage_all(comp, cs);
+			cs->x0=msg->x1;
+			cs->y0=msg->y1;
+			if(cs->visible)
+				comp_damage_all(comp, cs);
+			break;
+		case SURFMSG_LAYER:
+			cs->layer=msg->layer;
+			comp_sort(comp);
+			if(cs->visible)
+				comp_damage_all(comp, cs);
+			break;
+		case SURFMSG_SHOW:
+			cs->visible=true;
+			comp_damage_all(comp, cs);
+			break;
+		case SURFMSG_HIDE:
+			if(cs->visible)
+				comp_damage_all(comp, cs);
+			cs->visible=false;
+			break;
+		case SURFMSG_RAISE:
+			cs->visible=true;
+			cs->stamp=++comp->stamp;
+			comp_sort(comp);
+			comp_damage_all(comp, cs);
+			break;
+		default:
+			break;
+	}
+}
+
+/*-------------------------------------------------------------
+Convert a rect in raw FB coordinates to pos_rotate coordinates,
+as the reverse of fb_dirty_add_pos().
+-------------------------------------------------------------*/
+static void comp_raw_to_pos(FBDEV *fbdev, const FB_RECT *raw, FB_RECT *pos)
+{
+	int xres=fbdev->vinfo.xres;
+	int yres=fbdev->vinfo.yres;
+
+	switch(fbdev->pos_rotate) {
+		case 1:
+			pos->x1=raw->y1;		pos->x2=raw->y2;
+			pos->y1=(xres-1)-raw->x2;	pos->y2=(xres-1)-raw->x1;
+			break;
+		case 2:
+			pos->x1=(xres-1)-raw->x2;	pos->x2=(xres-1)-raw->x1;
+			pos->y1=(yres-1)-raw->y2;	pos->y2=(yres-1)-raw->y1;
+			break;
+		case 3:
+			pos->x1=(yres-1)-raw->y2;	pos->x2=(yres-1)-raw->y1;
+			pos->y1=raw->x1;		pos->y2=raw->x2;
+			break;
+		default:
+			*pos=*raw;
+			break;
+	}
+}
+
+/*------------------------------------------------------------------
+Compose all damaged areas in FB back buffer, then refresh them only.
+
+For each damaged rect, visible surfaces are blended bottom up, from
+the topmost opaque surface which covers the whole rect, or from the
+background color if there is no such one.
+-------------------------------------------------------------------*/
+static void comp_render(EGI_COMPOSITOR *comp)
+{
+	FBDEV *fbdev=comp->fbdev;
+	FB_RECT rects[FBDEV_MAX_DIRTY_RECTS];
+	FB_RECT pos;
+	EGI_COMPSURF *cs;
+	EGI_IMGBUF *eimg;
+	int n;
+	int i,j,k;
+	int start;
+	int x1,y1,x2,y2;
+	long int loc;
+
+	/* Take a copy, fb_blit_span() only adds rects within them */
+	n=fbdev->ndirty;
+	memcpy(rects, fbdev->dirty, n*sizeof(FB_RECT));
+
+	for(k=0; k<n; k++) {
+		comp_raw_to_pos(fbdev, &rects[k], &pos);
+
+		/* Find the topmost opaque surface covering the whole rect */
+		for(start=comp->nsurfs-1; start>=0; start--) {
+			cs=comp->surfs[start];
+			if( cs->visible && cs->surf.eimg->alpha==NULL
+			    && cs->x0 <= pos.x1 && cs->x0+cs->surf.eimg->width-1 >= pos.x2
+			    && cs->y0 <= pos.y1 && cs->y0+cs->surf.eimg->height-1 >= pos.y2 )
+				break;
+		}
+
+		/* Fill background */
+		if(start<0) {
+			for(i=pos.y1; i<=pos.y2; i++)
+				fb_blit_span(fbdev, fbdev->pos_rotate, pos.x1, i, pos.x2-pos.x1+1, NULL, NULL, comp->bkcolor);
+			start=0;
+		}
+
+		/* Blend surfaces bottom up */
+		for(j=start; j<comp->nsurfs; j++) {
+			cs=comp->surfs[j];
+			eimg=cs->surf.eimg;
+			if(!cs->visible)
+				continue;
+
+			x1= pos.x1 > cs->x0 ? pos.x1 : cs->x0;
+			y1= pos.y1 > cs->y0 ? pos.y1 : cs->y0;
+			x2= pos.x2 < cs->x0+eimg->width-1 ? pos.x2 : cs->x0+eimg->width-1;
+			y2= pos.y2 < cs->y0+eimg->height-1 ? pos.y2 : cs->y0+eimg->height-1;
+			if( x1>x2 || y1>y2 )
+				continue;
+
+			for(i=y1; i<=y2; i++) {
+				loc=(i-cs->y0)*eimg->width+(x1-cs->x0);
+				fb_blit_span( fbdev, fbdev->pos_rotate, x1, i, x2-x1+1, eimg->imgbuf+loc,
+						eimg->alpha ? eimg->alpha+loc : NULL, -1 );
+			}
+		}
+	}
+
+	fb_dirty_flush(fbdev, 0);
+}
+
+/*--------------------------------------------------------
+Drop surfaces whose owner processes are gone.
+--------------------------------------------------------*/
+static void comp_check_clients(EGI_COMPOSITOR *comp)
+{
+	int i;
+
+	for(i=comp->nsurfs-1; i>=0; i--) {
+		if( kill(comp->surfs[i]->surf.head->pid, 0)<0 && errno==ESRCH ) {
+			printf("%s: Owner of surface '%s' is gone.\n", __func__, comp->surfs[i]->surf.name);
+			comp_remove(comp, i, true);
+		}
+	}
+}
+
+static long comp_diffms(const struct timespec *tm_start, const struct timespec *tm_end)
+{
+	return (tm_end->tv_sec-tm_start->tv_sec)*1000+(tm_end->tv_nsec-tm_start->tv_nsec)/1000000;
+}
+
+
+/*----------------------------------------------------------------------
+Create a compositor on a real FBDEV, and open its socket.
+Only one compositor for a system, EGI_COMPOSITOR_SOCK will be replaced.
+
+Note:
+1. Dirty region tracking of the FBDEV is turned on.
+2. Surfaces are positioned in FB pos_rotate coordinates, so call
+   fb_position_rotate() before creating the compositor.
+
+@fbdev:		A real FBDEV, with back buffer enabled.
+@bkcolor:	Color for the area no surface covers.
+
+Return:
+	A pointer to EGI_COMPOSITOR	OK
+	NULL				Fails
+----------------------------------------------------------------------*/
+EGI_COMPOSITOR* egi_compositor_create(FBDEV *fbdev, EGI_16BIT_COLOR bkcolor)
+{
+	EGI_COMPOSITOR *comp;
+	struct sockaddr_un addr;
+	int i;
+
+	if( fbdev==NULL || fbdev->virt || fbdev->map_bk==NULL ) {
+		printf("%s: Input FBDEV is invalid!\n", __func__);
+		return NULL;
+	}
+
+	comp=calloc(1, sizeof(EGI_COMPOSITOR));
+	if(comp==NULL) {
+		printf("%s: Fail to calloc comp!\n", __func__);
+		return NULL;
+	}
+	comp->fbdev=fbdev;
+	comp->bkcolor=bkcolor;
+
+	comp->sockfd=socket(AF_UNIX, SOCK_DGRAM, 0);
+	if(comp->sockfd<0) {
+		printf("%s: Fail to create socket: %s\n", __func__, strerror(errno));
+		free(comp);
+		return NULL;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family=AF_UNIX;
+	strncpy(addr.sun_path, EGI_COMPOSITOR_SOCK, sizeof(addr.sun_path)-1);
+	unlink(EGI_COMPOSITOR_SOCK);
+	if( bind(comp->sockfd, (struct sockaddr *)&addr, sizeof(addr)) <0 ) {
+		printf("%s: Fail to bind '%s': %s\n", __func__, EGI_COMPOSITOR_SOCK, strerror(errno));
+		close(comp->sockfd);
+		free(comp);
+		return NULL;
+	}
+	fcntl(comp->sockfd, F_SETFL, fcntl(comp->sockfd, F_GETFL)|O_NONBLOCK);
+
+	/* Clear screen with bkcolor */
+	fb_filo_off(fbdev);
+	fb_dirty_off(fbdev);
+	for(i=0; i<fbdev->pos_yres; i++)
+		fb_blit_span(fbdev, fbdev->pos_rotate, 0, i, fbdev->pos_xres, NULL, NULL, bkcolor);
+	fb_page_refresh(fbdev, 0);
+	fb_dirty_on(fbdev);
+
+	return comp;
+}
+
+
+/*----------------------------------------------------
+Free a compositor, all surfaces are unmapped, but their
+shmem are NOT removed.
+----------------------------------------------------*/
+void egi_compositor_free(EGI_COMPOSITOR **comp)
+{
+	if(comp==NULL || *comp==NULL)
+		return;
+
+	while( (*comp)->nsurfs >0 )
+		comp_remove(*comp, (*comp)->nsurfs-1, false);
+
+	close((*comp)->sockfd);
+	unlink(EGI_COMPOSITOR_SOCK);
+	fb_dirty_off((*comp)->fbdev);
+
+	free(*comp);
+	*comp=NULL;
+}
+
+
+/*-------------------------------------------------------------------------
+Run the compositor: receive messages from APPs, and refresh damaged areas,
+at most once every EGI_COMPOSITOR_MINGAP ms.
+
+@comp:		An EGI_COMPOSITOR.
+@sigstop:	Return when it's set to true, or NULL to run forever.
+
+Return:
+	0	OK, stopped by sigstop.
+	<0	Fails
+--------------------------------------------------------------------------*/
+int egi_compositor_run(EGI_COMPOSITOR *comp, bool *sigstop)
+{
+	struct pollfd pfd;
+	struct timespec tm_now, tm_flush, tm_check;
+	EGI_SURFMSG msg;
+	int timeout;
+	long ms;
+
+	if(comp==NULL)
+		return -1;
+
+	pfd.fd=comp->sockfd;
+	pfd.events=POLLIN;
+
+	clock_gettime(CLOCK_MONOTONIC, &tm_flush);
+	tm_check=tm_flush;
+
+	while( sigstop==NULL || !*sigstop ) {
+
+		/* Wait for messages, or time to flush */
+		timeout=1000;
+		if( comp->fbdev->ndirty >0 ) {
+			clock_gettime(CLOCK_MONOTONIC, &tm_now);
+			ms=comp_diffms(&tm_flush, &tm_now);
+			timeout= ms < EGI_COMPOSITOR_MINGAP ? EGI_COMPOSITOR_MINGAP-ms : 0;
+		}
+		if( poll(&pfd, 1, timeout) <0 && errno != EINTR ) {
+			printf("%s: poll(): %s\n", __func__, strerror(errno));
+			return -2;
+		}
+
+		/* Handle all messages */
+		while( recv(comp->sockfd, &msg, sizeof(msg), 0) == sizeof(msg) )
+			comp_handle_msg(comp, &msg);
+
+		clock_gettime(CLOCK_MONOTONIC, &tm_now);
+
+		if( comp_diffms(&tm_check, &tm_now) >= 1000 ) {
+			comp_check_clients(comp);
+			tm_check=tm_now;
+		}
+
+		if( comp->fbdev->ndirty >0 && comp_diffms(&tm_flush, &tm_now) >= EGI_COMPOSITOR_MINGAP ) {
+			comp_render(comp);
+			tm_flush=tm_now;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,118 @@
+/*------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+Shared-memory surfaces and a compositor for EGI APPs.
+
+1. The compositor process owns the FB(init_fbdev), while each APP draws
+   to an EGI_SURFACE, which is an EGI_IMGBUF in an egi_shmem region, and
+   works as a virtual FBDEV by init_virt_fbdev().
+2. APPs submit damage rects by EGI_SURFMSG datagrams through a UNIX
+   domain socket, the compositor blends visible surfaces layer by layer
+   with alpha, and refreshes only damaged areas of the FB.
+3. To switch APPs, just raise a surface, no full screen repainting.
+   A surface with higher layer, such as a status bar, stays over others.
+
+Midas Zhou
+------------------------------------------------------------------*/
+#ifndef __EGI_SURFACE_H__
+#define __EGI_SURFACE_H__
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include "egi_imgbuf.h"
+#include "egi_shmem.h"
+
+typedef struct fbdev FBDEV;  /* Just a declaration, referring to definition in egi_fbdev.h */
+
+#define EGI_COMPOSITOR_SOCK		"/tmp/.egi_compositor"
+#define EGI_COMPOSITOR_MAX_SURFACES	16
+#define EGI_COMPOSITOR_MINGAP		15	/* Min. gap between two FB flushes, in ms */
+#define EGI_SURFACE_NAME_MAX		32
+#define EGI_SURFACE_MAGIC		0x45535246	/* "ESRF" */
+
+/* Layers for APPs, surfaces with bigger layer number are put on top */
+enum egi_surface_layer {
+	SURF_LAYER_BKGROUND	=0,
+	SURF_LAYER_APP		=1,
+	SURF_LAYER_STATUSBAR	=2,
+	SURF_LAYER_OVERLAY	=3,
+};
+
+/* Commands of EGI_SURFMSG */
+enum egi_surfmsg_cmd {
+	SURFMSG_REGISTER	=1,	/* x1,y1: position, x2,y2: width,height, layer, alpha_on */
+	SURFMSG_UNREGISTER	=2,
+	SURFMSG_DAMAGE		=3,	/* x1,y1,x2,y2: damaged rect, relative to the surface */
+	SURFMSG_MOVE		=4,	/* x1,y1: new position */
+	SURFMSG_LAYER		=5,	/* layer: new layer */
+	SURFMSG_SHOW		=6,
+	SURFMSG_HIDE		=7,
+	SURFMSG_RAISE		=8,	/* Show and put on top of surfaces in the same layer */
+};
+
+/* Head of surface data in shared memory, followed by color[width*height] and alpha[width*height] */
+typedef struct egi_surface_head {
+	unsigned int	magic;		/* EGI_SURFACE_MAGIC */
+	pid_t		pid;		/* Owner process */
+	int		width;
+	int		height;
+	bool		alpha_on;	/* alpha data is effective */
+} EGI_SURFACE_HEAD;
+
+/* Message from APPs to the compositor */
+typedef struct egi_surfmsg {
+	int	cmd;				/* enum egi_surfmsg_cmd */
+	char	name[EGI_SURFACE_NAME_MAX];	/* Surface name */
+	pid_t	pid;				/* Sender */
+	int	x1, y1;
+	int	x2, y2;
+	int	layer;
+	bool	alpha_on;
+} EGI_SURFMSG;
+
+/* Surface for an APP */
+typedef struct egi_surface {
+	char		name[EGI_SURFACE_NAME_MAX];
+	EGI_SHMEM	shmem;
+	char		shm_name[EGI_SURFACE_NAME_MAX+16];
+	EGI_SURFACE_HEAD *head;		/* In shmem */
+	EGI_IMGBUF	*eimg;		/* imgbuf and alpha in shmem, for init_virt_fbdev() */
+	int		sockfd;		/* To send EGI_SURFMSG */
+	bool		owner;		/* True: created by this process, remove shmem when free */
+} EGI_SURFACE;
+
+/* Surface as seen by the compositor */
+typedef struct egi_compsurf {
+	EGI_SURFACE	surf;
+	int		x0, y0;		/* Position relative to screen, pos_rotate applied */
+	int		layer;
+	unsigned int	stamp;		/* Raise stamp, bigger on top in the same layer */
+	bool		visible;
+} EGI_COMPSURF;
+
+typedef struct egi_compositor {
+	FBDEV		*fbdev;
+	int		sockfd;
+	EGI_16BIT_COLOR	bkcolor;	/* Where no surface covers */
+	int		nsurfs;
+	EGI_COMPSURF	*surfs[EGI_COMPOSITOR_MAX_SURFACES];	/* Sorted by layer and stamp, bottom first */
+	unsigned int	stamp;
+} EGI_COMPOSITOR;
+
+
+/* For APPs */
+EGI_SURFACE*	egi_surface_create(const char *name, int x0, int y0, int width, int height,
+						int layer, bool alpha_on);
+void		egi_surface_free(EGI_SURFACE **surf);
+int		egi_surface_damage(EGI_SURFACE *surf, int x1, int y1, int x2, int y2);
+int		egi_surface_sendmsg(EGI_SURFACE *surf, int cmd, int x1, int y1, int layer);
+int		egi_surface_command(const char *name, int cmd, int x1, int y1, int layer);
+
+/* For the compositor */
+EGI_COMPOSITOR* egi_compositor_create(FBDEV *fbdev, EGI_16BIT_COLOR bkcolor);
+void		egi_compositor_free(EGI_COMPOSITOR **comp);
+int		egi_compositor_run(EGI_COMPOSITOR *comp, bool *sigstop);
+
+#endif
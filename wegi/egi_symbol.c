@@ -266,6 +266,8 @@ EGI_SYMPAGE sympg_heweather =
 
 /* -----  All static functions ----- */
 static uint16_t *symbol_load_page(EGI_SYMPAGE *sym_page);
+static int symbol_atlas_string_writeFB(FBDEV *fb_dev, const EGI_SYMPAGE *sym_page,
+			int fontcolor, int transpcolor, int x0, int y0, const char* str, int opaque);
 
 /* ----------------------------------------------------------------------
 TODO: Only for one symbol NOW!!!!!
@@ -327,6 +329,10 @@ int symbol_load_page_from_imgbuf(EGI_SYMPAGE *sym_page, EGI_IMGBUF *imgbuf)
 		sym_page->bkcolor=-1; /* use alpha instead of bkcolor */
 	}
 
+	/* build glyph atlas, the page is still usable without it */
+	if( symbol_build_atlas(sym_page)!=0 )
+		printf("%s: Fail to build glyph atlas!\n",__func__);
+
 	return 0;
 }
 
@@ -547,6 +553,11 @@ static uint16_t *symbol_load_page(EGI_SYMPAGE *sym_page)
 #endif /*  test end -----------------------------------*/
 
 	close(fd);
+
+	/* build glyph atlas, the page is still usable without it */
+	if( symbol_build_atlas(sym_page)!=0 )
+		printf("symbol_load_page(): fail to build glyph atlas for %s!\n", sym_page->path);
+
 	EGI_PLOG(LOGLV_INFO,"symbol_load_page(): succeed to load symbol image file %s!\n", sym_page->path);
 	//printf("sym_page->data = %p \n",sym_page->data);
 	return (uint16_t *)sym_page->data;
@@ -579,6 +590,8 @@ void symbol_release_page(EGI_SYMPAGE *sym_page)
 		sym_page->symoffset=NULL;
 	}
 
+	symbol_free_atlas(sym_page);
+
 	/* TODO:  1. For symbol page: symwidth is NOT dynamically allocated
 	 *	  2. For FTsymbol page: symwidth is dynamically allocated
 	 */
@@ -597,6 +610,188 @@ void symbol_release_page(EGI_SYMPAGE *sym_page)
 }
 
 
+/*--------------------------------------------------------------------
+Count runs of a symbol row, and save them to runs[] if it's not NULL.
+Effective pixels are those with alpha>0, or NOT bkcolor if the page
+has no alpha.
+
+@sym_page:	symbol page
+@code:		symbol code
+@row:		row in the symbol
+@runs:		to save runs, or NULL just to count.
+
+Return:
+	Number of runs in the row.
+---------------------------------------------------------------------*/
+static int symbol_atlas_scanrow(const EGI_SYMPAGE *sym_page, int code, int row, EGI_SYMRUN *runs)
+{
+	int j, js;
+	int width=sym_page->symwidth[code];
+	int poff=sym_page->symoffset[code]+row*width;
+	int nruns=0;
+
+	for(j=0; j<width; ) {
+		/* skip transparent pixels */
+		if(sym_page->alpha) {
+			while( j<width && sym_page->alpha[poff+j]==0 ) j++;
+		}
+		else {
+			while( j<width && sym_page->data[poff+j]==sym_page->bkcolor ) j++;
+		}
+		if(j==width)
+			break;
+
+		/* get a run */
+		js=j;
+		if(sym_page->alpha) {
+			while( j<width && sym_page->alpha[poff+j]!=0 ) j++;
+		}
+		else {
+			while( j<width && sym_page->data[poff+j]!=sym_page->bkcolor ) j++;
+		}
+		if(runs) {
+			runs[nruns].row=row;
+			runs[nruns].x=js;
+			runs[nruns].len=j-js;
+		}
+		nruns++;
+	}
+
+	return nruns;
+}
+
+
+/*--------------------------------------------------------------------------
+Build glyph atlas for a symbol page, it's called when a page is loaded.
+
+Each symbol is encoded as horizontal runs of effective pixels, so
+symbol_string_writeFB() can write runs to FB directly, instead of checking
+transparent color pixel by pixel. Alpha values of runs are packed and
+adjusted as egi_16bitColor_blend() does, so the result is the same as
+symbol_writeFB().
+A cached width table is also built for symbol_string_pixlen().
+
+Note: Not for FT2 pages, which hold only one character.
+
+@sym_page:	A loaded symbol page.
+
+Return:
+	0	OK
+	<0	Fails
+---------------------------------------------------------------------------*/
+int symbol_build_atlas(EGI_SYMPAGE *sym_page)
+{
+	EGI_SYMATLAS *atlas;
+	int i,j,k;
+	int row;
+	int poff;
+	int nruns;
+	int npix;
+	int pos;
+	int a;
+	const EGI_SYMRUN *run;
+
+	if( sym_page==NULL || sym_page->symtype==symtype_FT2 || sym_page->maxnum<0 )
+		return -1;
+	if( sym_page->symwidth==NULL || sym_page->symoffset==NULL )
+		return -1;
+	if( sym_page->data==NULL && sym_page->alpha==NULL )
+		return -1;
+
+	/* rebuild */
+	symbol_free_atlas(sym_page);
+
+	atlas=calloc(1, sizeof(EGI_SYMATLAS));
+	if(atlas==NULL) {
+		printf("%s: Fail to calloc atlas!\n",__func__);
+		return -2;
+	}
+
+	/* count runs and packed alpha */
+	nruns=0;
+	npix=0;
+	for(i=0; i<=sym_page->maxnum; i++) {
+		for(row=0; row<sym_page->symheight; row++)
+			nruns += symbol_atlas_scanrow(sym_page, i, row, NULL);
+	}
+
+	atlas->runs=malloc( (nruns>0 ? nruns : 1)*sizeof(EGI_SYMRUN) );
+	atlas->runidx=malloc( (sym_page->maxnum+2)*sizeof(int) );
+	atlas->alphaidx=malloc( (sym_page->maxnum+1)*sizeof(int) );
+	if( atlas->runs==NULL || atlas->runidx==NULL || atlas->alphaidx==NULL ) {
+		printf("%s: Fail to malloc runs!\n",__func__);
+		goto END_FAIL;
+	}
+
+	/* save runs */
+	nruns=0;
+	for(i=0; i<=sym_page->maxnum; i++) {
+		atlas->runidx[i]=nruns;
+		atlas->alphaidx[i]=npix;
+		for(row=0; row<sym_page->symheight; row++)
+			nruns += symbol_atlas_scanrow(sym_page, i, row, atlas->runs+nruns);
+		for(k=atlas->runidx[i]; k<nruns; k++)
+			npix += atlas->runs[k].len;
+	}
+	atlas->runidx[i]=nruns;
+	atlas->nruns=nruns;
+
+	/* pack alpha values of runs */
+	if(sym_page->alpha) {
+		atlas->alpha=malloc( npix>0 ? npix : 1 );
+		if(atlas->alpha==NULL) {
+			printf("%s: Fail to malloc alpha!\n",__func__);
+			goto END_FAIL;
+		}
+		pos=0;
+		for(i=0; i<=sym_page->maxnum; i++) {
+			for(k=atlas->runidx[i]; k<atlas->runidx[i+1]; k++) {
+				run=atlas->runs+k;
+				poff=sym_page->symoffset[i]+run->row*sym_page->symwidth[i]+run->x;
+				for(j=0; j<run->len; j++) {
+					/* Same as egi_16bitColor_blend() */
+					a=sym_page->alpha[poff+j]*3/2;
+					atlas->alpha[pos++]= a>255 ? 255 : a;
+				}
+			}
+		}
+	}
+
+	/* width table */
+	for(i=0; i<256 && i<=sym_page->maxnum; i++)
+		atlas->advance[i]=sym_page->symwidth[i];
+
+	sym_page->atlas=atlas;
+
+	EGI_PDEBUG(DBG_SYMBOL,"%d runs, %d alpha bytes in the atlas.\n", nruns, sym_page->alpha ? npix : 0);
+	return 0;
+
+END_FAIL:
+	free(atlas->runs);
+	free(atlas->runidx);
+	free(atlas->alphaidx);
+	free(atlas);
+	return -3;
+}
+
+
+/*----------------------------------
+	Free glyph atlas of a page
+-----------------------------------*/
+void symbol_free_atlas(EGI_SYMPAGE *sym_page)
+{
+	if(sym_page==NULL || sym_page->atlas==NULL)
+		return;
+
+	free(sym_page->atlas->runs);
+	free(sym_page->atlas->runidx);
+	free(sym_page->atlas->alphaidx);
+	free(sym_page->atlas->alpha);
+	free(sym_page->atlas);
+	sym_page->atlas=NULL;
+}
+
+
 /*-----------------------------------------------------------------------
 check integrity of a ((loaded)) page structure
 
@@ -708,18 +903,27 @@ void symbol_save_pagemem(EGI_SYMPAGE *sym_page)
 -------------------------------------------*/
 int symbol_string_pixlen(char *str, const EGI_SYMPAGE *font)
 {
-	int i;
-        int len=strlen(str);
+	const unsigned char *p=(const unsigned char *)str;
 	int pixlen=0;
 
-	if( len==0 || font==NULL)
+	if( str==NULL || font==NULL)
 		return 0;
 
-        for(i=0;i<len;i++)
+	/* use cached width table, 0 for codes out of range */
+	if(font->atlas) {
+		while(*p)
+			pixlen += font->atlas->advance[*p++];
+		return pixlen;
+	}
+
+	if(font->symwidth==NULL)
+		return 0;
+
+        for( ; *p; p++)
         {
                 /* only if in code range */
-                if( str[i] <= font->maxnum )
-                           pixlen += font->symwidth[ (unsigned int)str[i] ];
+                if( *p <= font->maxnum )
+                           pixlen += font->symwidth[*p];
         }
 
 	return pixlen;
@@ -845,6 +1049,10 @@ void symbol_writeFB(FBDEV *fb_dev, const EGI_SYMPAGE *sym_page, 	\
 	}
 
 
+	/* mark dirty area of the symbol */
+	if(virt_fb==NULL)
+		fb_dirty_add_pos(fb_dev, x0, y0, x0+width-1, y0+height-1);
+
 	/* init palpha for non FT symobls */
 	if(sym_page->alpha == NULL) {
 		palpha=255;
@@ -1146,6 +1354,125 @@ void symbol_writeFB(FBDEV *fb_dev, const EGI_SYMPAGE *sym_page, 	\
 }
 
 
+/*---------------------------------------------------------------------------------
+Write a symbol string with runs of glyph atlas, for symbol_string_writeFB().
+
+The string is clipped to the screen only once, then each run is cut to the clipped
+window and written to FB by fb_blit_span(), and dirty area of the string is also
+marked only once. Result is the same as calling symbol_writeFB() for each symbol.
+
+It does NOT apply for following cases, which are left to symbol_writeFB():
+1. The page has no atlas.
+2. opaque<255, including luminance decrement.
+3. TESTFONT_COLOR_FLIP for pages without alpha.
+   Or transpcolor>=0 but NOT bkcolor for pages without alpha, as runs are masks of
+   pixels which are NOT bkcolor.
+4. Pages with alpha, if FB is 32bits, or if virtual FB has alpha data (sum of
+   alpha differs).
+5. Rotated virtual FB.
+
+Params: see symbol_string_writeFB(), transpcolor is already reset by the caller.
+
+Return:
+	0	OK, the string is written(or out of screen).
+	<0	Not applicable.
+----------------------------------------------------------------------------------*/
+static int symbol_atlas_string_writeFB(FBDEV *fb_dev, const EGI_SYMPAGE *sym_page,
+			int fontcolor, int transpcolor, int x0, int y0, const char* str, int opaque)
+{
+	const EGI_SYMATLAS *atlas=sym_page->atlas;
+	const unsigned char *p;
+	const EGI_SYMRUN *run, *end;
+	const unsigned char *alpha;
+	const uint16_t *data;
+	FB_BLITWIN win;
+	int blit_rotate;
+	int height=sym_page->symheight;
+	int width;
+	int code;
+	int x;
+	int xs, xe, ys, ye;	/* clipped window of the string */
+	int y, xa, xb;		/* a run clipped to [xa xb) */
+	int row;
+
+	if( fb_dev==NULL || str==NULL || atlas==NULL || opaque<255 )
+		return -1;
+
+	if(sym_page->alpha) {
+		#ifdef LETS_NOTE
+		return -1;
+		#endif
+		if( fb_dev->virt_fb && fb_dev->virt_fb->alpha )
+			return -1;
+		if( sym_page->data==NULL && fontcolor<0 )
+			return -1;
+	}
+	else if( TESTFONT_COLOR_FLIP || sym_page->data==NULL
+		 || ( transpcolor>=0 && transpcolor!=sym_page->bkcolor ) ) {
+		return -1;
+	}
+
+	if( fb_dev->virt_fb && fb_dev->pos_rotate!=0 )
+		return -1;
+
+	/* clip the string only once */
+	if( fb_blit_clip( fb_dev, fb_dev->pos_rotate, 0, 0, 0, 0, x0, y0,
+				symbol_string_pixlen((char *)str, sym_page), height, false, &win ) !=0 )
+		return 0;
+	xs=win.xw;  xe=win.xw+win.w;
+	ys=win.yw;  ye=win.yw+win.h;
+
+	/* mark dirty area of the string only once, not again by each span */
+	if(fb_dev->virt_fb==NULL)
+		fb_dirty_add_pos(fb_dev, xs, ys, xe-1, ye-1);
+	blit_rotate=win.pos_rotate|FB_BLIT_NODIRTY;
+
+	for( p=(const unsigned char *)str, x=x0; *p && x<xe; x+=atlas->advance[code], p++ ) {
+		code=*p;
+		if( code > sym_page->maxnum )
+			continue;
+		width=sym_page->symwidth[code];
+		if( x+width <= xs )
+			continue;
+
+		data= sym_page->data ? sym_page->data+sym_page->symoffset[code] : NULL;
+
+		/* no transparent pixel, write all rows */
+		if( transpcolor<0 && sym_page->alpha==NULL ) {
+			xa= x<xs ? xs : x;
+			xb= x+width>xe ? xe : x+width;
+			for(row=ys-y0; row<ye-y0; row++)
+				fb_blit_span(fb_dev, blit_rotate, xa, y0+row, xb-xa,
+							data+row*width+(xa-x), NULL, fontcolor);
+			continue;
+		}
+
+		alpha= atlas->alpha ? atlas->alpha+atlas->alphaidx[code] : NULL;
+		end=atlas->runs+atlas->runidx[code+1];
+		for( run=atlas->runs+atlas->runidx[code]; run<end; alpha= alpha ? alpha+run->len : NULL, run++ ) {
+			y=y0+run->row;
+			if( y<ys )
+				continue;
+			if( y>=ye )
+				break;
+
+			xa=x+run->x;
+			xb=xa+run->len;
+			if( xa<xs ) xa=xs;
+			if( xb>xe ) xb=xe;
+			if( xa>=xb )
+				continue;
+
+			fb_blit_span( fb_dev, blit_rotate, xa, y, xb-xa,
+				      data ? data+run->row*width+(xa-x) : NULL,
+				      alpha ? alpha+(xa-x-run->x) : NULL, fontcolor );
+		}
+	}
+
+	return 0;
+}
+
+
 /*------------------------------------------------------------------------------
 1. write a symbol/font string to FB device.
 2. Write them at the same line.
@@ -1190,6 +1517,10 @@ void symbol_string_writeFB(FBDEV *fb_dev, const EGI_SYMPAGE *sym_page, 	\
 	if(transpcolor>=0 && sym_page->bkcolor>=0 )
 		transpcolor=sym_page->bkcolor;
 
+	/* write runs of glyph atlas, if applicable */
+	if( symbol_atlas_string_writeFB(fb_dev, sym_page, fontcolor, transpcolor, x0, y0, str, opaque)==0 )
+		return;
+
 	while(*p) /* code '0' will be deemed as end token here !!! */
 	{
 		symbol_writeFB(fb_dev,sym_page,fontcolor,transpcolor,x,y0,*p,opaque);/* at same line, so y=y0 */
@@ -50,9 +50,34 @@ enum symbol_type
 };
 
 
+/*
+ * A horizontal run of effective pixels in a symbol, see symbol_build_atlas().
+ * Runs of a symbol are stored row by row, and left to right in a row.
+ */
+typedef struct symbol_run {
+	uint16_t row;		/* Row in the symbol */
+	uint16_t x;		/* Start pixel in the row */
+	uint16_t len;		/* Number of pixels */
+} EGI_SYMRUN;
+
+/*
+ * Glyph atlas of a symbol page, precompiled from .data/.alpha when the page is loaded.
+ * 1. Without .alpha, runs are 1-bit masks of pixels which are NOT bkcolor.
+ * 2. With .alpha, runs cover pixels with alpha>0, and their alpha values are packed
+ *    into .alpha in the same order as the runs, adjusted as egi_16bitColor_blend() does.
+ */
+typedef struct symbol_atlas {
+	int		nruns;		/* Total runs of all symbols */
+	EGI_SYMRUN	*runs;		/* Runs of all symbols, symbol by symbol */
+	int		*runidx;	/* [maxnum+2], runs of symbol i: runs[runidx[i]] ~ runs[runidx[i+1]-1] */
+	int		*alphaidx;	/* [maxnum+1], packed alpha of symbol i starts from alpha[alphaidx[i]] */
+	unsigned char	*alpha;		/* Packed alpha values, or NULL if the page has no alpha */
+	int		advance[256];	/* Cached width table, 0 for codes out of range */
+} EGI_SYMATLAS;
+
 /*
  * symbol page struct
- * TODO: Cache FT2 characters if possible.
+ * NOTE: FT2 characters are cached in egi_FTsymbol.c, see FTglyph_get().
  * NOTE:
  *       1. For FT(FreeType2) wchar page, a symbl_page holds only one character. and many memebers
  *	    are not applicable then.
@@ -107,6 +132,9 @@ struct symbol_page
 	int *symb_code; /* default NULL, if not applicable
 			 * MAYBE: applicable for FT page
 			 */
+
+	/* glyph atlas for fast string writing, NULL if not built */
+	EGI_SYMATLAS *atlas;
 };
 
 
@@ -133,6 +161,8 @@ void 	symbol_release_page(EGI_SYMPAGE *sym_page);
 int 	symbol_check_page(const EGI_SYMPAGE *sym_page, char *func);
 void 	symbol_save_pagemem(EGI_SYMPAGE *sym_page);
 int 	symbol_load_page_from_imgbuf(EGI_SYMPAGE *sym_page, EGI_IMGBUF *imgbuf);
+int 	symbol_build_atlas(EGI_SYMPAGE *sym_page);
+void 	symbol_free_atlas(EGI_SYMPAGE *sym_page);
 
 /*--------------------------------------------------------------------------------------------
 transpcolor:    >=0 transparent pixel will not be written to FB, so backcolor is shown there.
@@ -7,6 +7,10 @@ published by the Free Software Foundation.
 NOTE:
 1. egi_touch_loopread() will wait until live_touch_data.updated is fals,
    so discard first egi_touch_getdata() before loop call it.
+2. egi_touch_loopread() also pushes touch data into an event queue, and
+   egi_touch_waitdata() sleeps on it until an event arrives, so a page
+   routine needs NOT spin on egi_touch_getdata(). Once the event queue is
+   in use, loopread will NOT wait for live_touch_data to be read out.
 
 
 TODO:
@@ -49,6 +53,18 @@ static bool tok_loopread_nowait;	/* If ture, touch_loopread will run nonstop,
 					 * after last data is read out.
 					 */
 
+/* Touch event queue: mutex protected data */
+#define TOUCH_EVQUEUE_SIZE	32	/* Max. touch events in queue */
+static EGI_TOUCH_DATA	evqueue[TOUCH_EVQUEUE_SIZE];  /* ring buffer of touch events */
+static int		evq_head;	/* index of the oldest event */
+static int		evq_count;	/* number of events in queue */
+static bool		evq_wakeup;	/* To wake up egi_touch_waitdata() without event */
+static bool		evq_on;		/* Event queue is in use, set by egi_touch_waitdata() */
+static enum egi_touch_status evq_last_status=released_hold; /* status of last pushed event */
+static unsigned int	evq_dropped;	/* events dropped as queue is full */
+static pthread_mutex_t	evq_mutex=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	evq_cond;	/* To signal a new event or wakeup, CLOCK_MONOTONIC */
+
 /*----------------------------------------------------------------------------------
 Wait for a touch 'pressing' event, return on the event or
 when time is out.
@@ -239,6 +255,187 @@ int egi_touch_timeWait_release(unsigned int s, unsigned int ms, EGI_TOUCH_DATA *
 
 
 
+/*-----------------------------------------------------------------------
+Push touch data into the event queue, called by egi_touch_loopread().
+
+Coalescing:
+1. 'released_hold' is pushed only once after 'releasing', repeated idle
+   status will NOT be queued.
+2. A 'pressed_hold' replaces the newest queued 'pressed_hold', as
+   coord and dx/dy are all up to date in the latter one.
+3. If the queue is full, the oldest event is dropped.
+------------------------------------------------------------------------*/
+static void egi_touch_pushevent(const EGI_TOUCH_DATA *data)
+{
+	int tail;
+
+	if( pthread_mutex_lock(&evq_mutex) !=0 )
+		return;
+
+	if( data->status==released_hold && evq_last_status==released_hold ) {
+		pthread_mutex_unlock(&evq_mutex);
+		return;
+	}
+	evq_last_status=data->status;
+
+	/* Coalesce drag samples */
+	if( evq_count>0 && data->status==pressed_hold ) {
+		tail=(evq_head+evq_count-1)%TOUCH_EVQUEUE_SIZE;
+		if( evqueue[tail].status==pressed_hold ) {
+			evqueue[tail]=*data;
+			pthread_mutex_unlock(&evq_mutex);
+			return;
+		}
+	}
+
+	/* Drop the oldest one if full */
+	if( evq_count==TOUCH_EVQUEUE_SIZE ) {
+		evq_head=(evq_head+1)%TOUCH_EVQUEUE_SIZE;
+		evq_count--;
+		evq_dropped++;
+	}
+
+	tail=(evq_head+evq_count)%TOUCH_EVQUEUE_SIZE;
+	evqueue[tail]=*data;
+	evqueue[tail].updated=true;
+	evq_count++;
+
+	pthread_cond_signal(&evq_cond);
+	pthread_mutex_unlock(&evq_mutex);
+}
+
+
+/*----------------------------------------------------------------------------
+Wait for a touch event in the event queue, return on the event, or when
+time is out or egi_touch_wakeup() is called.
+The caller sleeps on a cond and costs no CPU when there is no touch.
+
+@touch_data:  To pass out touch data of the event, data->updated is true.
+	      If no event, data->updated=false and data->status=released_hold.
+	      If NULL, ignored.
+@ms:	      Timeout in Millisecond. 0 as no wait.
+
+Retrun:
+	0	Ok, an event is read out.
+	>0	Time out, or woken up by egi_touch_wakeup().
+	<0	Fails, touch_loopread is NOT running.
+-----------------------------------------------------------------------------*/
+int egi_touch_waitdata(EGI_TOUCH_DATA *touch_data, unsigned int ms)
+{
+	struct timespec outtime;
+	int wait_ret=0;
+	int ret;
+
+	/* Assert thread loop_read is running */
+	if(!tok_loopread_running)
+		return -1;
+
+	clock_gettime(CLOCK_MONOTONIC, &outtime);
+	outtime.tv_sec += ms/1000;
+	outtime.tv_nsec += (ms%1000)*1000000;
+	if(outtime.tv_nsec >= 1000000000) {
+		outtime.tv_sec += 1;
+		outtime.tv_nsec -= 1000000000;
+	}
+
+	if( pthread_mutex_lock(&evq_mutex) !=0 ) {
+                printf("%s: Fail to lock evq_mutex!\n",__func__);
+		return -2;
+	}
+/*  --- >>>  Critical Zone  */
+	evq_on=true;
+
+	while( evq_count==0 && !evq_wakeup && ms>0 && wait_ret!=ETIMEDOUT ) {
+		wait_ret=pthread_cond_timedwait(&evq_cond, &evq_mutex, &outtime);
+		if( wait_ret!=0 && wait_ret!=ETIMEDOUT )
+			break;
+	}
+	evq_wakeup=false;
+
+	if( evq_count>0 ) {
+		if(touch_data!=NULL)
+			*touch_data=evqueue[evq_head];
+		evq_head=(evq_head+1)%TOUCH_EVQUEUE_SIZE;
+		evq_count--;
+		ret=0;
+	}
+	else {
+		if(touch_data!=NULL) {
+			touch_data->updated=false;
+			touch_data->status=released_hold;
+		}
+		ret=1;
+	}
+
+	pthread_mutex_unlock(&evq_mutex);
+/*  --- <<<   Critical Zone  */
+
+	return ret;
+}
+
+
+/*-------------------------------------------------------
+Wake up the thread waiting in egi_touch_waitdata(),
+Usually called by page runners when the page needs
+to be refreshed.
+--------------------------------------------------------*/
+void egi_touch_wakeup(void)
+{
+	if( pthread_mutex_lock(&evq_mutex) !=0 )
+		return;
+
+	evq_wakeup=true;
+	pthread_cond_signal(&evq_cond);
+
+	pthread_mutex_unlock(&evq_mutex);
+}
+
+
+/*-------------------------------------------------------
+Discard all touch events in the queue.
+--------------------------------------------------------*/
+void egi_touch_flushdata(void)
+{
+	if( pthread_mutex_lock(&evq_mutex) !=0 )
+		return;
+
+	evq_head=0;
+	evq_count=0;
+
+	pthread_mutex_unlock(&evq_mutex);
+}
+
+
+/*-------------------------------------------------------
+Return true if the touch state machine is released, i.e.
+the last status it reported is 'released_hold'.
+--------------------------------------------------------*/
+bool egi_touch_released(void)
+{
+	bool released;
+
+	if( pthread_mutex_lock(&evq_mutex) !=0 )
+		return false;
+
+	released=( evq_last_status==released_hold );
+
+	pthread_mutex_unlock(&evq_mutex);
+
+	return released;
+}
+
+
+/*-------------------------------------------------------
+Return number of events dropped since touch_loopread
+starts, as the event queue was full.
+--------------------------------------------------------*/
+unsigned int egi_touch_dropped(void)
+{
+	return evq_dropped;
+}
+
+
+
 /*-----------------------------------------------------------------
 @nowati
 Ture:	Touch_loopread thread will not check live_touch_data.updated
@@ -281,6 +478,23 @@ int egi_start_touchread(void)
 	/* reset cond flag */
 	flag_cond=0;
 
+	/* initiliaze event queue cond, with monotonic clock for timedwait */
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	if( pthread_cond_init(&evq_cond, &attr) !=0 ) {
+                printf("%s: Fail to initialize evq_cond!\n", __func__);
+		pthread_condattr_destroy(&attr);
+		return -3;
+	}
+	pthread_condattr_destroy(&attr);
+	evq_head=0;
+	evq_count=0;
+	evq_wakeup=false;
+	evq_on=false;
+	evq_dropped=0;
+	evq_last_status=released_hold;
+
 	/* start touch_read thread */
         if( pthread_create(&thread_loopread, NULL, (void *)egi_touch_loopread, NULL) !=0 )
         {
@@ -324,6 +538,12 @@ int egi_end_touchread(void)
 		ret-=2;
 	}
 
+	/* destroy event queue cond */
+        if( pthread_cond_destroy(&evq_cond) !=0 ) {
+		printf("%s:Fail to destroy evq_cond.\n", __func__);
+		ret-=8;
+	}
+
 	/* destroy mutex lock */
         if( pthread_mutex_destroy(&mutex_lockCond) !=0 ) {
 		printf("%s:Fail to destroy mutex_lockCond.\n", __func__);
@@ -493,8 +713,8 @@ enum egi_touch_status 	 !!! --- TO see lateset in egi.h --- !!!
 	        /* 1. necessary wait,just for XPT to prepare data */
         	tm_delayms(2);
 
-		/* wait .... until read out,  AND NOT nowait mode */
-		if( live_touch_data.updated==true && !tok_loopread_nowait )
+		/* wait .... until read out,  AND NOT nowait mode, AND event queue NOT in use */
+		if( live_touch_data.updated==true && !tok_loopread_nowait && !evq_on )
 			continue;
 
 		/* 2. read XPT to get avg tft-LCD coordinate */
@@ -543,6 +763,9 @@ enum egi_touch_status 	 !!! --- TO see lateset in egi.h --- !!!
 				   printf("%s: 'releasing', BUT flag_cond already 0...\n",__func__);
 				}
 
+				/* push to event queue, before dx/dy reset */
+				egi_touch_pushevent(&live_touch_data);
+
 				/* reset sliding deviation ---- After wtouch_data update! ---- */
 				live_touch_data.dx=0;
 				live_touch_data.dy=0;
@@ -556,6 +779,7 @@ enum egi_touch_status 	 !!! --- TO see lateset in egi.h --- !!!
 				/* update touch data */
 				live_touch_data.updated=true;
 				live_touch_data.status=released_hold;
+				egi_touch_pushevent(&live_touch_data);
 
 				/* reset last_x,y */
 				last_x=0;
@@ -588,6 +812,8 @@ enum egi_touch_status 	 !!! --- TO see lateset in egi.h --- !!!
 				EGI_PDEBUG(DBG_TOUCH,"egi_touch_loopread(): ...... dx=%d, dy=%d ......\n",
 								live_touch_data.dx,live_touch_data.dy );
 
+				egi_touch_pushevent(&live_touch_data);
+
                         }
                         else /* CASE PRESSING: it's a pressing action */
                         {
@@ -629,6 +855,8 @@ enum egi_touch_status 	 !!! --- TO see lateset in egi.h --- !!!
 											  ... ... ...\n",tus);
                                         live_touch_data.status=db_pressing;
                                 }
+
+				egi_touch_pushevent(&live_touch_data);
                         }
                         //eig_pdebug(DBG_TOUCH,"egi_touch_loopread(): --- XPT_READ_STATUS_COMPLETE ---\n");
 
@@ -21,6 +21,11 @@ int 		egi_start_touchread(void);
 int 		egi_end_touchread(void);
 bool 		egi_touchread_is_running(void);
 bool 		egi_touch_getdata(EGI_TOUCH_DATA *data);
+int 		egi_touch_waitdata(EGI_TOUCH_DATA *touch_data, unsigned int ms);
+void 		egi_touch_wakeup(void);
+void 		egi_touch_flushdata(void);
+bool 		egi_touch_released(void);
+unsigned int 	egi_touch_dropped(void);
 EGI_TOUCH_DATA 	egi_touch_peekdata(void);
 int 		egi_touch_peekdx(void);
 int 		egi_touch_peekdy(void);
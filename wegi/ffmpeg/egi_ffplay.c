@@ -366,6 +366,8 @@ void * egi_thread_ffplay(EGI_PAGE *page)
 	uint8_t			*buffer=NULL;
 	struct SwsContext	*sws_ctx=NULL;
 	AVRational 		time_base; /*get from video stream, pFormatCtx->streams[videoStream]->time_base*/
+	int64_t			vpts;	   /* in time_base, pts of decoded video frame */
+	long long		vpts_ms;   /* in ms, pts of video frame for presentation */
 
 	int Hb,Vb;  /* Horizontal and Veritcal size of a picture */
 	/* for Pic Info. */
@@ -405,6 +407,9 @@ void * egi_thread_ffplay(EGI_PAGE *page)
 	char			chanlayout_string[256];
 	int 			bytes_used;
 	int			got_frame;
+	int64_t			apts;	   /* in audio stream time_base, pts of decoded audio frame */
+	long long		apts_end=FF_NOPTS; /* in ms, pts of the end of PCM data written to the device */
+	int			pcm_delay;  /* in ms, delay of PCM device */
 	struct SwrContext		*swr=NULL; /* AV_SAMPLE_FMT_FLTP format conversion */
 	uint8_t			*outputBuffer=NULL;/* for converted data */
 	int 			outsamples;
@@ -581,6 +586,7 @@ pFormatCtx->probesize2=128*1024;
 	/* reset stream index first */
 	videoStream=-1;
 	audioStream=-1;
+	apts_end=FF_NOPTS;
 
 	//printf("%d streams found.\n",pFormatCtx->nb_streams);
 	/* find the first available stream of VIDEO and AUDIO */
@@ -1296,6 +1302,7 @@ if(enable_seekloop)
 	/* seek starting point */
 	EGI_PDEBUG(DBG_FFPLAY,"av_seek_frame() to the starting point...\n");
         av_seek_frame(pFormatCtx, 0, 0, AVSEEK_FLAG_ANY);
+	ff_reset_Clock();	/* pts restarts */
 }
 else
 {	//pFormatCtx->streams[videoStream]->time_base
@@ -1305,6 +1312,7 @@ else
 	 */
 	if(FFplay_Ctx->start_tmsecs !=0 ) {
 	  av_seek_frame(pFormatCtx, videoStream,(FFplay_Ctx->start_tmsecs)*time_base.den/time_base.num, AVSEEK_FLAG_ANY);
+	  ff_reset_Clock();
 	}
 }
 
@@ -1351,8 +1359,11 @@ if(enable_avfilter)
 						//goto FAIL_OR_TERM;
 					}
 					/* push data to pic buff for SPI LCD displaying */
-					printf(" start Load_Pic2Buff()....\n");
-					if( ff_load_Pic2Buff(&pic_info,filt_pFrame->data[0],numBytes) <0 )
+					//printf(" start Load_Pic2Buff()....\n");
+					vpts=filt_pFrame->pts;
+					vpts_ms = (vpts==AV_NOPTS_VALUE) ? FF_NOPTS :
+						  av_rescale_q(vpts, time_base, (AVRational){1,1000});
+					if( ff_load_Pic2Buff(&pic_info,filt_pFrame->data[0],numBytes,vpts_ms,audioStream>=0) <0 )
 						EGI_PDEBUG(DBG_FFPLAY," [%lld] PICBuffs are full! video frame is dropped!\n",
 									tm_get_tmstampms());
 
@@ -1372,7 +1383,10 @@ else /* elif AVFilter OFF, then apply SWS and send scaled RGB data to pic buff f
 
 				/* push data to pic buff for SPI LCD displaying */
 				//printf("%s: start Load_Pic2Buff()....\n",__func__);
-				if( ff_load_Pic2Buff(&pic_info,pFrameRGB->data[0],numBytes) <0 )
+				vpts=av_frame_get_best_effort_timestamp(pFrame);
+				vpts_ms = (vpts==AV_NOPTS_VALUE) ? FF_NOPTS :
+					  av_rescale_q(vpts, time_base, (AVRational){1,1000});
+				if( ff_load_Pic2Buff(&pic_info,pFrameRGB->data[0],numBytes,vpts_ms,audioStream>=0) <0 )
 					EGI_PDEBUG(DBG_FFPLAY,"[%lld] PICBuffs are full! video frame is dropped!\n",
 								tm_get_tmstampms());
 } /* end of AVFilter ON/OFF */
@@ -1455,6 +1469,20 @@ else /* elif AVFilter OFF, then apply SWS and send scaled RGB data to pic buff f
 
 					}
 
+					/* update audio clock for video presentation, as pts of the end of
+					 * PCM data written minus PCM delay.
+					 */
+					apts=av_frame_get_best_effort_timestamp(pAudioFrame);
+					if(apts != AV_NOPTS_VALUE)
+						apts_end=av_rescale_q(apts, pFormatCtx->streams[audioStream]->time_base,
+										(AVRational){1,1000} );
+					if(apts_end != FF_NOPTS && pAudioFrame->sample_rate > 0) {
+						apts_end += (long long)pAudioFrame->nb_samples*1000/pAudioFrame->sample_rate;
+						pcm_delay=egi_pcm_delay_ms();
+						if(pcm_delay>=0)
+							ff_update_AudioClock(apts_end, pcm_delay);
+					}
+
 					/*    ---- 1024 points FFT displaying handling ----
 					 *   Note:
 					 *     1. For sample rate 44100 only, noninterleaved.
@@ -1523,6 +1551,9 @@ if(enable_clip_test)
 				egi_sleep(0,0,100);
 			} while(FFplay_Ctx->ffcmd==cmd_pause); // !=cmd_play;
 
+			/* The clock kept running while paused, restart it from the next frame or PCM */
+			ff_reset_Clock();
+
 			/* Don not reset, pass down curretn cmd */
 
 		    }
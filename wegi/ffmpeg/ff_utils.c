@@ -8,13 +8,14 @@ Note:
 
 TODO:
 1. Putting subtitle displaying codes in thdf_Display_Pic() may be better.
-2. Apply EGI_FIFO for frame buffering instead of picbuff[];
 
 
 Midas_Zhou
 -------------------------------------------------------------------------*/
 #include <stdio.h>
 #include <dirent.h>
+#include <time.h>
+#include <pthread.h>
 #include <limits.h> /* system: NAME_MAX 255; PATH_MAX 4096 */
 
 #include "egi_common.h"
@@ -38,20 +39,121 @@ enum ffplay_cmd control_cmd;
 /***
  * 1. Thanks to slow SPI transfering speed, producing speed is usually greater than consuming speed.
  * 2. Following keys to be initialized in ff_malloc_PICbuffs().
+ * 3. pPICbuffs[] is a lock-free SPSC ring: ff_load_Pic2Buff() is the only producer and
+ *    it only writes nfp, thdf_Display_Pic() is the only consumer and it only writes nfc.
+ *    Slot of frame n is pPICbuffs[n&(PIC_BUFF_NUM-1)], ring is empty if nfp==nfc,
+ *    and full if nfp-nfc==PIC_BUFF_NUM.
  */
-static int ifplay;	/* current playing frame index of pPICbuffs[] */
 unsigned long nfc;	/* total frames read from pPICbuffs and consumed */
 unsigned long nfp;	/* total frames produced and copied to pPICbuffs */
+static unsigned long nfd; /* total frames dropped by the display thread, as they are late */
 
 static uint8_t** pPICbuffs=NULL; /* PIC_BUF_NUM*Screen_size*16bits, data buff for several screen pictures */
+static long long pts_PICbuff[PIC_BUFF_NUM]; /* in ms, presentation time stamp of each pPICbuffs[] */
 
-static bool IsFree_PICbuff[PIC_BUFF_NUM]={false};  /* tag to indicate availiability of pPICbuffs[x].
-						    * LoadPic2Buff() put 'false' tag
-						    * thdf_Display_Pic() put 'true' tag,
-						    */
+/* Master clock for frame presentation, protected by clock_mutex.
+ * If audio is playing, it's the audio clock updated by ff_update_AudioClock(),
+ * else a monotonic clock started by the first video frame.
+ */
+static pthread_mutex_t clock_mutex=PTHREAD_MUTEX_INITIALIZER;
+static bool 	 aclock_valid;	/* audio clock is available */
+static long long aclock_ms;	/* in ms, audio pts being heard at aclock_stamp */
+static long long aclock_stamp;	/* in ms, monotonic time when aclock_ms is updated */
+static bool 	 vclock_valid;	/* video clock is started */
+static long long vclock_base;	/* in ms, pts of video clock base */
+static long long vclock_stamp;	/* in ms, monotonic time of vclock_base */
 
 static long seek_Subtitle_TmStamp(char *subpath, unsigned int tmsec);
 
+/*---------------------------------------
+Return monotonic time in ms.
+---------------------------------------*/
+static inline long long ff_get_monotonic_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (long long)ts.tv_sec*1000+ts.tv_nsec/1000000;
+}
+
+/*-----------------------------------------------------------
+Reset the master clock, call it before playing a new file.
+------------------------------------------------------------*/
+void ff_reset_Clock(void)
+{
+	pthread_mutex_lock(&clock_mutex);
+	aclock_valid=false;
+	vclock_valid=false;
+	pthread_mutex_unlock(&clock_mutex);
+}
+
+/*-------------------------------------------------------------------
+Update audio clock, call it in audio playing thread just after
+PCM data is written by egi_play_pcm_buff().
+
+@pts_end:  in ms, pts of the end of PCM data written to the device.
+@delay:	   in ms, PCM delay of the device, see egi_pcm_delay_ms().
+--------------------------------------------------------------------*/
+void ff_update_AudioClock(long long pts_end, int delay)
+{
+	pthread_mutex_lock(&clock_mutex);
+	aclock_ms=pts_end-delay;
+	aclock_stamp=ff_get_monotonic_ms();
+	aclock_valid=true;
+	pthread_mutex_unlock(&clock_mutex);
+}
+
+/*--------------------------------------------------------------
+Get current master clock in ms.
+If audio clock is not available, then the video clock is used.
+And if the video clock is not started yet, then it starts with
+the given pts.
+
+@pts:	in ms, pts of the frame to be presented.
+---------------------------------------------------------------*/
+static long long ff_get_Clock(long long pts)
+{
+	long long now=ff_get_monotonic_ms();
+	long long clock;
+
+	pthread_mutex_lock(&clock_mutex);
+	if(aclock_valid) {
+		clock=aclock_ms+(now-aclock_stamp);
+	}
+	else {
+		if(!vclock_valid) {
+			vclock_base=pts;
+			vclock_stamp=now;
+			vclock_valid=true;
+		}
+		clock=vclock_base+(now-vclock_stamp);
+	}
+	pthread_mutex_unlock(&clock_mutex);
+
+	return clock;
+}
+
+/*-------------------------------------------------------------
+Restart the master clock with given pts, as pts goes
+discontinuous. e.g. after seeking to the start.
+The audio clock is dropped too, as its reference is stale now,
+so the video clock runs from pts until the next
+ff_update_AudioClock().
+--------------------------------------------------------------*/
+static void ff_restart_Clock(long long pts)
+{
+	pthread_mutex_lock(&clock_mutex);
+	aclock_valid=false;
+	vclock_base=pts;
+	vclock_stamp=ff_get_monotonic_ms();
+	vclock_valid=true;
+	pthread_mutex_unlock(&clock_mutex);
+}
+
+
+
+
 
 
 /*--------------------------------------------------------------
@@ -86,42 +188,15 @@ uint8_t**  ff_malloc_PICbuffs(int width, int height, int pixel_size )
                 }
         }
 
-        /* set tag */
-        for(i=0;i<PIC_BUFF_NUM;i++) {
-                IsFree_PICbuff[i]=true;
-        }
-
    	/* init key values */
    	nfc=0;
    	nfp=0;
-   	ifplay=0;
+   	nfd=0;
 
-        return pPICbuffs;
-}
-
-/*----------------------------------------
-return a free PICbuff slot/tag number
+	/* reset presentation clock */
+	ff_reset_Clock();
 
-Return value:
-        >=0  OK
-        <0   fails
----------------------------------------------*/
-static inline int ff_get_FreePicBuff(void)
-{
-        int i;
-	int index;
-
-        for(i=0;i<PIC_BUFF_NUM;i++) {
-		/* check and get free slot number in preceding ifplay order. */
-		index=(ifplay+i+1)&(PIC_BUFF_NUM-1);
-
-                if(IsFree_PICbuff[index]) {
-
-                        return index;
-		}
-        }
-
-        return -1;
+        return pPICbuffs;
 }
 
 /*----------------------------------
@@ -149,12 +224,17 @@ static void ff_free_PicBuffs(void)
 }
 
 
-/*--------------------------------------------------------
+/*--------------------------------------------------------------------
 	     a thread fucntion
- In a loop to display pPICBuffs[]
+ In a loop to display pPICBuffs[], each frame is presented at its PTS
+ against the master clock(audio clock if available):
+ 1. A frame earlier than the clock is held until its time.
+ 2. A frame later than FF_LATE_DROPMS is dropped if there is a newer
+    one in the ring, so video catches up with audio.
+ 3. A frame of FF_NOPTS is displayed at once.
 
 WARNING: !!! for 1_producer and 1_consumer scenario only!!!
-----------------------------------------------------------*/
+----------------------------------------------------------------------*/
 void* thdf_Display_Pic(void * argv)
 {
    if(FFplay_Ctx==NULL) {
@@ -162,9 +242,11 @@ void* thdf_Display_Pic(void * argv)
 	return (void *)-1;
    }
 
-   int 	i;
    int  index;
-   unsigned long nfc_tmp;
+   unsigned long ncons;		/* nfc, only this thread writes it */
+   unsigned long nprod;		/* loaded nfp */
+   long long pts;
+   long long diff;
    bool still_image;
 
    struct PicInfo *ppic =(struct PicInfo *) argv;
@@ -196,53 +278,77 @@ void* thdf_Display_Pic(void * argv)
 	//exit(-1);
    }
 
+   ncons=__atomic_load_n(&nfc, __ATOMIC_RELAXED);
 
    while(1)
    {
-	   nfc_tmp=nfc; /* starting from nfc_tmp, check PIC_BUFF_NUM buffs one by one */
-	   for(i=0;i<PIC_BUFF_NUM;i++) /* to display all pic buff in pPICbuff[] */
-	   {
-//		if( !IsFree_PICbuff[i] ) { 	/* If new frame available */
-		index= (nfc_tmp+i) & (PIC_BUFF_NUM-1);
-		if( !IsFree_PICbuff[index] ) {
-			/* set index of pPICbuff[] for current playing frame*/
-			ifplay=index;
-
-			//printf("imgbuf.width=%d, .height=%d \n",imgbuf.width,imgbuf.height);
-			imgbuf->imgbuf=(uint16_t *)pPICbuffs[index]; /* Ownership transfered! */
-
-			/* window_position displaying */
+	   /* quit ffplay */
+	   if(control_cmd == cmd_exit_display_thread ) {
+		EGI_PLOG(LOGLV_INFO,"%s: exit commmand is received!\n",__func__);
+		break;
+	   }
+
+	   nprod=__atomic_load_n(&nfp, __ATOMIC_ACQUIRE);
+
+	   /* Still image: keep the last frame in ring and refresh it, release it only when a newer one comes */
+	   if( still_image ) {
+		if( nprod-ncons > 1 ) {
+			ncons++;
+			__atomic_store_n(&nfc, ncons, __ATOMIC_RELEASE);
+		}
+		if( nprod != ncons ) {
+			imgbuf->imgbuf=(uint16_t *)pPICbuffs[ncons&(PIC_BUFF_NUM-1)]; /* Ownership transfered! */
 			egi_imgbuf_windisplay(imgbuf, &ff_fb_dev, -1,
 					0, 0, ppic->Hs, ppic->Vs, imgbuf->width, imgbuf->height);
+		}
+		tm_delayms( nprod-ncons > 1 ? FF_DISPLAY_TICKMS : 500 );
+		continue;
+	   }
+
+	   /* Ring is empty */
+	   if( nprod == ncons ) {
+		usleep(FF_DISPLAY_TICKMS*1000);
+		continue;
+	   }
 
-		   	/* put a FREE tag after display, then it can be overwritten. */
-	  	   	IsFree_PICbuff[index]=true;
+	   index=ncons & (PIC_BUFF_NUM-1);
+	   pts=pts_PICbuff[index];
 
-			tm_delayms(25);
-	   		//usleep(20000);
+	   if( pts != FF_NOPTS ) {
+		diff=pts-ff_get_Clock(pts);
 
-			/* increase number of frames consumed */
-			nfc++;
+		/* Too late, drop it only if a newer frame is ready */
+		if( diff < -FF_LATE_DROPMS && nprod-ncons > 1 ) {
+			nfd++;
+			ncons++;
+			__atomic_store_n(&nfc, ncons, __ATOMIC_RELEASE);
+			continue;
+		}
+		/* PTS discontinuity, as seek or loop back, restart the clock and display it at once. */
+		else if( diff > FF_MAX_AVDIFFMS || diff < -FF_MAX_AVDIFFMS ) {
+			EGI_PDEBUG(DBG_FFPLAY,"PTS discontinuity: diff=%lldms, restart clock.\n", diff);
+			ff_restart_Clock(pts);
+		}
+		/* Too early, wait a while */
+		else if( diff > 0 ) {
+			usleep( (diff > FF_DISPLAY_TICKMS ? FF_DISPLAY_TICKMS : diff)*1000 );
+			continue;
 		}
 	   }
 
-  	  /* revive slot [0] for still image */
-	  if( still_image )  {
-		tm_delayms(500);
-		nfc=1; /* since ff_get_FreePicBuff() from 1 */
-		IsFree_PICbuff[1]=false;
-	  }
+	   imgbuf->imgbuf=(uint16_t *)pPICbuffs[index]; /* Ownership transfered! */
 
-	   /* quit ffplay */
-	   if(control_cmd == cmd_exit_display_thread ) {
-		EGI_PLOG(LOGLV_INFO,"%s: exit commmand is received!\n",__func__);
-		break;
-	   }
+	   /* window_position displaying */
+	   egi_imgbuf_windisplay(imgbuf, &ff_fb_dev, -1,
+				0, 0, ppic->Hs, ppic->Vs, imgbuf->width, imgbuf->height);
 
-	  tm_delayms(25);
-	  //usleep(2000);
+	   /* release the slot after display, then it can be overwritten. */
+	   ncons++;
+	   __atomic_store_n(&nfc, ncons, __ATOMIC_RELEASE);
   }
 
+  EGI_PLOG(LOGLV_INFO,"%s: %lu frames displayed, %lu late frames dropped.\n", __func__, nfc-nfd, nfd);
+
   ff_free_PicBuffs();
   imgbuf->imgbuf=NULL; /* since freed by ff_free_PicBuffs() */
 
@@ -254,36 +360,43 @@ void* thdf_Display_Pic(void * argv)
 
 /*------------------------------------------------------------------------
  Copy RGB data from *data to PicInfo.data
+ If the ring is full, it waits for a free slot for FF_PICBUFF_WAITMS at
+ most, so the decoder is paced by the display when there is no audio.
+ With audio, the caller also feeds the PCM device, so it must not wait
+ and the picture is dropped at once.
 
   ppic: 	a PicInfo struct
   data:		data source
   numbytes:	amount of data copied, in byte.
-
-TODO: Pic data loading must NOT exceed displaying by one circle of PIC buff.
-
+  pts:		in ms, presentation time stamp of the picture,
+		or FF_NOPTS to display it at once.
+  nowait:	true: do not wait for a free slot.
 
  Return value:
 	>=0 Ok (slot number of PICBuffs)
-	<0  fails
+	<0  fails, the picture is dropped.
 --------------------------------------------------------------------------*/
-int ff_load_Pic2Buff(struct PicInfo *ppic,const uint8_t *data, int numBytes)
+int ff_load_Pic2Buff(struct PicInfo *ppic,const uint8_t *data, int numBytes, long long pts, bool nowait)
 {
 	int nbuff;
+	int ms;
+
+	/* wait for a free slot */
+	for( ms=0; nfp-__atomic_load_n(&nfc, __ATOMIC_ACQUIRE) >= PIC_BUFF_NUM; ms+=FF_DISPLAY_TICKMS ) {
+		if( nowait || ms >= FF_PICBUFF_WAITMS || control_cmd == cmd_exit_display_thread )
+			return -1;
+		usleep(FF_DISPLAY_TICKMS*1000);
+	}
 
-	nbuff=ff_get_FreePicBuff(); /* get a slot number */
-	//printf("Load_Pic2Buff(): get_FreePicBuff() =%d\n",nbuff);
+	nbuff=nfp & (PIC_BUFF_NUM-1); /* get a slot number */
 
-	/* only if PICBuff has free slot, and no more than PIC_BUFF_NUM(one circle of buff), then renew ppic */
-	if( nbuff >= 0 && nfp-nfc < PIC_BUFF_NUM  ){
-		ppic->data=pPICbuffs[nbuff]; /* get pointer to the PICBuff */
-		//printf("Load_Pic2Buff(): start memcpy..\n");
-		memcpy(ppic->data, data, numBytes);
-		IsFree_PICbuff[nbuff]=false; /* put a NON_FREE tag to the buff slot */
-		ppic->nPICbuff=nbuff;	/* put slot number */
+	ppic->data=pPICbuffs[nbuff]; /* get pointer to the PICBuff */
+	memcpy(ppic->data, data, numBytes);
+	pts_PICbuff[nbuff]=pts;
+	ppic->nPICbuff=nbuff;	/* put slot number */
 
-		/* increase total number of frames produced */
-		nfp++;
-	}
+	/* increase total number of frames produced, publish the slot */
+	__atomic_store_n(&nfp, nfp+1, __ATOMIC_RELEASE);
 
 	return nbuff;
 }
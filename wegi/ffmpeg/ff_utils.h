@@ -40,6 +40,13 @@ extern FBDEV ff_fb_dev;
 #define BUFF_NUM_EXPONENT	2
 #define PIC_BUFF_NUM  		(1<<BUFF_NUM_EXPONENT)  /* total number of RGB picture data buffers. */
 
+/* frame presentation scheduler, all in ms */
+#define FF_NOPTS		(-1LL)	/* pts unknown, to display the frame at once */
+#define FF_DISPLAY_TICKMS	5	/* max. sleep time for the display thread in one wait */
+#define FF_LATE_DROPMS		60	/* drop a frame later than this if a newer one is ready */
+#define FF_MAX_AVDIFFMS		2000	/* beyond this, the pts is taken as discontinuous */
+#define FF_PICBUFF_WAITMS	200	/* max. time for the producer to wait for a free PICbuff */
+
 /* information of a decoded picture, for pthread params */
 struct PicInfo {
         /* coordinate for display window layout on LCD */
@@ -66,8 +73,9 @@ struct PicInfo {
 /*  functions	*/
 uint8_t**  	ff_malloc_PICbuffs(int width, int height, int pixel_size );
 //static void  	ff_free_PicBuffs(void);
-//int 	   	ff_get_FreePicBuff(void);
-int 	   	ff_load_Pic2Buff(struct PicInfo *ppic,const uint8_t *data, int numBytes);
+int 	   	ff_load_Pic2Buff(struct PicInfo *ppic,const uint8_t *data, int numBytes, long long pts, bool nowait);
+void 		ff_reset_Clock(void);
+void 		ff_update_AudioClock(long long pts_end, int delay);
 void* 	   	thdf_Display_Pic(void * argv);
 void* 	   	thdf_Display_Subtitle(void * argv);
 //static long 	   seek_Subtitle_TmStamp(char *subpath, unsigned int tmsec);
@@ -0,0 +1,528 @@
+/*----------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+A software mixer with one persistent ALSA playback stream,
+see egi_mixer.h.
+
+Midas Zhou
+----------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include "egi_mixer.h"
+
+/* State of a request slot */
+enum {
+	MIXREQ_FREE=0,		/* Free for a new request */
+	MIXREQ_FILL,		/* Taken by a caller, filling */
+	MIXREQ_READY,		/* Ready for the mixer thread */
+};
+
+/* Request commands */
+enum {
+	MIXCMD_PLAY=0,
+	MIXCMD_STOP,
+};
+
+typedef struct {
+	int			state;		/* MIXREQ_xxx, atomic */
+	int			cmd;		/* MIXCMD_xxx */
+	int			id;		/* Voice id */
+	const EGI_PCMBUF	*pcmbuf;
+	int			gain;
+	int			nloop;
+	int			prio;
+} MIXER_REQ;
+
+/* A playing voice, for the mixer thread only */
+typedef struct {
+	bool			active;
+	int			id;
+	const EGI_PCMBUF	*pcmbuf;
+	int			gain;
+	int			nloop;		/* Loops left, <=0 forever */
+	int			prio;
+	unsigned int		nframes;	/* Total frames of pcmbuf */
+	unsigned int		pos;		/* Current frame in pcmbuf */
+	unsigned int		frac;		/* Fraction of pos, in 1/65536 */
+	unsigned int		step;		/* pcmbuf frames for each output frame, in 1/65536 */
+} MIXER_VOICE;
+
+static struct {
+	snd_pcm_t	*pcm_handle;
+	unsigned int	nchanl;
+	unsigned int	srate;
+	unsigned int	period;		/* Frames for each write */
+	int32_t		*accbuf;	/* [period*nchanl], sum of voices */
+	int16_t		*outbuf;	/* [period*nchanl], saturated */
+
+	pthread_t	thread;
+	sem_t		wake;		/* Posted for each request */
+	bool		quit;
+	bool		dead;		/* PCM fails to recover and the mixer thread exits, atomic */
+
+	MIXER_REQ	reqs[EGI_MIXER_REQSLOTS];
+	MIXER_VOICE	voices[EGI_MIXER_VOICES];
+	int		nactive;	/* Active voices, for the mixer thread */
+	int		nplaying;	/* A copy of nactive for other threads, atomic */
+	int		idseq;		/* Last voice id, atomic */
+} g_mixer;
+
+static void *mixer_thread(void *arg);
+
+
+/*--------------------------------------------------------------------
+Open a PCM device with S16 interleaved format, and start the mixer
+thread, with SCHED_FIFO if permitted.
+
+@dev_name:	PCM device, Example: "default"
+@nchanl:	Number of channels of the stream
+@srate:		Sample rate of the stream
+
+Return:
+	0	OK
+	<0	Fails
+---------------------------------------------------------------------*/
+int egi_mixer_open(const char *dev_name, unsigned int nchanl, unsigned int srate)
+{
+	snd_pcm_hw_params_t *params;
+	snd_pcm_uframes_t buffer_size, period_size;
+	pthread_attr_t attr;
+	struct sched_param sparam;
+	int dir=0;
+
+	if(g_mixer.pcm_handle!=NULL) {
+		printf("%s: Mixer is already open!\n",__func__);
+		return -1;
+	}
+	if(dev_name==NULL || nchanl==0 || srate==0)
+		return -1;
+
+	g_mixer.pcm_handle=egi_open_playback_device( dev_name, SND_PCM_FORMAT_S16_LE,
+						     SND_PCM_ACCESS_RW_INTERLEAVED, true,
+						     nchanl, srate, 50000 );
+	if(g_mixer.pcm_handle==NULL)
+		return -2;
+
+	/* Get actual rate and period size */
+	snd_pcm_hw_params_alloca(&params);
+	if( snd_pcm_hw_params_current(g_mixer.pcm_handle, params) <0
+	    || snd_pcm_hw_params_get_rate(params, &g_mixer.srate, &dir) <0
+	    || snd_pcm_get_params(g_mixer.pcm_handle, &buffer_size, &period_size) <0 )
+	{
+		printf("%s: Fail to get PCM params!\n",__func__);
+		goto ERR_PCM;
+	}
+	g_mixer.nchanl=nchanl;
+	g_mixer.period=period_size;
+	printf("%s: Mixer opened, %d channels, %dHz, period %d frames.\n",
+				__func__, g_mixer.nchanl, g_mixer.srate, g_mixer.period);
+
+	g_mixer.accbuf=malloc(g_mixer.period*nchanl*sizeof(int32_t));
+	g_mixer.outbuf=malloc(g_mixer.period*nchanl*sizeof(int16_t));
+	if(g_mixer.accbuf==NULL || g_mixer.outbuf==NULL) {
+		printf("%s: Fail to malloc mix buffers!\n",__func__);
+		goto ERR_BUFF;
+	}
+
+	memset(g_mixer.reqs, 0, sizeof(g_mixer.reqs));
+	memset(g_mixer.voices, 0, sizeof(g_mixer.voices));
+	g_mixer.nactive=0;
+	g_mixer.nplaying=0;
+	g_mixer.quit=false;
+	g_mixer.dead=false;
+	if( sem_init(&g_mixer.wake, 0, 0) !=0 ) {
+		printf("%s: Fail to init semaphore!\n",__func__);
+		goto ERR_BUFF;
+	}
+
+	/* Try real-time thread first */
+	pthread_attr_init(&attr);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+	sparam.sched_priority=sched_get_priority_min(SCHED_FIFO)+10;
+	pthread_attr_setschedparam(&attr, &sparam);
+	if( pthread_create(&g_mixer.thread, &attr, mixer_thread, NULL) !=0 ) {
+		printf("%s: Fail to create SCHED_FIFO thread, try normal one.\n",__func__);
+		if( pthread_create(&g_mixer.thread, NULL, mixer_thread, NULL) !=0 ) {
+			printf("%s: Fail to create mixer thread!\n",__func__);
+			pthread_attr_destroy(&attr);
+			sem_destroy(&g_mixer.wake);
+			goto ERR_BUFF;
+		}
+	}
+	pthread_attr_destroy(&attr);
+
+	return 0;
+
+ERR_BUFF:
+	free(g_mixer.accbuf);  g_mixer.accbuf=NULL;
+	free(g_mixer.outbuf);  g_mixer.outbuf=NULL;
+ERR_PCM:
+	snd_pcm_close(g_mixer.pcm_handle);
+	g_mixer.pcm_handle=NULL;
+	return -3;
+}
+
+
+/*---------------------------------------------
+Stop the mixer thread, and close the PCM device.
+All voices are dropped. It MUST be called even
+if the mixer is dead, to release it.
+----------------------------------------------*/
+void egi_mixer_close(void)
+{
+	if(g_mixer.pcm_handle==NULL)
+		return;
+
+	__atomic_store_n(&g_mixer.quit, true, __ATOMIC_RELEASE);
+	sem_post(&g_mixer.wake);
+	pthread_join(g_mixer.thread, NULL);
+	sem_destroy(&g_mixer.wake);
+
+	snd_pcm_drop(g_mixer.pcm_handle);
+	snd_pcm_close(g_mixer.pcm_handle);
+	g_mixer.pcm_handle=NULL;
+
+	free(g_mixer.accbuf);  g_mixer.accbuf=NULL;
+	free(g_mixer.outbuf);  g_mixer.outbuf=NULL;
+}
+
+
+/*-------------------------------------------------------
+Take a free request slot by CAS, fill it, and wake up the
+mixer thread.
+
+Return:
+	0	OK
+	<0	All slots are busy
+--------------------------------------------------------*/
+static int mixer_request(int cmd, int id, const EGI_PCMBUF *pcmbuf, int gain, int nloop, int prio)
+{
+	MIXER_REQ *req;
+	int expect;
+	int i;
+
+	for(i=0; i<EGI_MIXER_REQSLOTS; i++) {
+		req=&g_mixer.reqs[i];
+		expect=MIXREQ_FREE;
+		if( !__atomic_compare_exchange_n(&req->state, &expect, MIXREQ_FILL, false,
+						 __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) )
+			continue;
+
+		req->cmd=cmd;
+		req->id=id;
+		req->pcmbuf=pcmbuf;
+		req->gain=gain;
+		req->nloop=nloop;
+		req->prio=prio;
+		__atomic_store_n(&req->state, MIXREQ_READY, __ATOMIC_RELEASE);
+
+		sem_post(&g_mixer.wake);
+		return 0;
+	}
+
+	return -1;
+}
+
+
+/*----------------------------------------------------------------
+Play an EGI_PCMBUF as a new voice, it never blocks.
+
+@pcmbuf:	PCM data, S16/S8/U8 interleaved, 1 or 2 channels.
+		It MUST be kept until the voice ends.
+@gain:		EGI_MIXER_GAIN_UNITY for 1.0
+@nloop:		Loop times, <=0 forever, until egi_mixer_stop().
+@prio:		Priority, bigger value for higher priority.
+
+Return:
+	>0	OK, id of the voice.
+	<0	Fails, request slots are full, or the mixer is dead.
+-----------------------------------------------------------------*/
+int egi_mixer_play(const EGI_PCMBUF *pcmbuf, int gain, int nloop, int prio)
+{
+	int id;
+
+	if( g_mixer.pcm_handle==NULL || __atomic_load_n(&g_mixer.dead, __ATOMIC_ACQUIRE) )
+		return -1;
+
+	if(pcmbuf==NULL || pcmbuf->pcmbuf==NULL || pcmbuf->noninterleaved
+	   || pcmbuf->nchanl==0 || pcmbuf->depth==0 || pcmbuf->srate==0 )
+	{
+		printf("%s: Invalid pcmbuf!\n",__func__);
+		return -1;
+	}
+	if(pcmbuf->sformat!=SND_PCM_FORMAT_S16_LE && pcmbuf->sformat!=SND_PCM_FORMAT_S8
+	   && pcmbuf->sformat!=SND_PCM_FORMAT_U8 )
+	{
+		printf("%s: Unsupported sample format!\n",__func__);
+		return -1;
+	}
+
+	/* Positive id, 0 is skipped when it wraps */
+	do {
+		id=__atomic_add_fetch(&g_mixer.idseq, 1, __ATOMIC_RELAXED) & 0x7FFFFFFF;
+	} while(id==0);
+
+	if( mixer_request(MIXCMD_PLAY, id, pcmbuf, gain, nloop, prio) <0 )
+		return -2;
+
+	return id;
+}
+
+
+/*-----------------------------------------
+Stop a voice, it never blocks.
+
+@id:	Voice id returned by egi_mixer_play()
+
+Return:
+	0	OK, the voice stops at next period.
+	<0	Fails
+------------------------------------------*/
+int egi_mixer_stop(int id)
+{
+	if( g_mixer.pcm_handle==NULL || id<=0 || __atomic_load_n(&g_mixer.dead, __ATOMIC_ACQUIRE) )
+		return -1;
+
+	return mixer_request(MIXCMD_STOP, id, NULL, 0, 0, 0);
+}
+
+
+/*---------------------------------------
+Return number of voices being played.
+----------------------------------------*/
+int egi_mixer_active_voices(void)
+{
+	return __atomic_load_n(&g_mixer.nplaying, __ATOMIC_RELAXED);
+}
+
+
+/*-------------------------------------------------
+Start a voice for a PLAY request. If all voices are
+busy, replace the one of the lowest priority.
+--------------------------------------------------*/
+static void mixer_start_voice(const MIXER_REQ *req)
+{
+	MIXER_VOICE *voice=NULL;
+	const EGI_PCMBUF *pcmbuf=req->pcmbuf;
+	int i;
+
+	for(i=0; i<EGI_MIXER_VOICES; i++) {
+		if(!g_mixer.voices[i].active) {
+			voice=&g_mixer.voices[i];
+			break;
+		}
+		if( voice==NULL || g_mixer.voices[i].prio < voice->prio )
+			voice=&g_mixer.voices[i];
+	}
+
+	if(voice->active) {
+		if(voice->prio > req->prio)
+			return;		/* Drop the new one */
+	}
+	else
+		g_mixer.nactive++;
+
+	voice->active=true;
+	voice->id=req->id;
+	voice->pcmbuf=pcmbuf;
+	voice->gain=req->gain;
+	voice->nloop=req->nloop;
+	voice->prio=req->prio;
+	voice->nframes=pcmbuf->size/pcmbuf->depth/pcmbuf->nchanl;
+	voice->pos=0;
+	voice->frac=0;
+	voice->step=((uint64_t)pcmbuf->srate<<16)/g_mixer.srate;
+
+	if(voice->nframes==0 || voice->step==0) {
+		voice->active=false;
+		g_mixer.nactive--;
+	}
+}
+
+
+/*-----------------------------------------
+Pick up all READY requests, and free slots.
+------------------------------------------*/
+static void mixer_fetch_requests(void)
+{
+	MIXER_REQ *req;
+	int i,k;
+
+	for(i=0; i<EGI_MIXER_REQSLOTS; i++) {
+		req=&g_mixer.reqs[i];
+		if( __atomic_load_n(&req->state, __ATOMIC_ACQUIRE) != MIXREQ_READY )
+			continue;
+
+		if(req->cmd==MIXCMD_PLAY) {
+			mixer_start_voice(req);
+		}
+		else {	/* MIXCMD_STOP */
+			for(k=0; k<EGI_MIXER_VOICES; k++) {
+				if( g_mixer.voices[k].active && g_mixer.voices[k].id==req->id ) {
+					g_mixer.voices[k].active=false;
+					g_mixer.nactive--;
+				}
+			}
+		}
+
+		__atomic_store_n(&req->state, MIXREQ_FREE, __ATOMIC_RELEASE);
+	}
+
+	__atomic_store_n(&g_mixer.nplaying, g_mixer.nactive, __ATOMIC_RELAXED);
+}
+
+
+/*-------------------------------------------
+Get sample of the channel at frame pos, as S16.
+--------------------------------------------*/
+static inline int mixer_sample(const EGI_PCMBUF *pcmbuf, unsigned int pos, unsigned int chanl)
+{
+	unsigned long k=(unsigned long)pos*pcmbuf->nchanl + chanl;
+
+	switch(pcmbuf->sformat) {
+		case SND_PCM_FORMAT_S8:
+			return ((int8_t *)pcmbuf->pcmbuf)[k]<<8;
+		case SND_PCM_FORMAT_U8:
+			return ((int)pcmbuf->pcmbuf[k]-128)<<8;
+		default:	/* SND_PCM_FORMAT_S16_LE */
+			return ((int16_t *)pcmbuf->pcmbuf)[k];
+	}
+}
+
+
+/*--------------------------------------------------------
+Add a voice to accbuf for one period, resampled by nearest
+frame, and mono is copied to all channels.
+Return:
+	true	The voice ends.
+---------------------------------------------------------*/
+static bool mixer_add_voice(MIXER_VOICE *voice)
+{
+	const EGI_PCMBUF *pcmbuf=voice->pcmbuf;
+	unsigned int nchanl=g_mixer.nchanl;
+	unsigned int srcmax=pcmbuf->nchanl-1;
+	int32_t *acc=g_mixer.accbuf;
+	unsigned int i,j;
+
+	for(i=0; i<g_mixer.period; i++) {
+		/* End of pcmbuf, loop or end */
+		while(voice->pos >= voice->nframes) {
+			if(voice->nloop==1)
+				return true;
+			if(voice->nloop>1)
+				voice->nloop--;
+			voice->pos -= voice->nframes;
+		}
+
+		for(j=0; j<nchanl; j++)
+			acc[j] += mixer_sample(pcmbuf, voice->pos, j<srcmax ? j : srcmax) * voice->gain >> 8;
+		acc += nchanl;
+
+		voice->frac += voice->step;
+		voice->pos += voice->frac>>16;
+		voice->frac &= 0xFFFF;
+	}
+
+	return false;
+}
+
+
+/*---------------------------------------------------
+Mix active voices for one period, and saturate to S16.
+----------------------------------------------------*/
+static void mixer_mix_period(void)
+{
+	unsigned int n=g_mixer.period*g_mixer.nchanl;
+	int32_t sum;
+	unsigned int i;
+
+	memset(g_mixer.accbuf, 0, n*sizeof(int32_t));
+
+	for(i=0; i<EGI_MIXER_VOICES; i++) {
+		if( g_mixer.voices[i].active && mixer_add_voice(&g_mixer.voices[i]) ) {
+			g_mixer.voices[i].active=false;
+			g_mixer.nactive--;
+		}
+	}
+	__atomic_store_n(&g_mixer.nplaying, g_mixer.nactive, __ATOMIC_RELAXED);
+
+	for(i=0; i<n; i++) {
+		sum=g_mixer.accbuf[i];
+		if(sum>32767)
+			sum=32767;
+		else if(sum<-32768)
+			sum=-32768;
+		g_mixer.outbuf[i]=(int16_t)sum;
+	}
+}
+
+
+/*--------------------------------------------------------
+The mixer thread, the only one to write the PCM device.
+If the PCM fails to recover from an error, it marks the
+mixer dead and exits, instead of retrying forever.
+---------------------------------------------------------*/
+static void *mixer_thread(void *arg)
+{
+	snd_pcm_t *pcm_handle=g_mixer.pcm_handle;
+	bool running=true;	/* PCM is prepared and being written */
+	unsigned int wf;
+	int16_t *pbuf;
+	int ret;
+
+	while( !__atomic_load_n(&g_mixer.quit, __ATOMIC_ACQUIRE) ) {
+
+		mixer_fetch_requests();
+
+		/* Idle: play out what's written, then sleep until next request */
+		if(g_mixer.nactive==0) {
+			if(running) {
+				snd_pcm_drain(pcm_handle);
+				running=false;
+			}
+			sem_wait(&g_mixer.wake);
+			continue;
+		}
+		if(!running) {
+			snd_pcm_prepare(pcm_handle);
+			running=true;
+		}
+
+		mixer_mix_period();
+
+		/* Write a period */
+		wf=g_mixer.period;
+		pbuf=g_mixer.outbuf;
+		while(wf>0) {
+			ret=snd_pcm_writei(pcm_handle, pbuf, wf);
+			if(ret==-EPIPE) {
+				/* EPIPE means underrun */
+				fprintf(stderr,"%s: snd_pcm_writei(): underrun occurred\n",__func__);
+				snd_pcm_prepare(pcm_handle);
+				continue;
+			}
+			else if(ret<0) {
+				fprintf(stderr,"%s: snd_pcm_writei(): %s\n",__func__, snd_strerror(ret));
+				if( snd_pcm_recover(pcm_handle, ret, 1) <0 ) {
+					fprintf(stderr,"%s: Fail to recover PCM, mixer is dead!\n",__func__);
+					__atomic_store_n(&g_mixer.nplaying, 0, __ATOMIC_RELAXED);
+					__atomic_store_n(&g_mixer.dead, true, __ATOMIC_RELEASE);
+					return (void *)-1;
+				}
+				continue;
+			}
+			wf -= ret;
+			pbuf += ret*g_mixer.nchanl;
+		}
+	}
+
+	return (void *)0;
+}
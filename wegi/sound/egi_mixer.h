@@ -0,0 +1,43 @@
+/*----------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+A software mixer with one persistent ALSA playback stream.
+
+1. egi_mixer_open() opens and configures the PCM device only once, a
+   real-time thread then mixes up to EGI_MIXER_VOICES voices into it,
+   period by period, summed in int32 and saturated to S16.
+2. A voice plays an EGI_PCMBUF(S16/S8/U8, mono or stereo, any sample
+   rate) with its gain, loop times and priority. If all voices are busy,
+   a new voice replaces the playing voice of the lowest priority, only
+   if its priority is NOT lower than that one.
+3. egi_mixer_play() and egi_mixer_stop() never lock and never block,
+   requests are put into free slots by CAS, and the mixer thread picks
+   them up at the next period. So they can be called from any thread.
+4. The stream is drained and the thread sleeps when no voice is playing.
+5. If the PCM fails to recover from a write error, the mixer is dead:
+   the thread exits and egi_mixer_play() fails, call egi_mixer_close().
+
+Note:
+   The EGI_PCMBUF MUST NOT be freed before its voice ends, or before
+   egi_mixer_close().
+
+Midas Zhou
+----------------------------------------------------------------------*/
+#ifndef __EGI_MIXER_H__
+#define __EGI_MIXER_H__
+
+#include "egi_pcm.h"
+
+#define EGI_MIXER_VOICES	8	/* Max. voices mixed at the same time */
+#define EGI_MIXER_REQSLOTS	16	/* Slots for pending play/stop requests */
+#define EGI_MIXER_GAIN_UNITY	256	/* Gain 1.0, gain is in 1/256 */
+
+int	egi_mixer_open(const char *dev_name, unsigned int nchanl, unsigned int srate);
+void	egi_mixer_close(void);
+int	egi_mixer_play(const EGI_PCMBUF *pcmbuf, int gain, int nloop, int prio);
+int	egi_mixer_stop(int id);
+int	egi_mixer_active_voices(void);
+
+#endif
@@ -93,6 +93,7 @@ static snd_mixer_t *g_volmix_handle; 	/* for volume control */
 static bool g_blInterleaved;		/* Interleaved or Noninterleaved */
 static char g_snd_device[256]; 		/* Pending, use "default" now. */
 static int period_size;			/* period size of HW, in frames. */
+static unsigned int g_srate;		/* actual sample rate of HW */
 
 /*-------------------------------------------------------------------------------
  Open an PCM device and set following parameters:
@@ -162,6 +163,8 @@ int egi_prepare_pcm_device(unsigned int nchan, unsigned int srate, bool bl_inter
 	if(dir != 0)
 		printf("%s: Actual sampling rate is set to %d HZ!\n",__func__, srate);
 
+	g_srate=srate;
+
 	/* set HW params */
 	rc=snd_pcm_hw_params(g_ffpcm_handle,params);
 	if(rc<0) /* rc=0 on success */
@@ -189,6 +192,34 @@ int egi_pcm_period_size(void)
 }
 
 
+/*----------------------------------------------------
+Return delay of the PCM playback, in ms.
+It's the time for the frames already written
+by egi_play_pcm_buff() to be heard.
+
+Note: Call it in the same thread as
+      egi_play_pcm_buff().
+Return:
+	>=0	OK
+	<0	Fails
+-----------------------------------------------------*/
+int egi_pcm_delay_ms(void)
+{
+	snd_pcm_sframes_t delay;
+
+	if(g_ffpcm_handle==NULL || g_srate==0)
+		return -1;
+
+	if( snd_pcm_delay(g_ffpcm_handle, &delay) <0 )
+		return -2;
+
+	if(delay<0)	/* underrun */
+		delay=0;
+
+	return (int)((long long)delay*1000/g_srate);
+}
+
+
 /*----------------------------------------------
   close pcm device and free resources
   together with volmix.
@@ -199,6 +230,7 @@ void egi_close_pcm_device(void)
 		snd_pcm_drain(g_ffpcm_handle);
 		snd_pcm_close(g_ffpcm_handle);
 		g_ffpcm_handle=NULL;
+		g_srate=0;
 	}
 
 	if(g_volmix_handle !=NULL) {
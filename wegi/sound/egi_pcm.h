@@ -78,6 +78,7 @@ typedef enum _snd_pcm_format {
 /* --- SYS PCM functions --- */
 int	egi_prepare_pcm_device(unsigned int nchan, unsigned int srate, bool bl_interleaved);
 int 	egi_pcm_period_size(void);
+int 	egi_pcm_delay_ms(void);
 void 	egi_close_pcm_device(void);
 void 	egi_play_pcm_buff(void** buffer, int nf);
 int  	egi_getset_pcm_volume(int *pvol, int *percnt);
@@ -0,0 +1,62 @@
+/*----------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+Test egi_mixer: Trigger wav files repeatedly and overlapped, all in
+one PCM stream.
+
+Usage: test_mixer wav_file1 [wav_file2 ...]
+
+Midas Zhou
+----------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "egi_pcm.h"
+#include "egi_mixer.h"
+
+#define MAX_FILES	8
+
+int main(int argc, char** argv)
+{
+	EGI_PCMBUF *pcmbuf[MAX_FILES]={NULL};
+	int nfiles;
+	int i,k;
+	int id;
+
+	if(argc<2) {
+		printf("Usage: %s wav_file1 [wav_file2 ...]\n",argv[0]);
+		exit(1);
+	}
+
+	/* Read wav files into EGI_PCMBUF */
+	nfiles= argc-1 > MAX_FILES ? MAX_FILES : argc-1;
+	for(i=0; i<nfiles; i++) {
+		pcmbuf[i]=egi_pcmbuf_readfile(argv[1+i]);
+		if(pcmbuf[i]==NULL)
+			exit(1);
+	}
+
+	/* Open mixer with params of the first file */
+	if( egi_mixer_open("default", pcmbuf[0]->nchanl, pcmbuf[0]->srate) !=0 )
+		exit(2);
+
+	/* Trigger sounds every 150ms, overlapped */
+	for(k=0; k<40; k++) {
+		i=k%nfiles;
+		id=egi_mixer_play(pcmbuf[i], EGI_MIXER_GAIN_UNITY/2, 1, i);
+		printf("Play '%s', voice id=%d, active voices %d\n", argv[1+i], id, egi_mixer_active_voices());
+		usleep(150000);
+	}
+
+	/* Wait for all voices to end */
+	while( egi_mixer_active_voices()>0 )
+		usleep(100000);
+
+	egi_mixer_close();
+	for(i=0; i<nfiles; i++)
+		egi_pcmbuf_free(&pcmbuf[i]);
+
+	return 0;
+}
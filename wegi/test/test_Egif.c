@@ -207,6 +207,7 @@ while(1) {  ////////////////////////////////  ---  LOOP TEST  ---  /////////////
         gif_ctxt.yw=yw;
         gif_ctxt.winw=egif->SWidth>xres ? xres:egif->SWidth; /* put window at center of LCD */
         gif_ctxt.winh=egif->SHeight>yres ? yres:egif->SHeight;
+        gif_ctxt.Cache_Started=false;
 
 
 #if 0  /* ----------------------  TEST:  egi_gif_runDisplayThread( )  ----------------------- */
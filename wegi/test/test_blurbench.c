@@ -0,0 +1,141 @@
+/*------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+A benchmark for egi_imgbuf_blur_box(), a separable box filter with
+running sums. Time cost should stay flat as radius grows.
+
+1. Results of 1 pass are compared with a brute-force box filter,
+   which averages all 2*r+1 pixels for each pixel, for small radii.
+2. Then time cost of 1 pass and 3 passes(~Gaussian) are listed for
+   radius from 1 to 256.
+
+Usage:	test_blurbench [width] [height]
+	default 480x320
+
+Midas Zhou
+midaszhou@yahoo.com
+------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "egi_image.h"
+#include "egi_timer.h"
+
+/* Brute-force box filter for one channel, edge pixels repeated, rounded */
+static void brute_line(int *dst, const int *src, int n, int stride, int r)
+{
+	int i, k, idx;
+	int sum;
+
+	for(i=0; i<n; i++) {
+		sum=0;
+		for(k=-r; k<=r; k++) {
+			idx=i+k;
+			if(idx<0) idx=0;
+			if(idx>n-1) idx=n-1;
+			sum+=src[idx*stride];
+		}
+		dst[i*stride]=(sum+r)/(2*r+1);
+	}
+}
+
+/* Brute-force blur of R,G,B and alpha, then compare with eimg, return Max. error */
+static int brute_check(const EGI_IMGBUF *srcimg, const EGI_IMGBUF *eimg, int r)
+{
+	int w=srcimg->width, h=srcimg->height;
+	int *ch, *tmp;
+	int c, i, j, v, err, maxerr=0;
+
+	ch=malloc(w*h*sizeof(int));
+	tmp=malloc(w*h*sizeof(int));
+	if(ch==NULL || tmp==NULL) {
+		free(ch); free(tmp);
+		return -1;
+	}
+
+	for(c=0; c<4; c++) {
+		for(i=0; i<w*h; i++) {
+			v=srcimg->imgbuf[i];
+			ch[i]= c==0 ? v>>11 : c==1 ? (v>>5)&0x3F : c==2 ? v&0x1F : srcimg->alpha[i];
+		}
+		for(j=0; j<h; j++)
+			brute_line(tmp+j*w, ch+j*w, w, 1, r);
+		for(i=0; i<w; i++)
+			brute_line(ch+i, tmp+i, h, w, r);
+		for(i=0; i<w*h; i++) {
+			v=eimg->imgbuf[i];
+			v= c==0 ? v>>11 : c==1 ? (v>>5)&0x3F : c==2 ? v&0x1F : eimg->alpha[i];
+			err=abs(v-ch[i]);
+			if(err>maxerr) maxerr=err;
+		}
+	}
+
+	free(ch);
+	free(tmp);
+	return maxerr;
+}
+
+int main(int argc, char **argv)
+{
+	int i, r;
+	int width=480, height=320;
+	EGI_IMGBUF *srcimg, *eimg;
+	struct timeval tm_start,tm_end;
+	long us1, us3;
+	int err;
+
+	if(argc>2) {
+		width=atoi(argv[1]);
+		height=atoi(argv[2]);
+	}
+	if(width<1 || height<1) {
+		printf("Usage: %s [width] [height]\n",argv[0]);
+		return -1;
+	}
+
+	srcimg=egi_imgbuf_create(height, width, 255, 0);
+	eimg=egi_imgbuf_create(height, width, 255, 0);
+	if(srcimg==NULL || eimg==NULL) {
+		printf("Fail to create imgbuf!\n");
+		return -2;
+	}
+
+	/* random noise over color bars */
+	srand(1);
+	for(i=0; i<width*height; i++) {
+		srcimg->imgbuf[i]=( (i%width)*8/width*0x2104 + (rand()&0x18E3) )&0xFFFF;
+		srcimg->alpha[i]=rand()&0xFF;
+	}
+
+	/* 1. check with brute-force box filter */
+	for(r=1; r<=8; r<<=1) {
+		egi_imgbuf_blur_box(eimg, srcimg, r, 1, true);
+		err=brute_check(srcimg, eimg, r);
+		printf("radius %d: Max. error to brute-force box filter: %d %s\n", r, err, err>1 ? "!!! FAIL !!!" : "");
+	}
+
+	/* 2. time cost for radii */
+	printf("\n%dx%d RGB565+alpha\n", width, height);
+	printf("radius   1 pass(ms)  3 passes(ms)\n");
+	for(r=1; r<=256; r<<=1) {
+		gettimeofday(&tm_start, NULL);
+		egi_imgbuf_blur_box(eimg, srcimg, r, 1, true);
+		gettimeofday(&tm_end, NULL);
+		us1=tm_diffus(tm_start,tm_end);
+
+		gettimeofday(&tm_start, NULL);
+		egi_imgbuf_blur_box(eimg, srcimg, r, 3, true);
+		gettimeofday(&tm_end, NULL);
+		us3=tm_diffus(tm_start,tm_end);
+
+		printf("%5d   %9.2f  %11.2f\n", r, us1/1000.0, us3/1000.0);
+	}
+
+	egi_imgbuf_free(srcimg);
+	egi_imgbuf_free(eimg);
+
+	return 0;
+}
@@ -0,0 +1,182 @@
+/*------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+A benchmark for EGI FFT functions:
+	mat_egiFFFT()		old fixed point FFT
+	mat_fft_int()		plan-based fixed point FFT
+	mat_fft_real_int()	plan-based fixed point FFT for real input
+	mat_fft_float()		plan-based float FFT
+
+Amplitudes of all results are compared with a double DFT.
+
+Usage:	test_fftbench [nexp] [rounds]
+	nexp	np=1<<nexp, default 10
+	rounds	default 1000
+
+Midas Zhou
+midaszhou@yahoo.com
+------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <inttypes.h>
+#include <sys/time.h>
+#include "egi_math.h"
+#include "egi_timer.h"
+
+int main(int argc, char **argv)
+{
+	int i,k;
+	int nexp=10;
+	int rounds=1000;
+	unsigned int np;
+	int aexp=11;	/* Max. amplitude 1<<aexp, nexp+aexp Max. 21 for mat_egiFFFT() */
+
+	int 		*nx;		/* input INT */
+	double		*ref;		/* double DFT amplitude */
+	EGI_FCOMPLEX 	*ffx;		/* old FFT result */
+	EGI_FCOMPLEX 	*wang;		/* old phase angle factor */
+	EGI_FFT_PLAN	*plan;
+	int32_t		*re, *im;
+	float		*fre, *fim;
+
+	struct timeval 	tm_start,tm_end;
+	long		us_old, us_int, us_real, us_float;
+	double		err_old=0, err_int=0, err_real=0, err_float=0;
+	double		amp;
+
+	if(argc>1)
+		nexp=atoi(argv[1]);
+	if(argc>2)
+		rounds=atoi(argv[2]);
+	if(nexp<2 || nexp>15 || rounds<1) {
+		printf("Usage: %s [nexp(2-15)] [rounds]\n",argv[0]);
+		return -1;
+	}
+	if(nexp+aexp>21)
+		aexp=21-nexp;
+	np=1<<nexp;
+
+	nx=calloc(np, sizeof(int));
+	ref=calloc(np, sizeof(double));
+	ffx=calloc(np, sizeof(EGI_FCOMPLEX));
+	re=calloc(np, sizeof(int32_t));
+	im=calloc(np, sizeof(int32_t));
+	fre=calloc(np, sizeof(float));
+	fim=calloc(np, sizeof(float));
+	wang=mat_CompFFTAng(np);
+	plan=mat_fft_create_plan(np);
+	if( nx==NULL || ref==NULL || ffx==NULL || re==NULL || im==NULL
+	    || fre==NULL || fim==NULL || wang==NULL || plan==NULL ) {
+		printf("Fail to allocate memory!\n");
+		return -2;
+	}
+
+	/* input samples, sampling rate 16k */
+	srand(1);
+	for(i=0; i<np; i++) {
+		nx[i]= (int)( ((1<<aexp)/4)*cos(2.0*MATH_PI*1000*i/16000) )
+		      +(int)( ((1<<aexp)/4)*cos(2.0*MATH_PI*3000*i/16000+3.0*MATH_PI/4.0) )
+		      +(int)( ((1<<aexp)/4)*cos(2.0*MATH_PI*5000*i/16000-1.0*MATH_PI/4.0) )
+		      +rand()%((1<<aexp)/8) - (1<<aexp)/16;
+	}
+
+	/* double DFT as reference, X[0]...X[np/2] */
+	for(k=0; k<=np/2; k++) {
+		double sr=0, si=0;
+		for(i=0; i<np; i++) {
+			sr+=nx[i]*cos(2.0*MATH_PI*k*i/np);
+			si-=nx[i]*sin(2.0*MATH_PI*k*i/np);
+		}
+		ref[k]=sqrt(sr*sr+si*si);
+	}
+
+	/* 1. old mat_egiFFFT() */
+	gettimeofday(&tm_start, NULL);
+	for(k=0; k<rounds; k++)
+		mat_egiFFFT(np, wang, NULL, nx, ffx);
+	gettimeofday(&tm_end, NULL);
+	us_old=tm_diffus(tm_start,tm_end);
+	for(k=0; k<=np/2; k++) {
+		amp=fabs(mat_floatCompAmp(ffx[k])-ref[k]);
+		if(amp>err_old) err_old=amp;
+	}
+
+	/* 2. mat_fft_int() */
+	gettimeofday(&tm_start, NULL);
+	for(k=0; k<rounds; k++) {
+		for(i=0; i<np; i++) {
+			re[i]=nx[i];
+			im[i]=0;
+		}
+		mat_fft_int(plan, re, im);
+	}
+	gettimeofday(&tm_end, NULL);
+	us_int=tm_diffus(tm_start,tm_end);
+	for(k=0; k<=np/2; k++) {
+		amp=fabs(mat_intCompAmp(re[k],im[k])-ref[k]);
+		if(amp>err_int) err_int=amp;
+	}
+
+	/* 3. mat_fft_real_int() */
+	gettimeofday(&tm_start, NULL);
+	for(k=0; k<rounds; k++) {
+		for(i=0; i<np; i++)
+			re[i]=nx[i];
+		mat_fft_real_int(plan, re, im);
+	}
+	gettimeofday(&tm_end, NULL);
+	us_real=tm_diffus(tm_start,tm_end);
+	for(k=0; k<=np/2; k++) {
+		amp=fabs(mat_intCompAmp(re[k],im[k])-ref[k]);
+		if(amp>err_real) err_real=amp;
+	}
+
+	/* 4. mat_fft_float() */
+	gettimeofday(&tm_start, NULL);
+	for(k=0; k<rounds; k++) {
+		for(i=0; i<np; i++) {
+			fre[i]=nx[i];
+			fim[i]=0.0;
+		}
+		mat_fft_float(plan, fre, fim);
+	}
+	gettimeofday(&tm_end, NULL);
+	us_float=tm_diffus(tm_start,tm_end);
+	for(k=0; k<=np/2; k++) {
+		amp=fabs(sqrt(fre[k]*fre[k]+fim[k]*fim[k])-ref[k]);
+		if(amp>err_float) err_float=amp;
+	}
+
+	if(us_old<1) us_old=1;
+	if(us_int<1) us_int=1;
+	if(us_real<1) us_real=1;
+	if(us_float<1) us_float=1;
+
+	printf("FFT np=%d, %d rounds, Max. amplitude error is relative to np/2=%d\n", np, rounds, np/2);
+	printf("mat_egiFFFT():      %8.1f us/FFT,  Max. amp error %.2f\n",
+					1.0*us_old/rounds, err_old);
+	printf("mat_fft_int():      %8.1f us/FFT,  Max. amp error %.2f,  x%.1f\n",
+					1.0*us_int/rounds, err_int, 1.0*us_old/us_int);
+	printf("mat_fft_real_int(): %8.1f us/FFT,  Max. amp error %.2f,  x%.1f\n",
+					1.0*us_real/rounds, err_real, 1.0*us_old/us_real);
+	printf("mat_fft_float():    %8.1f us/FFT,  Max. amp error %.2f,  x%.1f\n",
+					1.0*us_float/rounds, err_float, 1.0*us_old/us_float);
+
+	/* free resources */
+	mat_egiFFFT(0, NULL, NULL, NULL, NULL);
+	mat_fft_free_plan(&plan);
+	free(wang);
+	free(nx);
+	free(ref);
+	free(ffx);
+	free(re);
+	free(im);
+	free(fre);
+	free(fim);
+
+	return 0;
+}
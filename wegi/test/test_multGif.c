@@ -160,7 +160,7 @@ int main(int argc, char **argv)
                               COLOR_RGB_TO16BITS(224,60,49), -1, 255 );   /* fontcolor, transcolor, opaque */
 
 	    printf(" page refresh \n");
-	    fb_page_refresh(&gv_fb_dev);
+	    fb_page_refresh(&gv_fb_dev,0);
 	    usleep(10000);
 	}
 
@@ -205,20 +205,22 @@ static void *thread_GifImgbuf_update(void *arg)
 	}
 	printf("%s: Finish slurping '%s' to EGI_GIF.\n", __func__, param->fname);
 
+	/* Pre-decode all frames, it's OK to go on without it. */
+	if( egi_gif_buildFrameCache(egif, 0) !=0 )
+		printf("%s: Fail to build frame cache for '%s'.\n",__func__, param->fname);
+
 	/* assign EGI_GIF */
 	param->egif=egif;
 
+	/* FBDEV is NULL, update egif->Simgbuf ONLY */
+	EGI_GIF_CONTEXT gif_ctxt={
+		.fbdev=NULL, .egif=egif, .nloop=-1, .DirectFB_ON=false,
+		.User_DisposalMode=-1, .User_TransColor=-1, .User_BkgColor=-1,
+		.xp=0, .yp=0, .xw=0, .yw=0, .winw=egif->SWidth, .winh=egif->SHeight
+	};
+
 	/* Loop updating Simgbuf of egif */
-        while(1) {
-	    /* FBDEV is NULL, update egif->Simgbuf ONLY */
-            egi_gif_displayFrame( NULL, egif, 		/* *fbdev, EGI_GIF *egif */
-				  100, false,		/*  nloop, bool DirectFB_ON */
-		  -1,-1, -1,		/*  int User_DisposalMode, int User_TransColor, int User_BkgColor, */
-				  0,0,  		/* xp, yp */
-				  0,0, 			/* xw, yw */
-				  0,0			/* winw, winh */
-			);
-	}
+	egi_gif_displayGifCtxt(&gif_ctxt);
 
     	egi_gif_free(&egif);
 
@@ -0,0 +1,123 @@
+/*------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+A benchmark for egi_imgbuf_resize_into(), resizing into a reused
+imgbuf, against egi_imgbuf_resize(), which creates a new imgbuf for
+each call.
+
+For each size, time per resize(ms) is listed for:
+	resize:		egi_imgbuf_resize() and egi_imgbuf_free().
+	resize_into:	egi_imgbuf_resize_into() a reused imgbuf.
+Results of the two are also compared, with and without alpha.
+
+Usage:	test_resizebench [width] [height] [rounds]
+	default 240x320, 20 rounds
+
+Midas Zhou
+midaszhou@yahoo.com
+------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "egi_image.h"
+#include "egi_timer.h"
+
+int main(int argc, char **argv)
+{
+	int i, k;
+	int width=240, height=320;
+	int rounds=20;
+	int scales[]={ 10, 25, 50, 75, 100, 150, 200, 400 };	/* in percent */
+	int rw, rh;
+	EGI_IMGBUF *eimg, *outimg, *refimg;
+	unsigned char *alpha;
+	struct timeval tm_start,tm_end;
+	long us[2];
+	int diff;
+
+	if(argc>2) {
+		width=atoi(argv[1]);
+		height=atoi(argv[2]);
+	}
+	if(argc>3)
+		rounds=atoi(argv[3]);
+	if(width<1 || height<1 || rounds<1) {
+		printf("Usage: %s [width] [height] [rounds]\n",argv[0]);
+		return -1;
+	}
+
+	eimg=egi_imgbuf_create(height, width, 255, 0);
+	if(eimg==NULL) {
+		printf("Fail to create imgbuf!\n");
+		return -2;
+	}
+	srand(1);
+	for(i=0; i<width*height; i++) {
+		eimg->imgbuf[i]=rand()&0xFFFF;
+		eimg->alpha[i]=rand()&0xFF;
+	}
+	alpha=eimg->alpha;
+
+	printf("%dx%d RGB565+alpha, %d rounds, ms per resize\n", width, height, rounds);
+	printf("scale     size       resize   resize_into   same(alpha)   same(no alpha)\n");
+	for(k=0; k<sizeof(scales)/sizeof(scales[0]); k++) {
+		rw=width*scales[k]/100;
+		rh=height*scales[k]/100;
+		if(rw<2) rw=2;
+		if(rh<2) rh=2;
+
+		/* the reused imgbuf */
+		outimg=egi_imgbuf_create(rh, rw, 0, 0);
+		if(outimg==NULL) {
+			printf("Fail to create imgbuf!\n");
+			return -2;
+		}
+
+		gettimeofday(&tm_start, NULL);
+		for(i=0; i<rounds; i++) {
+			refimg=egi_imgbuf_resize(eimg, rw, rh);
+			if(refimg==NULL) {
+				printf("Fail to resize imgbuf!\n");
+				return -3;
+			}
+			if(i<rounds-1)
+				egi_imgbuf_free(refimg);
+		}
+		gettimeofday(&tm_end, NULL);
+		us[0]=tm_diffus(tm_start,tm_end);
+
+		gettimeofday(&tm_start, NULL);
+		for(i=0; i<rounds; i++) {
+			if(egi_imgbuf_resize_into(outimg, eimg)!=0) {
+				printf("Fail to resize into imgbuf!\n");
+				return -3;
+			}
+		}
+		gettimeofday(&tm_end, NULL);
+		us[1]=tm_diffus(tm_start,tm_end);
+
+		printf("%4d%%   %4dx%-4d  %8.3f    %8.3f       %s", scales[k], rw, rh,
+				us[0]/1000.0/rounds, us[1]/1000.0/rounds,
+				( memcmp(outimg->imgbuf, refimg->imgbuf, rw*rh*sizeof(EGI_16BIT_COLOR))
+				  || memcmp(outimg->alpha, refimg->alpha, rw*rh) ) ? "!!! NO !!!" : "yes      ");
+		egi_imgbuf_free(refimg);
+
+		/* without alpha, outimg->alpha keeps intact */
+		eimg->alpha=NULL;
+		refimg=egi_imgbuf_resize(eimg, rw, rh);
+		diff= refimg==NULL || refimg->alpha!=NULL || egi_imgbuf_resize_into(outimg, eimg)!=0
+		      || memcmp(outimg->imgbuf, refimg->imgbuf, rw*rh*sizeof(EGI_16BIT_COLOR));
+		eimg->alpha=alpha;
+		printf("     %s\n", diff ? "!!! NO !!!" : "yes");
+
+		egi_imgbuf_free(refimg);
+		egi_imgbuf_free(outimg);
+	}
+
+	egi_imgbuf_free(eimg);
+
+	return 0;
+}
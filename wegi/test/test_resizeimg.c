@@ -51,6 +51,7 @@ int rad=200;
 EGI_IMGBUF* pimg=NULL; /* input picture image */
 EGI_IMGBUF* eimg=NULL;
 EGI_IMGBUF* softimg=NULL;
+EGI_IMGBUF* rszimg=NULL; /* reused by egi_imgbuf_resize_into(), for max. size in LOOP TEST */
 
 show_jpg("/tmp/home.jpg",&gv_fb_dev, false, 0, 0);
 
@@ -121,6 +122,17 @@ do {    ////////////////////////////  3. LOOP TEST   ///////////////////////////
    printf("show jpg...\n");
    show_jpg("/tmp/home.jpg",&gv_fb_dev, false, 0, 0);
 
+   /* create rszimg for max. size only once, alpha only if pimg has alpha */
+   if(rszimg==NULL) {
+	rszimg=egi_imgbuf_create(240*4*320/240, 240*4, 0, 0);	/* height, width, alpha, color */
+	if(rszimg==NULL)
+		exit(-1);
+   }
+   if(pimg->alpha==NULL) {
+	free(rszimg->alpha);
+	rszimg->alpha=NULL;
+   }
+
    #if  1 /* ----- scale step 12/240 for W240H320 image  -------- */
    for(i=24, j=32; i<=240*4; i+=24, j+=32 ) {
    #else  /* ----- scale step 1/240 for W240H320 image  -------- */
@@ -130,11 +142,12 @@ do {    ////////////////////////////  3. LOOP TEST   ///////////////////////////
 	k++;
 	//show_jpg("/tmp/home.jpg",&gv_fb_dev, false, 0, 0);
 
-	/* resize */
-	eimg=egi_imgbuf_resize( pimg, i, i*320/240 );   /* eimg, width, height */
-	//eimg=egi_imgbuf_resize( pimg, i, i ); /* eimg, width, height */
-	if(eimg==NULL)
+	/* resize into rszimg, its data is laid out for the new size, no new imgbuf */
+	rszimg->width=i;
+	rszimg->height=i*320/240;
+	if( egi_imgbuf_resize_into(rszimg, pimg) !=0 )
 		exit(-1);
+	eimg=rszimg;
 
 	#if 0 /* >>>>>>  copy a block to replace pimg >>>>>>>>> */
 	/* if size is big as 240x320, then copy a 240x320 size block to replace pimg */
@@ -157,7 +170,6 @@ do {    ////////////////////////////  3. LOOP TEST   ///////////////////////////
 			       //0, 0, eimg->width>240?240:eimg->width , eimg->height   /* xw, yw, winw,  winh */
 			      );
 
-	egi_imgbuf_free(eimg);
 	tm_delayms(150);
 
 	/* break for() */
@@ -172,6 +184,7 @@ do {    ////////////////////////////  3. LOOP TEST   ///////////////////////////
 }while(1); ////////////////////////////    LOOP TEST   /////////////////////////////////
 
 	egi_imgbuf_free(pimg);
+	egi_imgbuf_free(rszimg);
 
 
 
@@ -0,0 +1,271 @@
+/*----------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+Test EGI_RING, and compare throughput with EGI_FIFO.
+
+1. Stress test: A producer pushes sequence numbers by push()
+   and reserve()/commit() with random batch sizes, and a consumer
+   pulls them by pull() and peek()/release(), both block on the
+   ring when it's full/empty. The consumer checks the sequence.
+2. Benchmark: Stream items of 4 and 1024 bytes through EGI_FIFO
+   (pin_wait=1, retry on overrun/underrun), EGI_RING item by item,
+   and EGI_RING by batch.
+
+Usage: test_ring [Mitems]
+
+Midas Zhou
+-----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "egi_fifo.h"
+#include "egi_ring.h"
+
+#define STRESS_CAPACITY		64	/* Small, to wrap and block often */
+#define BENCH_CAPACITY		512
+#define BENCH_BATCH		32
+
+static unsigned int	total_items;	/* Items for each test */
+static unsigned int	item_size;	/* Bench item size */
+static EGI_RING		*ring;
+static EGI_FIFO		*fifo;
+
+static long long tm_us(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (long long)tv.tv_sec*1000000+tv.tv_usec;
+}
+
+
+/* ------------------------ Stress test -------------------------- */
+static void *stress_producer(void *arg)
+{
+	unsigned int seq=0;
+	unsigned int seed=1;
+	unsigned int n, k, cnt;
+	uint32_t batch[STRESS_CAPACITY];
+	uint32_t *slot;
+
+	while(seq<total_items) {
+		n=1+rand_r(&seed)%(STRESS_CAPACITY/2);
+		if(n>total_items-seq)
+			n=total_items-seq;
+
+		if( egi_ring_wait_space(ring, 1, -1) !=0 )
+			break;
+
+		if(seq&1) {	/* Copy a batch */
+			for(k=0; k<n; k++)
+				batch[k]=seq+k;
+			seq += egi_ring_push(ring, batch, n);
+		}
+		else {		/* Zero copy */
+			cnt=n;
+			slot=egi_ring_reserve(ring, &cnt);
+			for(k=0; k<cnt; k++)
+				slot[k]=seq+k;
+			egi_ring_commit(ring, cnt);
+			seq += cnt;
+		}
+	}
+
+	return (void *)0;
+}
+
+static void *stress_consumer(void *arg)
+{
+	unsigned int seq=0;
+	unsigned int seed=2;
+	unsigned int n, k, cnt;
+	uint32_t batch[STRESS_CAPACITY];
+	const uint32_t *slot;
+	long errs=0;
+
+	while(seq<total_items) {
+		n=1+rand_r(&seed)%(STRESS_CAPACITY/2);
+
+		if( egi_ring_wait_data(ring, 1, -1) !=0 )
+			break;
+
+		if(seed&1) {	/* Copy a batch */
+			cnt=egi_ring_pull(ring, batch, n);
+			slot=batch;
+		}
+		else {		/* Zero copy */
+			cnt=n;
+			slot=egi_ring_peek(ring, &cnt);
+		}
+
+		for(k=0; k<cnt; k++) {
+			if(slot[k]!=seq+k && errs++<10)
+				printf("%s: ERROR! data=%u, expect %u\n", __func__, slot[k], seq+k);
+		}
+		seq += cnt;
+
+		if(slot!=batch)
+			egi_ring_release(ring, cnt);
+	}
+
+	return (void *)errs;
+}
+
+static int stress_test(void)
+{
+	pthread_t thp, thc;
+	void *errs;
+	long long tm;
+
+	ring=egi_ring_create(STRESS_CAPACITY, sizeof(uint32_t));
+	if(ring==NULL)
+		return -1;
+
+	tm=tm_us();
+	pthread_create(&thp, NULL, stress_producer, NULL);
+	pthread_create(&thc, NULL, stress_consumer, NULL);
+	pthread_join(thp, NULL);
+	pthread_join(thc, &errs);
+	tm=tm_us()-tm;
+
+	printf("Stress test: %u items through a ring of %d, %s, %lldms.\n",
+			total_items, STRESS_CAPACITY, errs==0 ? "OK" : "FAILS", tm/1000);
+
+	egi_ring_free(&ring);
+	return errs==0 ? 0 : -1;
+}
+
+
+/* ------------------------ Benchmark -------------------------- */
+static void *fifo_pusher(void *arg)
+{
+	unsigned char *data=calloc(1, item_size);
+	unsigned int i;
+
+	for(i=0; i<total_items; i++) {
+		*(uint32_t *)data=i;
+		while( egi_push_fifo(fifo, data, item_size, NULL, NULL, NULL) !=0 );
+	}
+
+	free(data);
+	return (void *)0;
+}
+
+static void *fifo_puller(void *arg)
+{
+	unsigned char *data=calloc(1, item_size);
+	unsigned int i;
+	long errs=0;
+
+	for(i=0; i<total_items; i++) {
+		while( egi_pull_fifo(fifo, data, item_size, NULL, NULL, NULL) !=0 );
+		if( *(uint32_t *)data != i )
+			errs++;
+	}
+
+	free(data);
+	return (void *)errs;
+}
+
+static void *ring_pusher(void *arg)
+{
+	int batch=(int)(long)arg;
+	unsigned char *data=calloc(batch, item_size);
+	unsigned int i, k, n, cnt;
+
+	for(i=0; i<total_items; i+=cnt) {
+		n= total_items-i < batch ? total_items-i : batch;
+		for(k=0; k<n; k++)
+			*(uint32_t *)(data+k*item_size)=i+k;
+
+		egi_ring_wait_space(ring, n, -1);
+		cnt=egi_ring_push(ring, data, n);
+	}
+
+	free(data);
+	return (void *)0;
+}
+
+static void *ring_puller(void *arg)
+{
+	int batch=(int)(long)arg;
+	unsigned char *data=calloc(batch, item_size);
+	unsigned int i, k, n, cnt;
+	long errs=0;
+
+	for(i=0; i<total_items; i+=cnt) {
+		n= total_items-i < batch ? total_items-i : batch;
+		egi_ring_wait_data(ring, n, -1);
+		cnt=egi_ring_pull(ring, data, n);
+		for(k=0; k<cnt; k++) {
+			if( *(uint32_t *)(data+k*item_size) != i+k )
+				errs++;
+		}
+	}
+
+	free(data);
+	return (void *)errs;
+}
+
+/* Run a pair of threads, print throughput */
+static void bench_run(const char *name, void *(*pusher)(void *), void *(*puller)(void *), long batch)
+{
+	pthread_t thp, thc;
+	void *errs;
+	long long tm;
+
+	tm=tm_us();
+	pthread_create(&thp, NULL, pusher, (void *)batch);
+	pthread_create(&thc, NULL, puller, (void *)batch);
+	pthread_join(thp, NULL);
+	pthread_join(thc, &errs);
+	tm=tm_us()-tm;
+	if(tm<1)
+		tm=1;
+
+	printf("	%-16s %10.0f items/s, %8.1f MB/s %s\n", name,
+			(double)total_items*1000000/tm, (double)total_items*item_size/tm,
+			errs==0 ? "" : "(DATA ERROR!)");
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int sizes[]={ 4, 1024 };
+	unsigned int mitems=2;
+	int i;
+
+	if(argc>1)
+		mitems=atoi(argv[1]);
+	if(mitems==0)
+		mitems=2;
+	total_items=mitems*1000000;
+
+	if( stress_test() !=0 )
+		exit(1);
+
+	for(i=0; i<2; i++) {
+		item_size=sizes[i];
+		total_items= item_size>64 ? mitems*100000 : mitems*1000000;
+		printf("Benchmark: %u items of %u bytes, capacity %d:\n", total_items, item_size, BENCH_CAPACITY);
+
+		fifo=egi_malloc_fifo(BENCH_CAPACITY, item_size, 1);	/* pin_wait */
+		ring=egi_ring_create(BENCH_CAPACITY, item_size);
+		if(fifo==NULL || ring==NULL)
+			exit(1);
+
+		bench_run("EGI_FIFO", fifo_pusher, fifo_puller, 1);
+		bench_run("EGI_RING", ring_pusher, ring_puller, 1);
+		bench_run("EGI_RING batch", ring_pusher, ring_puller, BENCH_BATCH);
+
+		egi_free_fifo(fifo);
+		egi_ring_free(&ring);
+	}
+
+	return 0;
+}
@@ -0,0 +1,144 @@
+/*------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+A benchmark for egi_imgbuf_rotate_into(), rows are walked with only
+additions and each row's valid span is calculated first.
+
+For each angle, throughput(Mpixels/s of output imgbuf) is listed for:
+	per-pixel:	old method, mapping every pixel of the output
+			imgbuf with multiplications and bounds test.
+	nearest:	egi_imgbuf_rotate_into(), nearest pixel.
+	bilinear:	egi_imgbuf_rotate_into(), bilinear interpolation.
+Results of nearest and per-pixel are also compared.
+
+Usage:	test_rotbench [width] [height] [rounds]
+	default 240x320, 20 rounds
+
+Midas Zhou
+midaszhou@yahoo.com
+------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "egi_image.h"
+#include "egi_math.h"
+#include "egi_timer.h"
+
+/* Old per-pixel mapping of egi_imgbuf_rotate() */
+static void rotate_perpixel(EGI_IMGBUF *outimg, const EGI_IMGBUF *eimg, int angle)
+{
+	int i,j,m,n;
+	int xr,yr;
+	int index_in, index_out;
+	int ang=angle%360;
+	int asign= ang >= 0 ? 1 : -1;
+	int width=outimg->width, height=outimg->height;
+
+	ang= ang>=0 ? ang : -ang;
+	memset(outimg->imgbuf, 0, width*height*sizeof(EGI_16BIT_COLOR));
+	memset(outimg->alpha, 0, width*height);
+
+	m=height>>1;
+	n=width>>1;
+	for(i=-m; i<=m; i++) {
+		for(j=-n; j<=n; j++) {
+			xr = (j*fp16_cos[ang]+i*asign*fp16_sin[ang])>>16;
+                        yr = (-j*asign*fp16_sin[ang]+i*fp16_cos[ang])>>16;
+			xr += eimg->width>>1;
+			yr += eimg->height>>1;
+			if( xr >= 0 && xr < eimg->width && yr >=0 && yr < eimg->height) {
+				index_out=width*(i+m)+(j+n);
+				index_in=eimg->width*yr+xr;
+				outimg->imgbuf[index_out]=eimg->imgbuf[index_in];
+				outimg->alpha[index_out]=eimg->alpha[index_in];
+			}
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int i, k;
+	int width=240, height=320;
+	int rounds=20;
+	int angles[]={ 0, 15, 30, 45, 60, 90, 135, 180, -45 };
+	int rw, rh;
+	EGI_IMGBUF *eimg, *outimg, *refimg;
+	struct timeval tm_start,tm_end;
+	long us[3];
+	int diff;
+
+	if(argc>2) {
+		width=atoi(argv[1]);
+		height=atoi(argv[2]);
+	}
+	if(argc>3)
+		rounds=atoi(argv[3]);
+	if(width<1 || height<1 || rounds<1) {
+		printf("Usage: %s [width] [height] [rounds]\n",argv[0]);
+		return -1;
+	}
+
+	mat_create_fpTrigonTab();
+
+	eimg=egi_imgbuf_create(height, width, 255, 0);
+	if(eimg==NULL) {
+		printf("Fail to create imgbuf!\n");
+		return -2;
+	}
+	srand(1);
+	for(i=0; i<width*height; i++) {
+		eimg->imgbuf[i]=rand()&0xFFFF;
+		eimg->alpha[i]=rand()&0xFF;
+	}
+
+	printf("%dx%d RGB565+alpha, %d rounds, Mpixels/s of rotated imgbuf\n", width, height, rounds);
+	printf("angle     size     per-pixel   nearest   bilinear   nearest==per-pixel\n");
+	for(k=0; k<sizeof(angles)/sizeof(angles[0]); k++) {
+		egi_imgbuf_rotsize(eimg, angles[k], &rh, &rw);
+		outimg=egi_imgbuf_create(rh, rw, 0, 0);
+		refimg=egi_imgbuf_create(rh, rw, 0, 0);
+		if(outimg==NULL || refimg==NULL) {
+			printf("Fail to create imgbuf!\n");
+			return -2;
+		}
+
+		gettimeofday(&tm_start, NULL);
+		for(i=0; i<rounds; i++)
+			rotate_perpixel(refimg, eimg, angles[k]);
+		gettimeofday(&tm_end, NULL);
+		us[0]=tm_diffus(tm_start,tm_end);
+
+		gettimeofday(&tm_start, NULL);
+		for(i=0; i<rounds; i++)
+			egi_imgbuf_rotate_into(outimg, eimg, angles[k], false);
+		gettimeofday(&tm_end, NULL);
+		us[1]=tm_diffus(tm_start,tm_end);
+
+		diff= memcmp(outimg->imgbuf, refimg->imgbuf, rw*rh*sizeof(EGI_16BIT_COLOR))
+		      || memcmp(outimg->alpha, refimg->alpha, rw*rh);
+
+		gettimeofday(&tm_start, NULL);
+		for(i=0; i<rounds; i++)
+			egi_imgbuf_rotate_into(outimg, eimg, angles[k], true);
+		gettimeofday(&tm_end, NULL);
+		us[2]=tm_diffus(tm_start,tm_end);
+
+		for(i=0; i<3; i++)
+			if(us[i]<1) us[i]=1;
+
+		printf("%5d   %4dx%-4d  %8.2f  %8.2f  %8.2f       %s\n", angles[k], rw, rh,
+				1.0*rw*rh*rounds/us[0], 1.0*rw*rh*rounds/us[1], 1.0*rw*rh*rounds/us[2],
+				diff ? "!!! DIFFERENT !!!" : "yes");
+
+		egi_imgbuf_free(outimg);
+		egi_imgbuf_free(refimg);
+	}
+
+	egi_imgbuf_free(eimg);
+
+	return 0;
+}
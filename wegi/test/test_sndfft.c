@@ -22,9 +22,10 @@ int main(void)
 	unsigned int 	nexp=10; 	// 10
 	unsigned int 	np=1<<nexp;  	/* input element number for FFT */
 	unsigned int 	aexp=11;   	/* 11 MAX Amp=1<<aexp */
-	int		*nx;
-	EGI_FCOMPLEX 	*ffx;  		/* FFT result */
-        EGI_FCOMPLEX 	*wang; 		/* unit phase angle factor */
+	int32_t		*nx;		/* FFT input, and real part of result */
+	int32_t		*ffim;  	/* imaginary part of FFT result */
+	EGI_FFT_PLAN	*plan;		/* FFT plan */
+	int		k;
 	unsigned int 	ns=1<<5;//6;   	/* points for spectrum diagram */
 	unsigned int    avg;
 	int		ng=np/ns;	/* each ns covers ng numbers of np */
@@ -40,17 +41,21 @@ int main(void)
 	}
 
 	/* prepare FFT */
-	nx=calloc(np, sizeof(int));
+	nx=calloc(np, sizeof(int32_t));
 	if(nx==NULL) {
 		printf("Fail to calloc nx[].\n");
 		return -1;
 	}
-	ffx=calloc(np, sizeof(EGI_FCOMPLEX));
-	if(ffx==NULL) {
-		printf("Fail to calloc ffx[]. \n");
+	ffim=calloc(np/2+1, sizeof(int32_t));
+	if(ffim==NULL) {
+		printf("Fail to calloc ffim[]. \n");
+		return -1;
+	}
+        plan=mat_fft_create_plan(np); /* bit-reverse index and twiddle factors */
+	if(plan==NULL) {
+		printf("Fail to create FFT plan. \n");
 		return -1;
 	}
-        wang=mat_CompFFTAng(np); /*  phase angle */
 
         /* for pcm capture */
         snd_pcm_t *play_handle;
@@ -187,13 +192,14 @@ int main(void)
 			nx[i]=buff[i]>>4;  /* trim amplitude to Max 2^11 */
 		}
 
-		/* ---  Run FFT with INT nx[]  --- */
-        	mat_egiFFFT(np, wang, NULL, nx, ffx);
+		/* ---  Run real input FFT with INT nx[], result X[0]...X[np/2] in nx[] and ffim[] --- */
+        	mat_fft_real_int(plan, nx, ffim);
 
 		/* update sdy */
 #if 0  /* -----  1. Symmetric spectrum diagram ----- */
 		for(i=0; i<ns; i++) {
-			sdy[i]=240-( mat_uintCompAmp( ffx[i*ng])>>(nexp-1 -5) ); //(nexp-1) );
+			k= i*ng<=np/2 ? i*ng : np-i*ng;	/* |X[np-k]|=|X[k]| */
+			sdy[i]=240-( mat_intCompAmp(nx[k],ffim[k])>>(nexp-1 -5) ); //(nexp-1) );
 			/* trim sdy[] */
 			if(sdy[i]<0)
 				sdy[i]=0;
@@ -203,14 +209,14 @@ int main(void)
 		step=ng>>1;
 		for(i=0; i<ns; i++) {		     /* fs=8k, 1024 elements, resolution 8Hz, ng=4 */
 		  #if 1 /* direct calculation */
-			sdy[i]=240-( mat_uintCompAmp( ffx[i*(ng>>1)])>>(nexp-1 -3) ); //(nexp-1) );
-			//sdy[i]=240-( mat_uint32Log2( mat_uintCompAmp(ffx[i*(ng>>1)]) )<<3  );
+			sdy[i]=240-( mat_intCompAmp(nx[i*(ng>>1)],ffim[i*(ng>>1)])>>(nexp-1 -3) ); //(nexp-1) );
+			//sdy[i]=240-( mat_uint32Log2( mat_intCompAmp(nx[i*(ng>>1)],ffim[i*(ng>>1)]) )<<3  );
 
 		  #else  /* average */
 			/* get average Amp */
 			avg=0;
 			for( j=0; j< step; j++ ) {
-				avg+=mat_uintCompAmp(ffx[i*step])>>(nexp-1 -3);
+				avg+=mat_intCompAmp(nx[i*step],ffim[i*step])>>(nexp-1 -3);
 			}
 			sdy[i]=240-avg/step;
 		  #endif
@@ -256,8 +262,8 @@ int main(void)
         snd_pcm_close(rec_handle);
         snd_pcm_close(play_handle);
 
-	free(ffx);
-	free(wang);
+	free(ffim);
+	mat_fft_free_plan(&plan);
 
         /* <<<<<  EGI general release >>>>> */
         printf("FTsymbol_release_allfonts()...\n");
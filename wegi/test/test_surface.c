@@ -0,0 +1,177 @@
+/*------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+An example of EGI_SURFACE and the compositor.
+
+Usage:
+	test_surface -s			Start the compositor, which owns the FB.
+	test_surface -a name [-x x0 -y y0]
+					Start an APP surface with a bouncing ball.
+	test_surface -b			Start a status bar surface over APPs.
+	test_surface -r name		Raise surface of an APP.
+
+Example:
+	test_surface -s &
+	test_surface -b &
+	test_surface -a app1 &
+	test_surface -a app2 -x 40 -y 60 &
+	test_surface -r app1
+
+Midas Zhou
+------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include "egi_common.h"
+#include "egi_surface.h"
+
+#define APP_WIDTH	200
+#define APP_HEIGHT	240
+#define BAR_HEIGHT	20
+#define BALL_R		15
+
+static bool sigstop=false;
+
+static void sigint_handler(int signum)
+{
+	sigstop=true;
+}
+
+/*-----------------------------------------------------
+Bouncing ball in an opaque surface, only the area of
+old and new ball is submitted as damaged.
+-----------------------------------------------------*/
+static void run_app(const char *name, int x0, int y0)
+{
+	EGI_SURFACE *surf;
+	FBDEV vfb_dev={0};
+	int x=APP_WIDTH/2, y=APP_HEIGHT/2;
+	int dx=3, dy=2;
+	int nx, ny;
+	EGI_16BIT_COLOR bkcolor=egi_color_random(color_light);
+
+	surf=egi_surface_create(name, x0, y0, APP_WIDTH, APP_HEIGHT, SURF_LAYER_APP, false);
+	if(surf==NULL)
+		return;
+	init_virt_fbdev(&vfb_dev, surf->eimg);
+
+	draw_filled_rect2(&vfb_dev, bkcolor, 0, 0, APP_WIDTH-1, APP_HEIGHT-1);
+	egi_surface_damage(surf, 0, 0, APP_WIDTH-1, APP_HEIGHT-1);
+
+	while(!sigstop) {
+		nx=x+dx;
+		ny=y+dy;
+		if( nx<BALL_R || nx>APP_WIDTH-1-BALL_R ) { dx=-dx; nx=x+dx; }
+		if( ny<BALL_R || ny>APP_HEIGHT-1-BALL_R ) { dy=-dy; ny=y+dy; }
+
+		draw_filled_circle2(&vfb_dev, x, y, BALL_R, bkcolor);
+		draw_filled_circle2(&vfb_dev, nx, ny, BALL_R, WEGI_COLOR_RED);
+		egi_surface_damage(surf, (x<nx?x:nx)-BALL_R, (y<ny?y:ny)-BALL_R,
+					 (x>nx?x:nx)+BALL_R, (y>ny?y:ny)+BALL_R);
+		x=nx;
+		y=ny;
+		usleep(20000);
+	}
+
+	release_virt_fbdev(&vfb_dev);
+	egi_surface_free(&surf);
+}
+
+static void draw_bar_block(EGI_SURFACE *surf, int x, EGI_16BIT_COLOR color, unsigned char alpha)
+{
+	int i,j;
+
+	for(i=0; i<BAR_HEIGHT; i++) {
+		for(j=x; j<x+BAR_HEIGHT; j++) {
+			surf->eimg->imgbuf[i*surf->eimg->width+j]=color;
+			surf->eimg->alpha[i*surf->eimg->width+j]=alpha;
+		}
+	}
+}
+
+/*-----------------------------------------------------
+A half transparent status bar, with a running block.
+-----------------------------------------------------*/
+static void run_statusbar(int width)
+{
+	EGI_SURFACE *surf;
+	int i;
+	int k=0;
+
+	surf=egi_surface_create("statusbar", 0, 0, width, BAR_HEIGHT, SURF_LAYER_STATUSBAR, true);
+	if(surf==NULL)
+		return;
+
+	for(i=0; i<width*BAR_HEIGHT; i++) {
+		surf->eimg->imgbuf[i]=WEGI_COLOR_BLACK;
+		surf->eimg->alpha[i]=160;
+	}
+	egi_surface_damage(surf, 0, 0, width-1, BAR_HEIGHT-1);
+
+	while(!sigstop) {
+		/* Move the block BAR_HEIGHT pixels right */
+		draw_bar_block(surf, k, WEGI_COLOR_BLACK, 160);
+		egi_surface_damage(surf, k, 0, k+BAR_HEIGHT-1, BAR_HEIGHT-1);
+		k=(k+BAR_HEIGHT)%(width-BAR_HEIGHT+1);
+		draw_bar_block(surf, k, WEGI_COLOR_GREEN, 255);
+		egi_surface_damage(surf, k, 0, k+BAR_HEIGHT-1, BAR_HEIGHT-1);
+		sleep(1);
+	}
+
+	egi_surface_free(&surf);
+}
+
+
+int main(int argc, char **argv)
+{
+	EGI_COMPOSITOR *comp;
+	int opt;
+	int x0=0, y0=BAR_HEIGHT;
+
+	signal(SIGINT, sigint_handler);
+
+	while( (opt=getopt(argc,argv,"hsa:bx:y:r:"))!=-1 ) {
+		switch(opt) {
+			case 's':
+				if( init_fbdev(&gv_fb_dev) )
+					return -1;
+				comp=egi_compositor_create(&gv_fb_dev, WEGI_COLOR_GRAY);
+				if(comp==NULL) {
+					release_fbdev(&gv_fb_dev);
+					return -2;
+				}
+				egi_compositor_run(comp, &sigstop);
+				egi_compositor_free(&comp);
+				release_fbdev(&gv_fb_dev);
+				return 0;
+			case 'x':
+				x0=atoi(optarg);
+				break;
+			case 'y':
+				y0=atoi(optarg);
+				break;
+			case 'a':
+				run_app(optarg, x0, y0);
+				return 0;
+			case 'b':
+				run_statusbar(240);
+				return 0;
+			case 'r':
+				return egi_surface_command(optarg, SURFMSG_RAISE, 0, 0, 0);
+			case 'h':
+			default:
+				printf("Usage: %s [-s] [-b] [-x x0 -y y0 -a name] [-r name]\n", argv[0]);
+				printf("	-s	Start the compositor.\n");
+				printf("	-b	Start a status bar.\n");
+				printf("	-a	Start an APP surface with name.\n");
+				printf("	-r	Raise surface with name.\n");
+				return 0;
+		}
+	}
+
+	printf("Usage: %s [-s] [-b] [-x x0 -y y0 -a name] [-r name]\n", argv[0]);
+	return 0;
+}
@@ -0,0 +1,160 @@
+/*------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+A benchmark for symbol_string_writeFB() with glyph atlas, strings are
+written by runs and clipped only once, instead of pixel by pixel with
+transparent color checks.
+
+For sympg_numbfont and sympg_testfont, strings per second are listed for:
+	per-symbol:	old method, symbol_writeFB() for each symbol.
+	atlas:		symbol_string_writeFB(), with glyph atlas.
+Both are written to a virtual FB and results are compared, then
+to the FB back buffer if it's available.
+
+Usage:	test_symbench [rounds]
+	default 2000 rounds
+
+Midas Zhou
+midaszhou@yahoo.com
+------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "egi_common.h"
+#include "egi_symbol.h"
+
+/* Old method of symbol_string_writeFB() */
+static void string_writeFB_perSymbol(FBDEV *fb_dev, const EGI_SYMPAGE *sym_page,
+			int fontcolor, int transpcolor, int x0, int y0, const char* str)
+{
+	const unsigned char *p=(const unsigned char *)str;
+
+	if(transpcolor>=0)
+		transpcolor=sym_page->bkcolor;
+	for( ; *p; p++) {
+		symbol_writeFB(fb_dev, sym_page, fontcolor, transpcolor, x0, y0, *p, 255);
+		if( *p <= sym_page->maxnum )
+			x0 += sym_page->symwidth[*p];
+	}
+}
+
+/* Write the string rounds times with both methods, return us[2] */
+static void bench_font(FBDEV *fb_dev, const EGI_SYMPAGE *font, const char *str, int rounds, long *us)
+{
+	int i;
+	struct timeval tm_start,tm_end;
+
+	gettimeofday(&tm_start, NULL);
+	for(i=0; i<rounds; i++)
+		string_writeFB_perSymbol(fb_dev, font, WEGI_COLOR_RED, 1, i%16, 20, str);
+	gettimeofday(&tm_end, NULL);
+	us[0]=tm_diffus(tm_start,tm_end);
+
+	gettimeofday(&tm_start, NULL);
+	for(i=0; i<rounds; i++)
+		symbol_string_writeFB(fb_dev, font, WEGI_COLOR_RED, 1, i%16, 20, str, 255);
+	gettimeofday(&tm_end, NULL);
+	us[1]=tm_diffus(tm_start,tm_end);
+
+	if(us[0]<1) us[0]=1;
+	if(us[1]<1) us[1]=1;
+}
+
+/* Compare results on virtual FB, with clipping at screen edges */
+static bool compare_font(const EGI_SYMPAGE *font, const char *str)
+{
+	EGI_IMGBUF *img1, *img2;
+	FBDEV vfb1={0}, vfb2={0};
+	int x0, y0;
+	bool same=true;
+
+	img1=egi_imgbuf_create(320, 240, 0, WEGI_COLOR_GRAY);
+	img2=egi_imgbuf_create(320, 240, 0, WEGI_COLOR_GRAY);
+	if(img1==NULL || img2==NULL) {
+		egi_imgbuf_free(img1);
+		egi_imgbuf_free(img2);
+		return false;
+	}
+	init_virt_fbdev(&vfb1, img1);
+	init_virt_fbdev(&vfb2, img2);
+
+	for(y0=-30; y0<340 && same; y0+=37) {
+		for(x0=-60; x0<260; x0+=23) {
+			string_writeFB_perSymbol(&vfb1, font, -1, 1, x0, y0, str);
+			symbol_string_writeFB(&vfb2, font, -1, 1, x0, y0, str, 255);
+		}
+		same= memcmp(img1->imgbuf, img2->imgbuf, 240*320*sizeof(EGI_16BIT_COLOR))==0;
+	}
+
+	release_virt_fbdev(&vfb1);
+	release_virt_fbdev(&vfb2);
+	egi_imgbuf_free(img1);
+	egi_imgbuf_free(img2);
+
+	return same;
+}
+
+int main(int argc, char **argv)
+{
+	int k;
+	int rounds=2000;
+	long us[2];
+	EGI_IMGBUF *img;
+	FBDEV vfb_dev={0};
+	struct {
+		const char *name;
+		EGI_SYMPAGE *font;
+		const char *str;
+	} tests[]= {
+		{ "numbfont", &sympg_numbfont, "12:34:56" },
+		{ "testfont", &sympg_testfont, "Temp 23.5C  RH 41%" },
+	};
+
+	if(argc>1)
+		rounds=atoi(argv[1]);
+	if(rounds<1) {
+		printf("Usage: %s [rounds]\n",argv[0]);
+		return -1;
+	}
+
+	if(symbol_load_allpages() !=0 ) {
+		printf("Fail to load symbol pages!\n");
+		return -2;
+	}
+
+	img=egi_imgbuf_create(320, 240, 0, WEGI_COLOR_GRAY);
+	if(img==NULL) {
+		symbol_release_allpages();
+		return -3;
+	}
+	init_virt_fbdev(&vfb_dev, img);
+
+	printf("%d rounds, strings per second\n", rounds);
+	printf("font       FB         per-symbol      atlas    same\n");
+	for(k=0; k<sizeof(tests)/sizeof(tests[0]); k++) {
+		bench_font(&vfb_dev, tests[k].font, tests[k].str, rounds, us);
+		printf("%-10s virtual  %10.1f  %10.1f    %s\n", tests[k].name,
+				1.0e6*rounds/us[0], 1.0e6*rounds/us[1],
+				compare_font(tests[k].font, tests[k].str) ? "yes" : "!!! DIFFERENT !!!" );
+	}
+
+	release_virt_fbdev(&vfb_dev);
+	egi_imgbuf_free(img);
+
+	/* Write to back buffer of FB, not refreshed */
+	if( init_fbdev(&gv_fb_dev)==0 ) {
+		for(k=0; k<sizeof(tests)/sizeof(tests[0]); k++) {
+			bench_font(&gv_fb_dev, tests[k].font, tests[k].str, rounds, us);
+			printf("%-10s FB       %10.1f  %10.1f\n", tests[k].name,
+					1.0e6*rounds/us[0], 1.0e6*rounds/us[1]);
+		}
+		release_fbdev(&gv_fb_dev);
+	}
+
+	symbol_release_allpages();
+
+	return 0;
+}
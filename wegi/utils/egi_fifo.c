@@ -29,6 +29,9 @@ A EGI FIFO buffer
 
 5. Ahead may be -1,0,1,2, most likely 0 or 1.
 
+6. It takes a mutex lock for each item. For one pusher and one puller, EGI_RING in egi_ring.h
+   is lock-free, and supports batch/zero-copy access.
+
 
 Midas Zhou
 --------------------------------------------------------------------------------------------------------*/
@@ -237,20 +240,7 @@ int egi_push_fifo(EGI_FIFO *fifo,  unsigned char *data, int size,
 
 	/* Now, fifo->pin is no more than buff_size-1. */
 
-	/* ----- FOR TEST ---------------- */
-	if(fifo->pin==0)
-	{
-		if( ((*data)<<(32-8)) != 0 )
-		{
-			EGI_PLOG(LOGLV_ERROR,"FIFO ERROR!!! push data=%d is NOT N*512 when pin==0! pout=%d, ahead-%d\n",
-								*data, fifo->pout, fifo->ahead );
-			exit(0);
-		}
-	}
-	/* ----- END OF TEST ------------ */
-
-	/* Clear slot and push data */
-	memset((fifo->buff)[fifo->pin],0,fifo->item_size);
+	/* Push data, the rest of the slot is not cleared */
 	memcpy((fifo->buff)[fifo->pin],data,size); /* Not item_size however */
 	/* pass out params */
 	if(in != NULL)	*in=fifo->pin;
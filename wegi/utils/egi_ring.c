@@ -0,0 +1,447 @@
+/*----------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+A lock-free single-producer/single-consumer ring buffer,
+see egi_ring.h.
+
+Memory order:
+   Producer writes items, then stores head with RELEASE, consumer
+   loads head with ACQUIRE before reading items, and it's the same
+   for tail in the other direction.
+   For blocking, the waiter sets its wait flag, then rechecks the
+   counter, and the other side updates the counter, then checks
+   the flag, both with a SEQ_CST fence in between, so a wakeup is
+   never missed.
+
+Midas Zhou
+-----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "egi_ring.h"
+
+
+/*-----------------------------------------------------
+Wait on a futex word while it's val, until deadline.
+@deadline:	CLOCK_MONOTONIC, NULL to wait forever.
+Return:
+	0		Woken up, or value changed.
+	ETIMEDOUT	Deadline passed.
+------------------------------------------------------*/
+static int ring_futex_wait(uint32_t *addr, uint32_t val, const struct timespec *deadline)
+{
+	struct timespec now, rel;
+
+	if(deadline!=NULL) {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		rel.tv_sec=deadline->tv_sec-now.tv_sec;
+		rel.tv_nsec=deadline->tv_nsec-now.tv_nsec;
+		if(rel.tv_nsec<0) {
+			rel.tv_sec--;
+			rel.tv_nsec+=1000000000;
+		}
+		if(rel.tv_sec<0)
+			return ETIMEDOUT;
+	}
+
+	if( syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, deadline ? &rel : NULL, NULL, 0) <0 ) {
+		if(errno==ETIMEDOUT)
+			return ETIMEDOUT;
+	}
+
+	return 0;	/* Woken up, EAGAIN or EINTR */
+}
+
+static void ring_futex_wake(uint32_t *addr)
+{
+	syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+/* Deadline of timeout_ms from now */
+static void ring_deadline(struct timespec *deadline, int timeout_ms)
+{
+	clock_gettime(CLOCK_MONOTONIC, deadline);
+	deadline->tv_sec += timeout_ms/1000;
+	deadline->tv_nsec += (timeout_ms%1000)*1000000;
+	if(deadline->tv_nsec >= 1000000000) {
+		deadline->tv_sec++;
+		deadline->tv_nsec -= 1000000000;
+	}
+}
+
+
+/*---------------------------------------------------------
+Create an EGI_RING.
+
+@capacity:	Max. items, rounded up to power of 2.
+@item_size:	Size of each item, in bytes.
+
+Return:
+	!NULL	OK
+	NULL	Fails
+----------------------------------------------------------*/
+EGI_RING* egi_ring_create(unsigned int capacity, unsigned int item_size)
+{
+	EGI_RING *ring=NULL;
+	unsigned int cap;
+
+	if( capacity==0 || capacity > (1U<<30) || item_size==0 ) {
+		printf("%s: Input capacity or item_size is invalid.\n",__func__);
+		return NULL;
+	}
+
+	for(cap=1; cap<capacity; cap<<=1);
+
+	/* Aligned, so producer/consumer data never share a cache line with others */
+	if( posix_memalign((void **)&ring, EGI_RING_CACHELINE, sizeof(EGI_RING)) !=0 ) {
+		printf("%s: Fail to malloc ring.\n",__func__);
+		return NULL;
+	}
+	memset(ring, 0, sizeof(EGI_RING));
+
+	ring->buff=malloc((size_t)cap*item_size);
+	if(ring->buff==NULL) {
+		printf("%s: Fail to malloc ring->buff.\n",__func__);
+		free(ring);
+		return NULL;
+	}
+
+	ring->item_size=item_size;
+	ring->capacity=cap;
+	ring->mask=cap-1;
+
+	return ring;
+}
+
+
+/*-------------------------------------------------
+Free an EGI_RING, both producer and consumer MUST
+have quit.
+--------------------------------------------------*/
+void egi_ring_free(EGI_RING **ring)
+{
+	if(ring==NULL || *ring==NULL)
+		return;
+
+	free((*ring)->buff);
+	free(*ring);
+	*ring=NULL;
+}
+
+
+/*--------------------------------------
+Return number of items in the ring, it's
+only a snapshot.
+---------------------------------------*/
+unsigned int egi_ring_count(EGI_RING *ring)
+{
+	uint32_t tail=__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+	return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail;
+}
+
+
+/* Same as egi_ring_reserve(), from position head */
+static void* ring_reserve_at(EGI_RING *ring, uint32_t head, unsigned int *n)
+{
+	unsigned int space, idx, cnt;
+
+	/* Load shared tail only when the cached one says not enough */
+	space=ring->capacity-(head-ring->tail_cache);
+	if(space < *n) {
+		ring->tail_cache=__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		space=ring->capacity-(head-ring->tail_cache);
+	}
+	if(space==0) {
+		*n=0;
+		return NULL;
+	}
+
+	idx=head & ring->mask;
+	cnt=*n;
+	if(cnt>space)
+		cnt=space;
+	if(cnt>ring->capacity-idx)
+		cnt=ring->capacity-idx;
+
+	*n=cnt;
+	return ring->buff + (size_t)idx*ring->item_size;
+}
+
+
+/*-------------------------------------------------------------
+Producer: Reserve continuous free slots in the ring, then
+write items there and call egi_ring_commit().
+
+@n:	In: Max. items wanted.
+	Out: Items reserved, it may be less than wanted if the
+	ring is nearly full, or at the end of the buff.
+
+Return:
+	Pointer to the first reserved slot	OK
+	NULL					The ring is full
+-------------------------------------------------------------*/
+void* egi_ring_reserve(EGI_RING *ring, unsigned int *n)
+{
+	return ring_reserve_at(ring, __atomic_load_n(&ring->head, __ATOMIC_RELAXED), n);
+}
+
+
+/*---------------------------------------------------
+Producer: Publish n items written to reserved slots,
+and wake up the consumer if it waits.
+----------------------------------------------------*/
+void egi_ring_commit(EGI_RING *ring, unsigned int n)
+{
+	uint32_t head=__atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+
+	__atomic_store_n(&ring->head, head+n, __ATOMIC_RELEASE);
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if( __atomic_load_n(&ring->cwait, __ATOMIC_RELAXED) )
+		ring_futex_wake(&ring->head);
+}
+
+
+/*-----------------------------------------------------
+Producer: Copy a batch of items into the ring, with one
+commit, it never blocks.
+
+Return:
+	Number of items pushed, less than n if the ring is
+	full.
+------------------------------------------------------*/
+unsigned int egi_ring_push(EGI_RING *ring, const void *items, unsigned int n)
+{
+	const unsigned char *pin=items;
+	uint32_t head=__atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+	unsigned int total=0;
+	unsigned int cnt;
+	void *dest;
+
+	/* At most twice, for the buff end, and publish all at last */
+	while(total<n) {
+		cnt=n-total;
+		dest=ring_reserve_at(ring, head+total, &cnt);
+		if(dest==NULL)
+			break;
+
+		memcpy(dest, pin, (size_t)cnt*ring->item_size);
+		pin += (size_t)cnt*ring->item_size;
+		total += cnt;
+	}
+
+	if(total>0)
+		egi_ring_commit(ring, total);
+
+	return total;
+}
+
+
+/*---------------------------------------------------------
+Producer: Wait until there are at least n free slots.
+
+@n:		Free slots wanted, 1 to capacity.
+@timeout_ms:	<0 wait forever.
+
+Return:
+	0	OK
+	1	Timeout
+	<0	Fails
+----------------------------------------------------------*/
+int egi_ring_wait_space(EGI_RING *ring, unsigned int n, int timeout_ms)
+{
+	struct timespec deadline;
+	uint32_t head, tail;
+
+	if(ring==NULL || n==0 || n>ring->capacity)
+		return -1;
+
+	if(timeout_ms>=0)
+		ring_deadline(&deadline, timeout_ms);
+
+	head=__atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+	for(;;) {
+		tail=__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		if( ring->capacity-(head-tail) >= n )
+			break;
+
+		/* Set flag, then recheck */
+		__atomic_store_n(&ring->pwait, 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		tail=__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		if( ring->capacity-(head-tail) >= n ) {
+			__atomic_store_n(&ring->pwait, 0, __ATOMIC_RELAXED);
+			break;
+		}
+
+		if( ring_futex_wait(&ring->tail, tail, timeout_ms<0 ? NULL : &deadline) == ETIMEDOUT ) {
+			__atomic_store_n(&ring->pwait, 0, __ATOMIC_RELAXED);
+			tail=__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+			if( ring->capacity-(head-tail) >= n )
+				break;
+			return 1;
+		}
+		__atomic_store_n(&ring->pwait, 0, __ATOMIC_RELAXED);
+	}
+
+	ring->tail_cache=tail;
+	return 0;
+}
+
+
+/* Same as egi_ring_peek(), from position tail */
+static const void* ring_peek_at(EGI_RING *ring, uint32_t tail, unsigned int *n)
+{
+	unsigned int avail, idx, cnt;
+
+	/* Load shared head only when the cached one says not enough */
+	avail=ring->head_cache-tail;
+	if(avail < *n) {
+		ring->head_cache=__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		avail=ring->head_cache-tail;
+	}
+	if(avail==0) {
+		*n=0;
+		return NULL;
+	}
+
+	idx=tail & ring->mask;
+	cnt=*n;
+	if(cnt>avail)
+		cnt=avail;
+	if(cnt>ring->capacity-idx)
+		cnt=ring->capacity-idx;
+
+	*n=cnt;
+	return ring->buff + (size_t)idx*ring->item_size;
+}
+
+
+/*-------------------------------------------------------------
+Consumer: Peek continuous items in the ring, read them there
+and then call egi_ring_release().
+
+@n:	In: Max. items wanted.
+	Out: Items available, it may be less than wanted, or at
+	the end of the buff.
+
+Return:
+	Pointer to the first item	OK
+	NULL				The ring is empty
+-------------------------------------------------------------*/
+const void* egi_ring_peek(EGI_RING *ring, unsigned int *n)
+{
+	return ring_peek_at(ring, __atomic_load_n(&ring->tail, __ATOMIC_RELAXED), n);
+}
+
+
+/*----------------------------------------------------
+Consumer: Free n items that have been read, and wake
+up the producer if it waits.
+-----------------------------------------------------*/
+void egi_ring_release(EGI_RING *ring, unsigned int n)
+{
+	uint32_t tail=__atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+
+	__atomic_store_n(&ring->tail, tail+n, __ATOMIC_RELEASE);
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if( __atomic_load_n(&ring->pwait, __ATOMIC_RELAXED) )
+		ring_futex_wake(&ring->tail);
+}
+
+
+/*------------------------------------------------------
+Consumer: Copy a batch of items out of the ring, with
+one release, it never blocks.
+
+Return:
+	Number of items pulled, less than n if the ring is
+	empty.
+-------------------------------------------------------*/
+unsigned int egi_ring_pull(EGI_RING *ring, void *items, unsigned int n)
+{
+	unsigned char *pout=items;
+	uint32_t tail=__atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+	unsigned int total=0;
+	unsigned int cnt;
+	const void *src;
+
+	/* At most twice, for the buff end, and release all at last */
+	while(total<n) {
+		cnt=n-total;
+		src=ring_peek_at(ring, tail+total, &cnt);
+		if(src==NULL)
+			break;
+
+		memcpy(pout, src, (size_t)cnt*ring->item_size);
+		pout += (size_t)cnt*ring->item_size;
+		total += cnt;
+	}
+
+	if(total>0)
+		egi_ring_release(ring, total);
+
+	return total;
+}
+
+
+/*---------------------------------------------------------
+Consumer: Wait until there are at least n items.
+
+@n:		Items wanted, 1 to capacity.
+@timeout_ms:	<0 wait forever.
+
+Return:
+	0	OK
+	1	Timeout
+	<0	Fails
+----------------------------------------------------------*/
+int egi_ring_wait_data(EGI_RING *ring, unsigned int n, int timeout_ms)
+{
+	struct timespec deadline;
+	uint32_t head, tail;
+
+	if(ring==NULL || n==0 || n>ring->capacity)
+		return -1;
+
+	if(timeout_ms>=0)
+		ring_deadline(&deadline, timeout_ms);
+
+	tail=__atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+	for(;;) {
+		head=__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		if( head-tail >= n )
+			break;
+
+		/* Set flag, then recheck */
+		__atomic_store_n(&ring->cwait, 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		head=__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		if( head-tail >= n ) {
+			__atomic_store_n(&ring->cwait, 0, __ATOMIC_RELAXED);
+			break;
+		}
+
+		if( ring_futex_wait(&ring->head, head, timeout_ms<0 ? NULL : &deadline) == ETIMEDOUT ) {
+			__atomic_store_n(&ring->cwait, 0, __ATOMIC_RELAXED);
+			head=__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+			if( head-tail >= n )
+				break;
+			return 1;
+		}
+		__atomic_store_n(&ring->cwait, 0, __ATOMIC_RELAXED);
+	}
+
+	ring->head_cache=head;
+	return 0;
+}
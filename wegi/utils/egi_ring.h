@@ -0,0 +1,68 @@
+/*----------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+A lock-free single-producer/single-consumer ring buffer, to stream
+PCM or other data between two threads, instead of EGI_FIFO.
+
+1. Capacity is rounded up to power of 2, and head/tail are free
+   running counters, so there's no wraparound mark to track.
+2. Producer and consumer data are on separate cache lines, each side
+   keeps a cached copy of the other's counter, and reads the shared
+   one only when the cached one says full/empty.
+3. Zero copy: egi_ring_reserve()/egi_ring_commit() for the producer,
+   and egi_ring_peek()/egi_ring_release() for the consumer, work on
+   the buffer directly. egi_ring_push()/egi_ring_pull() copy a batch
+   of items with one commit/release.
+4. egi_ring_wait_data()/egi_ring_wait_space() block on a futex, and
+   the other side makes a FUTEX_WAKE syscall only if someone waits.
+
+Note:
+   Only ONE producer thread and ONE consumer thread for a ring!
+
+Midas Zhou
+-----------------------------------------------------------------*/
+#ifndef __EGI_RING_H__
+#define __EGI_RING_H__
+
+#include <stdint.h>
+
+#define EGI_RING_CACHELINE	64	/* Not less than L1 cache line size */
+
+typedef struct egi_ring
+{
+	/* Constant after creation */
+	unsigned int	item_size;	/* Size of each item, in bytes */
+	unsigned int	capacity;	/* Max. items, power of 2 */
+	unsigned int	mask;		/* capacity-1 */
+	unsigned char	*buff;		/* [capacity][item_size] */
+
+	/* Producer side */
+	uint32_t	head __attribute__((aligned(EGI_RING_CACHELINE)));  /* Items ever pushed, futex word */
+	uint32_t	tail_cache;	/* Producer's copy of tail */
+	int		pwait;		/* Producer is waiting for space */
+
+	/* Consumer side */
+	uint32_t	tail __attribute__((aligned(EGI_RING_CACHELINE)));  /* Items ever pulled, futex word */
+	uint32_t	head_cache;	/* Consumer's copy of head */
+	int		cwait;		/* Consumer is waiting for data */
+} __attribute__((aligned(EGI_RING_CACHELINE))) EGI_RING;
+
+EGI_RING*	egi_ring_create(unsigned int capacity, unsigned int item_size);
+void		egi_ring_free(EGI_RING **ring);
+unsigned int	egi_ring_count(EGI_RING *ring);
+
+/* Producer */
+void*		egi_ring_reserve(EGI_RING *ring, unsigned int *n);
+void		egi_ring_commit(EGI_RING *ring, unsigned int n);
+unsigned int	egi_ring_push(EGI_RING *ring, const void *items, unsigned int n);
+int		egi_ring_wait_space(EGI_RING *ring, unsigned int n, int timeout_ms);
+
+/* Consumer */
+const void*	egi_ring_peek(EGI_RING *ring, unsigned int *n);
+void		egi_ring_release(EGI_RING *ring, unsigned int n);
+unsigned int	egi_ring_pull(EGI_RING *ring, void *items, unsigned int n);
+int		egi_ring_wait_data(EGI_RING *ring, unsigned int n, int timeout_ms);
+
+#endif
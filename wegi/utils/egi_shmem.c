@@ -28,8 +28,30 @@ Return:
 	<0	Fails
 -------------------------------------------------------------*/
 int egi_shmem_open(EGI_SHMEM *shmem)
+{
+	return egi_shmem_open_flags(shmem, O_CREAT);
+}
+
+/*-------------------------------------------------------------
+Open shared memory with oflag and get msg_data with mmap.
+
+@shmem:	A struct pointer to EGI_SHMEM.
+@oflag:	0		Open an existing one only, it fails if the
+			named memory dosen't exist or is smaller than
+			shmem->shm_size.
+	O_CREAT		Create it if it dosen't exist.
+	O_CREAT|O_EXCL	Create it, it fails if it exists already,
+			with errno EEXIST.
+
+Return:
+	0	OK
+	<0	Fails
+--------------------------------------------------------------*/
+int egi_shmem_open_flags(EGI_SHMEM *shmem, int oflag)
 {
         int shmfd;
+	struct stat sb;
+	int ret=0;
 
 	/* check input */
 	if(shmem==NULL||shmem->shm_name==NULL)
@@ -41,30 +63,48 @@ int egi_shmem_open(EGI_SHMEM *shmem)
 	}
 
 	/* open shm */
-	shmfd=shm_open(shmem->shm_name, O_CREAT|O_RDWR, 0666);
+	oflag &= O_CREAT|O_EXCL;
+	shmfd=shm_open(shmem->shm_name, oflag|O_RDWR, 0666);
         if(shmfd<0) {
-                printf("%s: fail shm_open(): %s",__func__, strerror(errno));
+                printf("%s: fail shm_open(): %s\n",__func__, strerror(errno));
 		return -3;
         }
 
-        /* resize */
-        if( ftruncate(shmfd, shmem->shm_size) <0 ) { /* page size */
-                printf("%s: fail ftruncate(): %s",__func__, strerror(errno));
-		return -4;
+        /* resize, or check size of an existing one */
+	if(oflag & O_CREAT) {
+	        if( ftruncate(shmfd, shmem->shm_size) <0 ) { /* page size */
+        	        printf("%s: fail ftruncate(): %s\n",__func__, strerror(errno));
+			ret=-4;
+			goto END_FUNC;
+		}
+	}
+	else if( fstat(shmfd, &sb)<0 || sb.st_size < shmem->shm_size ) {
+		printf("%s: shm '%s' is smaller than shm_size!\n",__func__, shmem->shm_name);
+		ret=-4;
+		goto END_FUNC;
 	}
 
         /* mmap */
         shmem->shm_map=mmap(NULL, shmem->shm_size, PROT_READ|PROT_WRITE, MAP_SHARED, shmfd, 0);
         if( shmem->shm_map==MAP_FAILED ) {
-                printf("%s: fail mmap(): %s",__func__, strerror(errno));
-		return -5;
+                printf("%s: fail mmap(): %s\n",__func__, strerror(errno));
+		shmem->shm_map=NULL;
+		ret=-5;
+		goto END_FUNC;
         }
 
 	/* get msg_data pointer */
 	shmem->msg_data=(typeof(shmem->msg_data))(shmem->shm_map);
 
+END_FUNC:
+	/* The mapping is kept after the fd is closed */
+	close(shmfd);
 
-	return 0;
+	/* Remove the one just created by O_EXCL */
+	if( ret<0 && (oflag & O_EXCL) )
+		shm_unlink(shmem->shm_name);
+
+	return ret;
 }
 
 
@@ -41,6 +41,7 @@ typedef struct {
 
 
 int egi_shmem_open(EGI_SHMEM *shmem);
+int egi_shmem_open_flags(EGI_SHMEM *shmem, int oflag);
 int egi_shmem_close(EGI_SHMEM *shmem);
 int egi_shmem_remove(const char *name);
 
@@ -35,6 +35,7 @@ Midas
 #include "gyro_l3g4200d.h"
 #include "i2c_adxl345.h" //--- use  read() write() to operate I2C
 #include "data_server.h"
+#include "telemetry.h" //batched binary telemetry to multiple clients
 #include "filters.h"
 #include "mathwork.h"
 #include "kalman_n2m2.h"
@@ -148,6 +149,8 @@ int main(void)
 
    //----- TCP buffer -----
    float tcp_buff[2];
+   struct telem_server *telem_svr=NULL;
+   int64_t ts_us; //timestamp of telemetry samples
 
    //----- timer -----
    struct timeval tm_start,tm_end;
@@ -155,7 +158,6 @@ int main(void)
 
    //----- pthread -----
    pthread_t pthrd_WriteOled;
-   pthread_t pthrd_TCPsendData;
    pthread_t pthrd_ReadADXL345;
    pthread_t pthrd_ReadL3G4200D;
    int pret;
@@ -235,30 +237,16 @@ int main(void)
 
 //-------------- Prepare TCP Data Server ----------------
 #ifdef TCP_TRANSFER
-   printf("Prepare TCP data server ...\n");
-   if(prepare_data_server() < 0)
+   //----- raw and filtered (angle, angular rate) are published in batches of 20 samples or 50ms,
+   //----- any number of clients may connect at any time, see python/telem_view.py
+   printf("Start telemetry server on port %d ...\n", TELEM_PORT);
+   telem_svr=telem_server_start(TELEM_PORT, 20, 50);
+   if(telem_svr==NULL)
    {
-	printf(" fail to prepare data server!\n");
+	printf(" fail to start telemetry server!\n");
 	ret_val=-3;
 	goto CALL_FAIL;
    }
-
-   //----- wait to accept data client ----
-   printf("wait for Matlab to connect...\n");
-   cltsock_desc=accept_data_client();
-   if(cltsock_desc < 0){
-	printf(" Fail to accept data client!\n");
-	ret_val=-4;
-	goto CALL_FAIL;
-   }
-
-   //----- create thread for TCP data sending
-   if(pthread_create(&pthrd_TCPsendData,NULL,(void *)loop_send_data, (void *)fdb_kalman) !=0)
-   {
-	printf("fail to create pthread for TCP data transfering\n");
-	ret_val=-1;
-	goto CALL_FAIL;
-   }
 #endif  //------------ end TCP_TRANSFER PREPARATION -----------
 
    //================   LOOP: read data from sensors and proceed  ===============
@@ -378,6 +366,15 @@ while (1) {
 	   pthread_mutex_lock(&fdb_kalman->kmlock);
            float_KalmanFilter( fdb_kalman, pMat_S );   //[mx1] input observation matrix
 	   pthread_mutex_unlock(&fdb_kalman->kmlock);
+
+#ifdef TCP_TRANSFER
+	   //----- publish raw observation and Kalman output, no blocking -----
+	   ts_us=telem_clock_us();
+	   tcp_buff[0]=fangX;
+	   tcp_buff[1]=fangRXYZ[1];
+	   telem_publish(telem_svr, TELEM_RAW, ts_us, tcp_buff, 2);
+	   telem_publish(telem_svr, TELEM_FILTERED, ts_us, pMat_Y->pmat, 2);
+#endif
 //	   printf("pMat_Y:  %e,   %e \n", *pMat_Y->pmat, *(pMat_Y->pmat+1));
 //	   printf("pMat_P:  %e,   %e \n", *fdb_kalman->pMP->pmat, *(fdb_kalman->pMP->pmat+3));
 //	   printf("pMat_Pp:  %e,  %e \n", *fdb_kalman->pMPp->pmat, *(fdb_kalman->pMPp->pmat+3));
@@ -420,7 +417,6 @@ while (1) {
 /*
    //----- wait OLED display thread
    pthread_join(pthrd_WriteOled,NULL);
-   pthread_join(pthrd_TCPsendData,NULL);
 */
 #ifdef PTHREAD_READ_SENSORS
    pthread_join(pthrd_ReadADXL345,NULL);
@@ -429,7 +425,10 @@ while (1) {
 
 
 CALL_FAIL:
-
+#ifdef TCP_TRANSFER
+   //----- close all clients, frames not sent yet are discarded -----
+   telem_server_stop(&telem_svr);
+#endif
 
 #ifdef PTHREAD_READ_SENSORS
    //------ release mutext locker -----